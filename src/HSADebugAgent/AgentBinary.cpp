@@ -9,7 +9,11 @@
 #include <cstring>
 #include <string>
 #include <cstdlib>
+#include <cxxabi.h>
 #include <errno.h>
+#include <map>
+#include <memory>
+#include <pthread.h>
 #include <fstream>
 #include <iostream>
 
@@ -20,9 +24,14 @@
 
 #include "AgentBinary.h"
 #include "AgentConfiguration.h"
+#include "AgentFramedProtocol.h"
 #include "AgentISABuffer.h"
+#include "AgentISAWorker.h"
+#include "AgentKernelBinaryCache.h"
 #include "AgentLogging.h"
 #include "AgentNotifyGdb.h"
+#include "AgentSharedMemRegistry.h"
+#include "AgentTiming.h"
 #include "AgentUtils.h"
 #include "CommunicationControl.h"
 #include "HSADebugAgent.h"
@@ -32,26 +41,23 @@
 namespace HwDbgAgent
 {
 
-/// Default constructor
-AgentBinary::AgentBinary():
+/// Constructor
+AgentBinary::AgentBinary(AgentSharedMemRegistry* pSharedMemRegistry, AgentKernelBinaryCache* pBinaryCache):
     m_pBinary(nullptr),
     m_binarySize(0),
+    m_binaryHash(0),
+    m_kernelObject(0),
     m_kernelName(""),
-    m_codeObjBufferShmKey(-1),
-    m_codeObjBufferMaxSize(0),
+    m_pSharedMemRegistry(pSharedMemRegistry),
+    m_pBinaryCache(pBinaryCache),
     m_pIsaBuffer(nullptr),
-    m_enableISADisassemble(true)
+    m_enableISADisassemble(true),
+    m_isISADeferred(false),
+    m_isISAPublished(false)
 {
-    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
-    status = GetActiveAgentConfig()->GetConfigShmKey(HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM, m_codeObjBufferShmKey);
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    if (m_pSharedMemRegistry == nullptr)
     {
-        AGENT_ERROR("Could not get shared mem key");
-    }
-    status = GetActiveAgentConfig()->GetConfigShmSize(HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM, m_codeObjBufferMaxSize);
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
-    {
-        AGENT_ERROR("Could not get shared mem max size");
+        AGENT_ERROR("AgentBinary: The shared mem registry is nullptr");
     }
 
     m_pIsaBuffer = new (std::nothrow) AgentISABuffer;
@@ -64,10 +70,17 @@ AgentBinary::AgentBinary():
     pDisableISAEnvVar = std::getenv("ROCM_GDB_DISABLE_ISA_DISASSEMBLE");
     if (pDisableISAEnvVar != nullptr)
     {
-        AGENT_LOG("Disable GPU ISA disassemble," <<
-                  " ROCM_GDB_DISABLE_ISA_DISASSEMBLE = " << pDisableISAEnvVar);
-        AGENT_OP("Disable GPU ISA disassemble," <<
-                  " ROCM_GDB_DISABLE_ISA_DISASSEMBLE = " << pDisableISAEnvVar);
+        // Every dispatch has a binary, the user is only told once
+        static bool s_isNoticePrinted = false;
+
+        if (!s_isNoticePrinted)
+        {
+            s_isNoticePrinted = true;
+            AGENT_LOG("Disable GPU ISA disassemble," <<
+                      " ROCM_GDB_DISABLE_ISA_DISASSEMBLE = " << pDisableISAEnvVar);
+            AGENT_OP("Disable GPU ISA disassemble," <<
+                     " ROCM_GDB_DISABLE_ISA_DISASSEMBLE = " << pDisableISAEnvVar);
+        }
 
         m_enableISADisassemble = false;
     }
@@ -82,93 +95,278 @@ AgentBinary::~AgentBinary()
     }
 }
 
-/// Demangle the input kernel name
-HsailAgentStatus AgentBinary::DemangleKernelName(const std::string& ipKernelName,
-                                                       std::string& demangledNameOut) const
+/// Demangled kernel names, keyed by the mangled name
+static std::map<std::string, std::string> gs_DemangledKernelNames;
+
+/// Protects gs_DemangledKernelNames
+static pthread_mutex_t gs_DemangledKernelNamesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/// The binary of every kernel object hashed before, keyed by the kernel_object
+static std::map<uint64_t, AgentPreparedBinary> gs_PreparedBinaries;
+
+/// Protects gs_PreparedBinaries
+static pthread_mutex_t gs_PreparedBinariesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+void AgentRecordPreparedBinary(const uint64_t kernelObject, const uint64_t binaryHash, const size_t binarySize)
 {
-    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
-    // The strings are saved to a file and then piped in and out to c++filt
-    const std::string MANGLED_STRING_FILE="/tmp/mangled_kernel";
-    const std::string DEMANGLED_STRING_FILE="/tmp/demangled_kernel";
+    AgentPreparedBinary preparedBinary;
+    preparedBinary.m_binaryHash = binaryHash;
+    preparedBinary.m_binarySize = binarySize;
+
+    pthread_mutex_lock(&gs_PreparedBinariesMutex);
+    gs_PreparedBinaries[kernelObject] = preparedBinary;
+    pthread_mutex_unlock(&gs_PreparedBinariesMutex);
+}
 
+bool AgentFindPreparedBinary(const uint64_t kernelObject, AgentPreparedBinary& preparedBinaryOut)
+{
+    bool isFound = false;
 
-    if (ipKernelName.empty())
+    pthread_mutex_lock(&gs_PreparedBinariesMutex);
+
+    std::map<uint64_t, AgentPreparedBinary>::const_iterator binaryIt = gs_PreparedBinaries.find(kernelObject);
+
+    if (binaryIt != gs_PreparedBinaries.end())
     {
-        AGENT_ERROR("Input kernel name to Demangle function is empty");
-        return status;
+        preparedBinaryOut = binaryIt->second;
+        isFound = true;
     }
 
-    demangledNameOut.clear();
+    pthread_mutex_unlock(&gs_PreparedBinariesMutex);
 
-    // Just use the mangled kernel name if C++filt is not on system
-    // The below check for a non-zero is correct.
-    // if c++filt is not found, which will return some positive number
-    if (system("which c++filt > /dev/null 2>&1"))
+    return isFound;
+}
+
+void AgentForgetPreparedBinaries()
+{
+    pthread_mutex_lock(&gs_PreparedBinariesMutex);
+    gs_PreparedBinaries.clear();
+    pthread_mutex_unlock(&gs_PreparedBinariesMutex);
+}
+
+/// Check if the '<' or '>' at a position is part of an operator name, like "operator<<" or "operator->"
+/// \param[in]  demangledName The demangled name
+/// \param[in]  position      The position of the character
+/// \param[out] startOut      The position of the "operator" keyword
+/// \return true if the character belongs to an operator name
+static bool IsInOperatorName(const std::string& demangledName, const size_t position, size_t& startOut)
+{
+    static const char OPERATOR_KEYWORD[] = "operator";
+    static const size_t OPERATOR_KEYWORD_LEN = sizeof(OPERATOR_KEYWORD) - 1;
+
+    // Longest first, the demangler writes "operator><int>" for operator> with template arguments
+    static const char* const OPERATOR_NAMES[] = {"<<=", ">>=", "->*", "<=>", "<<", ">>", "<=", ">=", "->", "<", ">"};
+
+    // The operator names are at most 3 characters long
+    for (size_t offset = 0; offset < 3 && offset <= position; offset++)
     {
-        int err_no = errno;
-        AGENT_LOG("DemangleKernelName: errno of which c++filt: " << err_no
-                    << "errno: " << strerror(err_no));
+        const size_t nameStart = position - offset;
 
-        demangledNameOut.assign(ipKernelName);
-        AGENT_OP("c++filt could not be found in the PATH, kernel names will remain mangled");
-        status = HSAIL_AGENT_STATUS_SUCCESS;
-        return status;
+        if (nameStart < OPERATOR_KEYWORD_LEN ||
+            demangledName.compare(nameStart - OPERATOR_KEYWORD_LEN, OPERATOR_KEYWORD_LEN, OPERATOR_KEYWORD) != 0)
+        {
+            continue;
+        }
+
+        for (const char* pOperatorName : OPERATOR_NAMES)
+        {
+            const size_t nameLen = strlen(pOperatorName);
+
+            if (demangledName.compare(nameStart, nameLen, pOperatorName) == 0)
+            {
+                if (offset >= nameLen)
+                {
+                    return false;
+                }
+
+                startOut = nameStart - OPERATOR_KEYWORD_LEN;
+                return true;
+            }
+        }
+
+        return false;
     }
 
-    std::ofstream out(MANGLED_STRING_FILE, std::ofstream::out);
-    if (!out.is_open())
+    return false;
+}
+
+/// Reduce a demangled function name to the output of "c++filt -p":
+/// the parameter list, the cv and ref qualifiers and the return type
+/// of a function template are removed
+static void RemoveParameterList(std::string& demangledName)
+{
+    static const char* const QUALIFIERS[] = {" const", " volatile", " &&", " &"};
+
+    bool isQualifierRemoved = true;
+
+    while (isQualifierRemoved)
     {
-        AGENT_LOG("Mangled kernel file " << MANGLED_STRING_FILE << "could not be opened");
-        return status;
+        isQualifierRemoved = false;
+
+        for (const char* pQualifier : QUALIFIERS)
+        {
+            const size_t qualifierLen = strlen(pQualifier);
+
+            if (demangledName.size() > qualifierLen &&
+                demangledName.compare(demangledName.size() - qualifierLen, qualifierLen, pQualifier) == 0)
+            {
+                demangledName.erase(demangledName.size() - qualifierLen);
+                isQualifierRemoved = true;
+            }
+        }
     }
-    else
+
+    if (demangledName.empty() || demangledName[demangledName.size() - 1] != ')')
     {
-        std::string ipKernelNameWithUnderscore(ipKernelName);
+        return;
+    }
+
+    // Walk back to the parenthesis that opens the last group,
+    // nested parentheses belong to parameter types
+    int depth = 0;
 
-        // If there is no underscore in the beginning, add one and then call c++filt
-        // This is a work-around to a runtime issue where the first character of the
-        // mangled name is missing, based on name mangling conventions in C++
-        // the first 2 characters are _Z
-        if(ipKernelName[0] == 'Z')
+    for (size_t i = demangledName.size(); i > 0; i--)
+    {
+        char c = demangledName[i - 1];
+
+        if (c == ')')
         {
-            std::string::iterator it;
-            it = ipKernelNameWithUnderscore.insert(ipKernelNameWithUnderscore.begin(),'_');
+            depth++;
         }
+        else if (c == '(')
+        {
+            depth--;
 
-        AGENT_LOG("Kernel name passed to c++filt " << ipKernelNameWithUnderscore);
+            if (depth == 0)
+            {
+                demangledName.erase(i - 1);
+                break;
+            }
+        }
+    }
+
+    // Conversion operators, like "operator unsigned long", have no return type
+    // and their type may have spaces
+    const size_t conversionPos = demangledName.rfind("operator ");
 
-        out << ipKernelNameWithUnderscore;
-        out.close();
+    if (conversionPos != std::string::npos && (conversionPos == 0 || demangledName[conversionPos - 1] == ':'))
+    {
+        return;
+    }
 
-        std::stringstream demangleCommand;
-        // The -p option removes the parameter list from the demangled name
-        demangleCommand << "c++filt -p"<< " < " << MANGLED_STRING_FILE << " > " << DEMANGLED_STRING_FILE;
-        int retCode = system(demangleCommand.str().c_str());
-        int err_no = errno;
-        AGENT_LOG("DemangleKernelName: Return code: " << retCode << "errno: " << strerror(err_no));
+    // Only function templates have a return type, it ends at the last space
+    // outside of template arguments and parentheses
+    depth = 0;
 
+    for (size_t i = demangledName.size(); i > 0; i--)
+    {
+        char c = demangledName[i - 1];
+        size_t operatorStart = 0;
 
-        std::ifstream inputStream(DEMANGLED_STRING_FILE, std::ifstream::in);
-        if (inputStream.is_open())
+        if ((c == '<' || c == '>') && IsInOperatorName(demangledName, i - 1, operatorStart))
         {
-            getline(inputStream, demangledNameOut);
-            status = HSAIL_AGENT_STATUS_SUCCESS;
+            // Continue before the "operator" keyword
+            i = operatorStart + 1;
+        }
+        else if (c == ')' || c == '>')
+        {
+            depth++;
+        }
+        else if (c == '(' || c == '<')
+        {
+            depth--;
+        }
+        else if (c == ' ' && depth == 0 && i > 1 && IsInOperatorName(demangledName, i - 2, operatorStart))
+        {
+            // The space of "operator< <char>" comes before template arguments
+            i = operatorStart + 1;
+        }
+        else if (c == ' ' && depth == 0)
+        {
+            demangledName.erase(0, i);
+            break;
+        }
+    }
+}
 
-            AGENT_LOG("Demangled kernel name: " << demangledNameOut);
+/// Demangle the input kernel name
+HsailAgentStatus AgentBinary::DemangleKernelName(const std::string& ipKernelName,
+                                                       std::string& demangledNameOut)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (ipKernelName.empty())
+    {
+        AGENT_ERROR("Input kernel name to Demangle function is empty");
+        return status;
+    }
 
-            inputStream.close();
+    demangledNameOut.clear();
 
-            // Delete tmp files
-            AgentDeleteFile(MANGLED_STRING_FILE.c_str());
-            AgentDeleteFile(DEMANGLED_STRING_FILE.c_str());
-        }
+    std::string ipKernelNameWithUnderscore(ipKernelName);
+
+    // If there is no underscore in the beginning, add one and then demangle
+    // This is a work-around to a runtime issue where the first character of the
+    // mangled name is missing, based on name mangling conventions in C++
+    // the first 2 characters are _Z
+    // The fixed name is the key, so the name of the ELF symbol finds the same result
+    if(ipKernelName[0] == 'Z')
+    {
+        ipKernelNameWithUnderscore.insert(ipKernelNameWithUnderscore.begin(), '_');
+    }
+
+    pthread_mutex_lock(&gs_DemangledKernelNamesMutex);
+
+    std::map<std::string, std::string>::const_iterator nameIt = gs_DemangledKernelNames.find(ipKernelNameWithUnderscore);
+
+    if (nameIt != gs_DemangledKernelNames.end())
+    {
+        demangledNameOut.assign(nameIt->second);
+        pthread_mutex_unlock(&gs_DemangledKernelNamesMutex);
+
+        AGENT_LOG("Demangled kernel name (cached): " << demangledNameOut);
+
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+        return status;
     }
+
+    pthread_mutex_unlock(&gs_DemangledKernelNamesMutex);
+
+    AGENT_LOG("Kernel name passed to the demangler " << ipKernelNameWithUnderscore);
+
+    int demangleStatus = 0;
+    uint64_t demangleStartNs = AgentGetTimestampNs();
+    char* pDemangledName = abi::__cxa_demangle(ipKernelNameWithUnderscore.c_str(), nullptr, nullptr, &demangleStatus);
+    AgentRecordTime(AGENT_TIMER_DEMANGLE, demangleStartNs, 0);
+
+    if (demangleStatus == 0 && pDemangledName != nullptr)
+    {
+        demangledNameOut.assign(pDemangledName);
+        RemoveParameterList(demangledNameOut);
+    }
+    else
+    {
+        // Not a mangled name (a C or OpenCL kernel), used as it is like c++filt does
+        AGENT_LOG("DemangleKernelName: Demangler status " << demangleStatus << " for " << ipKernelNameWithUnderscore);
+        demangledNameOut.assign(ipKernelNameWithUnderscore);
+    }
+
+    free(pDemangledName);
+
+    AGENT_LOG("Demangled kernel name: " << demangledNameOut);
+
+    pthread_mutex_lock(&gs_DemangledKernelNamesMutex);
+    gs_DemangledKernelNames[ipKernelNameWithUnderscore] = demangledNameOut;
+    pthread_mutex_unlock(&gs_DemangledKernelNamesMutex);
+
+    status = HSAIL_AGENT_STATUS_SUCCESS;
     return status;
 }
 
 // Call the DBE and set up the buffer
-HsailAgentStatus AgentBinary::PopulateBinaryFromDBE(HwDbgContextHandle dbgContextHandle,
-                                                    const hsa_kernel_dispatch_packet_t* pAqlPacket)
+HsailAgentStatus AgentBinary::PopulateBinaryFromDBE(HwDbgContextHandle                  dbgContextHandle,
+                                                    const hsa_kernel_dispatch_packet_t* pAqlPacket,
+                                                    const AgentPreparedBinary*          pPreparedBinary)
 {
     AGENT_LOG("Initialize a new binary");
     assert(dbgContextHandle != nullptr);
@@ -209,6 +407,57 @@ HsailAgentStatus AgentBinary::PopulateBinaryFromDBE(HwDbgContextHandle dbgContex
         status = HSAIL_AGENT_STATUS_SUCCESS;
     }
 
+    m_kernelObject = (pAqlPacket != nullptr) ? pAqlPacket->kernel_object : 0;
+
+    // The binary of a kernel object does not change till its executable is destroyed,
+    // the hash is only computed for a kernel object that was not prepared before
+    if (pPreparedBinary != nullptr && pPreparedBinary->m_binarySize == m_binarySize)
+    {
+        m_binaryHash = pPreparedBinary->m_binaryHash;
+    }
+    else
+    {
+        m_binaryHash = AgentComputeBinaryHash(m_pBinary, m_binarySize);
+
+        if (m_kernelObject != 0)
+        {
+            AgentRecordPreparedBinary(m_kernelObject, m_binaryHash, m_binarySize);
+        }
+    }
+
+    m_isISAPublished = false;
+
+    // A gdb that asks for the ISA with HSAIL_COMMAND_GET_ISA gets it on demand,
+    // the binary is only disassembled if gdb asks for it
+    m_isISADeferred = m_enableISADisassemble &&
+                      AgentGetGdbProtocolVersion() >= HSAIL_FRAME_PROTOCOL_VERSION_LAZY_ISA;
+
+    if (m_isISADeferred)
+    {
+        AgentDeferISADisassembly(m_binaryHash, m_pBinary, m_binarySize);
+    }
+
+    // A kernel dispatched before does not need c++filt and the disassembler again
+    std::string cachedKernelName;
+    std::shared_ptr<const std::string> pCachedISAText;
+
+    if (m_pBinaryCache != nullptr && pAqlPacket != nullptr &&
+        m_pBinaryCache->Find(pAqlPacket->kernel_object, m_binaryHash, cachedKernelName, pCachedISAText) &&
+        (!m_enableISADisassemble || m_isISADeferred || pCachedISAText != nullptr))
+    {
+        m_kernelName.assign(cachedKernelName);
+
+        AGENT_LOG("PopulateBinaryFromDBE: Kernel Name found in the cache " << m_kernelName);
+
+        // The ISA dump file is only written when gdb takes control, see PublishISA
+        if (m_enableISADisassemble && !m_isISADeferred && pCachedISAText != nullptr)
+        {
+            m_pIsaBuffer->PopulateISAFromText(*pCachedISAText);
+        }
+
+        return status;
+    }
+
     // get the kernel name for the active dispatch
     std::string demangledKernelName;
     const char* pMangledKernelName(nullptr);
@@ -235,9 +484,67 @@ HsailAgentStatus AgentBinary::PopulateBinaryFromDBE(HwDbgContextHandle dbgContex
 
     AGENT_LOG("PopulateBinaryFromDBE: Kernel Name found " << m_kernelName);
 
-    if (m_enableISADisassemble)
+    // The dispatch does not wait for the disassembler, PublishISA waits for the ISA
+    // if gdb takes control before a worker thread is done with it
+    if (m_enableISADisassemble && !m_isISADeferred)
+    {
+        AgentQueueISADisassembly(m_binaryHash, m_pBinary, m_binarySize);
+    }
+
+    // The ISA is added to the cache entry by PublishISA
+    if (m_pBinaryCache != nullptr && pAqlPacket != nullptr && status == HSAIL_AGENT_STATUS_SUCCESS)
     {
-        m_pIsaBuffer->PopulateISAFromCodeObj(m_binarySize, m_pBinary);
+        m_pBinaryCache->Add(pAqlPacket->kernel_object, m_binaryHash, m_kernelName, std::string());
+    }
+
+    return status;
+}
+
+HsailAgentStatus AgentBinary::PublishISA()
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    // gdb asks for a deferred ISA with HSAIL_COMMAND_GET_ISA
+    if (!m_enableISADisassemble || m_isISADeferred || m_isISAPublished)
+    {
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+        return status;
+    }
+
+    if (m_pIsaBuffer == nullptr)
+    {
+        AGENT_ERROR("PublishISA: The ISA buffer is nullptr");
+        return status;
+    }
+
+    if (m_pIsaBuffer->GetISAText().empty())
+    {
+        std::string isaText;
+
+        if (!AgentGetDisassembledISA(m_binaryHash, isaText))
+        {
+            AGENT_ERROR("PublishISA: No ISA for " << m_kernelName);
+            return status;
+        }
+
+        status = m_pIsaBuffer->PopulateISAFromText(isaText);
+
+        if (status != HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            return status;
+        }
+
+        if (m_pBinaryCache != nullptr && m_kernelObject != 0)
+        {
+            m_pBinaryCache->Add(m_kernelObject, m_binaryHash, m_kernelName, isaText);
+        }
+    }
+
+    status = m_pIsaBuffer->WriteToISADumpFile();
+
+    if (status == HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        m_isISAPublished = true;
     }
 
     return status;
@@ -248,11 +555,17 @@ const std::string AgentBinary::GetKernelName()const
     return m_kernelName;
 }
 
+uint64_t AgentBinary::GetBinaryHash() const
+{
+    return m_binaryHash;
+}
+
 /// Validate parameters of the binary, write the binary to shmem
 /// and let gdb know we have a new binary
 HsailAgentStatus AgentBinary::NotifyGDB(const hsa_kernel_dispatch_packet_t* pAqlPacket,
                                         const uint64_t                      queueID,
-                                        const uint64_t                      packetID) const
+                                        const uint64_t                      packetID,
+                                        const bool                          isBinaryKnownToGdb) const
 {
 
     HsailAgentStatus status;
@@ -263,6 +576,26 @@ HsailAgentStatus AgentBinary::NotifyGDB(const hsa_kernel_dispatch_packet_t* pAql
         AGENT_LOG("NotifyGDB: Kernel name may not have not been populated");
     }
 
+    // A gdb that keeps the binaries it received only needs the hash,
+    // the code object shared mem is left as it is
+    if (isBinaryKnownToGdb &&
+        AgentGetGdbProtocolVersion() >= HSAIL_FRAME_PROTOCOL_VERSION_REUSE_BINARY)
+    {
+        status = AgentNotifyReuseBinary(m_binarySize,
+                                        m_binaryHash,
+                                        m_kernelName,
+                                        pAqlPacket,
+                                        queueID,
+                                        packetID);
+
+        if (HSAIL_AGENT_STATUS_FAILURE == status)
+        {
+            AGENT_ERROR("NotifyGDB: Couldnt not notify gdb");
+        }
+
+        return status;
+    }
+
     // Call function in AgentNotify
     // Let gdb know we have a new binary
     status = WriteBinaryToSharedMem();
@@ -274,6 +607,7 @@ HsailAgentStatus AgentBinary::NotifyGDB(const hsa_kernel_dispatch_packet_t* pAql
     }
 
     status = AgentNotifyNewBinary(m_binarySize,
+                                  m_binaryHash,
                                   m_kernelName,
                                   pAqlPacket,
                                   queueID,
@@ -303,66 +637,34 @@ HsailAgentStatus AgentBinary::WriteBinaryToSharedMem() const
         return status;
     }
 
-    if (m_binarySize > m_codeObjBufferMaxSize)
+    if (m_pSharedMemRegistry == nullptr)
     {
-        AGENT_ERROR("WriteBinaryToShmem: Error Binary is larger than the shared mem allocated");
+        AGENT_ERROR("WriteBinaryToShmem: The shared mem registry is nullptr");
         return status;
     }
 
-    // The shared mem segment needs place for a size_t value and the binary
-    if ((m_binarySize + sizeof(size_t)) > m_codeObjBufferMaxSize)
-    {
-        AGENT_ERROR("WriteBinaryToShmem: Binary size is too big");
-        return status;
-    }
+    AGENT_LOG("DBE Code object size: " << m_binarySize);
 
-    // Get the pointer to the shmem segment
-    void* pShm = AgentMapSharedMemBuffer(m_codeObjBufferShmKey, m_codeObjBufferMaxSize);
+    // The shared mem region grows if the binary does not fit
+    void* pPayload = m_pSharedMemRegistry->BeginRegionUpdate(HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM, m_binarySize);
 
-    if (pShm == (int*) - 1)
+    if (pPayload == nullptr)
     {
-        AGENT_ERROR("WriteBinaryToShmem: Error with AgentMapSharedMemBuffer");
+        AGENT_ERROR("WriteBinaryToShmem: Could not make room for a binary of " << m_binarySize << " bytes");
+        status = HSAIL_AGENT_STATUS_FAILURE;
         return status;
     }
 
-    // Clear the memory fist
-    memset(pShm, 0, m_codeObjBufferMaxSize);
-
-    // Write the size first
-    size_t* pShmSizeLocation = (size_t*)pShm;
-    pShmSizeLocation[0] = m_binarySize;
-
-    AGENT_LOG("DBE Code object size: " << pShmSizeLocation[0]);
-
-    // Write the binary after the size_t info
-    void* pShmBinaryLocation = (size_t*)pShm + 1;
-    if (m_binarySize < m_codeObjBufferMaxSize)
-    {
-        // Copy the binary
-        memcpy(pShmBinaryLocation, m_pBinary, m_binarySize);
-    }
-    else
-    {
-        AGENT_WARNING("WriteBinaryToSharedMem: Did not copy code object to shared memory");
-        AGENT_WARNING("Binary Size is =" << pShmSizeLocation[0] <<
-                      " but shared memory size = " << m_codeObjBufferMaxSize << "bytes");
-    }
-
-    //printf("Debug OP");
-    //for(int i = 0; i<10;i++)
-    //{
-    //    printf("%d \t %d\n",i,*((int*)pShmBinaryLocation + i));
-    //}
-
-    // Detach shared memory
-    status = AgentUnMapSharedMemBuffer(pShm);
+    memcpy(pPayload, m_pBinary, m_binarySize);
 
+    status = m_pSharedMemRegistry->EndRegionUpdate(HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM, m_binarySize);
     if (status != HSAIL_AGENT_STATUS_SUCCESS)
     {
-        AGENT_ERROR("WriteBinaryToShmem: Error with AgentUnMapSharedMemBuffer");
+        AGENT_ERROR("WriteBinaryToShmem: Could not publish the binary");
         return status;
     }
 
+    status = HSAIL_AGENT_STATUS_SUCCESS;
     return status;
 }
 
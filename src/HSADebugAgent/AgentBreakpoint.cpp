@@ -95,50 +95,39 @@ void AgentBreakpoint::PrintHitMessage() const
     return;
 }
 
-// Find an empty slot in the payload, and save the hitcount and gdb id
-HsailAgentStatus AgentBreakpoint::UpdateNotificationPayload(HsailNotificationPayload* pNotify) const
+// Find this breakpoint's entry in the report, or add one, and save the hitcount and gdb id
+HsailAgentStatus AgentBreakpoint::UpdateHitRecords(std::vector<HsailBreakpointHitRecord>* pHits) const
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
 
-    if (pNotify == nullptr)
+    if (pHits == nullptr)
     {
-        AGENT_ERROR("UpdateNotificationPayload: Notification structure is nullptr");
+        AGENT_ERROR("UpdateHitRecords: Hit report is nullptr");
         return status;
-
     }
 
-    if (pNotify->m_Notification != HSAIL_NOTIFY_BREAKPOINT_HIT)
+    if (m_GdbId.empty())
     {
-        AGENT_ERROR("UpdateNotificationPayload: Invalid type, expect breakpoint hit payload");
+        AGENT_ERROR("UpdateHitRecords: The breakpoint has no gdb ID");
         return status;
     }
 
-    bool posFound = false;
-    unsigned int pos = 0;
-
-    for (pos = 0; pos < HSAIL_MAX_REPORTABLE_BREAKPOINTS; pos++)
+    for (HsailBreakpointHitRecord& hit : *pHits)
     {
-        // If this is an empty slot or my slot, that'll work
-        if (pNotify->payload.BreakpointHit.m_breakpointId[pos] == -1 ||
-            pNotify->payload.BreakpointHit.m_breakpointId[pos] == m_GdbId.at(0))
+        if (hit.m_breakpointId == m_GdbId.at(0))
         {
-            posFound = true;
-            break;
+            hit.m_hitCount = m_hitcount;
+            status = HSAIL_AGENT_STATUS_SUCCESS;
+            return status;
         }
     }
 
-    if (posFound)
-    {
-        pNotify->payload.BreakpointHit.m_breakpointId[pos] = m_GdbId.at(0);
-        pNotify->payload.BreakpointHit.m_hitCount[pos] = m_hitcount;
-        status = HSAIL_AGENT_STATUS_SUCCESS;
-    }
-    else
-    {
-        AGENT_ERROR("An empty slot could not be found in the Notification payload");
-        status = HSAIL_AGENT_STATUS_FAILURE;
-    }
+    HsailBreakpointHitRecord hit;
+    hit.m_breakpointId = m_GdbId.at(0);
+    hit.m_hitCount = m_hitcount;
+    pHits->push_back(hit);
 
+    status = HSAIL_AGENT_STATUS_SUCCESS;
     return status;
 }
 
@@ -5,6 +5,7 @@
 /// \file
 /// \brief The breakpoint manager class
 //==============================================================================
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 #include <cstring>
@@ -23,6 +24,7 @@
 
 #include "AgentLogging.h"
 #include "AgentNotifyGdb.h"
+#include "AgentSharedMemRegistry.h"
 #include "AgentUtils.h"
 #include "CommunicationControl.h"
 #include "HSADebugAgent.h"
@@ -30,27 +32,16 @@
 namespace HwDbgAgent
 {
 
-/// Construct a breakpoint manager, also allocate the shared memory needed for momentary breakpoints
-AgentBreakpointManager::AgentBreakpointManager():
+/// Construct a breakpoint manager, the shared memory needed for momentary breakpoints
+/// is owned by the agent context's shared memory registry
+AgentBreakpointManager::AgentBreakpointManager(AgentSharedMemRegistry* pSharedMemRegistry):
     m_kernelSourceFilename("temp_source"),
-    m_momentaryBPShmKey(-1),
-    m_momentaryBPShmMaxSize(0)
+    m_pSharedMemRegistry(pSharedMemRegistry),
+    m_breakpointPCIndex(),
+    m_momentaryPCIndex(),
+    m_isPCIndexStale(true)
 {
-    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
-    status = GetActiveAgentConfig()->GetConfigShmKey(HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM, m_momentaryBPShmKey);
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
-    {
-        AGENT_ERROR("Could not get shared mem key");
-    }
-
-    status = GetActiveAgentConfig()->GetConfigShmSize(HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM, m_momentaryBPShmMaxSize);
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
-    {
-        AGENT_ERROR("Could not get shared mem max size");
-    }
-
-    status = AllocateMomentaryBPBuffer();
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    if (m_pSharedMemRegistry == nullptr)
     {
         AGENT_ERROR("Could not initialize the shared mem buffer for momentary BP");
     }
@@ -111,6 +102,79 @@ bool AgentBreakpointManager::GetBreakpointFromGDBId(const GdbBkptId ipId,
 }
 
 
+bool AgentBreakpointManager::IsPCIndexEntryBefore(const PCIndexEntry& lhs, const PCIndexEntry& rhs)
+{
+    if (lhs.m_pc != rhs.m_pc)
+    {
+        return lhs.m_pc < rhs.m_pc;
+    }
+
+    return lhs.m_position < rhs.m_position;
+}
+
+void AgentBreakpointManager::BuildPCIndex(const std::vector<AgentBreakpoint*>& breakpoints,
+                                          std::vector<PCIndexEntry>&           indexOut)
+{
+    indexOut.clear();
+    indexOut.reserve(breakpoints.size());
+
+    for (unsigned int i = 0; i < breakpoints.size(); i++)
+    {
+        // We should not have any nullptr elements in the vector, IsPCExists reports them
+        if (breakpoints[i] != nullptr)
+        {
+            PCIndexEntry entry;
+            entry.m_pc = breakpoints[i]->m_pc;
+            entry.m_position = static_cast<int>(i);
+            indexOut.push_back(entry);
+        }
+    }
+
+    std::sort(indexOut.begin(), indexOut.end(), IsPCIndexEntryBefore);
+}
+
+void AgentBreakpointManager::UpdatePCIndex() const
+{
+    if (m_isPCIndexStale)
+    {
+        BuildPCIndex(m_pBreakpoints, m_breakpointPCIndex);
+        BuildPCIndex(m_pMomentaryBreakpoints, m_momentaryPCIndex);
+        m_isPCIndexStale = false;
+    }
+}
+
+size_t AgentBreakpointManager::FindFirstPCIndexEntry(const std::vector<PCIndexEntry>& index,
+                                                     const HwDbgCodeAddress           pc)
+{
+    if (index.empty())
+    {
+        return 0;
+    }
+
+    // The entries of a PC are in the order of the breakpoint vector,
+    // so the first match is the one a scan of the vector would find.
+    // The search halves the range without a branch on the comparison,
+    // the PCs of the waves are too random for the branch predictor
+    const PCIndexEntry* pFirst = index.data();
+    size_t count = index.size();
+
+    while (count > 1)
+    {
+        const size_t half = count / 2;
+        pFirst = (pFirst[half].m_pc < pc) ? pFirst + half : pFirst;
+        count -= half;
+    }
+
+    const size_t position = static_cast<size_t>(pFirst - index.data()) + ((pFirst->m_pc < pc) ? 1 : 0);
+
+    if (position == index.size() || index[position].m_pc != pc)
+    {
+        return index.size();
+    }
+
+    return position;
+}
+
 /// Get the position of the breakpoint which includes this PC
 /// \todo maybe template the function GetBreakpointFrom* ?
 /// pBreakpointPosOut -1 if the breakpoint does not exist or is disabled
@@ -129,24 +193,21 @@ bool AgentBreakpointManager::GetBreakpointFromPC(const HwDbgCodeAddress pc,
         return retVal;
     }
 
-    bool pcbpFound = false;
-    unsigned int bpCount = (unsigned int)m_pBreakpoints.size();
+    UpdatePCIndex();
 
-    for (unsigned int i = 0; i < bpCount; i++)
+    for (size_t i = FindFirstPCIndexEntry(m_breakpointPCIndex, pc);
+         i < m_breakpointPCIndex.size() && m_breakpointPCIndex[i].m_pc == pc;
+         i++)
     {
-        AgentBreakpoint* pCurrentBP = m_pBreakpoints.at(i);
+        AgentBreakpoint* pCurrentBP = m_pBreakpoints.at(m_breakpointPCIndex[i].m_position);
 
-        if (pCurrentBP->m_pc == pc)
+        // It should be enabled, otherwise something is very wrong
+        if (pCurrentBP->m_bpState == HSAIL_BREAKPOINT_STATE_ENABLED ||
+            pCurrentBP->m_bpState == HSAIL_BREAKPOINT_STATE_PENDING)
         {
-            // It should be enabled, otherwise something is very wrong
-            if (pCurrentBP->m_bpState == HSAIL_BREAKPOINT_STATE_ENABLED ||
-                pCurrentBP->m_bpState == HSAIL_BREAKPOINT_STATE_PENDING)
-            {
-                bpIndex = i;
-                retVal = true;
-                pcbpFound = true;
-                break;
-            }
+            bpIndex = m_breakpointPCIndex[i].m_position;
+            retVal = true;
+            break;
         }
     }
 
@@ -154,28 +215,19 @@ bool AgentBreakpointManager::GetBreakpointFromPC(const HwDbgCodeAddress pc,
 
     if (!retVal)
     {
-        unsigned int momentaryBPCount = (unsigned int)m_pMomentaryBreakpoints.size();
+        size_t momentaryIndexPos = FindFirstPCIndexEntry(m_momentaryPCIndex, pc);
 
-        for (unsigned int i = 0; i < momentaryBPCount; i++)
+        if (momentaryIndexPos < m_momentaryPCIndex.size())
         {
-            AgentBreakpoint* pCurrentBP = m_pMomentaryBreakpoints.at(i);
-
-            if (pCurrentBP->m_pc == pc)
-            {
-                // Found the breakpoint:
-                bpMomentary = true;
-                bpIndex = i;
-                retVal = true;
-                break;
-            }
+            // Found the breakpoint:
+            bpMomentary = true;
+            bpIndex = m_momentaryPCIndex[momentaryIndexPos].m_position;
+            retVal = true;
         }
     }
 
-    if (!pcbpFound && !bpMomentary)
-    {
-        AGENT_LOG("AgentBreakpointManager:GetBreakpointForPC, Couldnt find a mometary bp or a source pc");
-    }
-
+    // A miss is not logged, the PC of every active wave is looked up at a stop
+    // and a wave does not need to be at a breakpoint
     *pBreakpointPosOut = bpIndex;
     *pMomentaryBreakpointOut = bpMomentary;
 
@@ -187,29 +239,27 @@ bool AgentBreakpointManager::IsPCExists(const HwDbgCodeAddress inputPC,
 {
     bool retCode = false;
 
-    for (unsigned int i = 0; i < m_pBreakpoints.size(); i++)
-    {
-        AgentBreakpoint* bp = m_pBreakpoints.at(i);
+    UpdatePCIndex();
 
-        if (bp != nullptr)
-        {
-            if (bp->m_type == HSAIL_BREAKPOINT_TYPE_PC_BP)
-            {
-                if (bp->m_pc == inputPC)
-                {
+    if (m_breakpointPCIndex.size() != m_pBreakpoints.size())
+    {
+        // We should not have any nullptr elements in the vector, since when we free
+        // the AgentBreakpoint, we also remove it from m_pBreakpoints
+        AGENT_ERROR("IsPCDuplicate: bp was nullptr");
+    }
 
-                    duplicatePosition = i;
+    for (size_t i = FindFirstPCIndexEntry(m_breakpointPCIndex, inputPC);
+         i < m_breakpointPCIndex.size() && m_breakpointPCIndex[i].m_pc == inputPC;
+         i++)
+    {
+        AgentBreakpoint* bp = m_pBreakpoints.at(m_breakpointPCIndex[i].m_position);
 
-                    retCode = true;
-                    break;
-                }
-            }
-        }
-        else
+        if (bp->m_type == HSAIL_BREAKPOINT_TYPE_PC_BP)
         {
-            // We should not have any nullptr elements in the vector, since when we free
-            // the AgentBreakpoint, we also remove it from m_pBreakpoints
-            AGENT_ERROR("IsPCDuplicate: bp was nullptr");
+            duplicatePosition = m_breakpointPCIndex[i].m_position;
+
+            retCode = true;
+            break;
         }
     }
 
@@ -223,35 +273,25 @@ bool AgentBreakpointManager::IsPCBreakpoint(const HwDbgCodeAddress pc) const
 
     if (HSAIL_ISA_PC_UNKOWN != pc)
     {
-        unsigned int bpCount = (unsigned int)m_pBreakpoints.size();
+        UpdatePCIndex();
 
-        for (unsigned int i = 0; i < bpCount; i++)
+        size_t indexPos = FindFirstPCIndexEntry(m_breakpointPCIndex, pc);
+
+        // This logic assumes that each PC will be unique to a breakpoint
+        // That means that once a breakpoint is disabled, the PC should not be hit by the DBE
+        // Only the first breakpoint at the PC is checked since something is logically wrong otherwise
+        if (indexPos < m_breakpointPCIndex.size())
         {
-            AgentBreakpoint* pCurrentBP = m_pBreakpoints.at(i);
+            const AgentBreakpoint* pCurrentBP = m_pBreakpoints.at(m_breakpointPCIndex[indexPos].m_position);
 
-            if (pCurrentBP->m_pc == pc)
-            {
-                // It should be enabled, otherwise something is very wrong
-                if (pCurrentBP->m_bpState == HSAIL_BREAKPOINT_STATE_ENABLED)
-                {
-                    retVal = true;
-                    break;
-                }
-                else
-                {
-                    // This logic assumes that each PC will be unique to a breakpoint
-                    // That means that once a breakpoint is disabled, the PC should not be hit by the DBE
-                    // We exit this loop if this happens since something is logically wrong here
-                    break;
-                }
-            }
+            // It should be enabled, otherwise something is very wrong
+            retVal = (pCurrentBP->m_bpState == HSAIL_BREAKPOINT_STATE_ENABLED);
         }
     }
 
     return retVal;
 }
 
-
 bool AgentBreakpointManager::IsDuplicatesPresent(const HwDbgContextHandle  dbeContextHandle,
                                                  const HsailCommandPacket& ipPacket,
                                                  const HsailBkptType       ipType)
@@ -306,6 +346,7 @@ bool AgentBreakpointManager::IsDuplicatesPresent(const HwDbgContextHandle  dbeCo
             // where the segment is loaded when a new AQL packet is dispatched.
 
             m_pBreakpoints.at(duplicatePosition)->m_pc = ipPacket.m_pc;
+            m_isPCIndexStale = true;
             m_pBreakpoints.at(duplicatePosition)->CreateBreakpointDBE(dbeContextHandle,
                                                                      ipPacket.m_gdbBreakpointID);
             isDuplicatePresent = true;
@@ -422,6 +463,7 @@ HsailAgentStatus AgentBreakpointManager::CreateBreakpoint(const HwDbgContextHand
     if (status == HSAIL_AGENT_STATUS_SUCCESS)
     {
         m_pBreakpoints.push_back(pBkpt);
+        m_isPCIndexStale = true;
     }
     else
     {
@@ -471,6 +513,7 @@ HsailAgentStatus AgentBreakpointManager::ClearBreakpointVectors()
     }
 
     m_pMomentaryBreakpoints.clear();
+    m_isPCIndexStale = true;
     return status;
 }
 
@@ -546,6 +589,7 @@ HsailAgentStatus AgentBreakpointManager::DeleteBreakpoint(const HwDbgContextHand
     {
         delete m_pBreakpoints.at(breakpointpos);
         m_pBreakpoints.erase(m_pBreakpoints.begin() + breakpointpos);
+        m_isPCIndexStale = true;
     }
     else
     {
@@ -869,26 +913,6 @@ HsailAgentStatus AgentBreakpointManager::EnablePCBreakpoint(const HwDbgContextHa
 }
 
 
-/// Allocate the shared mem for the momentary breakpoints
-HsailAgentStatus AgentBreakpointManager::AllocateMomentaryBPBuffer() const
-{
-    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
-
-    status = AgentAllocSharedMemBuffer(m_momentaryBPShmKey, m_momentaryBPShmMaxSize);
-
-    return status;
-}
-
-/// Free the shared mem for the momentary breakpoints
-HsailAgentStatus AgentBreakpointManager::FreeMomentaryBPBuffer() const
-{
-    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
-
-    status = AgentFreeSharedMemBuffer(m_momentaryBPShmKey, m_momentaryBPShmMaxSize);
-    return status;
-
-}
-
 /// Create a momentary breakpoint
 HsailAgentStatus AgentBreakpointManager::CreateMomentaryBreakpoints(const HwDbgContextHandle DbeContextHandle,
                                                                     const HsailCommandPacket ipPacket)
@@ -903,8 +927,21 @@ HsailAgentStatus AgentBreakpointManager::CreateMomentaryBreakpoints(const HwDbgC
     int numMomentaryBp = 0;
     numMomentaryBp = ipPacket.m_numMomentaryBP;
 
+    if (m_pSharedMemRegistry == nullptr)
+    {
+        AGENT_ERROR("MomentaryBreakpoint: The shared mem registry is nullptr");
+        return status;
+    }
+
+    // gdb grows the region when the momentary breakpoints do not fit
+    if (m_pSharedMemRegistry->RefreshRegion(HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM) != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("MomentaryBreakpoint: Could not map the momentary breakpoints written by gdb");
+        return status;
+    }
+
     HsailMomentaryBP* pMomentaryBP = nullptr;
-    pMomentaryBP = (HsailMomentaryBP*)AgentMapSharedMemBuffer(m_momentaryBPShmKey, m_momentaryBPShmMaxSize);
+    pMomentaryBP = (HsailMomentaryBP*)m_pSharedMemRegistry->GetRegion(HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM);
 
     if (pMomentaryBP == nullptr)
     {
@@ -912,6 +949,14 @@ HsailAgentStatus AgentBreakpointManager::CreateMomentaryBreakpoints(const HwDbgC
         return status;
     }
 
+    if (numMomentaryBp < 0 ||
+        sizeof(HsailMomentaryBP)*numMomentaryBp >
+        m_pSharedMemRegistry->GetRegionSize(HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM))
+    {
+        AGENT_ERROR("MomentaryBreakpoint: Invalid number of momentary breakpoints " << numMomentaryBp);
+        return status;
+    }
+
     AGENT_LOG("MomentaryBreakpoint: Create " << numMomentaryBp << " momentary breakpoints");
 
     for (int i = 0; i < numMomentaryBp; i++)
@@ -950,6 +995,7 @@ HsailAgentStatus AgentBreakpointManager::CreateMomentaryBreakpoints(const HwDbgC
         if (status == HSAIL_AGENT_STATUS_SUCCESS)
         {
             m_pMomentaryBreakpoints.push_back(pBkpt);
+            m_isPCIndexStale = true;
         }
         else
         {
@@ -960,7 +1006,7 @@ HsailAgentStatus AgentBreakpointManager::CreateMomentaryBreakpoints(const HwDbgC
     // Clear memory after we are done
     memset(pMomentaryBP, 0, sizeof(HsailMomentaryBP)*numMomentaryBp);
 
-    status = AgentUnMapSharedMemBuffer((void*)pMomentaryBP);
+    status = HSAIL_AGENT_STATUS_SUCCESS;
     return status;
 }
 
@@ -996,6 +1042,7 @@ HsailAgentStatus AgentBreakpointManager::ClearMomentaryBreakpoints(const HwDbgCo
     }
 
     m_pMomentaryBreakpoints.clear();
+    m_isPCIndexStale = true;
 
     return (0 == failureCount) ? HSAIL_AGENT_STATUS_SUCCESS : HSAIL_AGENT_STATUS_FAILURE;
 }
@@ -1045,6 +1092,57 @@ int AgentBreakpointManager::GetNumBreakpointsInState(const HsailBkptState ipStat
     return count;
 }
 
+bool AgentBreakpointManager::HasActiveBreakpoints() const
+{
+    return (GetNumBreakpointsInState(HSAIL_BREAKPOINT_STATE_ENABLED) > 0 ||
+            GetNumBreakpointsInState(HSAIL_BREAKPOINT_STATE_PENDING) > 0 ||
+            GetNumMomentaryBreakpointsInState(HSAIL_BREAKPOINT_STATE_ENABLED) > 0 ||
+            GetNumMomentaryBreakpointsInState(HSAIL_BREAKPOINT_STATE_PENDING) > 0);
+}
+
+void AgentBreakpointManager::GetActiveBreakpoints(std::vector<HwDbgCodeAddress>& pcsOut,
+                                                  std::vector<std::string>&      kernelNamesOut) const
+{
+    pcsOut.clear();
+    kernelNamesOut.clear();
+
+    for (size_t i = 0; i < m_pBreakpoints.size(); i++)
+    {
+        const AgentBreakpoint* pCurrentBP = m_pBreakpoints[i];
+
+        if (pCurrentBP == nullptr ||
+            (pCurrentBP->m_bpState != HSAIL_BREAKPOINT_STATE_ENABLED &&
+             pCurrentBP->m_bpState != HSAIL_BREAKPOINT_STATE_PENDING))
+        {
+            continue;
+        }
+
+        if (pCurrentBP->m_type == HSAIL_BREAKPOINT_TYPE_KERNEL_NAME_BP)
+        {
+            kernelNamesOut.push_back(pCurrentBP->m_kernelName);
+        }
+        else if (pCurrentBP->m_pc != HSAIL_ISA_PC_UNKOWN)
+        {
+            pcsOut.push_back(pCurrentBP->m_pc);
+        }
+    }
+
+    for (size_t i = 0; i < m_pMomentaryBreakpoints.size(); i++)
+    {
+        const AgentBreakpoint* pCurrentBP = m_pMomentaryBreakpoints[i];
+
+        if (pCurrentBP != nullptr &&
+            (pCurrentBP->m_bpState == HSAIL_BREAKPOINT_STATE_ENABLED ||
+             pCurrentBP->m_bpState == HSAIL_BREAKPOINT_STATE_PENDING))
+        {
+            pcsOut.push_back(pCurrentBP->m_pc);
+        }
+    }
+
+    std::sort(pcsOut.begin(), pcsOut.end());
+    std::sort(kernelNamesOut.begin(), kernelNamesOut.end());
+}
+
 // Check for kernel name breakpoints:
 // Return true if any breakpoints kernel name matches input kernel name argument
 bool AgentBreakpointManager::CheckAgainstKernelNameBreakpoints(const std::string& kernelName, int* pBpPositionOut) const
@@ -1270,18 +1368,8 @@ HsailAgentStatus AgentBreakpointManager::UpdateBreakpointStatistics(const HwDbgE
         return status;
     }
 
-    // Build a notification payload to tell gdb about what breakpoints were hit
-    HsailNotificationPayload notifyPayload;
-    memset(&notifyPayload, 0, sizeof(HsailNotificationPayload));
-
-    notifyPayload.m_Notification = HSAIL_NOTIFY_BREAKPOINT_HIT;
-    notifyPayload.payload.BreakpointHit.m_numActiveWaves = nWaves;
-
-    // Clear memory so that we know which breakpoints were updated
-    for (size_t i = 0; i < HSAIL_MAX_REPORTABLE_BREAKPOINTS; i++)
-    {
-        notifyPayload.payload.BreakpointHit.m_breakpointId[i] = -1;
-    }
+    // Build a report to tell gdb about what breakpoints were hit
+    std::vector<HsailBreakpointHitRecord> hits;
 
     // A logic check, we should have atleast one valid breakpoint set
     bool checkSingleValidBreakpoint = false;
@@ -1309,12 +1397,12 @@ HsailAgentStatus AgentBreakpointManager::UpdateBreakpointStatistics(const HwDbgE
             // Momentary breakpoints are not GDB breakpoints:
             if (!isMomentary)
             {
-                // Save it to the payload
-                status = pHitBP->UpdateNotificationPayload(&notifyPayload);
+                // Save it to the report
+                status = pHitBP->UpdateHitRecords(&hits);
 
                 if (status != HSAIL_AGENT_STATUS_SUCCESS)
                 {
-                    AGENT_ERROR("Could not update notification payload");
+                    AGENT_ERROR("Could not update the breakpoint hit report");
                     AGENT_ERROR("Breakpoint statistics are not correct");
                     break;
                 }
@@ -1329,7 +1417,7 @@ HsailAgentStatus AgentBreakpointManager::UpdateBreakpointStatistics(const HwDbgE
         return status;
     }
 
-    status = AgentNotifyBreakpointHit(notifyPayload);
+    status = AgentNotifyBreakpointHit(static_cast<int>(nWaves), hits);
     return status;
 }
 
@@ -1369,28 +1457,18 @@ HsailAgentStatus AgentBreakpointManager::ReportFunctionBreakpoint(const std::str
 
     m_pBreakpoints.at(bpPosition)->m_hitcount += 1;
 
-    HsailNotificationPayload notifyPayload;
-    memset(&notifyPayload, 0, sizeof(HsailNotificationPayload));
-    notifyPayload.m_Notification = HSAIL_NOTIFY_BREAKPOINT_HIT;
+    std::vector<HsailBreakpointHitRecord> hits;
 
-    // 0 is valid here since we wont have any started waves yet.
-    notifyPayload.payload.BreakpointHit.m_numActiveWaves = 0;
-
-    // Clear memory so that we know which breakpoints were updated
-    for (size_t i = 0; i < HSAIL_MAX_REPORTABLE_BREAKPOINTS; i++)
-    {
-        notifyPayload.payload.BreakpointHit.m_breakpointId[i] = -1;
-    }
-
-    status = m_pBreakpoints.at(bpPosition)->UpdateNotificationPayload(&notifyPayload);
+    status = m_pBreakpoints.at(bpPosition)->UpdateHitRecords(&hits);
 
     if (status != HSAIL_AGENT_STATUS_SUCCESS)
     {
-        AGENT_ERROR("Could not update notification packet for function breakpoint");
+        AGENT_ERROR("Could not update the hit report for function breakpoint");
         return status;
     }
 
-    status = AgentNotifyBreakpointHit(notifyPayload);
+    // 0 is valid here since we wont have any started waves yet.
+    status = AgentNotifyBreakpointHit(0, hits);
     return status;
 
 }
@@ -1405,13 +1483,6 @@ AgentBreakpointManager::~AgentBreakpointManager()
         AGENT_ERROR("~AgentBreakpointManager: Could not clear breakpoint vectors");
     }
 
-    status = FreeMomentaryBPBuffer();
-
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
-    {
-        AGENT_ERROR("~AgentBreakpointManager: Could not free the shared mem buffer for momentary BP");
-    }
-
     AGENT_LOG("~AgentBreakpointManager: Free Breakpoint Manager");
     // What other cleanup is needed ?
 }
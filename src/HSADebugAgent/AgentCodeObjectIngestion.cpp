@@ -0,0 +1,385 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Preparation of the code objects of an executable when it is loaded
+//==============================================================================
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <libelf.h>
+#include <map>
+#include <pthread.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AMDGPUDebug.h"
+
+#include "AgentBinary.h"
+#include "AgentCodeObjectIngestion.h"
+#include "AgentFramedProtocol.h"
+#include "AgentISAWorker.h"
+#include "AgentKernelBinaryCache.h"
+#include "AgentKernelFilter.h"
+#include "AgentLogging.h"
+#include "AgentQueueContext.h"
+#include "AgentSegmentLoader.h"
+#include "AgentTiming.h"
+#include "AgentUtils.h"
+
+namespace HwDbgAgent
+{
+
+/// The ELF symbol type of a kernel in an AMD HSA code object (STT_AMDGPU_HSA_KERNEL)
+static const unsigned char gs_STT_AMDGPU_HSA_KERNEL = 10;
+
+static pthread_mutex_t gs_IngestionMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/// Signaled when an executable is queued or the thread has to stop
+static pthread_cond_t gs_IngestionCond = PTHREAD_COND_INITIALIZER;
+
+/// The frozen executables the thread has not started
+static std::deque<uint64_t> gs_IngestionQueue;
+
+static pthread_t gs_IngestionThread;
+static bool gs_IsIngestionStarted = false;
+static bool gs_IsIngestionStopping = false;
+
+/// The kernel binary cache of the agent context, only used by the ingestion thread
+static AgentKernelBinaryCache* gs_pIngestionBinaryCache = nullptr;
+
+/// The segment loader of the agent context, given the load map the ingestion thread queries
+static AgentSegmentLoader* gs_pIngestionSegmentLoader = nullptr;
+
+// Counters, only changed by the ingestion thread
+static uint64_t gs_NumExecutablesIngested = 0;
+static uint64_t gs_NumCodeObjectsIngested = 0;
+static uint64_t gs_NumKernelsIngested = 0;
+
+/// The ingestion can be turned off by setting ROCM_GDB_DISABLE_LOAD_INGESTION
+static bool IsLoadIngestionEnabled()
+{
+    static const bool s_isEnabled = (std::getenv("ROCM_GDB_DISABLE_LOAD_INGESTION") == nullptr);
+    return s_isEnabled;
+}
+
+/// The ISA is not prepared if ROCM_GDB_DISABLE_ISA_DISASSEMBLE is set, like in AgentBinary
+static bool IsISADisassemblyEnabled()
+{
+    static const bool s_isEnabled = (std::getenv("ROCM_GDB_DISABLE_ISA_DISASSEMBLE") == nullptr);
+    return s_isEnabled;
+}
+
+/// Get the name and the ELF virtual address of the kernel symbols of a code object
+/// \param[in]  pCodeObj        The code object
+/// \param[in]  codeObjSize     The size of the code object
+/// \param[out] kernelSymbolsOut The name and the value of every kernel symbol
+static void GetKernelSymbols(const char*                                      pCodeObj,
+                             const size_t                                     codeObjSize,
+                             std::vector<std::pair<std::string, uint64_t> >& kernelSymbolsOut)
+{
+    if (codeObjSize < sizeof(Elf64_Ehdr))
+    {
+        return;
+    }
+
+    const Elf64_Ehdr* pElfEhDr = reinterpret_cast<const Elf64_Ehdr*>(pCodeObj);
+
+    if (pElfEhDr->e_ident[EI_MAG0] != ELFMAG0 || pElfEhDr->e_ident[EI_MAG1] != ELFMAG1 ||
+        pElfEhDr->e_ident[EI_MAG2] != ELFMAG2 || pElfEhDr->e_ident[EI_MAG3] != ELFMAG3 ||
+        pElfEhDr->e_ident[EI_CLASS] != ELFCLASS64)
+    {
+        AGENT_LOG("GetKernelSymbols: The code object is not a 64 bit ELF");
+        return;
+    }
+
+    size_t shdrOffsetInBytes = static_cast<size_t>(pElfEhDr->e_shoff);
+    size_t numSections = static_cast<size_t>(pElfEhDr->e_shnum);
+
+    if (shdrOffsetInBytes > codeObjSize ||
+        numSections > (codeObjSize - shdrOffsetInBytes) / sizeof(Elf64_Shdr))
+    {
+        AGENT_ERROR("GetKernelSymbols: The section headers are not in the code object");
+        return;
+    }
+
+    const Elf64_Shdr* pShdrList = reinterpret_cast<const Elf64_Shdr*>(pCodeObj + shdrOffsetInBytes);
+
+    for (size_t i = 0; i < numSections; i++)
+    {
+        if (pShdrList[i].sh_type != SHT_SYMTAB || pShdrList[i].sh_link >= numSections)
+        {
+            continue;
+        }
+
+        const Elf64_Shdr& symtab = pShdrList[i];
+        const Elf64_Shdr& strtab = pShdrList[symtab.sh_link];
+
+        if (symtab.sh_offset > codeObjSize || symtab.sh_size > codeObjSize - symtab.sh_offset ||
+            strtab.sh_offset > codeObjSize || strtab.sh_size > codeObjSize - strtab.sh_offset)
+        {
+            AGENT_ERROR("GetKernelSymbols: The symbol table is not in the code object");
+            continue;
+        }
+
+        const Elf64_Sym* pSymbols = reinterpret_cast<const Elf64_Sym*>(pCodeObj + symtab.sh_offset);
+        size_t numSymbols = static_cast<size_t>(symtab.sh_size / sizeof(Elf64_Sym));
+
+        const char* pStrings = pCodeObj + strtab.sh_offset;
+        size_t stringsSize = static_cast<size_t>(strtab.sh_size);
+
+        for (size_t j = 0; j < numSymbols; j++)
+        {
+            if (ELF64_ST_TYPE(pSymbols[j].st_info) != gs_STT_AMDGPU_HSA_KERNEL ||
+                pSymbols[j].st_name >= stringsSize)
+            {
+                continue;
+            }
+
+            const char* pName = pStrings + pSymbols[j].st_name;
+            size_t nameLength = strnlen(pName, stringsSize - pSymbols[j].st_name);
+
+            kernelSymbolsOut.push_back(std::make_pair(std::string(pName, nameLength),
+                                                      static_cast<uint64_t>(pSymbols[j].st_value)));
+        }
+    }
+}
+
+/// Prepare a code object, the segments are the ones it is loaded in
+static void IngestCodeObject(const std::vector<const HwDbgLoaderSegmentDescriptor*>& segments)
+{
+    const char* pCodeObj = static_cast<const char*>(segments[0]->pCodeObjectStorageBase);
+    size_t codeObjSize = segments[0]->codeObjectStorageSize;
+
+    uint64_t binaryHash = AgentComputeBinaryHash(pCodeObj, codeObjSize);
+
+    // A gdb that asks for the ISA gets it from the deferred copy, a gdb that does not
+    // ask for it gets the code object queued. The first dispatch queues a deferred code object
+    // if gdb turns out to be an older one.
+    if (IsISADisassemblyEnabled())
+    {
+        uint32_t gdbProtocolVersion = AgentGetGdbProtocolVersion();
+
+        if (gdbProtocolVersion != 0 && gdbProtocolVersion < HSAIL_FRAME_PROTOCOL_VERSION_LAZY_ISA)
+        {
+            AgentQueueISADisassembly(binaryHash, pCodeObj, codeObjSize);
+        }
+        else
+        {
+            AgentDeferISADisassembly(binaryHash, pCodeObj, codeObjSize);
+        }
+    }
+
+    std::vector<std::pair<std::string, uint64_t> > kernelSymbols;
+    GetKernelSymbols(pCodeObj, codeObjSize, kernelSymbols);
+
+    // The ELF virtual address of every segment the code object is loaded in
+    std::vector<uint64_t> segmentElfVAs(segments.size());
+
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        segmentElfVAs[i] = AgentSegmentLoader::GetSegmentElfVA(*segments[i]);
+    }
+
+    for (size_t i = 0; i < kernelSymbols.size(); i++)
+    {
+        const uint64_t symbolVA = kernelSymbols[i].second;
+
+        // The kernel object is the loaded address of the kernel symbol
+        uint64_t kernelObject = 0;
+
+        for (size_t j = 0; j < segments.size(); j++)
+        {
+            if (symbolVA >= segmentElfVAs[j] && symbolVA - segmentElfVAs[j] < segments[j]->segmentSize)
+            {
+                kernelObject = reinterpret_cast<uint64_t>(segments[j]->pSegmentBase) + (symbolVA - segmentElfVAs[j]);
+                break;
+            }
+        }
+
+        if (kernelObject == 0)
+        {
+            AGENT_LOG("IngestCodeObject: Kernel " << kernelSymbols[i].first << " is not in a loaded segment");
+            continue;
+        }
+
+        std::string demangledKernelName;
+
+        if (AgentBinary::DemangleKernelName(kernelSymbols[i].first, demangledKernelName) != HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            continue;
+        }
+
+        AgentRecordKernelName(kernelObject, kernelSymbols[i].first);
+        AgentRecordKernelName(kernelObject, demangledKernelName);
+
+        if (gs_pIngestionBinaryCache != nullptr)
+        {
+            gs_pIngestionBinaryCache->AddKernelName(kernelObject, binaryHash, demangledKernelName);
+        }
+
+        // The first dispatch of the kernel does not hash the binary again
+        AgentRecordPreparedBinary(kernelObject, binaryHash, codeObjSize);
+
+        gs_NumKernelsIngested++;
+    }
+
+    gs_NumCodeObjectsIngested++;
+}
+
+/// Prepare the code objects of a frozen executable
+static void IngestExecutable(const uint64_t executable)
+{
+    std::vector<HwDbgLoaderSegmentDescriptor> loadedSegments;
+
+    // The DBE is queried by the holder of the debug engine only, the debug thread may be using it
+    AgentAcquireIdleDebugEngine();
+    const uint64_t generation = AgentGetLoadMapGeneration();
+    HsailAgentStatus status = AgentQueryLoadedSegments(loadedSegments);
+    AgentReleaseDebugEngine();
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("IngestExecutable: Could not get the loaded segments of executable " << executable);
+        return;
+    }
+
+    // The next dispatch applies this load map without querying the DBE
+    if (gs_pIngestionSegmentLoader != nullptr)
+    {
+        gs_pIngestionSegmentLoader->OfferLoadMap(generation, loadedSegments);
+    }
+
+    // The segments of the executable, by the code object they are loaded from
+    std::map<const void*, std::vector<const HwDbgLoaderSegmentDescriptor*> > codeObjectSegments;
+
+    for (size_t i = 0; i < loadedSegments.size(); i++)
+    {
+        const HwDbgLoaderSegmentDescriptor& segment = loadedSegments[i];
+
+        // Only a code object in memory can be read here
+        if (segment.executable == executable &&
+            segment.codeObjectStorageType == HWDBG_LOADER_CODE_OBJECT_STORAGE_TYPE_MEMORY &&
+            segment.pCodeObjectStorageBase != nullptr &&
+            segment.codeObjectStorageSize > 0)
+        {
+            codeObjectSegments[segment.pCodeObjectStorageBase].push_back(&segment);
+        }
+    }
+
+    std::map<const void*, std::vector<const HwDbgLoaderSegmentDescriptor*> >::const_iterator codeObjIt;
+
+    for (codeObjIt = codeObjectSegments.begin(); codeObjIt != codeObjectSegments.end(); ++codeObjIt)
+    {
+        IngestCodeObject(codeObjIt->second);
+    }
+
+    gs_NumExecutablesIngested++;
+}
+
+static void* IngestionThread(void* pArgs)
+{
+    pthread_mutex_lock(&gs_IngestionMutex);
+
+    while (!gs_IsIngestionStopping)
+    {
+        if (gs_IngestionQueue.empty())
+        {
+            pthread_cond_wait(&gs_IngestionCond, &gs_IngestionMutex);
+            continue;
+        }
+
+        uint64_t executable = gs_IngestionQueue.front();
+        gs_IngestionQueue.pop_front();
+
+        pthread_mutex_unlock(&gs_IngestionMutex);
+
+        uint64_t startNs = AgentGetTimestampNs();
+        IngestExecutable(executable);
+        AgentRecordTime(AGENT_TIMER_CODE_OBJECT_INGESTION, startNs, 0);
+
+        pthread_mutex_lock(&gs_IngestionMutex);
+    }
+
+    pthread_mutex_unlock(&gs_IngestionMutex);
+
+    return nullptr;
+}
+
+void AgentStartCodeObjectIngestion(AgentKernelBinaryCache* pBinaryCache, AgentSegmentLoader* pSegmentLoader)
+{
+    if (!IsLoadIngestionEnabled())
+    {
+        AGENT_LOG("AgentStartCodeObjectIngestion: Disabled by ROCM_GDB_DISABLE_LOAD_INGESTION");
+        return;
+    }
+
+    pthread_mutex_lock(&gs_IngestionMutex);
+
+    if (!gs_IsIngestionStarted)
+    {
+        gs_pIngestionBinaryCache = pBinaryCache;
+        gs_pIngestionSegmentLoader = pSegmentLoader;
+        gs_IsIngestionStopping = false;
+
+        int retCode = pthread_create(&gs_IngestionThread, nullptr, IngestionThread, nullptr);
+
+        if (retCode != 0)
+        {
+            AGENT_ERROR("AgentStartCodeObjectIngestion: Could not create the ingestion thread, " << strerror(retCode));
+        }
+        else
+        {
+            gs_IsIngestionStarted = true;
+        }
+    }
+
+    pthread_mutex_unlock(&gs_IngestionMutex);
+}
+
+void AgentIngestExecutable(const uint64_t executable)
+{
+    pthread_mutex_lock(&gs_IngestionMutex);
+
+    if (gs_IsIngestionStarted && !gs_IsIngestionStopping)
+    {
+        gs_IngestionQueue.push_back(executable);
+        pthread_cond_signal(&gs_IngestionCond);
+    }
+
+    pthread_mutex_unlock(&gs_IngestionMutex);
+}
+
+void AgentStopCodeObjectIngestion()
+{
+    pthread_mutex_lock(&gs_IngestionMutex);
+
+    if (!gs_IsIngestionStarted)
+    {
+        pthread_mutex_unlock(&gs_IngestionMutex);
+        return;
+    }
+
+    gs_IsIngestionStopping = true;
+    gs_IngestionQueue.clear();
+    pthread_cond_signal(&gs_IngestionCond);
+
+    pthread_mutex_unlock(&gs_IngestionMutex);
+
+    pthread_join(gs_IngestionThread, nullptr);
+
+    pthread_mutex_lock(&gs_IngestionMutex);
+    gs_IsIngestionStarted = false;
+    gs_pIngestionBinaryCache = nullptr;
+    gs_pIngestionSegmentLoader = nullptr;
+    pthread_mutex_unlock(&gs_IngestionMutex);
+
+    AGENT_LOG("Code object ingestion statistics: " <<
+              "Executables: " << gs_NumExecutablesIngested << "\t" <<
+              "Code objects: " << gs_NumCodeObjectsIngested << "\t" <<
+              "Kernels: " << gs_NumKernelsIngested);
+}
+
+} // End Namespace HwDbgAgent
@@ -5,7 +5,11 @@
 /// \file
 /// \brief Agent side Implementation of the Hsail-gdb configuration manager
 //==============================================================================
+#include <cstdlib>
 #include <fstream>
+#include <sstream>
+
+#include <unistd.h>
 
 #include "AgentConfiguration.h"
 #include "AgentLogging.h"
@@ -15,7 +19,8 @@ namespace HwDbgAgent
 {
 /// Constructor
 AgentConfiguration::AgentConfiguration():
-    m_configFileName("hsail-gdb.cfg")
+    m_configFileName("hsail-gdb.cfg"),
+    m_sessionID()
 {
     HsailAgentStatus status  = ConfigureAgent();
     if (status != HSAIL_AGENT_STATUS_SUCCESS)
@@ -79,6 +84,93 @@ HsailAgentStatus AgentConfiguration::GetConfigShmSize(const HsailDebugConfigPara
     return status;
 }
 
+const std::string& AgentConfiguration::GetSessionID() const
+{
+    return m_sessionID;
+}
+
+std::string AgentConfiguration::GetSessionFileName(const char* pBaseName) const
+{
+    std::string fileName(pBaseName);
+
+    if (!m_sessionID.empty())
+    {
+        fileName += "-" + m_sessionID;
+    }
+
+    return fileName;
+}
+
+std::string AgentConfiguration::GetSessionShmName(const int shmKey) const
+{
+    std::stringstream shmName;
+    shmName << gs_SharedRegionNamePrefix << "-";
+
+    if (m_sessionID.empty())
+    {
+        shmName << getpid();
+    }
+    else
+    {
+        shmName << m_sessionID;
+    }
+
+    shmName << "-" << shmKey;
+
+    return shmName.str();
+}
+
+void AgentConfiguration::ReadSessionID()
+{
+    m_sessionID.clear();
+
+    // This is set by the hsail-gdb build script, the same variable names the log files
+    const char* pSessionEnvVar = std::getenv("ROCM_GDB_DEBUG_SESSION_ID");
+
+    if (pSessionEnvVar == nullptr)
+    {
+        return;
+    }
+
+    m_sessionID.assign(pSessionEnvVar);
+
+    // The ID becomes part of file names, keep it to characters that are safe in a path
+    for (char& c : m_sessionID)
+    {
+        bool isSafe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                      (c >= '0' && c <= '9') || c == '.' || c == '_' || c == '-';
+
+        if (!isSafe)
+        {
+            c = '_';
+        }
+    }
+
+    if (!m_sessionID.empty())
+    {
+        AGENT_LOG("ReadSessionID: Debug session " << m_sessionID);
+    }
+}
+
+int AgentConfiguration::GetSessionShmKey(const int baseKey) const
+{
+    if (m_sessionID.empty())
+    {
+        return baseKey;
+    }
+
+    // FNV-1a, gdb computes the same key from the session ID
+    uint32_t hash = 2166136261u;
+
+    for (const char c : m_sessionID)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+
+    return baseKey | static_cast<int>((hash & 0x7FFF) << 16);
+}
+
 bool AgentConfiguration::ValidateFile() const
 {
     bool retCode = false;
@@ -91,25 +183,31 @@ bool AgentConfiguration::ReadDefaultConfiguration()
 {
     bool retCode = false;
 
+    ReadSessionID();
+
     m_configMap[HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM].paramType = HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM;
-    m_configMap[HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM].param.shmemParam.m_shmKey = g_DBEBINARY_SHMKEY;
-    m_configMap[HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM].param.shmemParam.m_maxSize = g_BINARY_BUFFER_MAXSIZE;
+    m_configMap[HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM].param.shmemParam.m_shmKey = GetSessionShmKey(g_DBEBINARY_SHMKEY);
+    m_configMap[HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM].param.shmemParam.m_maxSize = g_BINARY_BUFFER_INITIAL_SIZE;
 
     m_configMap[HSAIL_DEBUG_CONFIG_ISA_BUFFER_SHM].paramType = HSAIL_DEBUG_CONFIG_ISA_BUFFER_SHM;
-    m_configMap[HSAIL_DEBUG_CONFIG_ISA_BUFFER_SHM].param.shmemParam.m_shmKey = g_ISASTREAM_SHMKEY;
-    m_configMap[HSAIL_DEBUG_CONFIG_ISA_BUFFER_SHM].param.shmemParam.m_maxSize = g_ISASTREAM_MAXSIZE;
+    m_configMap[HSAIL_DEBUG_CONFIG_ISA_BUFFER_SHM].param.shmemParam.m_shmKey = GetSessionShmKey(g_ISASTREAM_SHMKEY);
+    m_configMap[HSAIL_DEBUG_CONFIG_ISA_BUFFER_SHM].param.shmemParam.m_maxSize = g_ISASTREAM_INITIAL_SIZE;
 
     m_configMap[HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM].paramType = HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM;
-    m_configMap[HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM].param.shmemParam.m_shmKey = g_MOMENTARY_BP_BUFFER_SHMKEY;
-    m_configMap[HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM].param.shmemParam.m_maxSize = g_MOMENTARY_BP_BUFFER_MAXSIZE;
+    m_configMap[HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM].param.shmemParam.m_shmKey = GetSessionShmKey(g_MOMENTARY_BP_BUFFER_SHMKEY);
+    m_configMap[HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM].param.shmemParam.m_maxSize = g_MOMENTARY_BP_BUFFER_INITIAL_SIZE;
 
     m_configMap[HSAIL_DEBUG_CONFIG_WAVE_INFO_SHM].paramType = HSAIL_DEBUG_CONFIG_WAVE_INFO_SHM;
-    m_configMap[HSAIL_DEBUG_CONFIG_WAVE_INFO_SHM].param.shmemParam.m_shmKey = g_WAVE_BUFFER_SHMKEY;
-    m_configMap[HSAIL_DEBUG_CONFIG_WAVE_INFO_SHM].param.shmemParam.m_maxSize = g_WAVE_BUFFER_MAXSIZE;
+    m_configMap[HSAIL_DEBUG_CONFIG_WAVE_INFO_SHM].param.shmemParam.m_shmKey = GetSessionShmKey(g_WAVE_BUFFER_SHMKEY);
+    m_configMap[HSAIL_DEBUG_CONFIG_WAVE_INFO_SHM].param.shmemParam.m_maxSize = g_WAVE_BUFFER_INITIAL_SIZE;
 
     m_configMap[HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM].paramType = HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM;
-    m_configMap[HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM].param.shmemParam.m_shmKey = g_LOADMAP_SHMKEY;
-    m_configMap[HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM].param.shmemParam.m_maxSize = g_LOADMAP_MAXSIZE;
+    m_configMap[HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM].param.shmemParam.m_shmKey = GetSessionShmKey(g_LOADMAP_SHMKEY);
+    m_configMap[HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM].param.shmemParam.m_maxSize = g_LOADMAP_INITIAL_SIZE;
+
+    m_configMap[HSAIL_DEBUG_CONFIG_COMMAND_RING_SHM].paramType = HSAIL_DEBUG_CONFIG_COMMAND_RING_SHM;
+    m_configMap[HSAIL_DEBUG_CONFIG_COMMAND_RING_SHM].param.shmemParam.m_shmKey = GetSessionShmKey(g_COMMAND_RING_SHMKEY);
+    m_configMap[HSAIL_DEBUG_CONFIG_COMMAND_RING_SHM].param.shmemParam.m_maxSize = g_COMMAND_RING_MAXSIZE;
 
 
     retCode = true;
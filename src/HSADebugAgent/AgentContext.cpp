@@ -8,6 +8,7 @@
 #include <cassert>
 #include <cstring>
 
+#include <sys/syscall.h>
 #include <sys/wait.h>
 #include <pthread.h>
 #include <unistd.h>
@@ -18,8 +19,11 @@
 #include "AgentContext.h"
 #include "AgentConfiguration.h"
 #include "AgentFocusWaveControl.h"
+#include "AgentKernelBinaryCache.h"
+#include "AgentSegmentLoader.h"
 #include "AgentLogging.h"
 #include "AgentNotifyGdb.h"
+#include "AgentSharedMemRegistry.h"
 #include "AgentUtils.h"
 #include "AgentWavePrinter.h"
 #include "CommunicationControl.h"
@@ -29,102 +33,77 @@
 namespace HwDbgAgent
 {
 
+/// Bumped by every executable destroy
+static uint64_t gs_ExecutableDestroyGeneration = 0;
+
+void AgentForgetBinariesSentToGdb()
+{
+    __atomic_add_fetch(&gs_ExecutableDestroyGeneration, 1, __ATOMIC_RELEASE);
+}
+
 AgentContext::AgentContext():
     m_AgentState(HSAIL_AGENT_STATE_UNKNOWN),// State is unknown initially
     m_HwDebugState(),                       // This will zero initialize the structure
     m_DebugContextHandle(nullptr),             // No debug context is known
     m_LastEventType(HWDBG_EVENT_INVALID),
     m_ParentPID(getppid()),
-    m_codeObjBufferShmKey(-1),
-    m_codeObjBufferMaxSize(0),
-    m_loadMapBufferShmKey(-1),
-    m_loadMapBufferMaxSize(0),
+    m_ParentPidFd(-1),
+    m_pSharedMemRegistry(nullptr),
+    m_pKernelBinaryCache(nullptr),
+    m_pSegmentLoader(nullptr),
+    m_binaryHashesSentToGdb(),
+    m_kernelObjectsSentToGdb(),
+    m_sentToGdbGeneration(0),
     m_ReadyToContinue(false),
+    m_LastSyncMarkerId(0),
     m_workGroupSize(gs_UNKNOWN_HWDBGDIM3),
     m_gridSize(gs_UNKNOWN_HWDBGDIM3),
     m_pBPManager(nullptr),
     m_pWavePrinter(nullptr),
     m_pFocusWaveControl(nullptr)
 {
-    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
-
-    status = GetActiveAgentConfig()->GetConfigShmKey(HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM, m_codeObjBufferShmKey);
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
-    {
-        AGENT_ERROR("Could not get shared mem key");
-    }
-
-    status = GetActiveAgentConfig()->GetConfigShmSize(HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM, m_codeObjBufferMaxSize);
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
-    {
-        AGENT_ERROR("Could not get shared mem max size");
-    }
+    AGENT_LOG("Constructor Agent Context");
 
-    status = GetActiveAgentConfig()->GetConfigShmKey(HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM, m_loadMapBufferShmKey);
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
-    {
-        AGENT_ERROR("Could not get shared mem key");
-    }
+#ifdef SYS_pidfd_open
+    // Lets the debug thread sleep in poll() and still see the parent exit
+    m_ParentPidFd = static_cast<int>(syscall(SYS_pidfd_open, m_ParentPID, 0));
+#endif
 
-    status = GetActiveAgentConfig()->GetConfigShmSize(HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM, m_loadMapBufferMaxSize);
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    if (m_ParentPidFd < 0)
     {
-        AGENT_ERROR("Could not get shared mem max size");
+        AGENT_LOG("AgentContext: pidfd not available, the parent will be checked with getppid()");
+        m_ParentPidFd = -1;
     }
-
-    AGENT_LOG("Constructor Agent Context");
 }
 
 
-HsailAgentStatus AgentContext::AllocateBinaryandLoadMapSharedMem()
+// This mechanism allows us to delete the binary object when we get to EndDebugging
+HsailAgentStatus AgentContext::AddKernelBinaryToContext(AgentBinary* pAgentBinary)
 {
-    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
-    status = AgentAllocSharedMemBuffer(m_codeObjBufferShmKey, m_codeObjBufferMaxSize);
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
-    {
-        AGENT_ERROR("AllocateBinarySharedMemBuffer: Could not alloc shared memory for codeobj");
-        return status;
-    }
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_SUCCESS;
 
-    status = AgentAllocSharedMemBuffer(m_loadMapBufferShmKey, m_loadMapBufferMaxSize);
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
-    {
-        AGENT_ERROR("AllocateBinarySharedMemBuffer: Could not alloc shared memory for loadmap");
-    }
+    // We need to release what we had previously if we are getting a new one
+    status = ReleaseKernelBinary();
+
+    AGENT_LOG("AddKernelBinaryToContext: Register new binary with AgentContext");
 
+    m_pKernelBinaries.push_back(pAgentBinary);
     return status;
 }
 
-//! Private function to initialize the shared memory buffer for the binary
-HsailAgentStatus AgentContext::FreeBinaryandLoadMapSharedMem()
+HsailAgentStatus AgentContext::PublishKernelBinaryISA()
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
-    status = AgentFreeSharedMemBuffer(m_codeObjBufferShmKey, m_codeObjBufferMaxSize);
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
-    {
-        AGENT_ERROR("FreeBinarySharedMemBuffer: Could not free binary shared mem for codeobj");
-    }
 
-    status = AgentFreeSharedMemBuffer(m_loadMapBufferShmKey, m_loadMapBufferMaxSize);
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    if (m_pKernelBinaries.empty() || m_pKernelBinaries.back() == nullptr)
     {
-        AGENT_ERROR("FreeBinarySharedMemBuffer: Could not free binary shared mem for loadmap");
+        AGENT_LOG("PublishKernelBinaryISA: The context does not have any binary presently");
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+        return status;
     }
 
-    return status;
-}
+    status = m_pKernelBinaries.back()->PublishISA();
 
-// This mechanism allows us to delete the binary object when we get to EndDebugging
-HsailAgentStatus AgentContext::AddKernelBinaryToContext(AgentBinary* pAgentBinary)
-{
-    HsailAgentStatus status = HSAIL_AGENT_STATUS_SUCCESS;
-
-    // We need to release what we had previously if we are getting a new one
-    status = ReleaseKernelBinary();
-
-    AGENT_LOG("AddKernelBinaryToContext: Register new binary with AgentContext");
-
-    m_pKernelBinaries.push_back(pAgentBinary);
     return status;
 }
 
@@ -597,6 +576,29 @@ AgentFocusWaveControl* AgentContext::GetFocusWaveControl() const
     return m_pFocusWaveControl;
 }
 
+// This is used by all the objects that write data for gdb into shared memory
+AgentSharedMemRegistry* AgentContext::GetSharedMemRegistry() const
+{
+    if (m_pSharedMemRegistry == nullptr)
+    {
+        AGENT_ERROR("GetSharedMemRegistry: Returning a nullptr shared mem registry");
+    }
+
+    return m_pSharedMemRegistry;
+}
+
+// This is used by the binaries to skip the work done for a kernel dispatched before,
+// nullptr if the cache could not be allocated
+AgentKernelBinaryCache* AgentContext::GetKernelBinaryCache() const
+{
+    return m_pKernelBinaryCache;
+}
+
+AgentSegmentLoader* AgentContext::GetSegmentLoader() const
+{
+    return m_pSegmentLoader;
+}
+
 // Called once the object has been created
 // Explicitly done rather than moving this into the constructor since we want to be sure
 // We will also initialize the breakpoint manager in this case
@@ -617,30 +619,44 @@ HsailAgentStatus AgentContext::Initialize()
         return status;
     }
 
-    status =  AllocateBinaryandLoadMapSharedMem();
+    // All the shared memory regions are attached once here and stay attached until ShutDown
+    m_pSharedMemRegistry = new(std::nothrow) AgentSharedMemRegistry;
 
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    if (m_pSharedMemRegistry == nullptr)
     {
-        AGENT_ERROR("Could not allocate the shared memory for the DBE binary");
+        AGENT_ERROR("Could not allocate the shared memory registry");
         return status;
     }
 
+    status = m_pSharedMemRegistry->MapAllRegions();
+
     if (status != HSAIL_AGENT_STATUS_SUCCESS)
     {
-        AGENT_ERROR("Could not allocate the shared memory for the DBE binary");
+        AGENT_ERROR("Could not allocate the shared memory for gdb");
         return status;
     }
 
     // Initialize a breakpoint manager
-    m_pBPManager = new(std::nothrow) AgentBreakpointManager;
+    m_pBPManager = new(std::nothrow) AgentBreakpointManager(m_pSharedMemRegistry);
 
-    m_pWavePrinter = new(std::nothrow) AgentWavePrinter;
+    m_pWavePrinter = new(std::nothrow) AgentWavePrinter(m_pSharedMemRegistry);
 
     m_pFocusWaveControl = new(std::nothrow) AgentFocusWaveControl;
 
-    if (m_pBPManager == nullptr || m_pWavePrinter == nullptr || m_pFocusWaveControl == nullptr)
+    m_pSegmentLoader = new(std::nothrow) AgentSegmentLoader(m_pSharedMemRegistry);
+
+    // The cache is only an optimization, the binaries work without it
+    m_pKernelBinaryCache = new(std::nothrow) AgentKernelBinaryCache;
+
+    if (m_pKernelBinaryCache == nullptr)
+    {
+        AGENT_WARNING("Could not allocate the kernel binary cache");
+    }
+
+    if (m_pBPManager == nullptr || m_pWavePrinter == nullptr || m_pFocusWaveControl == nullptr ||
+        m_pSegmentLoader == nullptr)
     {
-        AGENT_ERROR("Could not initialize a BP manager or a wave printer");
+        AGENT_ERROR("Could not initialize a BP manager, a wave printer or a segment loader");
 
         status = HSAIL_AGENT_STATUS_FAILURE;
     }
@@ -782,12 +798,12 @@ HsailAgentStatus AgentContext::ShutDown(const bool skipDbeShutDown)
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
 
-    AGENT_LOG("Shutdown: Start to shutdown the AgentContext, wait for the debug thread");
+    AGENT_LOG("Shutdown: Start to shutdown the AgentContext, stop the debug thread");
 
-    status = WaitForDebugThreadCompletion();
+    status = StopDebugEventThread();
     if (status  != HSAIL_AGENT_STATUS_SUCCESS)
     {
-        AGENT_ERROR("ShutDown: Error waiting for the debug thread to complete");
+        AGENT_ERROR("ShutDown: Error stopping the debug thread");
     }
 
     switch (m_AgentState)
@@ -864,14 +880,6 @@ HsailAgentStatus AgentContext::ShutDown(const bool skipDbeShutDown)
 
     m_DebugContextHandle = nullptr;
 
-    // Free the shared memory for the binaries
-    status = FreeBinaryandLoadMapSharedMem();
-
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
-    {
-        AGENT_ERROR("Could not free the Binary Shared memory successfully");
-    }
-
     // Delete all the AgentBinary packages, we may have some left over
     for (size_t i = 0; i < m_pKernelBinaries.size(); i++)
     {
@@ -898,6 +906,34 @@ HsailAgentStatus AgentContext::ShutDown(const bool skipDbeShutDown)
         delete m_pFocusWaveControl;
     }
 
+    if (m_pKernelBinaryCache != nullptr)
+    {
+        m_pKernelBinaryCache->LogStatistics();
+        delete m_pKernelBinaryCache;
+        m_pKernelBinaryCache = nullptr;
+    }
+
+    if (m_pSegmentLoader != nullptr)
+    {
+        m_pSegmentLoader->LogStatistics();
+        delete m_pSegmentLoader;
+        m_pSegmentLoader = nullptr;
+    }
+
+    // Free the shared memory once nobody can write to it any more
+    if (m_pSharedMemRegistry != nullptr)
+    {
+        status = m_pSharedMemRegistry->UnMapAllRegions();
+
+        if (status != HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            AGENT_ERROR("Could not free the shared memory successfully");
+        }
+
+        delete m_pSharedMemRegistry;
+        m_pSharedMemRegistry = nullptr;
+    }
+
     m_AgentState = HSAIL_AGENT_STATE_CLOSED;
 
     return status;
@@ -933,6 +969,11 @@ bool AgentContext::CompareParentPID() const
     return retCode;
 }
 
+int AgentContext::GetParentPidFd() const
+{
+    return m_ParentPidFd;
+}
+
 /// Add a device info to the list of available devices.
 void AgentContext::AddDeviceInfo(uint64_t handle, RocmDeviceDesc& device)
 {
@@ -955,6 +996,51 @@ void AgentContext::SetActiveDevice(uint64_t handle)
     AGENT_WARNING("Active device not found");
 }
 
+bool AgentContext::IsBinarySentToGdb(const uint64_t binaryHash) const
+{
+    return (m_binaryHashesSentToGdb.find(binaryHash) != m_binaryHashesSentToGdb.end());
+}
+
+void AgentContext::AddBinarySentToGdb(const uint64_t binaryHash)
+{
+    m_binaryHashesSentToGdb.insert(binaryHash);
+}
+
+bool AgentContext::IsKernelObjectSentToGdb(const uint64_t kernelObject) const
+{
+    return (m_kernelObjectsSentToGdb.find(kernelObject) != m_kernelObjectsSentToGdb.end());
+}
+
+bool AgentContext::IsKernelObjectSentToGdb(const uint64_t kernelObject, const uint64_t binaryHash) const
+{
+    std::map<uint64_t, uint64_t>::const_iterator kernelIter = m_kernelObjectsSentToGdb.find(kernelObject);
+
+    return (kernelIter != m_kernelObjectsSentToGdb.end() && kernelIter->second == binaryHash);
+}
+
+void AgentContext::AddKernelObjectSentToGdb(const uint64_t kernelObject, const uint64_t binaryHash)
+{
+    m_kernelObjectsSentToGdb[kernelObject] = binaryHash;
+}
+
+void AgentContext::RefreshSentToGdb()
+{
+    const uint64_t generation = __atomic_load_n(&gs_ExecutableDestroyGeneration, __ATOMIC_ACQUIRE);
+
+    if (generation == m_sentToGdbGeneration)
+    {
+        return;
+    }
+
+    AGENT_LOG("RefreshSentToGdb: An executable was destroyed, forgetting " <<
+              m_kernelObjectsSentToGdb.size() << " kernel objects and " <<
+              m_binaryHashesSentToGdb.size() << " binaries sent to gdb");
+
+    m_kernelObjectsSentToGdb.clear();
+    m_binaryHashesSentToGdb.clear();
+    m_sentToGdbGeneration = generation;
+}
+
 // We can check that the destructor should not be called before we end debugging
 // We could add a lot of these checks in a Close() function
 AgentContext::~AgentContext()
@@ -970,6 +1056,12 @@ AgentContext::~AgentContext()
             AGENT_ERROR("~AgentContext: Context was not shutdown safely");
         }
     }
+
+    if (m_ParentPidFd >= 0)
+    {
+        close(m_ParentPidFd);
+        m_ParentPidFd = -1;
+    }
 }
 
 } // End Namespace HwDbgAgent
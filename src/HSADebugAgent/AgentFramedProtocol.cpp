@@ -0,0 +1,454 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Encoding and decoding of the framed messages exchanged with gdb
+//==============================================================================
+#include <cstring>
+
+#include "AgentFramedProtocol.h"
+#include "AgentLogging.h"
+
+namespace HwDbgAgent
+{
+
+/// Larger frames are treated as a corrupted stream
+static const uint32_t gs_MAX_FRAME_LENGTH = 1024 * 1024;
+
+// A fixed size packet is read as sizeof(HsailCommandPacket) bytes, the size every gdb writes.
+// New command fields must go in HsailCommandFrameFields
+static_assert(sizeof(HsailCommandPacket) == 576, "HsailCommandPacket must keep the layout gdb writes");
+
+/// The framing version gdb announced, 0 till gdb sends HSAIL_COMMAND_SET_PROTOCOL
+static uint32_t gs_GdbProtocolVersion = 0;
+
+AgentFrameWriter::AgentFrameWriter(const uint16_t frameType):
+    m_frame(sizeof(HsailFrameHeader))
+{
+    HsailFrameHeader header;
+    memset(&header, 0, sizeof(HsailFrameHeader));
+
+    header.m_magic = HSAIL_FRAME_MAGIC;
+    header.m_version = HSAIL_FRAME_PROTOCOL_VERSION;
+    header.m_type = frameType;
+    header.m_length = 0;
+
+    memcpy(m_frame.data(), &header, sizeof(HsailFrameHeader));
+}
+
+void AgentFrameWriter::AddBytes(const HsailFrameTag tag, const void* pValue, const size_t valueSize)
+{
+    HsailFrameFieldHeader field;
+    field.m_tag = static_cast<uint16_t>(tag);
+    field.m_reserved = 0;
+    field.m_length = static_cast<uint32_t>(valueSize);
+
+    const char* pField = reinterpret_cast<const char*>(&field);
+    m_frame.insert(m_frame.end(), pField, pField + sizeof(HsailFrameFieldHeader));
+
+    if (valueSize > 0 && pValue != nullptr)
+    {
+        const char* pValueBytes = static_cast<const char*>(pValue);
+        m_frame.insert(m_frame.end(), pValueBytes, pValueBytes + valueSize);
+    }
+
+    uint32_t length = static_cast<uint32_t>(m_frame.size() - sizeof(HsailFrameHeader));
+    memcpy(m_frame.data() + offsetof(HsailFrameHeader, m_length), &length, sizeof(uint32_t));
+}
+
+void AgentFrameWriter::AddBool(const HsailFrameTag tag, const bool value)
+{
+    uint8_t byteValue = value ? 1 : 0;
+    AddBytes(tag, &byteValue, sizeof(uint8_t));
+}
+
+void AgentFrameWriter::AddInt32(const HsailFrameTag tag, const int32_t value)
+{
+    AddBytes(tag, &value, sizeof(int32_t));
+}
+
+void AgentFrameWriter::AddUInt32(const HsailFrameTag tag, const uint32_t value)
+{
+    AddBytes(tag, &value, sizeof(uint32_t));
+}
+
+void AgentFrameWriter::AddUInt64(const HsailFrameTag tag, const uint64_t value)
+{
+    AddBytes(tag, &value, sizeof(uint64_t));
+}
+
+void AgentFrameWriter::AddString(const HsailFrameTag tag, const std::string& value)
+{
+    AddBytes(tag, value.data(), value.size());
+}
+
+const char* AgentFrameWriter::GetFrame() const
+{
+    return m_frame.data();
+}
+
+size_t AgentFrameWriter::GetFrameSize() const
+{
+    return m_frame.size();
+}
+
+AgentCommandStreamDecoder::AgentCommandStreamDecoder():
+    m_buffer()
+{
+}
+
+void AgentCommandStreamDecoder::Append(const char* pBytes, const size_t numBytes)
+{
+    if (pBytes == nullptr || numBytes == 0)
+    {
+        return;
+    }
+
+    m_buffer.insert(m_buffer.end(), pBytes, pBytes + numBytes);
+}
+
+bool AgentCommandStreamDecoder::HasPendingBytes() const
+{
+    return !m_buffer.empty();
+}
+
+bool AgentCommandStreamDecoder::GetNextPacket(HsailCommandPacket& packetOut, HsailCommandFrameFields& frameFieldsOut)
+{
+    bool retCode = false;
+
+    while (!retCode && m_buffer.size() >= sizeof(uint32_t))
+    {
+        uint32_t magic = 0;
+        memcpy(&magic, m_buffer.data(), sizeof(uint32_t));
+
+        size_t consumedBytes = 0;
+
+        if (magic != HSAIL_FRAME_MAGIC)
+        {
+            // A fixed size packet, the first field is the command.
+            // Its size is the one every gdb writes, newer fields only come in frames
+            if (m_buffer.size() < sizeof(HsailCommandPacket))
+            {
+                break;
+            }
+
+            memcpy(&packetOut, m_buffer.data(), sizeof(HsailCommandPacket));
+            memset(&frameFieldsOut, 0, sizeof(HsailCommandFrameFields));
+            consumedBytes = sizeof(HsailCommandPacket);
+            retCode = true;
+        }
+        else
+        {
+            if (m_buffer.size() < sizeof(HsailFrameHeader))
+            {
+                break;
+            }
+
+            HsailFrameHeader header;
+            memcpy(&header, m_buffer.data(), sizeof(HsailFrameHeader));
+
+            if (header.m_length > gs_MAX_FRAME_LENGTH)
+            {
+                // We can not find the start of the next message, drop everything we have
+                AGENT_ERROR("AgentCommandStreamDecoder: Frame length " << header.m_length <<
+                            " is too large, dropping " << m_buffer.size() << " bytes");
+                m_buffer.clear();
+                break;
+            }
+
+            if (m_buffer.size() < sizeof(HsailFrameHeader) + header.m_length)
+            {
+                break;
+            }
+
+            retCode = DecodeFrame(header, m_buffer.data() + sizeof(HsailFrameHeader), packetOut, frameFieldsOut);
+            consumedBytes = sizeof(HsailFrameHeader) + header.m_length;
+        }
+
+        m_buffer.erase(m_buffer.begin(), m_buffer.begin() + consumedBytes);
+    }
+
+    return retCode;
+}
+
+/// Copy a fixed size field value, the value must have exactly the expected size
+static bool CopyFieldValue(const HsailFrameFieldHeader& field, const char* pValue,
+                           void* pOut, const size_t outSize)
+{
+    if (field.m_length != outSize)
+    {
+        AGENT_ERROR("CopyFieldValue: Field " << field.m_tag << " has size " << field.m_length <<
+                    ", expected " << outSize);
+        return false;
+    }
+
+    memcpy(pOut, pValue, outSize);
+    return true;
+}
+
+/// Copy a string field value into a fixed size buffer, truncating if needed
+static void CopyFieldString(const HsailFrameFieldHeader& field, const char* pValue,
+                            char* pOut, const size_t outSize)
+{
+    size_t copySize = (field.m_length < outSize - 1) ? field.m_length : outSize - 1;
+
+    if (copySize < field.m_length)
+    {
+        AGENT_WARNING("CopyFieldString: Field " << field.m_tag << " truncated to " << copySize << " characters");
+    }
+
+    memcpy(pOut, pValue, copySize);
+    pOut[copySize] = '\0';
+}
+
+bool AgentCommandStreamDecoder::DecodeFrame(const HsailFrameHeader&  header,
+                                            const char*              pFields,
+                                            HsailCommandPacket&      packetOut,
+                                            HsailCommandFrameFields& frameFieldsOut) const
+{
+    memset(&packetOut, 0, sizeof(HsailCommandPacket));
+    memset(&frameFieldsOut, 0, sizeof(HsailCommandFrameFields));
+    packetOut.m_command = static_cast<HsailCommand>(header.m_type);
+    packetOut.m_pc = HSAIL_ISA_PC_UNKOWN;
+
+    size_t offset = 0;
+    bool isValid = true;
+
+    while (isValid && offset + sizeof(HsailFrameFieldHeader) <= header.m_length)
+    {
+        HsailFrameFieldHeader field;
+        memcpy(&field, pFields + offset, sizeof(HsailFrameFieldHeader));
+        offset += sizeof(HsailFrameFieldHeader);
+
+        if (offset + field.m_length > header.m_length)
+        {
+            AGENT_ERROR("DecodeFrame: Field " << field.m_tag << " overruns the frame");
+            isValid = false;
+            break;
+        }
+
+        const char* pValue = pFields + offset;
+        offset += field.m_length;
+
+        switch (field.m_tag)
+        {
+            case HSAIL_FRAME_TAG_PROTOCOL_VERSION:
+            {
+                uint32_t version = 0;
+                if (CopyFieldValue(field, pValue, &version, sizeof(uint32_t)))
+                {
+                    AgentSetGdbProtocolVersion(version);
+                }
+                break;
+            }
+
+            case HSAIL_FRAME_TAG_LOGGING_INFO:
+            {
+                uint32_t loggingInfo = 0;
+                if (CopyFieldValue(field, pValue, &loggingInfo, sizeof(uint32_t)))
+                {
+                    packetOut.m_loggingInfo = static_cast<HsailLogCommand>(loggingInfo);
+                }
+                break;
+            }
+
+            case HSAIL_FRAME_TAG_GDB_BREAKPOINT_ID:
+                CopyFieldValue(field, pValue, &packetOut.m_gdbBreakpointID, sizeof(int32_t));
+                break;
+
+            case HSAIL_FRAME_TAG_PC:
+                CopyFieldValue(field, pValue, &packetOut.m_pc, sizeof(uint64_t));
+                break;
+
+            case HSAIL_FRAME_TAG_HIT_COUNT:
+                CopyFieldValue(field, pValue, &packetOut.m_hitCount, sizeof(int32_t));
+                break;
+
+            case HSAIL_FRAME_TAG_LINE_NUM:
+                CopyFieldValue(field, pValue, &packetOut.m_lineNum, sizeof(int32_t));
+                break;
+
+            case HSAIL_FRAME_TAG_NUM_MOMENTARY_BP:
+                CopyFieldValue(field, pValue, &packetOut.m_numMomentaryBP, sizeof(int32_t));
+                break;
+
+            case HSAIL_FRAME_TAG_CONDITION:
+                CopyFieldValue(field, pValue, &packetOut.m_conditionPacket, sizeof(HsailConditionPacket));
+                break;
+
+            case HSAIL_FRAME_TAG_SOURCE_LINE:
+                CopyFieldString(field, pValue, packetOut.m_sourceLine, AGENT_MAX_SOURCE_LINE_LEN);
+                break;
+
+            case HSAIL_FRAME_TAG_KERNEL_NAME:
+                CopyFieldString(field, pValue, packetOut.m_kernelName, AGENT_MAX_FUNC_NAME_LEN);
+                break;
+
+            case HSAIL_FRAME_TAG_SYNC_ID:
+                CopyFieldValue(field, pValue, &frameFieldsOut.m_syncId, sizeof(uint64_t));
+                break;
+
+            case HSAIL_FRAME_TAG_BINARY_HASH:
+                CopyFieldValue(field, pValue, &frameFieldsOut.m_binaryHash, sizeof(uint64_t));
+                break;
+
+            case HSAIL_FRAME_TAG_PC_END:
+                CopyFieldValue(field, pValue, &frameFieldsOut.m_pcEnd, sizeof(uint64_t));
+                break;
+
+            case HSAIL_FRAME_TAG_KERNEL_FILTER:
+                CopyFieldString(field, pValue, frameFieldsOut.m_kernelFilter, AGENT_MAX_SOURCE_LINE_LEN);
+                break;
+
+            default:
+                // A newer gdb may send fields we do not know about
+                AGENT_LOG("DecodeFrame: Skip unknown field " << field.m_tag);
+                break;
+        }
+    }
+
+    return isValid;
+}
+
+void AgentSetGdbProtocolVersion(const uint32_t version)
+{
+    uint32_t usedVersion = (version < HSAIL_FRAME_PROTOCOL_VERSION) ? version : HSAIL_FRAME_PROTOCOL_VERSION;
+
+    AGENT_LOG("AgentSetGdbProtocolVersion: gdb framing version " << version <<
+              ", using version " << usedVersion);
+
+    __atomic_store_n(&gs_GdbProtocolVersion, usedVersion, __ATOMIC_RELEASE);
+}
+
+uint32_t AgentGetGdbProtocolVersion()
+{
+    return __atomic_load_n(&gs_GdbProtocolVersion, __ATOMIC_ACQUIRE);
+}
+
+void AgentEncodeNotificationFrame(const HsailNotificationPayload& payload, std::vector<char>& frameOut)
+{
+    AgentFrameWriter frame(static_cast<uint16_t>(payload.m_Notification));
+
+    switch (payload.m_Notification)
+    {
+        case HSAIL_NOTIFY_BREAKPOINT_HIT:
+        {
+            frame.AddInt32(HSAIL_FRAME_TAG_NUM_ACTIVE_WAVES, payload.payload.BreakpointHit.m_numActiveWaves);
+
+            for (int i = 0; i < HSAIL_MAX_REPORTABLE_BREAKPOINTS; i++)
+            {
+                if (payload.payload.BreakpointHit.m_breakpointId[i] == -1)
+                {
+                    continue;
+                }
+
+                HsailBreakpointHitRecord record;
+                record.m_breakpointId = payload.payload.BreakpointHit.m_breakpointId[i];
+                record.m_hitCount = payload.payload.BreakpointHit.m_hitCount[i];
+                frame.AddBytes(HSAIL_FRAME_TAG_BREAKPOINT_HIT, &record, sizeof(HsailBreakpointHitRecord));
+            }
+
+            break;
+        }
+
+        case HSAIL_NOTIFY_NEW_BINARY:
+        {
+            const char* pKernelName = payload.payload.BinaryNotification.m_KernelName;
+            frame.AddBytes(HSAIL_FRAME_TAG_KERNEL_NAME, pKernelName, strnlen(pKernelName, AGENT_MAX_FUNC_NAME_LEN));
+            frame.AddUInt64(HSAIL_FRAME_TAG_BINARY_SIZE, payload.payload.BinaryNotification.m_binarySize);
+            frame.AddBytes(HSAIL_FRAME_TAG_DISPATCH_PACKET,
+                           &payload.payload.BinaryNotification.m_packet,
+                           sizeof(HsailDispatchPacket));
+            frame.AddUInt64(HSAIL_FRAME_TAG_BINARY_HASH, payload.payload.BinaryNotification.m_binaryHash);
+            break;
+        }
+
+        case HSAIL_NOTIFY_REUSE_BINARY:
+        {
+            const char* pKernelName = payload.payload.ReuseBinaryNotification.m_KernelName;
+            frame.AddBytes(HSAIL_FRAME_TAG_KERNEL_NAME, pKernelName, strnlen(pKernelName, AGENT_MAX_FUNC_NAME_LEN));
+            frame.AddUInt64(HSAIL_FRAME_TAG_BINARY_HASH, payload.payload.ReuseBinaryNotification.m_binaryHash);
+            frame.AddBytes(HSAIL_FRAME_TAG_DISPATCH_PACKET,
+                           &payload.payload.ReuseBinaryNotification.m_packet,
+                           sizeof(HsailDispatchPacket));
+            break;
+        }
+
+        case HSAIL_NOTIFY_PREDISPATCH_STATE:
+            frame.AddUInt32(HSAIL_FRAME_TAG_PREDISPATCH_STATE,
+                            payload.payload.PredispatchNotification.m_predispatchState);
+            frame.AddInt32(HSAIL_FRAME_TAG_THREAD_ID, payload.payload.PredispatchNotification.m_HostDispatchTid);
+            break;
+
+        case HSAIL_NOTIFY_BEGIN_DEBUGGING:
+            frame.AddBool(HSAIL_FRAME_TAG_SET_DEVICE_FOCUS, payload.payload.BeginDebugNotification.setDeviceFocus);
+            break;
+
+        case HSAIL_NOTIFY_END_DEBUGGING:
+            frame.AddBool(HSAIL_FRAME_TAG_DISPATCH_COMPLETED,
+                          payload.payload.EndDebugNotification.hasDispatchCompleted);
+            break;
+
+        case HSAIL_NOTIFY_AGENT_ERROR:
+            frame.AddInt32(HSAIL_FRAME_TAG_ERROR_CODE, payload.payload.AgentErrorNotification.m_errorCode);
+            break;
+
+        case HSAIL_NOTIFY_FOCUS_CHANGE:
+            frame.AddBytes(HSAIL_FRAME_TAG_FOCUS_WORK_GROUP,
+                           &payload.payload.FocusChange.m_focusWorkGroup,
+                           sizeof(HsailWaveDim3));
+            frame.AddBytes(HSAIL_FRAME_TAG_FOCUS_WORK_ITEM,
+                           &payload.payload.FocusChange.m_focusWorkItem,
+                           sizeof(HsailWaveDim3));
+            break;
+
+        case HSAIL_NOTIFY_START_DEBUG_THREAD:
+            frame.AddInt32(HSAIL_FRAME_TAG_THREAD_ID, payload.payload.StartDebugThreadNotification.m_tid);
+            break;
+
+        case HSAIL_NOTIFY_KILL_COMPLETE:
+            frame.AddBool(HSAIL_FRAME_TAG_KILL_SUCCESSFUL, payload.payload.KillCompleteNotification.killSuccessful);
+            frame.AddBool(HSAIL_FRAME_TAG_QUIT_ISSUED, payload.payload.KillCompleteNotification.isQuitCommandIssued);
+            break;
+
+        case HSAIL_NOTIFY_NEW_ACTIVE_WAVES:
+            frame.AddInt32(HSAIL_FRAME_TAG_NUM_ACTIVE_WAVES, payload.payload.NewActiveWaveNotification.m_numActiveWaves);
+            break;
+
+        case HSAIL_NOTIFY_DEVICES:
+        {
+            int numDevices = payload.payload.DevicesNotification.m_devicesNum;
+
+            for (int i = 0; i < numDevices && i < AGENT_MAX_DEVICES_NUM; i++)
+            {
+                frame.AddBytes(HSAIL_FRAME_TAG_DEVICE,
+                               &payload.payload.DevicesNotification.m_deviceDescriptors[i],
+                               sizeof(RocmDeviceDesc));
+            }
+
+            break;
+        }
+
+        case HSAIL_NOTIFY_SYNC_REQUEST:
+            frame.AddUInt64(HSAIL_FRAME_TAG_SYNC_ID, payload.payload.SyncRequestNotification.m_syncId);
+            break;
+
+        case HSAIL_NOTIFY_ISA_READY:
+            frame.AddUInt64(HSAIL_FRAME_TAG_BINARY_HASH, payload.payload.IsaReadyNotification.m_binaryHash);
+            frame.AddUInt64(HSAIL_FRAME_TAG_ISA_SIZE, payload.payload.IsaReadyNotification.m_isaSize);
+            break;
+
+        case HSAIL_NOTIFY_COMMAND_RING:
+            frame.AddInt32(HSAIL_FRAME_TAG_SHM_KEY, payload.payload.CommandRingNotification.m_shmKey);
+            break;
+
+        default:
+            // The notification type is enough for the others
+            break;
+    }
+
+    frameOut.assign(frame.GetFrame(), frame.GetFrame() + frame.GetFrameSize());
+}
+
+} // End Namespace HwDbgAgent
@@ -0,0 +1,2022 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief In process decoder of the GCN instructions of a code object
+//==============================================================================
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include <amd_hsa_kernel_code.h>
+#include <libelf.h>
+
+#include "AgentGCNDecoder.h"
+#include "AgentLogging.h"
+
+namespace HwDbgAgent
+{
+
+/// Symbol type of the kernels in a code object, the symbol points to the amd_kernel_code_t
+static const unsigned int gs_STT_AMDGPU_HSA_KERNEL = 10;
+
+/// Column of the "//" comment in a rendered line, like llvm-objdump
+static const size_t gs_COMMENT_COLUMN = 50;
+
+/// The ELF machine of the AMD GPU code objects (EM_AMDGPU)
+static const uint16_t gs_EM_AMDGPU = 224;
+
+/// The note of the code objects of version 1 and 2 that names the ISA (NT_AMDGPU_HSA_ISA)
+static const uint32_t gs_NT_AMDGPU_HSA_ISA = 3;
+
+/// The ISA major version the tables describe, GFX8 (VI)
+static const uint32_t gs_SUPPORTED_ISA_MAJOR = 8;
+
+/// The GFX8 values of the machine field of e_flags (EF_AMDGPU_MACH) of the later code objects,
+/// gfx801 to gfx810
+static const uint32_t gs_EF_AMDGPU_MACH = 0xff;
+static const uint32_t gs_EF_AMDGPU_MACH_GFX8_FIRST = 0x028;
+static const uint32_t gs_EF_AMDGPU_MACH_GFX8_LAST = 0x02b;
+
+/// The ISA version of a NT_AMDGPU_HSA_ISA note, the vendor and architecture names follow it
+typedef struct
+{
+    uint16_t m_vendorNameSize;
+    uint16_t m_architectureNameSize;
+    uint32_t m_major;
+    uint32_t m_minor;
+    uint32_t m_stepping;
+} HsaISANoteDesc;
+
+typedef struct
+{
+    uint32_t         m_mask;            // Bits of the first word that identify the encoding
+    uint32_t         m_value;           // Value of these bits
+    AgentGCNEncoding m_encoding;
+    uint8_t          m_numWords;        // Size without a literal constant
+    uint8_t          m_opcodeShift;     // Position of the opcode field
+    uint16_t         m_opcodeMask;      // Width of the opcode field
+    const char*      m_pName;           // Used for opcodes missing in the opcode tables
+} EncodingInfo;
+
+/// The GCN3 encodings, the ones with more fixed bits first
+static const EncodingInfo gs_ENCODINGS[] =
+{
+    {0xFF800000, 0xBE800000, AGENT_GCN_ENCODING_SOP1,   1,  8, 0xFF,  "sop1"},
+    {0xFF800000, 0xBF000000, AGENT_GCN_ENCODING_SOPC,   1, 16, 0x7F,  "sopc"},
+    {0xFF800000, 0xBF800000, AGENT_GCN_ENCODING_SOPP,   1, 16, 0x7F,  "sopp"},
+    {0xF0000000, 0xB0000000, AGENT_GCN_ENCODING_SOPK,   1, 23, 0x1F,  "sopk"},
+    {0xC0000000, 0x80000000, AGENT_GCN_ENCODING_SOP2,   1, 23, 0x7F,  "sop2"},
+    {0xFC000000, 0xC0000000, AGENT_GCN_ENCODING_SMEM,   2, 18, 0xFF,  "smem"},
+    {0xFC000000, 0xC4000000, AGENT_GCN_ENCODING_EXP,    2,  0, 0x0,   "exp"},
+    {0xFC000000, 0xD0000000, AGENT_GCN_ENCODING_VOP3,   2, 16, 0x3FF, "vop3"},
+    {0xFC000000, 0xD4000000, AGENT_GCN_ENCODING_VINTRP, 1, 16, 0x3,   "vintrp"},
+    {0xFC000000, 0xD8000000, AGENT_GCN_ENCODING_DS,     2, 17, 0xFF,  "ds"},
+    {0xFC000000, 0xDC000000, AGENT_GCN_ENCODING_FLAT,   2, 18, 0x7F,  "flat"},
+    {0xFC000000, 0xE0000000, AGENT_GCN_ENCODING_MUBUF,  2, 18, 0x7F,  "buffer"},
+    {0xFC000000, 0xE8000000, AGENT_GCN_ENCODING_MTBUF,  2, 15, 0xF,   "tbuffer"},
+    {0xFC000000, 0xF0000000, AGENT_GCN_ENCODING_MIMG,   2, 18, 0x7F,  "image"},
+    {0xFE000000, 0x7E000000, AGENT_GCN_ENCODING_VOP1,   1,  9, 0xFF,  "vop1"},
+    {0xFE000000, 0x7C000000, AGENT_GCN_ENCODING_VOPC,   1, 17, 0xFF,  "vopc"},
+    {0x80000000, 0x00000000, AGENT_GCN_ENCODING_VOP2,   1, 25, 0x3F,  "vop2"}
+};
+
+typedef struct
+{
+    uint16_t    m_opcode;
+    const char* m_pName;
+} OpcodeName;
+
+// The opcode tables are sorted by opcode
+
+static const OpcodeName gs_SOP2_OPCODES[] =
+{
+    {0, "s_add_u32"}, {1, "s_sub_u32"}, {2, "s_add_i32"}, {3, "s_sub_i32"},
+    {4, "s_addc_u32"}, {5, "s_subb_u32"}, {6, "s_min_i32"}, {7, "s_min_u32"},
+    {8, "s_max_i32"}, {9, "s_max_u32"}, {10, "s_cselect_b32"}, {11, "s_cselect_b64"},
+    {12, "s_and_b32"}, {13, "s_and_b64"}, {14, "s_or_b32"}, {15, "s_or_b64"},
+    {16, "s_xor_b32"}, {17, "s_xor_b64"}, {18, "s_andn2_b32"}, {19, "s_andn2_b64"},
+    {20, "s_orn2_b32"}, {21, "s_orn2_b64"}, {22, "s_nand_b32"}, {23, "s_nand_b64"},
+    {24, "s_nor_b32"}, {25, "s_nor_b64"}, {26, "s_xnor_b32"}, {27, "s_xnor_b64"},
+    {28, "s_lshl_b32"}, {29, "s_lshl_b64"}, {30, "s_lshr_b32"}, {31, "s_lshr_b64"},
+    {32, "s_ashr_i32"}, {33, "s_ashr_i64"}, {34, "s_bfm_b32"}, {35, "s_bfm_b64"},
+    {36, "s_mul_i32"}, {37, "s_bfe_u32"}, {38, "s_bfe_i32"}, {39, "s_bfe_u64"},
+    {40, "s_bfe_i64"}, {41, "s_cbranch_g_fork"}, {42, "s_absdiff_i32"}, {43, "s_rfe_restore_b64"}
+};
+
+static const OpcodeName gs_SOPK_OPCODES[] =
+{
+    {0, "s_movk_i32"}, {1, "s_cmovk_i32"}, {2, "s_cmpk_eq_i32"}, {3, "s_cmpk_lg_i32"},
+    {4, "s_cmpk_gt_i32"}, {5, "s_cmpk_ge_i32"}, {6, "s_cmpk_lt_i32"}, {7, "s_cmpk_le_i32"},
+    {8, "s_cmpk_eq_u32"}, {9, "s_cmpk_lg_u32"}, {10, "s_cmpk_gt_u32"}, {11, "s_cmpk_ge_u32"},
+    {12, "s_cmpk_lt_u32"}, {13, "s_cmpk_le_u32"}, {14, "s_addk_i32"}, {15, "s_mulk_i32"},
+    {16, "s_cbranch_i_fork"}, {17, "s_getreg_b32"}, {18, "s_setreg_b32"}, {20, "s_setreg_imm32_b32"}
+};
+
+static const OpcodeName gs_SOP1_OPCODES[] =
+{
+    {0, "s_mov_b32"}, {1, "s_mov_b64"}, {2, "s_cmov_b32"}, {3, "s_cmov_b64"},
+    {4, "s_not_b32"}, {5, "s_not_b64"}, {6, "s_wqm_b32"}, {7, "s_wqm_b64"},
+    {8, "s_brev_b32"}, {9, "s_brev_b64"}, {10, "s_bcnt0_i32_b32"}, {11, "s_bcnt0_i32_b64"},
+    {12, "s_bcnt1_i32_b32"}, {13, "s_bcnt1_i32_b64"}, {14, "s_ff0_i32_b32"}, {15, "s_ff0_i32_b64"},
+    {16, "s_ff1_i32_b32"}, {17, "s_ff1_i32_b64"}, {18, "s_flbit_i32_b32"}, {19, "s_flbit_i32_b64"},
+    {20, "s_flbit_i32"}, {21, "s_flbit_i32_i64"}, {22, "s_sext_i32_i8"}, {23, "s_sext_i32_i16"},
+    {24, "s_bitset0_b32"}, {25, "s_bitset0_b64"}, {26, "s_bitset1_b32"}, {27, "s_bitset1_b64"},
+    {28, "s_getpc_b64"}, {29, "s_setpc_b64"}, {30, "s_swappc_b64"}, {31, "s_rfe_b64"},
+    {32, "s_and_saveexec_b64"}, {33, "s_or_saveexec_b64"}, {34, "s_xor_saveexec_b64"}, {35, "s_andn2_saveexec_b64"},
+    {36, "s_orn2_saveexec_b64"}, {37, "s_nand_saveexec_b64"}, {38, "s_nor_saveexec_b64"}, {39, "s_xnor_saveexec_b64"},
+    {40, "s_quadmask_b32"}, {41, "s_quadmask_b64"}, {42, "s_movrels_b32"}, {43, "s_movrels_b64"},
+    {44, "s_movreld_b32"}, {45, "s_movreld_b64"}, {46, "s_cbranch_join"}, {48, "s_abs_i32"},
+    {50, "s_set_gpr_idx_idx"}
+};
+
+static const OpcodeName gs_SOPC_OPCODES[] =
+{
+    {0, "s_cmp_eq_i32"}, {1, "s_cmp_lg_i32"}, {2, "s_cmp_gt_i32"}, {3, "s_cmp_ge_i32"},
+    {4, "s_cmp_lt_i32"}, {5, "s_cmp_le_i32"}, {6, "s_cmp_eq_u32"}, {7, "s_cmp_lg_u32"},
+    {8, "s_cmp_gt_u32"}, {9, "s_cmp_ge_u32"}, {10, "s_cmp_lt_u32"}, {11, "s_cmp_le_u32"},
+    {12, "s_bitcmp0_b32"}, {13, "s_bitcmp1_b32"}, {14, "s_bitcmp0_b64"}, {15, "s_bitcmp1_b64"},
+    {16, "s_setvskip"}, {17, "s_set_gpr_idx_on"}, {18, "s_cmp_eq_u64"}, {19, "s_cmp_lg_u64"}
+};
+
+static const OpcodeName gs_SOPP_OPCODES[] =
+{
+    {0, "s_nop"}, {1, "s_endpgm"}, {2, "s_branch"}, {4, "s_cbranch_scc0"},
+    {5, "s_cbranch_scc1"}, {6, "s_cbranch_vccz"}, {7, "s_cbranch_vccnz"}, {8, "s_cbranch_execz"},
+    {9, "s_cbranch_execnz"}, {10, "s_barrier"}, {11, "s_setkill"}, {12, "s_waitcnt"},
+    {13, "s_sethalt"}, {14, "s_sleep"}, {15, "s_setprio"}, {16, "s_sendmsg"},
+    {17, "s_sendmsghalt"}, {18, "s_trap"}, {19, "s_icache_inv"}, {20, "s_incperflevel"},
+    {21, "s_decperflevel"}, {22, "s_ttracedata"}, {23, "s_cbranch_cdbgsys"}, {24, "s_cbranch_cdbguser"},
+    {25, "s_cbranch_cdbgsys_or_user"}, {26, "s_cbranch_cdbgsys_and_user"}, {27, "s_endpgm_saved"}, {28, "s_set_gpr_idx_off"},
+    {29, "s_set_gpr_idx_mode"}
+};
+
+static const OpcodeName gs_SMEM_OPCODES[] =
+{
+    {0, "s_load_dword"}, {1, "s_load_dwordx2"}, {2, "s_load_dwordx4"}, {3, "s_load_dwordx8"},
+    {4, "s_load_dwordx16"}, {8, "s_buffer_load_dword"}, {9, "s_buffer_load_dwordx2"}, {10, "s_buffer_load_dwordx4"},
+    {11, "s_buffer_load_dwordx8"}, {12, "s_buffer_load_dwordx16"}, {16, "s_store_dword"}, {17, "s_store_dwordx2"},
+    {18, "s_store_dwordx4"}, {24, "s_buffer_store_dword"}, {25, "s_buffer_store_dwordx2"}, {26, "s_buffer_store_dwordx4"},
+    {32, "s_dcache_inv"}, {33, "s_dcache_wb"}, {34, "s_dcache_inv_vol"}, {35, "s_dcache_wb_vol"},
+    {36, "s_memtime"}, {37, "s_memrealtime"}, {38, "s_atc_probe"}, {39, "s_atc_probe_buffer"}
+};
+
+static const OpcodeName gs_VOP2_OPCODES[] =
+{
+    {0, "v_cndmask_b32"}, {1, "v_add_f32"}, {2, "v_sub_f32"}, {3, "v_subrev_f32"},
+    {4, "v_mul_legacy_f32"}, {5, "v_mul_f32"}, {6, "v_mul_i32_i24"}, {7, "v_mul_hi_i32_i24"},
+    {8, "v_mul_u32_u24"}, {9, "v_mul_hi_u32_u24"}, {10, "v_min_f32"}, {11, "v_max_f32"},
+    {12, "v_min_i32"}, {13, "v_max_i32"}, {14, "v_min_u32"}, {15, "v_max_u32"},
+    {16, "v_lshrrev_b32"}, {17, "v_ashrrev_i32"}, {18, "v_lshlrev_b32"}, {19, "v_and_b32"},
+    {20, "v_or_b32"}, {21, "v_xor_b32"}, {22, "v_mac_f32"}, {23, "v_madmk_f32"},
+    {24, "v_madak_f32"}, {25, "v_add_u32"}, {26, "v_sub_u32"}, {27, "v_subrev_u32"},
+    {28, "v_addc_u32"}, {29, "v_subb_u32"}, {30, "v_subbrev_u32"}, {31, "v_add_f16"},
+    {32, "v_sub_f16"}, {33, "v_subrev_f16"}, {34, "v_mul_f16"}, {35, "v_mac_f16"},
+    {36, "v_madmk_f16"}, {37, "v_madak_f16"}, {38, "v_add_u16"}, {39, "v_sub_u16"},
+    {40, "v_subrev_u16"}, {41, "v_mul_lo_u16"}, {42, "v_lshlrev_b16"}, {43, "v_lshrrev_b16"},
+    {44, "v_ashrrev_i16"}, {45, "v_max_f16"}, {46, "v_min_f16"}, {47, "v_max_u16"},
+    {48, "v_max_i16"}, {49, "v_min_u16"}, {50, "v_min_i16"}, {51, "v_ldexp_f16"}
+};
+
+static const OpcodeName gs_VOP1_OPCODES[] =
+{
+    {0, "v_nop"}, {1, "v_mov_b32"}, {2, "v_readfirstlane_b32"}, {3, "v_cvt_i32_f64"},
+    {4, "v_cvt_f64_i32"}, {5, "v_cvt_f32_i32"}, {6, "v_cvt_f32_u32"}, {7, "v_cvt_u32_f32"},
+    {8, "v_cvt_i32_f32"}, {10, "v_cvt_f16_f32"}, {11, "v_cvt_f32_f16"}, {12, "v_cvt_rpi_i32_f32"},
+    {13, "v_cvt_flr_i32_f32"}, {14, "v_cvt_off_f32_i4"}, {15, "v_cvt_f32_f64"}, {16, "v_cvt_f64_f32"},
+    {17, "v_cvt_f32_ubyte0"}, {18, "v_cvt_f32_ubyte1"}, {19, "v_cvt_f32_ubyte2"}, {20, "v_cvt_f32_ubyte3"},
+    {21, "v_cvt_u32_f64"}, {22, "v_cvt_f64_u32"}, {23, "v_trunc_f64"}, {24, "v_ceil_f64"},
+    {25, "v_rndne_f64"}, {26, "v_floor_f64"}, {27, "v_fract_f32"}, {28, "v_trunc_f32"},
+    {29, "v_ceil_f32"}, {30, "v_rndne_f32"}, {31, "v_floor_f32"}, {32, "v_exp_f32"},
+    {33, "v_log_f32"}, {34, "v_rcp_f32"}, {35, "v_rcp_iflag_f32"}, {36, "v_rsq_f32"},
+    {37, "v_rcp_f64"}, {38, "v_rsq_f64"}, {39, "v_sqrt_f32"}, {40, "v_sqrt_f64"},
+    {41, "v_sin_f32"}, {42, "v_cos_f32"}, {43, "v_not_b32"}, {44, "v_bfrev_b32"},
+    {45, "v_ffbh_u32"}, {46, "v_ffbl_b32"}, {47, "v_ffbh_i32"}, {48, "v_frexp_exp_i32_f64"},
+    {49, "v_frexp_mant_f64"}, {50, "v_fract_f64"}, {51, "v_frexp_exp_i32_f32"}, {52, "v_frexp_mant_f32"},
+    {53, "v_clrexcp"}, {54, "v_movreld_b32"}, {55, "v_movrels_b32"}, {56, "v_movrelsd_b32"}
+};
+
+typedef struct
+{
+    uint16_t    m_opcode;
+    const char* m_pName;
+    uint8_t     m_numSources;
+} VOP3OpcodeName;
+
+/// The opcodes that only exist in the VOP3 encoding
+static const VOP3OpcodeName gs_VOP3_OPCODES[] =
+{
+    {0x1C0, "v_mad_legacy_f32", 3}, {0x1C1, "v_mad_f32", 3}, {0x1C2, "v_mad_i32_i24", 3}, {0x1C3, "v_mad_u32_u24", 3},
+    {0x1C4, "v_cubeid_f32", 3}, {0x1C5, "v_cubesc_f32", 3}, {0x1C6, "v_cubetc_f32", 3}, {0x1C7, "v_cubema_f32", 3},
+    {0x1C8, "v_bfe_u32", 3}, {0x1C9, "v_bfe_i32", 3}, {0x1CA, "v_bfi_b32", 3}, {0x1CB, "v_fma_f32", 3},
+    {0x1CC, "v_fma_f64", 3}, {0x1CD, "v_lerp_u8", 3}, {0x1CE, "v_alignbit_b32", 3}, {0x1CF, "v_alignbyte_b32", 3},
+    {0x1D0, "v_min3_f32", 3}, {0x1D1, "v_min3_i32", 3}, {0x1D2, "v_min3_u32", 3}, {0x1D3, "v_max3_f32", 3},
+    {0x1D4, "v_max3_i32", 3}, {0x1D5, "v_max3_u32", 3}, {0x1D6, "v_med3_f32", 3}, {0x1D7, "v_med3_i32", 3},
+    {0x1D8, "v_med3_u32", 3}, {0x1D9, "v_sad_u8", 3}, {0x1DA, "v_sad_hi_u8", 3}, {0x1DB, "v_sad_u16", 3},
+    {0x1DC, "v_sad_u32", 3}, {0x1DD, "v_cvt_pk_u8_f32", 3}, {0x1DE, "v_div_fixup_f32", 3}, {0x1DF, "v_div_fixup_f64", 3},
+    {0x1E0, "v_div_scale_f32", 3}, {0x1E1, "v_div_scale_f64", 3}, {0x1E2, "v_div_fmas_f32", 3}, {0x1E3, "v_div_fmas_f64", 3},
+    {0x1E4, "v_msad_u8", 3}, {0x1E5, "v_qsad_pk_u16_u8", 3}, {0x1E6, "v_mqsad_pk_u16_u8", 3}, {0x1E7, "v_mqsad_u32_u8", 3},
+    {0x1E8, "v_mad_u64_u32", 3}, {0x1E9, "v_mad_i64_i32", 3},
+    {0x280, "v_add_f64", 2}, {0x281, "v_mul_f64", 2}, {0x282, "v_min_f64", 2}, {0x283, "v_max_f64", 2},
+    {0x284, "v_ldexp_f64", 2}, {0x285, "v_mul_lo_u32", 2}, {0x286, "v_mul_hi_u32", 2}, {0x287, "v_mul_hi_i32", 2},
+    {0x288, "v_ldexp_f32", 2}, {0x289, "v_readlane_b32", 2}, {0x28A, "v_writelane_b32", 2}, {0x28B, "v_bcnt_u32_b32", 2},
+    {0x28C, "v_mbcnt_lo_u32_b32", 2}, {0x28D, "v_mbcnt_hi_u32_b32", 2}, {0x28F, "v_lshlrev_b64", 2}, {0x290, "v_lshrrev_b64", 2},
+    {0x291, "v_ashrrev_i64", 2}, {0x292, "v_trig_preop_f64", 2}, {0x293, "v_bfm_b32", 2}, {0x294, "v_cvt_pknorm_i16_f32", 2},
+    {0x295, "v_cvt_pknorm_u16_f32", 2}, {0x296, "v_cvt_pkrtz_f16_f32", 2}, {0x297, "v_cvt_pk_u16_u32", 2}, {0x298, "v_cvt_pk_i16_i32", 2}
+};
+
+static const OpcodeName gs_VINTRP_OPCODES[] =
+{
+    {0, "v_interp_p1_f32"}, {1, "v_interp_p2_f32"}, {2, "v_interp_mov_f32"}
+};
+
+typedef enum
+{
+    DS_FORM_NONE,       // No operand
+    DS_FORM_WRITE,      // vaddr, vdata0
+    DS_FORM_WRITE2,     // vaddr, vdata0, vdata1
+    DS_FORM_READ,       // vdst, vaddr
+    DS_FORM_READ2,      // vdst, vaddr with two offsets
+    DS_FORM_RETURN,     // vdst, vaddr, vdata0
+    DS_FORM_RETURN2     // vdst, vaddr, vdata0, vdata1
+} DSForm;
+
+typedef struct
+{
+    uint16_t    m_opcode;
+    const char* m_pName;
+    DSForm      m_form;
+} DSOpcodeName;
+
+static const DSOpcodeName gs_DS_OPCODES[] =
+{
+    {0, "ds_add_u32", DS_FORM_WRITE}, {1, "ds_sub_u32", DS_FORM_WRITE}, {2, "ds_rsub_u32", DS_FORM_WRITE},
+    {3, "ds_inc_u32", DS_FORM_WRITE}, {4, "ds_dec_u32", DS_FORM_WRITE}, {5, "ds_min_i32", DS_FORM_WRITE},
+    {6, "ds_max_i32", DS_FORM_WRITE}, {7, "ds_min_u32", DS_FORM_WRITE}, {8, "ds_max_u32", DS_FORM_WRITE},
+    {9, "ds_and_b32", DS_FORM_WRITE}, {10, "ds_or_b32", DS_FORM_WRITE}, {11, "ds_xor_b32", DS_FORM_WRITE},
+    {12, "ds_mskor_b32", DS_FORM_WRITE2}, {13, "ds_write_b32", DS_FORM_WRITE}, {14, "ds_write2_b32", DS_FORM_WRITE2},
+    {15, "ds_write2st64_b32", DS_FORM_WRITE2}, {16, "ds_cmpst_b32", DS_FORM_WRITE2}, {17, "ds_cmpst_f32", DS_FORM_WRITE2},
+    {18, "ds_min_f32", DS_FORM_WRITE}, {19, "ds_max_f32", DS_FORM_WRITE}, {20, "ds_nop", DS_FORM_NONE},
+    {21, "ds_add_f32", DS_FORM_WRITE}, {30, "ds_write_b8", DS_FORM_WRITE}, {31, "ds_write_b16", DS_FORM_WRITE},
+    {32, "ds_add_rtn_u32", DS_FORM_RETURN}, {33, "ds_sub_rtn_u32", DS_FORM_RETURN}, {34, "ds_rsub_rtn_u32", DS_FORM_RETURN},
+    {35, "ds_inc_rtn_u32", DS_FORM_RETURN}, {36, "ds_dec_rtn_u32", DS_FORM_RETURN}, {37, "ds_min_rtn_i32", DS_FORM_RETURN},
+    {38, "ds_max_rtn_i32", DS_FORM_RETURN}, {39, "ds_min_rtn_u32", DS_FORM_RETURN}, {40, "ds_max_rtn_u32", DS_FORM_RETURN},
+    {41, "ds_and_rtn_b32", DS_FORM_RETURN}, {42, "ds_or_rtn_b32", DS_FORM_RETURN}, {43, "ds_xor_rtn_b32", DS_FORM_RETURN},
+    {44, "ds_mskor_rtn_b32", DS_FORM_RETURN2}, {45, "ds_wrxchg_rtn_b32", DS_FORM_RETURN}, {46, "ds_wrxchg2_rtn_b32", DS_FORM_RETURN2},
+    {47, "ds_wrxchg2st64_rtn_b32", DS_FORM_RETURN2}, {48, "ds_cmpst_rtn_b32", DS_FORM_RETURN2}, {49, "ds_cmpst_rtn_f32", DS_FORM_RETURN2},
+    {50, "ds_min_rtn_f32", DS_FORM_RETURN}, {51, "ds_max_rtn_f32", DS_FORM_RETURN}, {52, "ds_wrap_rtn_b32", DS_FORM_RETURN2},
+    {53, "ds_add_rtn_f32", DS_FORM_RETURN}, {54, "ds_read_b32", DS_FORM_READ}, {55, "ds_read2_b32", DS_FORM_READ2},
+    {56, "ds_read2st64_b32", DS_FORM_READ2}, {57, "ds_read_i8", DS_FORM_READ}, {58, "ds_read_u8", DS_FORM_READ},
+    {59, "ds_read_i16", DS_FORM_READ}, {60, "ds_read_u16", DS_FORM_READ}, {61, "ds_swizzle_b32", DS_FORM_READ},
+    {62, "ds_permute_b32", DS_FORM_RETURN}, {63, "ds_bpermute_b32", DS_FORM_RETURN}, {77, "ds_write_b64", DS_FORM_WRITE},
+    {78, "ds_write2_b64", DS_FORM_WRITE2}, {79, "ds_write2st64_b64", DS_FORM_WRITE2}, {118, "ds_read_b64", DS_FORM_READ},
+    {119, "ds_read2_b64", DS_FORM_READ2}, {120, "ds_read2st64_b64", DS_FORM_READ2}, {222, "ds_write_b96", DS_FORM_WRITE},
+    {223, "ds_write_b128", DS_FORM_WRITE}, {254, "ds_read_b96", DS_FORM_READ}, {255, "ds_read_b128", DS_FORM_READ}
+};
+
+static const OpcodeName gs_FLAT_OPCODES[] =
+{
+    {16, "flat_load_ubyte"}, {17, "flat_load_sbyte"}, {18, "flat_load_ushort"}, {19, "flat_load_sshort"},
+    {20, "flat_load_dword"}, {21, "flat_load_dwordx2"}, {22, "flat_load_dwordx3"}, {23, "flat_load_dwordx4"},
+    {24, "flat_store_byte"}, {26, "flat_store_short"}, {28, "flat_store_dword"}, {29, "flat_store_dwordx2"},
+    {30, "flat_store_dwordx3"}, {31, "flat_store_dwordx4"}, {64, "flat_atomic_swap"}, {65, "flat_atomic_cmpswap"},
+    {66, "flat_atomic_add"}, {67, "flat_atomic_sub"}, {68, "flat_atomic_smin"}, {69, "flat_atomic_umin"},
+    {70, "flat_atomic_smax"}, {71, "flat_atomic_umax"}, {72, "flat_atomic_and"}, {73, "flat_atomic_or"},
+    {74, "flat_atomic_xor"}, {75, "flat_atomic_inc"}, {76, "flat_atomic_dec"}, {96, "flat_atomic_swap_x2"},
+    {97, "flat_atomic_cmpswap_x2"}, {98, "flat_atomic_add_x2"}, {99, "flat_atomic_sub_x2"}, {100, "flat_atomic_smin_x2"},
+    {101, "flat_atomic_umin_x2"}, {102, "flat_atomic_smax_x2"}, {103, "flat_atomic_umax_x2"}, {104, "flat_atomic_and_x2"},
+    {105, "flat_atomic_or_x2"}, {106, "flat_atomic_xor_x2"}, {107, "flat_atomic_inc_x2"}, {108, "flat_atomic_dec_x2"}
+};
+
+static const OpcodeName gs_MUBUF_OPCODES[] =
+{
+    {0, "buffer_load_format_x"}, {1, "buffer_load_format_xy"}, {2, "buffer_load_format_xyz"}, {3, "buffer_load_format_xyzw"},
+    {4, "buffer_store_format_x"}, {5, "buffer_store_format_xy"}, {6, "buffer_store_format_xyz"}, {7, "buffer_store_format_xyzw"},
+    {16, "buffer_load_ubyte"}, {17, "buffer_load_sbyte"}, {18, "buffer_load_ushort"}, {19, "buffer_load_sshort"},
+    {20, "buffer_load_dword"}, {21, "buffer_load_dwordx2"}, {22, "buffer_load_dwordx3"}, {23, "buffer_load_dwordx4"},
+    {24, "buffer_store_byte"}, {26, "buffer_store_short"}, {28, "buffer_store_dword"}, {29, "buffer_store_dwordx2"},
+    {30, "buffer_store_dwordx3"}, {31, "buffer_store_dwordx4"}, {61, "buffer_store_lds_dword"}, {62, "buffer_wbinvl1"},
+    {63, "buffer_wbinvl1_vol"}, {64, "buffer_atomic_swap"}, {65, "buffer_atomic_cmpswap"}, {66, "buffer_atomic_add"},
+    {67, "buffer_atomic_sub"}, {68, "buffer_atomic_smin"}, {69, "buffer_atomic_umin"}, {70, "buffer_atomic_smax"},
+    {71, "buffer_atomic_umax"}, {72, "buffer_atomic_and"}, {73, "buffer_atomic_or"}, {74, "buffer_atomic_xor"},
+    {75, "buffer_atomic_inc"}, {76, "buffer_atomic_dec"}, {96, "buffer_atomic_swap_x2"}, {97, "buffer_atomic_cmpswap_x2"},
+    {98, "buffer_atomic_add_x2"}, {99, "buffer_atomic_sub_x2"}, {100, "buffer_atomic_smin_x2"}, {101, "buffer_atomic_umin_x2"},
+    {102, "buffer_atomic_smax_x2"}, {103, "buffer_atomic_umax_x2"}, {104, "buffer_atomic_and_x2"}, {105, "buffer_atomic_or_x2"},
+    {106, "buffer_atomic_xor_x2"}, {107, "buffer_atomic_inc_x2"}, {108, "buffer_atomic_dec_x2"}
+};
+
+static const OpcodeName gs_MTBUF_OPCODES[] =
+{
+    {0, "tbuffer_load_format_x"}, {1, "tbuffer_load_format_xy"}, {2, "tbuffer_load_format_xyz"}, {3, "tbuffer_load_format_xyzw"},
+    {4, "tbuffer_store_format_x"}, {5, "tbuffer_store_format_xy"}, {6, "tbuffer_store_format_xyz"}, {7, "tbuffer_store_format_xyzw"}
+};
+
+static const OpcodeName gs_MIMG_OPCODES[] =
+{
+    {0, "image_load"}, {1, "image_load_mip"}, {2, "image_load_pck"}, {3, "image_load_pck_sgn"},
+    {4, "image_load_mip_pck"}, {5, "image_load_mip_pck_sgn"}, {8, "image_store"}, {9, "image_store_mip"},
+    {10, "image_store_pck"}, {11, "image_store_mip_pck"}, {14, "image_get_resinfo"}, {32, "image_sample"},
+    {33, "image_sample_cl"}, {34, "image_sample_d"}, {35, "image_sample_d_cl"}, {36, "image_sample_l"},
+    {37, "image_sample_b"}, {38, "image_sample_b_cl"}, {39, "image_sample_lz"}, {64, "image_gather4"},
+    {96, "image_get_lod"}
+};
+
+#define GCN_TABLE_SIZE(table) (sizeof(table) / sizeof(table[0]))
+
+/// Binary search of an opcode in a table sorted by opcode
+template <typename EntryType>
+static const EntryType* FindOpcode(const EntryType* pTable, const size_t numEntries, const uint16_t opcode)
+{
+    const EntryType* pEnd = pTable + numEntries;
+    const EntryType* pEntry = std::lower_bound(pTable, pEnd, opcode,
+                                               [](const EntryType& entry, const uint16_t value)
+                                               {
+                                                   return entry.m_opcode < value;
+                                               });
+
+    if (pEntry == pEnd || pEntry->m_opcode != opcode)
+    {
+        return nullptr;
+    }
+
+    return pEntry;
+}
+
+template <typename EntryType>
+static const char* FindOpcodeName(const EntryType* pTable, const size_t numEntries, const uint16_t opcode)
+{
+    const EntryType* pEntry = FindOpcode(pTable, numEntries, opcode);
+    return (pEntry != nullptr) ? pEntry->m_pName : nullptr;
+}
+
+static std::string ToHex(const uint64_t value)
+{
+    std::stringstream hexStream;
+    hexStream << "0x" << std::hex << value;
+    return hexStream.str();
+}
+
+/// Name of the VOPC compares, the condition and the type follow from the opcode
+static std::string GetVOPCName(const uint16_t opcode)
+{
+    static const char* const CLASS_NAMES[] =
+    {
+        "v_cmp_class_f32", "v_cmpx_class_f32", "v_cmp_class_f64", "v_cmpx_class_f64", "v_cmp_class_f16", "v_cmpx_class_f16"
+    };
+    static const char* const FLOAT_CONDITIONS[] =
+    {
+        "f", "lt", "eq", "le", "gt", "lg", "ge", "o", "u", "nge", "nlg", "ngt", "nle", "neq", "nlt", "tru"
+    };
+    static const char* const FLOAT_GROUPS[] = {"v_cmp_%_f16", "v_cmpx_%_f16", "v_cmp_%_f32", "v_cmpx_%_f32", "v_cmp_%_f64", "v_cmpx_%_f64"};
+    static const char* const INT_CONDITIONS[] = {"f", "lt", "eq", "le", "gt", "ne", "ge", "t"};
+    static const char* const INT_GROUPS[] =
+    {
+        "v_cmp_%_i16", "v_cmp_%_u16", "v_cmpx_%_i16", "v_cmpx_%_u16",
+        "v_cmp_%_i32", "v_cmp_%_u32", "v_cmpx_%_i32", "v_cmpx_%_u32",
+        "v_cmp_%_i64", "v_cmp_%_u64", "v_cmpx_%_i64", "v_cmpx_%_u64"
+    };
+
+    std::string name;
+    const char* pCondition = nullptr;
+
+    if (opcode >= 0x10 && opcode <= 0x15)
+    {
+        return CLASS_NAMES[opcode - 0x10];
+    }
+    else if (opcode >= 0x20 && opcode <= 0x7F)
+    {
+        name = FLOAT_GROUPS[(opcode - 0x20) / 16];
+        pCondition = FLOAT_CONDITIONS[opcode % 16];
+    }
+    else if (opcode >= 0xA0 && opcode <= 0xFF)
+    {
+        name = INT_GROUPS[(opcode - 0xA0) / 8];
+        pCondition = INT_CONDITIONS[opcode % 8];
+    }
+    else
+    {
+        return std::string();
+    }
+
+    name.replace(name.find('%'), 1, pCondition);
+    return name;
+}
+
+/// Get the number of bits of a type suffix like "b32", "f64" or "u16", 0 if it is not a type
+static unsigned int GetTypeBits(const std::string& token)
+{
+    if (token.size() < 2 || std::string("biuf").find(token[0]) == std::string::npos)
+    {
+        return 0;
+    }
+
+    for (size_t i = 1; i < token.size(); i++)
+    {
+        if (token[i] < '0' || token[i] > '9')
+        {
+            return 0;
+        }
+    }
+
+    return static_cast<unsigned int>(strtoul(token.c_str() + 1, nullptr, 10));
+}
+
+/// Get the registers used by the destination and the sources of an ALU instruction
+/// from the type suffixes of its name: "v_cvt_f64_i32" writes 2 registers and reads 1
+static void GetOperandRegs(const std::string& name, unsigned int& dstRegsOut, unsigned int& srcRegsOut)
+{
+    unsigned int firstBits = 0;
+    unsigned int lastBits = 0;
+
+    std::stringstream nameStream(name);
+    std::string token;
+
+    while (std::getline(nameStream, token, '_'))
+    {
+        unsigned int bits = GetTypeBits(token);
+
+        if (bits != 0)
+        {
+            if (firstBits == 0)
+            {
+                firstBits = bits;
+            }
+
+            lastBits = bits;
+        }
+    }
+
+    dstRegsOut = (firstBits > 32) ? firstBits / 32 : 1;
+    srcRegsOut = (lastBits > 32) ? lastBits / 32 : 1;
+}
+
+/// Get the registers of the data of a memory instruction from its name
+static unsigned int GetDataRegs(const std::string& name)
+{
+    static const struct
+    {
+        const char*  m_pSuffix;
+        unsigned int m_numRegs;
+    } DATA_SUFFIXES[] =
+    {
+        {"dwordx16", 16}, {"dwordx8", 8}, {"dwordx4", 4}, {"dwordx3", 3}, {"dwordx2", 2},
+        {"_b128", 4}, {"_b96", 3}, {"_b64", 2}, {"_x2", 2},
+        {"format_xyzw", 4}, {"format_xyz", 3}, {"format_xy", 2}
+    };
+
+    for (size_t i = 0; i < GCN_TABLE_SIZE(DATA_SUFFIXES); i++)
+    {
+        const size_t suffixLen = strlen(DATA_SUFFIXES[i].m_pSuffix);
+
+        if (name.size() >= suffixLen &&
+            name.compare(name.size() - suffixLen, suffixLen, DATA_SUFFIXES[i].m_pSuffix) == 0)
+        {
+            return DATA_SUFFIXES[i].m_numRegs;
+        }
+    }
+
+    return 1;
+}
+
+/// Render a register or a range of registers: "v4" or "s[4:5]"
+static std::string RenderRegisters(const char* pPrefix, const unsigned int firstReg, const unsigned int numRegs)
+{
+    std::stringstream regStream;
+
+    if (numRegs <= 1)
+    {
+        regStream << pPrefix << firstReg;
+    }
+    else
+    {
+        regStream << pPrefix << "[" << firstReg << ":" << firstReg + numRegs - 1 << "]";
+    }
+
+    return regStream.str();
+}
+
+/// Render a scalar operand: a SGPR, a special register or an inline constant
+static std::string RenderScalarOperand(const unsigned int code, const unsigned int numRegs, const uint32_t literal)
+{
+    static const char* const FLOAT_CONSTANTS[] = {"0.5", "-0.5", "1.0", "-1.0", "2.0", "-2.0", "4.0", "-4.0", "0.15915494"};
+
+    if (code <= 101)
+    {
+        return RenderRegisters("s", code, numRegs);
+    }
+
+    if (code >= 112 && code <= 123)
+    {
+        return RenderRegisters("ttmp", code - 112, numRegs);
+    }
+
+    if (code >= 129 && code <= 192)
+    {
+        return std::to_string(code - 128);
+    }
+
+    if (code >= 193 && code <= 208)
+    {
+        return std::to_string(192 - static_cast<int>(code));
+    }
+
+    if (code >= 240 && code <= 248)
+    {
+        return FLOAT_CONSTANTS[code - 240];
+    }
+
+    switch (code)
+    {
+        case 102:
+            return (numRegs > 1) ? "flat_scratch" : "flat_scratch_lo";
+
+        case 103:
+            return "flat_scratch_hi";
+
+        case 104:
+            return (numRegs > 1) ? "xnack_mask" : "xnack_mask_lo";
+
+        case 105:
+            return "xnack_mask_hi";
+
+        case 106:
+            return (numRegs > 1) ? "vcc" : "vcc_lo";
+
+        case 107:
+            return "vcc_hi";
+
+        case 108:
+            return (numRegs > 1) ? "tba" : "tba_lo";
+
+        case 109:
+            return "tba_hi";
+
+        case 110:
+            return (numRegs > 1) ? "tma" : "tma_lo";
+
+        case 111:
+            return "tma_hi";
+
+        case 124:
+            return "m0";
+
+        case 126:
+            return (numRegs > 1) ? "exec" : "exec_lo";
+
+        case 127:
+            return "exec_hi";
+
+        case 128:
+            return "0";
+
+        case 251:
+            return "vccz";
+
+        case 252:
+            return "execz";
+
+        case 253:
+            return "scc";
+
+        case 254:
+            return "lds_direct";
+
+        case 255:
+            return ToHex(literal);
+
+        default:
+            return "src_" + std::to_string(code);
+    }
+}
+
+/// Render a 9 bit source operand, the codes from 256 are VGPRs
+static std::string RenderSourceOperand(const unsigned int code, const unsigned int numRegs, const uint32_t literal)
+{
+    if (code >= 256)
+    {
+        return RenderRegisters("v", code - 256, numRegs);
+    }
+
+    return RenderScalarOperand(code, numRegs, literal);
+}
+
+/// Render a VOP3 source with its neg and abs modifiers
+static std::string RenderVOP3Source(const unsigned int code,
+                                    const unsigned int numRegs,
+                                    const bool         isNeg,
+                                    const bool         isAbs)
+{
+    std::string source = RenderSourceOperand(code, numRegs, 0);
+
+    if (isAbs)
+    {
+        source = "|" + source + "|";
+    }
+
+    if (isNeg)
+    {
+        source = "-" + source;
+    }
+
+    return source;
+}
+
+/// Get the field of an instruction word
+static uint32_t GetBits(const uint32_t word, const unsigned int firstBit, const unsigned int numBits)
+{
+    return (word >> firstBit) & ((numBits >= 32) ? 0xFFFFFFFF : ((1u << numBits) - 1));
+}
+
+/// Get the mnemonic of an instruction, empty if the opcode is not in the tables
+static std::string GetInstructionName(const AgentGCNInstruction& instruction)
+{
+    const char* pName = nullptr;
+    const uint16_t opcode = instruction.m_opcode;
+
+    switch (instruction.m_encoding)
+    {
+        case AGENT_GCN_ENCODING_SOP2:
+            pName = FindOpcodeName(gs_SOP2_OPCODES, GCN_TABLE_SIZE(gs_SOP2_OPCODES), opcode);
+            break;
+
+        case AGENT_GCN_ENCODING_SOPK:
+            pName = FindOpcodeName(gs_SOPK_OPCODES, GCN_TABLE_SIZE(gs_SOPK_OPCODES), opcode);
+            break;
+
+        case AGENT_GCN_ENCODING_SOP1:
+            pName = FindOpcodeName(gs_SOP1_OPCODES, GCN_TABLE_SIZE(gs_SOP1_OPCODES), opcode);
+            break;
+
+        case AGENT_GCN_ENCODING_SOPC:
+            pName = FindOpcodeName(gs_SOPC_OPCODES, GCN_TABLE_SIZE(gs_SOPC_OPCODES), opcode);
+            break;
+
+        case AGENT_GCN_ENCODING_SOPP:
+            pName = FindOpcodeName(gs_SOPP_OPCODES, GCN_TABLE_SIZE(gs_SOPP_OPCODES), opcode);
+            break;
+
+        case AGENT_GCN_ENCODING_SMEM:
+            pName = FindOpcodeName(gs_SMEM_OPCODES, GCN_TABLE_SIZE(gs_SMEM_OPCODES), opcode);
+            break;
+
+        case AGENT_GCN_ENCODING_VOP2:
+            pName = FindOpcodeName(gs_VOP2_OPCODES, GCN_TABLE_SIZE(gs_VOP2_OPCODES), opcode);
+            break;
+
+        case AGENT_GCN_ENCODING_VOP1:
+            pName = FindOpcodeName(gs_VOP1_OPCODES, GCN_TABLE_SIZE(gs_VOP1_OPCODES), opcode);
+            break;
+
+        case AGENT_GCN_ENCODING_VOPC:
+            return GetVOPCName(opcode);
+
+        case AGENT_GCN_ENCODING_VOP3:
+            // The VOPC, VOP2 and VOP1 opcodes have a VOP3 form too
+            if (opcode < 0x100)
+            {
+                std::string vopcName = GetVOPCName(opcode);
+                return vopcName.empty() ? vopcName : vopcName + "_e64";
+            }
+            else if (opcode < 0x140)
+            {
+                pName = FindOpcodeName(gs_VOP2_OPCODES, GCN_TABLE_SIZE(gs_VOP2_OPCODES), opcode - 0x100);
+                return (pName == nullptr) ? std::string() : std::string(pName) + "_e64";
+            }
+            else if (opcode < 0x1C0)
+            {
+                pName = FindOpcodeName(gs_VOP1_OPCODES, GCN_TABLE_SIZE(gs_VOP1_OPCODES), opcode - 0x140);
+                return (pName == nullptr) ? std::string() : std::string(pName) + "_e64";
+            }
+
+            pName = FindOpcodeName(gs_VOP3_OPCODES, GCN_TABLE_SIZE(gs_VOP3_OPCODES), opcode);
+            break;
+
+        case AGENT_GCN_ENCODING_VINTRP:
+            pName = FindOpcodeName(gs_VINTRP_OPCODES, GCN_TABLE_SIZE(gs_VINTRP_OPCODES), opcode);
+            break;
+
+        case AGENT_GCN_ENCODING_DS:
+            pName = FindOpcodeName(gs_DS_OPCODES, GCN_TABLE_SIZE(gs_DS_OPCODES), opcode);
+            break;
+
+        case AGENT_GCN_ENCODING_FLAT:
+            pName = FindOpcodeName(gs_FLAT_OPCODES, GCN_TABLE_SIZE(gs_FLAT_OPCODES), opcode);
+            break;
+
+        case AGENT_GCN_ENCODING_MUBUF:
+            pName = FindOpcodeName(gs_MUBUF_OPCODES, GCN_TABLE_SIZE(gs_MUBUF_OPCODES), opcode);
+            break;
+
+        case AGENT_GCN_ENCODING_MTBUF:
+            pName = FindOpcodeName(gs_MTBUF_OPCODES, GCN_TABLE_SIZE(gs_MTBUF_OPCODES), opcode);
+            break;
+
+        case AGENT_GCN_ENCODING_MIMG:
+            pName = FindOpcodeName(gs_MIMG_OPCODES, GCN_TABLE_SIZE(gs_MIMG_OPCODES), opcode);
+            break;
+
+        case AGENT_GCN_ENCODING_EXP:
+            return "exp";
+
+        default:
+            break;
+    }
+
+    return (pName == nullptr) ? std::string() : std::string(pName);
+}
+
+/// Join the operands with ", " after the mnemonic
+static std::string JoinOperands(const std::string& name, const std::vector<std::string>& operands)
+{
+    std::string text(name);
+
+    for (size_t i = 0; i < operands.size(); i++)
+    {
+        text += (i == 0) ? " " : ", ";
+        text += operands[i];
+    }
+
+    return text;
+}
+
+static std::string RenderSOPP(const AgentGCNInstruction& instruction, const std::string& name)
+{
+    const uint32_t simm16 = GetBits(instruction.m_words[0], 0, 16);
+
+    switch (instruction.m_opcode)
+    {
+        case 1:     // s_endpgm
+        case 10:    // s_barrier
+        case 19:    // s_icache_inv
+        case 22:    // s_ttracedata
+        case 27:    // s_endpgm_saved
+        case 28:    // s_set_gpr_idx_off
+            return name;
+
+        case 12:    // s_waitcnt
+        {
+            const uint32_t vmCount = GetBits(simm16, 0, 4);
+            const uint32_t expCount = GetBits(simm16, 4, 3);
+            const uint32_t lgkmCount = GetBits(simm16, 8, 4);
+
+            std::stringstream waitStream;
+            waitStream << name;
+
+            // The counters at their maximum are not waited for
+            if (vmCount != 0xF)
+            {
+                waitStream << " vmcnt(" << vmCount << ")";
+            }
+
+            if (expCount != 0x7)
+            {
+                waitStream << " expcnt(" << expCount << ")";
+            }
+
+            if (lgkmCount != 0xF)
+            {
+                waitStream << " lgkmcnt(" << lgkmCount << ")";
+            }
+
+            return waitStream.str();
+        }
+
+        default:
+            break;
+    }
+
+    // The branches have a signed offset in words from the next instruction
+    if ((instruction.m_opcode >= 2 && instruction.m_opcode <= 9) ||
+        (instruction.m_opcode >= 23 && instruction.m_opcode <= 26))
+    {
+        return name + " " + std::to_string(static_cast<int16_t>(simm16));
+    }
+
+    // The message and the index mode are bit fields, the other immediates are counts
+    if (instruction.m_opcode == 16 || instruction.m_opcode == 17 || instruction.m_opcode == 29)
+    {
+        return name + " " + ToHex(simm16);
+    }
+
+    return name + " " + std::to_string(simm16);
+}
+
+static std::string RenderSMEM(const AgentGCNInstruction& instruction, const std::string& name)
+{
+    const uint32_t word0 = instruction.m_words[0];
+    const uint32_t word1 = instruction.m_words[1];
+
+    const unsigned int sbase = GetBits(word0, 0, 6) * 2;
+    const unsigned int sdata = GetBits(word0, 6, 7);
+    const bool isImmOffset = GetBits(word0, 17, 1) != 0;
+    const bool isGlc = GetBits(word0, 16, 1) != 0;
+    const uint32_t offset = GetBits(word1, 0, 20);
+
+    std::vector<std::string> operands;
+
+    if (instruction.m_opcode >= 32 && instruction.m_opcode <= 35)
+    {
+        // The cache invalidations have no operand
+        return name;
+    }
+
+    if (instruction.m_opcode == 36 || instruction.m_opcode == 37)
+    {
+        // s_memtime and s_memrealtime only write a 64 bit counter
+        operands.push_back(RenderScalarOperand(sdata, 2, 0));
+        return JoinOperands(name, operands);
+    }
+
+    const bool isBuffer = (name.find("buffer") != std::string::npos);
+
+    operands.push_back(RenderScalarOperand(sdata, GetDataRegs(name), 0));
+    operands.push_back(RenderScalarOperand(sbase, isBuffer ? 4 : 2, 0));
+    operands.push_back(isImmOffset ? ToHex(offset) : RenderScalarOperand(GetBits(offset, 0, 8), 1, 0));
+
+    std::string text = JoinOperands(name, operands);
+
+    if (isGlc)
+    {
+        text += " glc";
+    }
+
+    return text;
+}
+
+static std::string RenderVOP3(const AgentGCNInstruction& instruction, const std::string& name)
+{
+    const uint32_t word0 = instruction.m_words[0];
+    const uint32_t word1 = instruction.m_words[1];
+    const uint16_t opcode = instruction.m_opcode;
+
+    const unsigned int vdst = GetBits(word0, 0, 8);
+    const unsigned int absBits = GetBits(word0, 8, 3);
+    const unsigned int sdst = GetBits(word0, 8, 7);
+    const bool isClamp = GetBits(word0, 15, 1) != 0;
+    const unsigned int sources[3] = {GetBits(word1, 0, 9), GetBits(word1, 9, 9), GetBits(word1, 18, 9)};
+    const unsigned int omod = GetBits(word1, 27, 2);
+    const unsigned int negBits = GetBits(word1, 29, 3);
+
+    // The carry out ops and the div_scale and mad_*64 ops have a SGPR destination instead of abs bits
+    const bool hasScalarDst = (opcode >= 0x119 && opcode <= 0x11E) ||
+                              opcode == 0x1E0 || opcode == 0x1E1 || opcode == 0x1E8 || opcode == 0x1E9;
+
+    unsigned int dstRegs = 1;
+    unsigned int srcRegs = 1;
+    GetOperandRegs(name, dstRegs, srcRegs);
+
+    unsigned int numSources = 2;
+
+    if (opcode >= 0x140 && opcode < 0x1C0)
+    {
+        numSources = 1;
+    }
+    else if (opcode >= 0x1C0)
+    {
+        const VOP3OpcodeName* pEntry = FindOpcode(gs_VOP3_OPCODES, GCN_TABLE_SIZE(gs_VOP3_OPCODES), opcode);
+        numSources = (pEntry != nullptr) ? pEntry->m_numSources : 3;
+    }
+    else if (opcode == 0x100 || (opcode >= 0x11C && opcode <= 0x11E))
+    {
+        // v_cndmask_b32 and the carry in ops read a SGPR pair as src2
+        numSources = 3;
+    }
+
+    std::vector<std::string> operands;
+
+    if (opcode < 0x100)
+    {
+        // A compare writes a SGPR pair
+        operands.push_back(RenderScalarOperand(vdst, 2, 0));
+    }
+    else if (opcode == 0x142 || opcode == 0x289)
+    {
+        // v_readfirstlane_b32 and v_readlane_b32 write a SGPR
+        operands.push_back(RenderScalarOperand(vdst, 1, 0));
+    }
+    else
+    {
+        operands.push_back(RenderRegisters("v", vdst, dstRegs));
+    }
+
+    if (hasScalarDst)
+    {
+        operands.push_back(RenderScalarOperand(sdst, 2, 0));
+    }
+
+    for (unsigned int i = 0; i < numSources; i++)
+    {
+        unsigned int numRegs = srcRegs;
+
+        if (i == 2 && (opcode == 0x100 || (opcode >= 0x11C && opcode <= 0x11E)))
+        {
+            numRegs = 2;
+        }
+
+        const bool isNeg = ((negBits >> i) & 1) != 0;
+        const bool isAbs = !hasScalarDst && ((absBits >> i) & 1) != 0;
+
+        operands.push_back(RenderVOP3Source(sources[i], numRegs, isNeg, isAbs));
+    }
+
+    std::string text = JoinOperands(name, operands);
+
+    if (isClamp)
+    {
+        text += " clamp";
+    }
+
+    static const char* const OUTPUT_MODIFIERS[] = {"", " mul:2", " mul:4", " div:2"};
+    text += OUTPUT_MODIFIERS[omod];
+
+    return text;
+}
+
+/// The 32 bit forms of the ops that also have a VOP3 form are printed with "_e32"
+static bool HasVOP3Form(const AgentGCNInstruction& instruction)
+{
+    const uint16_t opcode = instruction.m_opcode;
+
+    switch (instruction.m_encoding)
+    {
+        case AGENT_GCN_ENCODING_VOP1:
+            // v_nop, v_readfirstlane_b32 and v_clrexcp
+            return opcode != 0 && opcode != 2 && opcode != 53;
+
+        case AGENT_GCN_ENCODING_VOP2:
+            // v_madmk and v_madak carry a literal that VOP3 cannot encode
+            return opcode != 23 && opcode != 24 && opcode != 36 && opcode != 37;
+
+        case AGENT_GCN_ENCODING_VOPC:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+/// Render VOP1, VOP2 and VOPC, with their SDWA and DPP forms
+static std::string RenderVOP(const AgentGCNInstruction& instruction, const std::string& name)
+{
+    const uint32_t word0 = instruction.m_words[0];
+    const uint32_t literal = (instruction.m_numWords > 1) ? instruction.m_words[1] : 0;
+
+    unsigned int dstRegs = 1;
+    unsigned int srcRegs = 1;
+    GetOperandRegs(name, dstRegs, srcRegs);
+
+    unsigned int src0 = GetBits(word0, 0, 9);
+    std::string mnemonic(name);
+    std::string suffix;
+
+    // The SDWA and DPP forms keep src0 in the second word
+    if (src0 == 249 || src0 == 250)
+    {
+        const uint32_t word1 = instruction.m_words[1];
+
+        mnemonic += (src0 == 249) ? "_sdwa" : "_dpp";
+
+        if (src0 == 250)
+        {
+            suffix = " dpp_ctrl:" + ToHex(GetBits(word1, 8, 9));
+        }
+
+        src0 = 256 + GetBits(word1, 0, 8);
+    }
+    else if (HasVOP3Form(instruction))
+    {
+        mnemonic += "_e32";
+    }
+
+    const std::string src0Text = RenderSourceOperand(src0, srcRegs, literal);
+
+    std::vector<std::string> operands;
+
+    switch (instruction.m_encoding)
+    {
+        case AGENT_GCN_ENCODING_VOP1:
+        {
+            const unsigned int vdst = GetBits(word0, 17, 8);
+
+            if (instruction.m_opcode == 0 || instruction.m_opcode == 53)
+            {
+                // v_nop and v_clrexcp have no operand
+                return mnemonic;
+            }
+
+            if (instruction.m_opcode == 2)
+            {
+                // v_readfirstlane_b32 writes a SGPR
+                operands.push_back(RenderScalarOperand(vdst, 1, 0));
+            }
+            else
+            {
+                operands.push_back(RenderRegisters("v", vdst, dstRegs));
+            }
+
+            operands.push_back(src0Text);
+            break;
+        }
+
+        case AGENT_GCN_ENCODING_VOP2:
+        {
+            const unsigned int vdst = GetBits(word0, 17, 8);
+            const std::string vsrc1 = RenderRegisters("v", GetBits(word0, 9, 8), srcRegs);
+            const uint16_t opcode = instruction.m_opcode;
+
+            operands.push_back(RenderRegisters("v", vdst, dstRegs));
+
+            // The carry ops write vcc
+            if (opcode >= 25 && opcode <= 30)
+            {
+                operands.push_back("vcc");
+            }
+
+            operands.push_back(src0Text);
+
+            if (opcode == 23 || opcode == 36)
+            {
+                // madmk: the constant is the multiplier
+                operands.push_back(ToHex(literal));
+                operands.push_back(vsrc1);
+            }
+            else if (opcode == 24 || opcode == 37)
+            {
+                // madak: the constant is added
+                operands.push_back(vsrc1);
+                operands.push_back(ToHex(literal));
+            }
+            else
+            {
+                operands.push_back(vsrc1);
+            }
+
+            // v_cndmask_b32 and the carry in ops read vcc
+            if (opcode == 0 || (opcode >= 28 && opcode <= 30))
+            {
+                operands.push_back("vcc");
+            }
+
+            break;
+        }
+
+        case AGENT_GCN_ENCODING_VOPC:
+            operands.push_back("vcc");
+            operands.push_back(src0Text);
+            operands.push_back(RenderRegisters("v", GetBits(word0, 9, 8), srcRegs));
+            break;
+
+        default:
+            break;
+    }
+
+    return JoinOperands(mnemonic, operands) + suffix;
+}
+
+static std::string RenderDS(const AgentGCNInstruction& instruction, const std::string& name)
+{
+    const uint32_t word0 = instruction.m_words[0];
+    const uint32_t word1 = instruction.m_words[1];
+
+    const unsigned int offset0 = GetBits(word0, 0, 8);
+    const unsigned int offset1 = GetBits(word0, 8, 8);
+    const bool isGds = GetBits(word0, 16, 1) != 0;
+
+    const std::string vaddr = RenderRegisters("v", GetBits(word1, 0, 8), 1);
+    const unsigned int numDataRegs = GetDataRegs(name);
+    const std::string vdata0 = RenderRegisters("v", GetBits(word1, 8, 8), numDataRegs);
+    const std::string vdata1 = RenderRegisters("v", GetBits(word1, 16, 8), numDataRegs);
+    const unsigned int vdst = GetBits(word1, 24, 8);
+
+    const DSOpcodeName* pEntry = FindOpcode(gs_DS_OPCODES, GCN_TABLE_SIZE(gs_DS_OPCODES), instruction.m_opcode);
+    const DSForm form = (pEntry != nullptr) ? pEntry->m_form : DS_FORM_NONE;
+
+    std::vector<std::string> operands;
+    bool hasTwoOffsets = false;
+
+    switch (form)
+    {
+        case DS_FORM_WRITE:
+            operands.push_back(vaddr);
+            operands.push_back(vdata0);
+            break;
+
+        case DS_FORM_WRITE2:
+            operands.push_back(vaddr);
+            operands.push_back(vdata0);
+            operands.push_back(vdata1);
+            hasTwoOffsets = (name.find("write2") != std::string::npos);
+            break;
+
+        case DS_FORM_READ:
+            operands.push_back(RenderRegisters("v", vdst, numDataRegs));
+            operands.push_back(vaddr);
+            break;
+
+        case DS_FORM_READ2:
+            // A read2 returns two values
+            operands.push_back(RenderRegisters("v", vdst, numDataRegs * 2));
+            operands.push_back(vaddr);
+            hasTwoOffsets = true;
+            break;
+
+        case DS_FORM_RETURN:
+            operands.push_back(RenderRegisters("v", vdst, numDataRegs));
+            operands.push_back(vaddr);
+            operands.push_back(vdata0);
+            break;
+
+        case DS_FORM_RETURN2:
+            operands.push_back(RenderRegisters("v", vdst, numDataRegs));
+            operands.push_back(vaddr);
+            operands.push_back(vdata0);
+            operands.push_back(vdata1);
+            break;
+
+        default:
+            break;
+    }
+
+    std::string text = JoinOperands(name, operands);
+
+    if (hasTwoOffsets)
+    {
+        if (offset0 != 0)
+        {
+            text += " offset0:" + std::to_string(offset0);
+        }
+
+        if (offset1 != 0)
+        {
+            text += " offset1:" + std::to_string(offset1);
+        }
+    }
+    else if ((offset0 | (offset1 << 8)) != 0)
+    {
+        text += " offset:" + std::to_string(offset0 | (offset1 << 8));
+    }
+
+    if (isGds)
+    {
+        text += " gds";
+    }
+
+    return text;
+}
+
+static std::string RenderFLAT(const AgentGCNInstruction& instruction, const std::string& name)
+{
+    const uint32_t word0 = instruction.m_words[0];
+    const uint32_t word1 = instruction.m_words[1];
+
+    const bool isGlc = GetBits(word0, 16, 1) != 0;
+    const bool isSlc = GetBits(word0, 17, 1) != 0;
+
+    const std::string vaddr = RenderRegisters("v", GetBits(word1, 0, 8), 2);
+    const unsigned int numDataRegs = GetDataRegs(name);
+    const unsigned int vdata = GetBits(word1, 8, 8);
+    const unsigned int vdst = GetBits(word1, 24, 8);
+
+    std::vector<std::string> operands;
+
+    if (name.find("_load_") != std::string::npos)
+    {
+        operands.push_back(RenderRegisters("v", vdst, numDataRegs));
+        operands.push_back(vaddr);
+    }
+    else if (name.find("_store_") != std::string::npos)
+    {
+        operands.push_back(vaddr);
+        operands.push_back(RenderRegisters("v", vdata, numDataRegs));
+    }
+    else
+    {
+        // An atomic only returns the old value with glc, cmpswap reads a compare value too
+        const unsigned int numSrcRegs = (name.find("cmpswap") != std::string::npos) ? numDataRegs * 2 : numDataRegs;
+
+        if (isGlc)
+        {
+            operands.push_back(RenderRegisters("v", vdst, numDataRegs));
+        }
+
+        operands.push_back(vaddr);
+        operands.push_back(RenderRegisters("v", vdata, numSrcRegs));
+    }
+
+    std::string text = JoinOperands(name, operands);
+
+    if (isGlc)
+    {
+        text += " glc";
+    }
+
+    if (isSlc)
+    {
+        text += " slc";
+    }
+
+    return text;
+}
+
+/// The MTBUF data and number formats, indexed by the dfmt and nfmt fields
+static const char* const gs_MTBUF_DATA_FORMATS[] =
+{
+    "BUF_DATA_FORMAT_INVALID", "BUF_DATA_FORMAT_8", "BUF_DATA_FORMAT_16", "BUF_DATA_FORMAT_8_8",
+    "BUF_DATA_FORMAT_32", "BUF_DATA_FORMAT_16_16", "BUF_DATA_FORMAT_10_11_11", "BUF_DATA_FORMAT_11_11_10",
+    "BUF_DATA_FORMAT_10_10_10_2", "BUF_DATA_FORMAT_2_10_10_10", "BUF_DATA_FORMAT_8_8_8_8", "BUF_DATA_FORMAT_32_32",
+    "BUF_DATA_FORMAT_16_16_16_16", "BUF_DATA_FORMAT_32_32_32", "BUF_DATA_FORMAT_32_32_32_32", "BUF_DATA_FORMAT_RESERVED_15"
+};
+
+static const char* const gs_MTBUF_NUMBER_FORMATS[] =
+{
+    "BUF_NUM_FORMAT_UNORM", "BUF_NUM_FORMAT_SNORM", "BUF_NUM_FORMAT_USCALED", "BUF_NUM_FORMAT_SSCALED",
+    "BUF_NUM_FORMAT_UINT", "BUF_NUM_FORMAT_SINT", "BUF_NUM_FORMAT_RESERVED_6", "BUF_NUM_FORMAT_FLOAT"
+};
+
+/// Render MUBUF and MTBUF
+static std::string RenderBuffer(const AgentGCNInstruction& instruction, const std::string& name)
+{
+    const uint32_t word0 = instruction.m_words[0];
+    const uint32_t word1 = instruction.m_words[1];
+    const bool isMTBUF = (instruction.m_encoding == AGENT_GCN_ENCODING_MTBUF);
+
+    const unsigned int offset = GetBits(word0, 0, 12);
+    const bool isOffen = GetBits(word0, 12, 1) != 0;
+    const bool isIdxen = GetBits(word0, 13, 1) != 0;
+    const bool isGlc = GetBits(word0, 14, 1) != 0;
+    const bool isSlc = isMTBUF ? false : (GetBits(word0, 17, 1) != 0);
+
+    const unsigned int vaddr = GetBits(word1, 0, 8);
+    const unsigned int vdata = GetBits(word1, 8, 8);
+    const unsigned int srsrc = GetBits(word1, 16, 5) * 4;
+    const unsigned int soffset = GetBits(word1, 24, 8);
+
+    std::vector<std::string> operands;
+
+    // The cache invalidations have no operand
+    if (!isMTBUF && (instruction.m_opcode == 62 || instruction.m_opcode == 63))
+    {
+        return name;
+    }
+
+    operands.push_back(RenderRegisters("v", vdata, GetDataRegs(name)));
+
+    if (isOffen && isIdxen)
+    {
+        operands.push_back(RenderRegisters("v", vaddr, 2));
+    }
+    else if (isOffen || isIdxen)
+    {
+        operands.push_back(RenderRegisters("v", vaddr, 1));
+    }
+    else
+    {
+        operands.push_back("off");
+    }
+
+    operands.push_back(RenderScalarOperand(srsrc, 4, 0));
+    operands.push_back(RenderScalarOperand(soffset, 1, 0));
+
+    std::string text = JoinOperands(name, operands);
+
+    const unsigned int dataFormat = isMTBUF ? GetBits(word0, 19, 4) : 0;
+    const unsigned int numberFormat = isMTBUF ? GetBits(word0, 23, 3) : 0;
+
+    // The default format, 8 bit unorm, is not printed
+    if (isMTBUF && (dataFormat != 1 || numberFormat != 0))
+    {
+        text += std::string(" format:[") + gs_MTBUF_DATA_FORMATS[dataFormat] + "," + gs_MTBUF_NUMBER_FORMATS[numberFormat] + "]";
+    }
+
+    if (isOffen)
+    {
+        text += " offen";
+    }
+
+    if (isIdxen)
+    {
+        text += " idxen";
+    }
+
+    if (offset != 0)
+    {
+        text += " offset:" + std::to_string(offset);
+    }
+
+    if (isGlc)
+    {
+        text += " glc";
+    }
+
+    if (isSlc)
+    {
+        text += " slc";
+    }
+
+    return text;
+}
+
+static std::string RenderMIMG(const AgentGCNInstruction& instruction, const std::string& name)
+{
+    const uint32_t word0 = instruction.m_words[0];
+    const uint32_t word1 = instruction.m_words[1];
+
+    const unsigned int dmask = GetBits(word0, 8, 4);
+    const unsigned int numDataRegs = (dmask == 0) ? 1 : static_cast<unsigned int>(__builtin_popcount(dmask));
+
+    std::vector<std::string> operands;
+    operands.push_back(RenderRegisters("v", GetBits(word1, 8, 8), numDataRegs));
+    operands.push_back(RenderRegisters("v", GetBits(word1, 0, 8), 1));
+    operands.push_back(RenderScalarOperand(GetBits(word1, 16, 5) * 4, 8, 0));
+
+    // Only the sample and gather ops use a sampler
+    if (instruction.m_opcode >= 32)
+    {
+        operands.push_back(RenderScalarOperand(GetBits(word1, 21, 5) * 4, 4, 0));
+    }
+
+    std::string text = JoinOperands(name, operands) + " dmask:" + ToHex(dmask);
+
+    static const struct
+    {
+        unsigned int m_bit;
+        const char*  m_pName;
+    } FLAGS[] = {{12, " unorm"}, {13, " glc"}, {14, " da"}, {15, " r128"}, {16, " tfe"}, {17, " lwe"}, {25, " slc"}};
+
+    for (size_t i = 0; i < GCN_TABLE_SIZE(FLAGS); i++)
+    {
+        if (GetBits(word0, FLAGS[i].m_bit, 1) != 0)
+        {
+            text += FLAGS[i].m_pName;
+        }
+    }
+
+    return text;
+}
+
+static std::string RenderEXP(const AgentGCNInstruction& instruction)
+{
+    const uint32_t word0 = instruction.m_words[0];
+    const uint32_t word1 = instruction.m_words[1];
+
+    const unsigned int enabledMask = GetBits(word0, 0, 4);
+    const unsigned int target = GetBits(word0, 4, 6);
+
+    std::string targetName;
+
+    if (target <= 7)
+    {
+        targetName = "mrt" + std::to_string(target);
+    }
+    else if (target == 8)
+    {
+        targetName = "mrtz";
+    }
+    else if (target == 9)
+    {
+        targetName = "null";
+    }
+    else if (target >= 12 && target <= 15)
+    {
+        targetName = "pos" + std::to_string(target - 12);
+    }
+    else if (target >= 32)
+    {
+        targetName = "param" + std::to_string(target - 32);
+    }
+    else
+    {
+        targetName = "invalid_target_" + std::to_string(target);
+    }
+
+    std::vector<std::string> operands;
+
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        operands.push_back(((enabledMask >> i) & 1) ? RenderRegisters("v", GetBits(word1, i * 8, 8), 1) : "off");
+    }
+
+    // The target is separated from the sources by a space only
+    std::string text = JoinOperands("exp " + targetName, operands);
+
+    if (GetBits(word0, 10, 1) != 0)
+    {
+        text += " compr";
+    }
+
+    if (GetBits(word0, 11, 1) != 0)
+    {
+        text += " done";
+    }
+
+    if (GetBits(word0, 12, 1) != 0)
+    {
+        text += " vm";
+    }
+
+    return text;
+}
+
+AgentGCNDecoder::AgentGCNDecoder():
+    m_instructions(),
+    m_symbols()
+{
+}
+
+AgentGCNDecoder::~AgentGCNDecoder()
+{
+    m_instructions.clear();
+    m_symbols.clear();
+}
+
+void AgentGCNDecoder::DecodeWords(const void* pWords, const size_t size, const uint64_t startPC)
+{
+    const char* pBytes = static_cast<const char*>(pWords);
+    size_t offset = 0;
+
+    while (offset + sizeof(uint32_t) <= size)
+    {
+        AgentGCNInstruction instruction;
+        memset(&instruction, 0, sizeof(AgentGCNInstruction));
+
+        instruction.m_pc = startPC + offset;
+        memcpy(&instruction.m_words[0], pBytes + offset, sizeof(uint32_t));
+
+        const uint32_t word0 = instruction.m_words[0];
+        const EncodingInfo* pEncodingInfo = nullptr;
+
+        for (size_t i = 0; i < GCN_TABLE_SIZE(gs_ENCODINGS); i++)
+        {
+            if ((word0 & gs_ENCODINGS[i].m_mask) == gs_ENCODINGS[i].m_value)
+            {
+                pEncodingInfo = &gs_ENCODINGS[i];
+                break;
+            }
+        }
+
+        unsigned int numWords = 1;
+
+        if (pEncodingInfo != nullptr)
+        {
+            instruction.m_encoding = pEncodingInfo->m_encoding;
+            instruction.m_opcode = static_cast<uint16_t>((word0 >> pEncodingInfo->m_opcodeShift) & pEncodingInfo->m_opcodeMask);
+            numWords = pEncodingInfo->m_numWords;
+
+            // A literal constant, or the SDWA and DPP word, follows the 32 bit encodings
+            switch (instruction.m_encoding)
+            {
+                case AGENT_GCN_ENCODING_SOP2:
+                case AGENT_GCN_ENCODING_SOPC:
+                    numWords += (GetBits(word0, 0, 8) == 255 || GetBits(word0, 8, 8) == 255) ? 1 : 0;
+                    break;
+
+                case AGENT_GCN_ENCODING_SOP1:
+                    numWords += (GetBits(word0, 0, 8) == 255) ? 1 : 0;
+                    break;
+
+                case AGENT_GCN_ENCODING_SOPK:
+                    // s_setreg_imm32_b32
+                    numWords += (instruction.m_opcode == 20) ? 1 : 0;
+                    break;
+
+                case AGENT_GCN_ENCODING_VOP2:
+                    // madmk and madak always have a constant
+                    if (instruction.m_opcode == 23 || instruction.m_opcode == 24 ||
+                        instruction.m_opcode == 36 || instruction.m_opcode == 37)
+                    {
+                        numWords += 1;
+                        break;
+                    }
+
+                    // Fall through
+                case AGENT_GCN_ENCODING_VOP1:
+                case AGENT_GCN_ENCODING_VOPC:
+                {
+                    const uint32_t src0 = GetBits(word0, 0, 9);
+                    numWords += (src0 == 255 || src0 == 249 || src0 == 250) ? 1 : 0;
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
+        if (offset + numWords * sizeof(uint32_t) > size)
+        {
+            // A truncated instruction is kept as a data word
+            instruction.m_encoding = AGENT_GCN_ENCODING_UNKNOWN;
+            numWords = 1;
+        }
+
+        if (numWords > 1)
+        {
+            memcpy(&instruction.m_words[1], pBytes + offset + sizeof(uint32_t), sizeof(uint32_t));
+        }
+
+        instruction.m_numWords = static_cast<uint8_t>(numWords);
+        m_instructions.push_back(instruction);
+
+        offset += numWords * sizeof(uint32_t);
+    }
+}
+
+/// Get the ISA major version from the notes of a code object
+/// \return true if a NT_AMDGPU_HSA_ISA note of the "AMD" vendor was found
+static bool GetNoteISAMajor(Elf* pElf, uint32_t& majorOut)
+{
+    static const char VENDOR_NAME[] = "AMD";
+
+    for (Elf_Scn* pSection = elf_nextscn(pElf, nullptr); pSection != nullptr; pSection = elf_nextscn(pElf, pSection))
+    {
+        Elf64_Shdr* pSectionHeader = elf64_getshdr(pSection);
+
+        if (pSectionHeader == nullptr || pSectionHeader->sh_type != SHT_NOTE)
+        {
+            continue;
+        }
+
+        Elf_Data* pNoteData = elf_getdata(pSection, nullptr);
+
+        if (pNoteData == nullptr || pNoteData->d_buf == nullptr)
+        {
+            continue;
+        }
+
+        const char* pNotes = static_cast<const char*>(pNoteData->d_buf);
+        size_t offset = 0;
+
+        while (offset + sizeof(Elf64_Nhdr) <= pNoteData->d_size)
+        {
+            Elf64_Nhdr noteHeader;
+            memcpy(&noteHeader, pNotes + offset, sizeof(Elf64_Nhdr));
+
+            // The name and the descriptor are padded to 4 bytes
+            const size_t nameOffset = offset + sizeof(Elf64_Nhdr);
+            const size_t descOffset = nameOffset + ((static_cast<size_t>(noteHeader.n_namesz) + 3) & ~static_cast<size_t>(3));
+            const size_t nextOffset = descOffset + ((static_cast<size_t>(noteHeader.n_descsz) + 3) & ~static_cast<size_t>(3));
+
+            if (descOffset > pNoteData->d_size || noteHeader.n_descsz > pNoteData->d_size - descOffset)
+            {
+                break;
+            }
+
+            if (noteHeader.n_type == gs_NT_AMDGPU_HSA_ISA &&
+                noteHeader.n_namesz == sizeof(VENDOR_NAME) &&
+                memcmp(pNotes + nameOffset, VENDOR_NAME, sizeof(VENDOR_NAME)) == 0 &&
+                noteHeader.n_descsz >= sizeof(HsaISANoteDesc))
+            {
+                HsaISANoteDesc isaDesc;
+                memcpy(&isaDesc, pNotes + descOffset, sizeof(HsaISANoteDesc));
+                majorOut = isaDesc.m_major;
+                return true;
+            }
+
+            offset = nextOffset;
+        }
+    }
+
+    return false;
+}
+
+/// Check if the code object is for a GFX8 device, the only ISA the tables describe.
+/// The ISA note of the older code objects is checked first, then the machine in e_flags
+static bool IsSupportedTarget(Elf* pElf, const Elf64_Ehdr& elfHeader)
+{
+    if (elfHeader.e_machine != gs_EM_AMDGPU)
+    {
+        AGENT_LOG("AgentGCNDecoder: Not an AMD GPU code object, machine " << elfHeader.e_machine);
+        return false;
+    }
+
+    uint32_t isaMajor = 0;
+
+    if (GetNoteISAMajor(pElf, isaMajor))
+    {
+        if (isaMajor != gs_SUPPORTED_ISA_MAJOR)
+        {
+            AGENT_LOG("AgentGCNDecoder: ISA version " << isaMajor << " is not supported");
+            return false;
+        }
+
+        return true;
+    }
+
+    const uint32_t machine = elfHeader.e_flags & gs_EF_AMDGPU_MACH;
+
+    if (machine < gs_EF_AMDGPU_MACH_GFX8_FIRST || machine > gs_EF_AMDGPU_MACH_GFX8_LAST)
+    {
+        AGENT_LOG("AgentGCNDecoder: The code object target 0x" << std::hex << machine << std::dec <<
+                  " is not supported");
+        return false;
+    }
+
+    return true;
+}
+
+HsailAgentStatus AgentGCNDecoder::Decode(const void* pCodeObj, const size_t size)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    m_instructions.clear();
+    m_symbols.clear();
+
+    if (pCodeObj == nullptr || size < sizeof(Elf64_Ehdr))
+    {
+        AGENT_ERROR("AgentGCNDecoder: Invalid input");
+        return status;
+    }
+
+    elf_version(EV_CURRENT);
+
+    Elf* pElf = elf_memory(const_cast<char*>(static_cast<const char*>(pCodeObj)), size);
+
+    if (pElf == nullptr)
+    {
+        AGENT_ERROR("AgentGCNDecoder: The code object is not an ELF file");
+        return status;
+    }
+
+    Elf64_Ehdr elfHeader;
+    memcpy(&elfHeader, pCodeObj, sizeof(Elf64_Ehdr));
+
+    // Another ISA is left to llvm-objdump
+    if (elfHeader.e_ident[EI_CLASS] != ELFCLASS64 || !IsSupportedTarget(pElf, elfHeader))
+    {
+        elf_end(pElf);
+        return status;
+    }
+
+    size_t sectionNamesIndex = 0;
+
+    if (elf_getshdrstrndx(pElf, &sectionNamesIndex) != 0)
+    {
+        AGENT_ERROR("AgentGCNDecoder: No section names");
+        elf_end(pElf);
+        return status;
+    }
+
+    const char* pText = nullptr;
+    size_t textSize = 0;
+    uint64_t textAddress = 0;
+    size_t textIndex = 0;
+
+    Elf_Scn* pSymTabSection = nullptr;
+    size_t symbolNamesIndex = 0;
+
+    for (Elf_Scn* pSection = elf_nextscn(pElf, nullptr); pSection != nullptr; pSection = elf_nextscn(pElf, pSection))
+    {
+        Elf64_Shdr* pSectionHeader = elf64_getshdr(pSection);
+
+        if (pSectionHeader == nullptr)
+        {
+            continue;
+        }
+
+        const char* pSectionName = elf_strptr(pElf, sectionNamesIndex, pSectionHeader->sh_name);
+
+        if (pSectionName != nullptr && strcmp(pSectionName, ".text") == 0)
+        {
+            Elf_Data* pSectionData = elf_getdata(pSection, nullptr);
+
+            if (pSectionData != nullptr)
+            {
+                pText = static_cast<const char*>(pSectionData->d_buf);
+                textSize = pSectionData->d_size;
+                textAddress = pSectionHeader->sh_addr;
+                textIndex = elf_ndxscn(pSection);
+            }
+        }
+        else if (pSectionHeader->sh_type == SHT_SYMTAB)
+        {
+            pSymTabSection = pSection;
+            symbolNamesIndex = pSectionHeader->sh_link;
+        }
+    }
+
+    if (pText == nullptr || textSize == 0)
+    {
+        AGENT_ERROR("AgentGCNDecoder: The code object has no .text section");
+        elf_end(pElf);
+        return status;
+    }
+
+    // The kernels start with their amd_kernel_code_t, which is not code
+    std::map<uint64_t, bool> codeStarts;
+
+    if (pSymTabSection != nullptr)
+    {
+        Elf_Data* pSymbolData = elf_getdata(pSymTabSection, nullptr);
+        const size_t numSymbols = (pSymbolData != nullptr) ? pSymbolData->d_size / sizeof(Elf64_Sym) : 0;
+        const Elf64_Sym* pSymbols = (pSymbolData != nullptr) ? static_cast<const Elf64_Sym*>(pSymbolData->d_buf) : nullptr;
+
+        for (size_t i = 0; i < numSymbols; i++)
+        {
+            const unsigned int symbolType = ELF64_ST_TYPE(pSymbols[i].st_info);
+
+            if (pSymbols[i].st_shndx != textIndex ||
+                (symbolType != STT_FUNC && symbolType != gs_STT_AMDGPU_HSA_KERNEL))
+            {
+                continue;
+            }
+
+            const char* pSymbolName = elf_strptr(pElf, symbolNamesIndex, pSymbols[i].st_name);
+
+            if (pSymbolName != nullptr && pSymbolName[0] != '\0')
+            {
+                m_symbols[pSymbols[i].st_value] = pSymbolName;
+                codeStarts[pSymbols[i].st_value] = (symbolType == gs_STT_AMDGPU_HSA_KERNEL);
+            }
+        }
+    }
+
+    // Decode from every symbol to the next one, or the whole section if there are no symbols
+    uint64_t regionStart = textAddress;
+    bool isKernel = false;
+
+    std::map<uint64_t, bool>::const_iterator startIt = codeStarts.begin();
+
+    while (true)
+    {
+        const uint64_t textEnd = textAddress + textSize;
+        uint64_t regionEnd = textEnd;
+
+        if (startIt != codeStarts.end() && startIt->first < textEnd)
+        {
+            regionEnd = std::max(regionStart, startIt->first);
+        }
+
+        uint64_t codeStart = regionStart + (isKernel ? sizeof(amd_kernel_code_t) : 0);
+
+        if (codeStart < regionEnd && regionStart >= textAddress)
+        {
+            DecodeWords(pText + (codeStart - textAddress), regionEnd - codeStart, codeStart);
+        }
+
+        if (startIt == codeStarts.end() || startIt->first >= textEnd)
+        {
+            break;
+        }
+
+        regionStart = startIt->first;
+        isKernel = startIt->second;
+        ++startIt;
+    }
+
+    elf_end(pElf);
+
+    AGENT_LOG("AgentGCNDecoder: " << m_instructions.size() << " instructions in " << textSize << " bytes of .text");
+
+    status = HSAIL_AGENT_STATUS_SUCCESS;
+    return status;
+}
+
+const std::vector<AgentGCNInstruction>& AgentGCNDecoder::GetInstructions() const
+{
+    return m_instructions;
+}
+
+/// Order the instructions by PC for the binary searches
+static bool IsInstructionBefore(const AgentGCNInstruction& instruction, const uint64_t pc)
+{
+    return instruction.m_pc < pc;
+}
+
+const AgentGCNInstruction* AgentGCNDecoder::FindInstruction(const uint64_t pc) const
+{
+    // The first instruction at or after pc, the one before it may contain pc
+    std::vector<AgentGCNInstruction>::const_iterator instructionIt =
+        std::lower_bound(m_instructions.begin(), m_instructions.end(), pc, IsInstructionBefore);
+
+    if (instructionIt != m_instructions.end() && instructionIt->m_pc == pc)
+    {
+        return &(*instructionIt);
+    }
+
+    if (instructionIt == m_instructions.begin())
+    {
+        return nullptr;
+    }
+
+    --instructionIt;
+
+    if (pc < instructionIt->m_pc + instructionIt->m_numWords * sizeof(uint32_t))
+    {
+        return &(*instructionIt);
+    }
+
+    return nullptr;
+}
+
+void AgentGCNDecoder::RenderInstruction(const AgentGCNInstruction& instruction, std::string& textOut)
+{
+    if (instruction.m_encoding == AGENT_GCN_ENCODING_UNKNOWN)
+    {
+        textOut = ".long " + ToHex(instruction.m_words[0]);
+        return;
+    }
+
+    std::string name = GetInstructionName(instruction);
+
+    if (name.empty())
+    {
+        // An opcode missing in the tables is shown with its encoding
+        for (size_t i = 0; i < GCN_TABLE_SIZE(gs_ENCODINGS); i++)
+        {
+            if (gs_ENCODINGS[i].m_encoding == instruction.m_encoding)
+            {
+                textOut = std::string(gs_ENCODINGS[i].m_pName) + "_op_" + std::to_string(instruction.m_opcode);
+                return;
+            }
+        }
+    }
+
+    const uint32_t word0 = instruction.m_words[0];
+    const uint32_t literal = (instruction.m_numWords > 1) ? instruction.m_words[1] : 0;
+
+    unsigned int dstRegs = 1;
+    unsigned int srcRegs = 1;
+    GetOperandRegs(name, dstRegs, srcRegs);
+
+    std::vector<std::string> operands;
+
+    switch (instruction.m_encoding)
+    {
+        case AGENT_GCN_ENCODING_SOP2:
+            operands.push_back(RenderScalarOperand(GetBits(word0, 16, 7), dstRegs, literal));
+            operands.push_back(RenderScalarOperand(GetBits(word0, 0, 8), srcRegs, literal));
+            operands.push_back(RenderScalarOperand(GetBits(word0, 8, 8), srcRegs, literal));
+            textOut = JoinOperands(name, operands);
+            break;
+
+        case AGENT_GCN_ENCODING_SOPK:
+        {
+            const uint32_t simm16 = GetBits(word0, 0, 16);
+            const std::string sdst = RenderScalarOperand(GetBits(word0, 16, 7), 1, 0);
+
+            // hwreg(id, offset, size) of s_getreg and s_setreg
+            std::stringstream hwRegStream;
+            hwRegStream << "hwreg(" << GetBits(simm16, 0, 6) << ", " << GetBits(simm16, 6, 5) << ", " << GetBits(simm16, 11, 5) + 1 << ")";
+
+            if (instruction.m_opcode == 17)
+            {
+                operands.push_back(sdst);
+                operands.push_back(hwRegStream.str());
+            }
+            else if (instruction.m_opcode == 18)
+            {
+                operands.push_back(hwRegStream.str());
+                operands.push_back(sdst);
+            }
+            else if (instruction.m_opcode == 20)
+            {
+                operands.push_back(hwRegStream.str());
+                operands.push_back(ToHex(literal));
+            }
+            else
+            {
+                operands.push_back(sdst);
+                operands.push_back(ToHex(simm16));
+            }
+
+            textOut = JoinOperands(name, operands);
+            break;
+        }
+
+        case AGENT_GCN_ENCODING_SOP1:
+        {
+            const std::string sdst = RenderScalarOperand(GetBits(word0, 16, 7), dstRegs, literal);
+            const std::string ssrc0 = RenderScalarOperand(GetBits(word0, 0, 8), srcRegs, literal);
+
+            // s_getpc_b64 has no source, s_setpc_b64, s_rfe_b64 and s_cbranch_join have no destination
+            if (instruction.m_opcode != 29 && instruction.m_opcode != 31 && instruction.m_opcode != 46)
+            {
+                operands.push_back(sdst);
+            }
+
+            if (instruction.m_opcode != 28)
+            {
+                operands.push_back(ssrc0);
+            }
+
+            textOut = JoinOperands(name, operands);
+            break;
+        }
+
+        case AGENT_GCN_ENCODING_SOPC:
+            operands.push_back(RenderScalarOperand(GetBits(word0, 0, 8), srcRegs, literal));
+            operands.push_back(RenderScalarOperand(GetBits(word0, 8, 8), srcRegs, literal));
+            textOut = JoinOperands(name, operands);
+            break;
+
+        case AGENT_GCN_ENCODING_SOPP:
+            textOut = RenderSOPP(instruction, name);
+            break;
+
+        case AGENT_GCN_ENCODING_SMEM:
+            textOut = RenderSMEM(instruction, name);
+            break;
+
+        case AGENT_GCN_ENCODING_VOP1:
+        case AGENT_GCN_ENCODING_VOP2:
+        case AGENT_GCN_ENCODING_VOPC:
+            textOut = RenderVOP(instruction, name);
+            break;
+
+        case AGENT_GCN_ENCODING_VOP3:
+            textOut = RenderVOP3(instruction, name);
+            break;
+
+        case AGENT_GCN_ENCODING_VINTRP:
+        {
+            static const char* const CHANNELS[] = {"x", "y", "z", "w"};
+            static const char* const PARAMETERS[] = {"p10", "p20", "p0", "invalid_param_3"};
+
+            const unsigned int vsrc = GetBits(word0, 0, 8);
+            const std::string attribute = "attr" + std::to_string(GetBits(word0, 10, 6)) + "." + CHANNELS[GetBits(word0, 8, 2)];
+
+            operands.push_back(RenderRegisters("v", GetBits(word0, 18, 8), 1));
+            operands.push_back((instruction.m_opcode == 2) ? PARAMETERS[GetBits(vsrc, 0, 2)] : RenderRegisters("v", vsrc, 1));
+            operands.push_back(attribute);
+
+            // The interpolation ops also have a VOP3 form
+            textOut = JoinOperands(name + "_e32", operands);
+            break;
+        }
+
+        case AGENT_GCN_ENCODING_DS:
+            textOut = RenderDS(instruction, name);
+            break;
+
+        case AGENT_GCN_ENCODING_FLAT:
+            textOut = RenderFLAT(instruction, name);
+            break;
+
+        case AGENT_GCN_ENCODING_MUBUF:
+        case AGENT_GCN_ENCODING_MTBUF:
+            textOut = RenderBuffer(instruction, name);
+            break;
+
+        case AGENT_GCN_ENCODING_MIMG:
+            textOut = RenderMIMG(instruction, name);
+            break;
+
+        case AGENT_GCN_ENCODING_EXP:
+            textOut = RenderEXP(instruction);
+            break;
+
+        default:
+            textOut = ".long " + ToHex(word0);
+            break;
+    }
+}
+
+void AgentGCNDecoder::RenderText(const uint64_t startPC, const uint64_t endPC, std::string& textOut) const
+{
+    textOut.clear();
+
+    std::vector<AgentGCNInstruction>::const_iterator instructionIt =
+        std::lower_bound(m_instructions.begin(), m_instructions.end(), startPC, IsInstructionBefore);
+
+    std::stringstream textStream;
+    std::string instructionText;
+
+    for (; instructionIt != m_instructions.end() && instructionIt->m_pc < endPC; ++instructionIt)
+    {
+        std::map<uint64_t, std::string>::const_iterator symbolIt = m_symbols.find(instructionIt->m_pc);
+
+        if (symbolIt == m_symbols.end() && instructionIt->m_pc >= sizeof(amd_kernel_code_t))
+        {
+            // The label of a kernel is at its amd_kernel_code_t, before the first instruction
+            symbolIt = m_symbols.find(instructionIt->m_pc - sizeof(amd_kernel_code_t));
+        }
+
+        if (symbolIt != m_symbols.end() &&
+            (symbolIt->first == instructionIt->m_pc ||
+             instructionIt == m_instructions.begin() ||
+             (instructionIt - 1)->m_pc < symbolIt->first))
+        {
+            textStream << "\n" << symbolIt->second << ":\n";
+        }
+
+        RenderInstruction(*instructionIt, instructionText);
+
+        // Same layout as llvm-objdump: the instruction, then its address and words in a comment
+        textStream << "\t" << std::left << std::setw(gs_COMMENT_COLUMN) << std::setfill(' ') << instructionText
+                   << " // " << std::right << std::setw(12) << std::setfill('0') << std::hex << std::uppercase
+                   << instructionIt->m_pc << ":";
+
+        for (unsigned int i = 0; i < instructionIt->m_numWords; i++)
+        {
+            textStream << " " << std::setw(8) << instructionIt->m_words[i];
+        }
+
+        textStream << std::dec << std::nouppercase << "\n";
+    }
+
+    textOut = textStream.str();
+}
+
+} // End Namespace HwDbgAgent
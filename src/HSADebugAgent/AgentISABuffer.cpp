@@ -7,6 +7,8 @@
 //==============================================================================
 #include <unistd.h>
 #include <errno.h>
+#include <cstdint>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <cstring>
@@ -14,9 +16,11 @@
 #include <iomanip>
 
 #include "AgentConfiguration.h"
+#include "AgentGCNDecoder.h"
 #include "AgentISABuffer.h"
 #include "AgentLogging.h"
 #include "AgentNotifyGdb.h"
+#include "AgentSharedMemRegistry.h"
 #include "AgentUtils.h"
 #include "CommunicationControl.h"
 #include "CommunicationParams.h"
@@ -39,26 +43,19 @@ AgentISABuffer::AgentISABuffer():
 {
 }
 
-HsailAgentStatus AgentISABuffer::WriteToSharedMem(const int isaBufferShmKey, const size_t isaBufferShmSize) const
+HsailAgentStatus AgentISABuffer::WriteToSharedMem(AgentSharedMemRegistry* pSharedMemRegistry) const
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
 
-    // Get the pointer to the shmem segment
-    void* pShm = AgentMapSharedMemBuffer(isaBufferShmKey, isaBufferShmSize);
-
-    if (pShm == (int*) - 1)
+    if (pSharedMemRegistry == nullptr)
     {
-        AGENT_ERROR("WriteBinaryToShmem: Error with AgentMapSharedMemBuffer");
+        AGENT_ERROR("WriteToSharedMem: The shared mem registry is nullptr");
         return status;
     }
 
-    // Clear the memory first
-    memset(pShm, 0, isaBufferShmSize);
-    // Write the size first
-    size_t* pShmSizeLocation = (size_t*)pShm;
-    pShmSizeLocation[0] = m_ISABufferLen;
+    AGENT_LOG("ISA size: " << m_ISABufferLen);
 
-    AGENT_LOG("ISA size: " << pShmSizeLocation[0]);
+    size_t payloadSize = (m_pISABufferText != nullptr) ? m_ISABufferLen : 0;
 
     if (m_pISABufferText == nullptr)
     {
@@ -68,26 +65,32 @@ HsailAgentStatus AgentISABuffer::WriteToSharedMem(const int isaBufferShmKey, con
             AGENT_ERROR("The ISA buffer len is non-zero but the buffer is nullptr");
         }
     }
-    else
+
+    // The shared mem region grows if the ISA text does not fit
+    void* pPayload = pSharedMemRegistry->BeginRegionUpdate(HSAIL_DEBUG_CONFIG_ISA_BUFFER_SHM, payloadSize);
+
+    if (pPayload == nullptr && payloadSize > 0)
     {
-        // Write the binary after the size_t info
-        void* pShmBinaryLocation = (size_t*)pShm + 1;
+        AGENT_WARNING("WriteToSharedMem: ISA Buffer could not be copied to GDB");
+        AGENT_WARNING("Could not make room for " << m_ISABufferLen << " bytes of ISA");
+        payloadSize = 0;
 
-        if (m_ISABufferLen < isaBufferShmSize )
-        {
-            // Copy the binary
-            memcpy(pShmBinaryLocation, m_pISABufferText, m_ISABufferLen);
-        }
-        else
-        {
-            AGENT_WARNING("WriteToSharedMem: ISA Buffer could not be copied to GDB");
-            AGENT_WARNING("Binary Size is = " << m_ISABufferLen <<
-                          " but shared memory size = " << isaBufferShmSize << "bytes");
-        }
+        // gdb still gets an empty ISA text
+        pPayload = pSharedMemRegistry->BeginRegionUpdate(HSAIL_DEBUG_CONFIG_ISA_BUFFER_SHM, payloadSize);
     }
 
-    status = AgentUnMapSharedMemBuffer(pShm);
+    if (pPayload == nullptr)
+    {
+        AGENT_ERROR("WriteToSharedMem: ISA buffer shared mem is not available");
+        return status;
+    }
 
+    if (payloadSize > 0)
+    {
+        memcpy(pPayload, m_pISABufferText, payloadSize);
+    }
+
+    status = pSharedMemRegistry->EndRegionUpdate(HSAIL_DEBUG_CONFIG_ISA_BUFFER_SHM, payloadSize);
     return status;
 }
 
@@ -117,13 +120,14 @@ bool AgentISABuffer::TestForAMDHsaCod()
     return retCode;
 }
 
-HsailAgentStatus  AgentISABuffer::DisassembleAMDHsaCod(const size_t size, const void* codeObj)
+HsailAgentStatus  AgentISABuffer::DisassembleAMDHsaCod(const size_t       size,
+                                                       const void*        codeObj,
+                                                       const std::string& codeObjFilename,
+                                                       const std::string& isatextFilename)
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
 
     const std::string amdhsaCodCommand = "amdhsacod -dump -code";
-    const std::string codeObjFilename  = "/tmp/codeobj";
-    std::string isatextFilename(gs_ISAFileNamePath);
 
     if (size <= 0 || codeObj == nullptr )
     {
@@ -171,7 +175,10 @@ HsailAgentStatus  AgentISABuffer::DisassembleAMDHsaCod(const size_t size, const
 }
 
 
-HsailAgentStatus  AgentISABuffer::DisassembleLLVMObjDump(const size_t size, const void* codeObj)
+HsailAgentStatus  AgentISABuffer::DisassembleLLVMObjDump(const size_t       size,
+                                                         const void*        codeObj,
+                                                         const std::string& codeObjFilename,
+                                                         const std::string& isatextFilename)
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
 
@@ -189,8 +196,6 @@ HsailAgentStatus  AgentISABuffer::DisassembleLLVMObjDump(const size_t size, cons
     std::string llvmCmdFileNameToUse("");
 
     const std::string llvmCmdOptions = "-disassemble -arch=amdgcn  -mcpu=fiji";
-    const std::string codeObjFilename  = "/tmp/codeobj";
-    std::string isatextFilename(gs_ISAFileNamePath);
 
     if (size <= 0 || codeObj == nullptr )
     {
@@ -198,7 +203,14 @@ HsailAgentStatus  AgentISABuffer::DisassembleLLVMObjDump(const size_t size, cons
         return status;
     }
 
-    if (AgentIsFileExists(LLVM_CMD_OPTION1.c_str()))
+    // ROCM_GDB_USE_LLVM_OBJDUMP can name the llvm-objdump to use
+    const char* pForcedLLVMCmd = std::getenv("ROCM_GDB_USE_LLVM_OBJDUMP");
+
+    if (pForcedLLVMCmd != nullptr && AgentIsFileExists(pForcedLLVMCmd))
+    {
+        llvmCmdFileNameToUse.append(pForcedLLVMCmd);
+    }
+    else if (AgentIsFileExists(LLVM_CMD_OPTION1.c_str()))
     {
         llvmCmdFileNameToUse.append(LLVM_CMD_OPTION1);
     }
@@ -254,6 +266,39 @@ HsailAgentStatus  AgentISABuffer::DisassembleLLVMObjDump(const size_t size, cons
     return status;
 }
 
+HsailAgentStatus AgentISABuffer::DisassembleGCNDecoder(const size_t size, const void* codeObj)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (size <= 0 || codeObj == nullptr)
+    {
+        AGENT_ERROR("DisassembleGCNDecoder: Invalid input");
+        return status;
+    }
+
+    AgentGCNDecoder decoder;
+    status = decoder.Decode(codeObj, size);
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("DisassembleGCNDecoder: Could not decode the code object");
+        return status;
+    }
+
+    std::string isaText;
+    decoder.RenderText(0, UINT64_MAX, isaText);
+
+    status = PopulateISAFromText(isaText);
+
+    return status;
+}
+
+bool AgentISABuffer::IsLLVMObjDumpForced()
+{
+    static const bool s_isForced = (std::getenv("ROCM_GDB_USE_LLVM_OBJDUMP") != nullptr);
+    return s_isForced;
+}
+
 HsailAgentStatus AgentISABuffer::PopulateISAFromFile(const std::string& ipFileName)
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
@@ -276,9 +321,16 @@ HsailAgentStatus AgentISABuffer::PopulateISAFromFile(const std::string& ipFileNa
 
         AGENT_LOG("ISA buffer size: " << m_ISABufferLen);
 
+        if (m_pISABufferText != nullptr)
+        {
+            delete [] m_pISABufferText;
+            m_pISABufferText = nullptr;
+        }
+
+        // One more byte to keep the text null terminated
         if (m_ISABufferLen > 0)
         {
-            m_pISABufferText = new(std::nothrow) char[m_ISABufferLen];
+            m_pISABufferText = new(std::nothrow) char[m_ISABufferLen + 1];
         }
 
         if (m_pISABufferText == nullptr)
@@ -289,6 +341,7 @@ HsailAgentStatus AgentISABuffer::PopulateISAFromFile(const std::string& ipFileNa
 
         ipStream.seekg(0, ipStream.beg);
         ipStream.read(m_pISABufferText, m_ISABufferLen);
+        m_pISABufferText[m_ISABufferLen] = '\0';
 
         AGENT_LOG("Save ISA from " << ipFileName);
 
@@ -305,14 +358,132 @@ HsailAgentStatus AgentISABuffer::PopulateISAFromFile(const std::string& ipFileNa
 
 HsailAgentStatus AgentISABuffer::PopulateISAFromCodeObj(const size_t size, const void* codeObj)
 {
+    // The GCN decoder does not need temporary files or a child process
+    if (!IsLLVMObjDumpForced() && DisassembleGCNDecoder(size, codeObj) == HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        return WriteToISADumpFile();
+    }
+
+    const std::string codeObjFilename(GetActiveAgentConfig()->GetSessionFileName("/tmp/codeobj"));
+    const std::string isatextFilename(GetActiveAgentConfig()->GetSessionFileName(gs_ISAFileNamePath));
+
     // Use amdhsacod
-    //HsailAgentStatus status = DisassembleAMDHsaCod(size, codeObj);
+    //HsailAgentStatus status = DisassembleAMDHsaCod(size, codeObj, codeObjFilename, isatextFilename);
 
     // Use LLVM tools
-    HsailAgentStatus status = DisassembleLLVMObjDump(size, codeObj);
+    HsailAgentStatus status = DisassembleLLVMObjDump(size, codeObj, codeObjFilename, isatextFilename);
+
+    // Keep the text so a later dispatch of the same binary does not need the disassembler
+    if (status == HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        status = PopulateISAFromFile(isatextFilename);
+    }
+
     return status;
 }
 
+HsailAgentStatus AgentISABuffer::PopulateISAFromCodeObj(const size_t       size,
+                                                        const void*        codeObj,
+                                                        const std::string& fileNameSuffix)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (fileNameSuffix.empty())
+    {
+        AGENT_ERROR("PopulateISAFromCodeObj: Empty file name suffix");
+        return status;
+    }
+
+    if (!IsLLVMObjDumpForced() && DisassembleGCNDecoder(size, codeObj) == HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+        return status;
+    }
+
+    // The files are private to this call, the ISA dump file read by gdb is left as it is
+    const std::string codeObjFilename(GetActiveAgentConfig()->GetSessionFileName("/tmp/codeobj") + fileNameSuffix);
+    const std::string isatextFilename(GetActiveAgentConfig()->GetSessionFileName(gs_ISAFileNamePath) + fileNameSuffix);
+
+    status = DisassembleLLVMObjDump(size, codeObj, codeObjFilename, isatextFilename);
+
+    if (status == HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        status = PopulateISAFromFile(isatextFilename);
+    }
+
+    if (AgentIsFileExists(isatextFilename.c_str()) &&
+        AgentDeleteFile(isatextFilename.c_str()) != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("Could not delete " << isatextFilename);
+    }
+
+    return status;
+}
+
+HsailAgentStatus AgentISABuffer::PopulateISAFromText(const std::string& isaText)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (isaText.empty())
+    {
+        AGENT_ERROR("PopulateISAFromText: Empty ISA text");
+        return status;
+    }
+
+    if (m_pISABufferText != nullptr)
+    {
+        delete [] m_pISABufferText;
+        m_pISABufferText = nullptr;
+    }
+
+    m_ISABufferLen = isaText.size();
+    m_pISABufferText = new(std::nothrow) char[m_ISABufferLen + 1];
+
+    if (m_pISABufferText == nullptr)
+    {
+        AGENT_ERROR("Could not allocate a buffer of size " << m_ISABufferLen);
+        m_ISABufferLen = 0;
+        return status;
+    }
+
+    memcpy(m_pISABufferText, isaText.c_str(), m_ISABufferLen + 1);
+
+    status = HSAIL_AGENT_STATUS_SUCCESS;
+    return status;
+}
+
+HsailAgentStatus AgentISABuffer::WriteToISADumpFile() const
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (m_pISABufferText == nullptr)
+    {
+        AGENT_ERROR("WriteToISADumpFile: No valid ISA buffer present");
+        return status;
+    }
+
+    // gdb reads the ISA of the active dispatch from the dump file
+    const std::string isatextFilename(GetActiveAgentConfig()->GetSessionFileName(gs_ISAFileNamePath));
+    status = AgentWriteBinaryToFile(m_pISABufferText, m_ISABufferLen, isatextFilename.c_str());
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("WriteToISADumpFile: Could not write " << isatextFilename);
+    }
+
+    return status;
+}
+
+std::string AgentISABuffer::GetISAText() const
+{
+    if (m_pISABufferText == nullptr)
+    {
+        return std::string();
+    }
+
+    return std::string(m_pISABufferText, m_ISABufferLen);
+}
+
 bool AgentISABuffer::CheckForKernelName(const std::string& kernelName) const
 {
     bool retCode = false;
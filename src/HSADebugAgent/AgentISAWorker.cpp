@@ -0,0 +1,653 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Background threads that disassemble code objects
+//==============================================================================
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <map>
+#include <pthread.h>
+#include <sstream>
+#include <vector>
+
+#include "AgentGCNDecoder.h"
+#include "AgentISABuffer.h"
+#include "AgentISAWorker.h"
+#include "AgentLogging.h"
+#include "AgentTiming.h"
+
+namespace HwDbgAgent
+{
+
+typedef enum
+{
+    ISA_JOB_DEFERRED,   /// Only disassembled if gdb asks for the ISA
+    ISA_JOB_QUEUED,     /// Waiting for a worker thread
+    ISA_JOB_RUNNING,    /// A worker thread is disassembling the code object
+    ISA_JOB_DONE,       /// The ISA text is ready
+    ISA_JOB_FAILED      /// The code object could not be disassembled
+} IsaJobState;
+
+typedef struct
+{
+    IsaJobState       m_state;
+    std::vector<char> m_codeObj;    // Copy of the code object, released once disassembled
+    std::string       m_isaText;    // Valid when m_state is ISA_JOB_DONE
+} IsaJob;
+
+/// Default number of worker threads
+static const unsigned int gs_DEFAULT_ISA_WORKER_THREADS = 1;
+
+/// Upper limit of ROCM_GDB_ISA_WORKER_THREADS
+static const unsigned int gs_MAX_ISA_WORKER_THREADS = 8;
+
+/// Limit of the ISA text of the done jobs and the code objects of the deferred jobs,
+/// the oldest jobs are dropped above it
+static const size_t gs_MAX_ISA_RESULTS_SIZE = 64 * 1024 * 1024;
+
+/// Protects all the state below
+static pthread_mutex_t gs_ISAWorkerMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/// Signaled when a job is queued or the workers have to stop
+static pthread_cond_t gs_ISAJobQueuedCond = PTHREAD_COND_INITIALIZER;
+
+/// Signaled when a job is done or failed
+static pthread_cond_t gs_ISAJobDoneCond = PTHREAD_COND_INITIALIZER;
+
+/// The jobs, keyed by the hash of the code object
+static std::map<uint64_t, IsaJob> gs_ISAJobs;
+
+/// Hashes of the queued jobs, the next one to run first
+static std::deque<uint64_t> gs_ISAJobQueue;
+
+/// Hashes of the deferred, done and failed jobs, the oldest first
+static std::list<uint64_t> gs_ISAFinishedJobs;
+
+/// Bytes of ISA text held by the done jobs and of code objects held by the deferred jobs
+static size_t gs_ISAResultsSize = 0;
+
+static pthread_t gs_ISAWorkerThreads[gs_MAX_ISA_WORKER_THREADS];
+static unsigned int gs_NumISAWorkerThreads = 0;
+static bool gs_IsISAWorkerStarted = false;
+static bool gs_IsISAWorkerStopping = false;
+
+static uint64_t gs_NumISAJobsQueued = 0;
+static uint64_t gs_NumISAJobsReused = 0;
+static uint64_t gs_NumISAJobsDone = 0;
+static uint64_t gs_NumISAJobsFailed = 0;
+static uint64_t gs_NumISAWaits = 0;
+static uint64_t gs_NumISAJobsDeferred = 0;
+static uint64_t gs_NumISAJobsRequested = 0;
+
+/// Deferred jobs dropped by EvictFinishedISAJobs, gdb never asked for their ISA
+static uint64_t gs_NumISAJobsEvictedDeferred = 0;
+
+/// Dropped deferred jobs that were deferred again with a new copy of their code object
+static uint64_t gs_NumISAJobsRecovered = 0;
+
+/// Dropped deferred jobs whose ISA was needed without being deferred again,
+/// gdb asked for it or a dispatch queued the code object
+static uint64_t gs_NumISAJobsLost = 0;
+
+/// The size of the code object of the dropped deferred jobs, keyed by the hash of the code object.
+/// gdb may still ask for their ISA, the code object is then looked for in the load map
+static std::map<uint64_t, size_t> gs_EvictedDeferredJobs;
+
+/// Ranges rendered by AgentGetISARange without disassembling the whole code object
+static uint64_t gs_NumISARangesDecoded = 0;
+
+/// Drop the oldest finished jobs till the ISA text fits in gs_MAX_ISA_RESULTS_SIZE.
+/// The most recent job is always kept. Called with gs_ISAWorkerMutex held.
+static void EvictFinishedISAJobs()
+{
+    while (gs_ISAResultsSize > gs_MAX_ISA_RESULTS_SIZE && gs_ISAFinishedJobs.size() > 1)
+    {
+        std::map<uint64_t, IsaJob>::iterator jobIt = gs_ISAJobs.find(gs_ISAFinishedJobs.front());
+        gs_ISAFinishedJobs.pop_front();
+
+        if (jobIt != gs_ISAJobs.end())
+        {
+            if (jobIt->second.m_state == ISA_JOB_DEFERRED)
+            {
+                gs_ISAResultsSize -= jobIt->second.m_codeObj.size();
+                gs_EvictedDeferredJobs[jobIt->first] = jobIt->second.m_codeObj.size();
+                gs_NumISAJobsEvictedDeferred++;
+            }
+            else
+            {
+                gs_ISAResultsSize -= jobIt->second.m_isaText.size();
+            }
+
+            gs_ISAJobs.erase(jobIt);
+        }
+    }
+}
+
+/// Disassemble a code object, temporary files are named after the hash
+/// so jobs can run in parallel. Called without gs_ISAWorkerMutex held.
+static HsailAgentStatus DisassembleISAJob(const uint64_t           binaryHash,
+                                          const std::vector<char>& codeObj,
+                                          std::string&             isaTextOut)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    std::stringstream fileNameSuffix;
+    fileNameSuffix << "-" << std::hex << binaryHash;
+
+    AgentISABuffer isaBuffer;
+
+    uint64_t startNs = AgentGetTimestampNs();
+    status = isaBuffer.PopulateISAFromCodeObj(codeObj.size(), codeObj.data(), fileNameSuffix.str());
+    AgentRecordTime(AGENT_TIMER_ISA_DISASSEMBLY, startNs, codeObj.size());
+
+    if (status == HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        isaTextOut = isaBuffer.GetISAText();
+    }
+
+    if (isaTextOut.empty())
+    {
+        AGENT_ERROR("DisassembleISAJob: Could not disassemble the code object " << fileNameSuffix.str());
+        status = HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    return status;
+}
+
+/// Save the result of a job and wake up the threads waiting for it.
+/// Called with gs_ISAWorkerMutex held.
+static void FinishISAJob(const uint64_t binaryHash, const HsailAgentStatus status, std::string& isaText)
+{
+    std::map<uint64_t, IsaJob>::iterator jobIt = gs_ISAJobs.find(binaryHash);
+
+    if (jobIt == gs_ISAJobs.end())
+    {
+        return;
+    }
+
+    IsaJob& job = jobIt->second;
+
+    if (status == HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        job.m_state = ISA_JOB_DONE;
+        job.m_isaText.swap(isaText);
+        gs_ISAResultsSize += job.m_isaText.size();
+        gs_NumISAJobsDone++;
+    }
+    else
+    {
+        job.m_state = ISA_JOB_FAILED;
+        gs_NumISAJobsFailed++;
+    }
+
+    gs_ISAFinishedJobs.push_back(binaryHash);
+    EvictFinishedISAJobs();
+
+    pthread_cond_broadcast(&gs_ISAJobDoneCond);
+}
+
+/// The worker thread, runs the queued jobs till AgentStopISAWorkers is called
+static void* ISAWorkerThread(void* pArgs)
+{
+    pthread_mutex_lock(&gs_ISAWorkerMutex);
+
+    while (true)
+    {
+        while (gs_ISAJobQueue.empty() && !gs_IsISAWorkerStopping)
+        {
+            pthread_cond_wait(&gs_ISAJobQueuedCond, &gs_ISAWorkerMutex);
+        }
+
+        if (gs_IsISAWorkerStopping)
+        {
+            break;
+        }
+
+        uint64_t binaryHash = gs_ISAJobQueue.front();
+        gs_ISAJobQueue.pop_front();
+
+        std::map<uint64_t, IsaJob>::iterator jobIt = gs_ISAJobs.find(binaryHash);
+
+        if (jobIt == gs_ISAJobs.end() || jobIt->second.m_state != ISA_JOB_QUEUED)
+        {
+            continue;
+        }
+
+        jobIt->second.m_state = ISA_JOB_RUNNING;
+
+        std::vector<char> codeObj;
+        codeObj.swap(jobIt->second.m_codeObj);
+
+        pthread_mutex_unlock(&gs_ISAWorkerMutex);
+
+        std::string isaText;
+        HsailAgentStatus status = DisassembleISAJob(binaryHash, codeObj, isaText);
+
+        pthread_mutex_lock(&gs_ISAWorkerMutex);
+
+        FinishISAJob(binaryHash, status, isaText);
+    }
+
+    pthread_mutex_unlock(&gs_ISAWorkerMutex);
+
+    return pArgs;
+}
+
+/// Start the worker threads, called with gs_ISAWorkerMutex held
+static void StartISAWorkers()
+{
+    gs_IsISAWorkerStarted = true;
+
+    unsigned int numThreads = gs_DEFAULT_ISA_WORKER_THREADS;
+
+    const char* pNumThreadsEnvVar = std::getenv("ROCM_GDB_ISA_WORKER_THREADS");
+
+    if (pNumThreadsEnvVar != nullptr)
+    {
+        char* pEnd = nullptr;
+        unsigned long envNumThreads = std::strtoul(pNumThreadsEnvVar, &pEnd, 10);
+
+        if (pEnd == pNumThreadsEnvVar || *pEnd != '\0' ||
+            envNumThreads > gs_MAX_ISA_WORKER_THREADS)
+        {
+            AGENT_WARNING("Invalid ROCM_GDB_ISA_WORKER_THREADS = " << pNumThreadsEnvVar <<
+                          ", using " << gs_DEFAULT_ISA_WORKER_THREADS);
+        }
+        else
+        {
+            numThreads = static_cast<unsigned int>(envNumThreads);
+        }
+    }
+
+    for (unsigned int i = 0; i < numThreads; i++)
+    {
+        int retCode = pthread_create(&gs_ISAWorkerThreads[gs_NumISAWorkerThreads], nullptr, ISAWorkerThread, nullptr);
+
+        if (retCode != 0)
+        {
+            AGENT_ERROR("StartISAWorkers: Could not create an ISA worker thread, " << strerror(retCode));
+            break;
+        }
+
+        gs_NumISAWorkerThreads++;
+    }
+
+    AGENT_LOG("StartISAWorkers: " << gs_NumISAWorkerThreads << " ISA worker threads");
+}
+
+/// Hand a job in the ISA_JOB_QUEUED state to the worker threads, or disassemble it
+/// on the calling thread if there is no worker thread.
+/// Called with gs_ISAWorkerMutex held, the mutex is held again when the call returns
+static HsailAgentStatus RunISAJob(const uint64_t binaryHash, IsaJob& job, const bool isUrgent)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (!gs_IsISAWorkerStarted)
+    {
+        StartISAWorkers();
+    }
+
+    if (gs_NumISAWorkerThreads > 0)
+    {
+        if (isUrgent)
+        {
+            gs_ISAJobQueue.push_front(binaryHash);
+        }
+        else
+        {
+            gs_ISAJobQueue.push_back(binaryHash);
+        }
+
+        pthread_cond_signal(&gs_ISAJobQueuedCond);
+
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+        return status;
+    }
+
+    // No worker thread, disassemble on the calling thread like before
+    job.m_state = ISA_JOB_RUNNING;
+
+    std::vector<char> codeObj;
+    codeObj.swap(job.m_codeObj);
+
+    pthread_mutex_unlock(&gs_ISAWorkerMutex);
+
+    std::string isaText;
+    status = DisassembleISAJob(binaryHash, codeObj, isaText);
+
+    pthread_mutex_lock(&gs_ISAWorkerMutex);
+    FinishISAJob(binaryHash, status, isaText);
+
+    return status;
+}
+
+HsailAgentStatus AgentQueueISADisassembly(const uint64_t binaryHash,
+                                          const void*    pBinary,
+                                          const size_t   binarySize)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (pBinary == nullptr || binarySize == 0)
+    {
+        AGENT_ERROR("AgentQueueISADisassembly: Invalid input");
+        return status;
+    }
+
+    pthread_mutex_lock(&gs_ISAWorkerMutex);
+
+    if (gs_IsISAWorkerStopping)
+    {
+        pthread_mutex_unlock(&gs_ISAWorkerMutex);
+        AGENT_ERROR("AgentQueueISADisassembly: The ISA workers are stopped");
+        return status;
+    }
+
+    std::map<uint64_t, IsaJob>::iterator jobIt = gs_ISAJobs.find(binaryHash);
+
+    // A code object deferred at load time is queued with the copy it already has
+    if (jobIt != gs_ISAJobs.end() && jobIt->second.m_state == ISA_JOB_DEFERRED)
+    {
+        gs_ISAFinishedJobs.remove(binaryHash);
+        gs_ISAResultsSize -= jobIt->second.m_codeObj.size();
+
+        jobIt->second.m_state = ISA_JOB_QUEUED;
+        gs_NumISAJobsQueued++;
+
+        status = RunISAJob(binaryHash, jobIt->second, false);
+
+        pthread_mutex_unlock(&gs_ISAWorkerMutex);
+
+        return status;
+    }
+
+    if (jobIt != gs_ISAJobs.end())
+    {
+        gs_NumISAJobsReused++;
+        pthread_mutex_unlock(&gs_ISAWorkerMutex);
+
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+        return status;
+    }
+
+    // A dropped deferred job queued by a dispatch is disassembled after all
+    if (gs_EvictedDeferredJobs.erase(binaryHash) > 0)
+    {
+        gs_NumISAJobsLost++;
+    }
+
+    IsaJob& job = gs_ISAJobs[binaryHash];
+    job.m_state = ISA_JOB_QUEUED;
+
+    const char* pBinaryBytes = static_cast<const char*>(pBinary);
+    job.m_codeObj.assign(pBinaryBytes, pBinaryBytes + binarySize);
+
+    gs_NumISAJobsQueued++;
+
+    status = RunISAJob(binaryHash, job, false);
+
+    pthread_mutex_unlock(&gs_ISAWorkerMutex);
+
+    return status;
+}
+
+HsailAgentStatus AgentDeferISADisassembly(const uint64_t binaryHash,
+                                          const void*    pBinary,
+                                          const size_t   binarySize)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (pBinary == nullptr || binarySize == 0)
+    {
+        AGENT_ERROR("AgentDeferISADisassembly: Invalid input");
+        return status;
+    }
+
+    pthread_mutex_lock(&gs_ISAWorkerMutex);
+
+    if (gs_ISAJobs.find(binaryHash) != gs_ISAJobs.end())
+    {
+        gs_NumISAJobsReused++;
+        pthread_mutex_unlock(&gs_ISAWorkerMutex);
+
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+        return status;
+    }
+
+    IsaJob& job = gs_ISAJobs[binaryHash];
+    job.m_state = ISA_JOB_DEFERRED;
+
+    const char* pBinaryBytes = static_cast<const char*>(pBinary);
+    job.m_codeObj.assign(pBinaryBytes, pBinaryBytes + binarySize);
+
+    // A dropped job deferred again was already counted
+    if (gs_EvictedDeferredJobs.erase(binaryHash) > 0)
+    {
+        gs_NumISAJobsRecovered++;
+    }
+    else
+    {
+        gs_NumISAJobsDeferred++;
+    }
+
+    // A deferred job is dropped like a finished one when the limit is reached
+    gs_ISAResultsSize += binarySize;
+    gs_ISAFinishedJobs.push_back(binaryHash);
+    EvictFinishedISAJobs();
+
+    pthread_mutex_unlock(&gs_ISAWorkerMutex);
+
+    status = HSAIL_AGENT_STATUS_SUCCESS;
+    return status;
+}
+
+bool AgentGetDisassembledISA(const uint64_t binaryHash, std::string& isaTextOut)
+{
+    bool retCode = false;
+
+    uint64_t startNs = AgentGetTimestampNs();
+
+    pthread_mutex_lock(&gs_ISAWorkerMutex);
+
+    std::map<uint64_t, IsaJob>::iterator jobIt = gs_ISAJobs.find(binaryHash);
+
+    // gdb asks for the ISA of a deferred job, it is disassembled now
+    if (jobIt != gs_ISAJobs.end() && jobIt->second.m_state == ISA_JOB_DEFERRED && !gs_IsISAWorkerStopping)
+    {
+        gs_NumISAJobsRequested++;
+
+        gs_ISAFinishedJobs.remove(binaryHash);
+        gs_ISAResultsSize -= jobIt->second.m_codeObj.size();
+
+        jobIt->second.m_state = ISA_JOB_QUEUED;
+        RunISAJob(binaryHash, jobIt->second, true);
+
+        // The job may be finished and evicted if it ran on this thread
+        jobIt = gs_ISAJobs.find(binaryHash);
+    }
+
+    if (jobIt != gs_ISAJobs.end() &&
+        (jobIt->second.m_state == ISA_JOB_QUEUED || jobIt->second.m_state == ISA_JOB_RUNNING))
+    {
+        gs_NumISAWaits++;
+
+        // Run this job next, the other queued jobs are not waited for
+        if (jobIt->second.m_state == ISA_JOB_QUEUED)
+        {
+            for (std::deque<uint64_t>::iterator queueIt = gs_ISAJobQueue.begin(); queueIt != gs_ISAJobQueue.end(); ++queueIt)
+            {
+                if (*queueIt == binaryHash)
+                {
+                    gs_ISAJobQueue.erase(queueIt);
+                    break;
+                }
+            }
+
+            gs_ISAJobQueue.push_front(binaryHash);
+        }
+
+        // A finished job can be evicted while this thread sleeps, so look it up again on every wake up
+        while (jobIt != gs_ISAJobs.end() && !gs_IsISAWorkerStopping &&
+               (jobIt->second.m_state == ISA_JOB_QUEUED || jobIt->second.m_state == ISA_JOB_RUNNING))
+        {
+            pthread_cond_wait(&gs_ISAJobDoneCond, &gs_ISAWorkerMutex);
+            jobIt = gs_ISAJobs.find(binaryHash);
+        }
+    }
+
+    if (jobIt != gs_ISAJobs.end() && jobIt->second.m_state == ISA_JOB_DONE)
+    {
+        isaTextOut.assign(jobIt->second.m_isaText);
+        retCode = true;
+    }
+
+    // gdb asked for a disassembly that was dropped, it was not avoided
+    if (jobIt == gs_ISAJobs.end() && gs_EvictedDeferredJobs.erase(binaryHash) > 0)
+    {
+        gs_NumISAJobsLost++;
+    }
+
+    pthread_mutex_unlock(&gs_ISAWorkerMutex);
+
+    AgentRecordTime(AGENT_TIMER_ISA_WAIT, startNs, isaTextOut.size());
+
+    if (!retCode)
+    {
+        AGENT_LOG("AgentGetDisassembledISA: No ISA for the code object " << std::hex << binaryHash << std::dec);
+    }
+
+    return retCode;
+}
+
+bool AgentIsDeferredISAEvicted(const uint64_t binaryHash, size_t& codeObjSizeOut)
+{
+    bool retCode = false;
+
+    pthread_mutex_lock(&gs_ISAWorkerMutex);
+
+    std::map<uint64_t, size_t>::const_iterator evictedIt = gs_EvictedDeferredJobs.find(binaryHash);
+
+    if (evictedIt != gs_EvictedDeferredJobs.end() && gs_ISAJobs.find(binaryHash) == gs_ISAJobs.end())
+    {
+        codeObjSizeOut = evictedIt->second;
+        retCode = true;
+    }
+
+    pthread_mutex_unlock(&gs_ISAWorkerMutex);
+
+    return retCode;
+}
+
+bool AgentGetISARange(const uint64_t binaryHash,
+                      const uint64_t startPC,
+                      const uint64_t endPC,
+                      std::string&   isaTextOut)
+{
+    bool retCode = false;
+
+    if (startPC >= endPC || AgentISABuffer::IsLLVMObjDumpForced())
+    {
+        return retCode;
+    }
+
+    uint64_t startNs = AgentGetTimestampNs();
+
+    // The job keeps its code object till a worker starts it,
+    // copy it so the decoding does not hold the mutex
+    std::vector<char> codeObj;
+
+    pthread_mutex_lock(&gs_ISAWorkerMutex);
+
+    std::map<uint64_t, IsaJob>::const_iterator jobIt = gs_ISAJobs.find(binaryHash);
+
+    if (jobIt != gs_ISAJobs.end() &&
+        (jobIt->second.m_state == ISA_JOB_DEFERRED || jobIt->second.m_state == ISA_JOB_QUEUED))
+    {
+        codeObj = jobIt->second.m_codeObj;
+    }
+
+    pthread_mutex_unlock(&gs_ISAWorkerMutex);
+
+    if (codeObj.empty())
+    {
+        return retCode;
+    }
+
+    AgentGCNDecoder decoder;
+
+    if (decoder.Decode(codeObj.data(), codeObj.size()) == HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        decoder.RenderText(startPC, endPC, isaTextOut);
+        retCode = !isaTextOut.empty();
+    }
+
+    AgentRecordTime(AGENT_TIMER_ISA_DISASSEMBLY, startNs, codeObj.size());
+
+    if (retCode)
+    {
+        pthread_mutex_lock(&gs_ISAWorkerMutex);
+        gs_NumISARangesDecoded++;
+        pthread_mutex_unlock(&gs_ISAWorkerMutex);
+    }
+
+    return retCode;
+}
+
+void AgentStopISAWorkers()
+{
+    pthread_mutex_lock(&gs_ISAWorkerMutex);
+
+    gs_IsISAWorkerStopping = true;
+    pthread_cond_broadcast(&gs_ISAJobQueuedCond);
+    pthread_cond_broadcast(&gs_ISAJobDoneCond);
+
+    pthread_mutex_unlock(&gs_ISAWorkerMutex);
+
+    // A worker finishes the job it is running before it sees the flag
+    for (unsigned int i = 0; i < gs_NumISAWorkerThreads; i++)
+    {
+        pthread_join(gs_ISAWorkerThreads[i], nullptr);
+    }
+
+    pthread_mutex_lock(&gs_ISAWorkerMutex);
+
+    gs_NumISAWorkerThreads = 0;
+    gs_ISAJobQueue.clear();
+    gs_ISAFinishedJobs.clear();
+    gs_ISAJobs.clear();
+    gs_EvictedDeferredJobs.clear();
+    gs_ISAResultsSize = 0;
+
+    pthread_mutex_unlock(&gs_ISAWorkerMutex);
+}
+
+void AgentLogISAWorkerStatistics()
+{
+    pthread_mutex_lock(&gs_ISAWorkerMutex);
+
+    AGENT_LOG("ISA worker statistics: " <<
+              "Queued: " << gs_NumISAJobsQueued << "\t" <<
+              "Reused: " << gs_NumISAJobsReused << "\t" <<
+              "Done: " << gs_NumISAJobsDone << "\t" <<
+              "Failed: " << gs_NumISAJobsFailed << "\t" <<
+              "Waits: " << gs_NumISAWaits << "\t" <<
+              "Bytes: " << gs_ISAResultsSize);
+
+    // Every deferred job gdb did not ask for is a disassembly that was not needed,
+    // a dropped job gdb asked for and that could not be recovered was not avoided either
+    AGENT_LOG("ISA worker lazy disassembly: " <<
+              "Deferred: " << gs_NumISAJobsDeferred << "\t" <<
+              "Requested: " << gs_NumISAJobsRequested << "\t" <<
+              "Avoided: " << gs_NumISAJobsDeferred - gs_NumISAJobsRequested - gs_NumISAJobsLost << "\t" <<
+              "Dropped: " << gs_NumISAJobsEvictedDeferred << "\t" <<
+              "Recovered: " << gs_NumISAJobsRecovered << "\t" <<
+              "Lost: " << gs_NumISAJobsLost << "\t" <<
+              "Ranges: " << gs_NumISARangesDecoded);
+
+    pthread_mutex_unlock(&gs_ISAWorkerMutex);
+}
+
+} // End Namespace HwDbgAgent
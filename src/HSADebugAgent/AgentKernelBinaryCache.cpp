@@ -0,0 +1,242 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Cache of the data the agent derives from a kernel binary
+//==============================================================================
+#include <cstdlib>
+
+#include "AgentKernelBinaryCache.h"
+#include "AgentLogging.h"
+
+namespace HwDbgAgent
+{
+
+/// Default limit of the cached text, in MB
+static const size_t gs_DEFAULT_KERNEL_BINARY_CACHE_MB = 64;
+
+AgentKernelBinaryCache::AgentKernelBinaryCache():
+    m_entries(),
+    m_entryIndex(),
+    m_isaTexts(),
+    m_size(0),
+    m_maxSize(gs_DEFAULT_KERNEL_BINARY_CACHE_MB * 1024 * 1024),
+    m_numHits(0),
+    m_numMisses(0),
+    m_numEvictions(0),
+    m_numPrefilled(0)
+{
+    pthread_mutex_init(&m_mutex, nullptr);
+
+    const char* pCacheSizeEnvVar = std::getenv("ROCM_GDB_KERNEL_BINARY_CACHE_MB");
+
+    if (pCacheSizeEnvVar != nullptr)
+    {
+        char* pEnd = nullptr;
+        unsigned long cacheSizeMB = std::strtoul(pCacheSizeEnvVar, &pEnd, 10);
+
+        if (pEnd == pCacheSizeEnvVar || *pEnd != '\0')
+        {
+            AGENT_WARNING("Invalid ROCM_GDB_KERNEL_BINARY_CACHE_MB = " << pCacheSizeEnvVar <<
+                          ", using " << gs_DEFAULT_KERNEL_BINARY_CACHE_MB << "MB");
+        }
+        else
+        {
+            m_maxSize = static_cast<size_t>(cacheSizeMB) * 1024 * 1024;
+        }
+    }
+
+    AGENT_LOG("AgentKernelBinaryCache: Limit " << m_maxSize << " bytes");
+}
+
+AgentKernelBinaryCache::~AgentKernelBinaryCache()
+{
+    m_entryIndex.clear();
+    m_entries.clear();
+    m_isaTexts.clear();
+
+    pthread_mutex_destroy(&m_mutex);
+}
+
+size_t AgentKernelBinaryCache::GetEntrySize(const CacheEntry& entry)
+{
+    return sizeof(CacheEntry) + entry.m_kernelName.size();
+}
+
+std::shared_ptr<const std::string> AgentKernelBinaryCache::ReferenceISAText(const uint64_t binaryHash, const std::string& isaText)
+{
+    std::map<uint64_t, ISATextEntry>::iterator textIt = m_isaTexts.find(binaryHash);
+
+    if (textIt != m_isaTexts.end())
+    {
+        textIt->second.m_numEntries++;
+        return textIt->second.m_pISAText;
+    }
+
+    if (isaText.empty())
+    {
+        return std::shared_ptr<const std::string>();
+    }
+
+    ISATextEntry textEntry;
+    textEntry.m_pISAText = std::make_shared<const std::string>(isaText);
+    textEntry.m_numEntries = 1;
+
+    m_isaTexts[binaryHash] = textEntry;
+    m_size += isaText.size();
+
+    return textEntry.m_pISAText;
+}
+
+void AgentKernelBinaryCache::ReleaseISAText(const CacheEntry& entry)
+{
+    if (entry.m_pISAText == nullptr)
+    {
+        return;
+    }
+
+    std::map<uint64_t, ISATextEntry>::iterator textIt = m_isaTexts.find(entry.m_key.second);
+
+    if (textIt == m_isaTexts.end())
+    {
+        return;
+    }
+
+    textIt->second.m_numEntries--;
+
+    if (textIt->second.m_numEntries == 0)
+    {
+        m_size -= textIt->second.m_pISAText->size();
+        m_isaTexts.erase(textIt);
+    }
+}
+
+void AgentKernelBinaryCache::RemoveEntry(const CacheEntryList::iterator& entryIt)
+{
+    ReleaseISAText(*entryIt);
+    m_size -= GetEntrySize(*entryIt);
+    m_entryIndex.erase(entryIt->m_key);
+    m_entries.erase(entryIt);
+}
+
+bool AgentKernelBinaryCache::Find(const uint64_t                       kernelObject,
+                                  const uint64_t                       binaryHash,
+                                  std::string&                         kernelNameOut,
+                                  std::shared_ptr<const std::string>&  pISATextOut)
+{
+    pthread_mutex_lock(&m_mutex);
+
+    std::map<CacheKey, CacheEntryList::iterator>::const_iterator indexIt =
+        m_entryIndex.find(CacheKey(kernelObject, binaryHash));
+
+    if (indexIt == m_entryIndex.end())
+    {
+        m_numMisses++;
+        pthread_mutex_unlock(&m_mutex);
+        return false;
+    }
+
+    // Move the entry to the front, the back is evicted first
+    m_entries.splice(m_entries.begin(), m_entries, indexIt->second);
+
+    kernelNameOut.assign(indexIt->second->m_kernelName);
+    pISATextOut = indexIt->second->m_pISAText;
+
+    m_numHits++;
+    pthread_mutex_unlock(&m_mutex);
+    return true;
+}
+
+void AgentKernelBinaryCache::Add(const uint64_t     kernelObject,
+                                 const uint64_t     binaryHash,
+                                 const std::string& kernelName,
+                                 const std::string& isaText)
+{
+    pthread_mutex_lock(&m_mutex);
+    InsertEntry(CacheKey(kernelObject, binaryHash), kernelName, isaText);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+bool AgentKernelBinaryCache::AddKernelName(const uint64_t     kernelObject,
+                                           const uint64_t     binaryHash,
+                                           const std::string& kernelName)
+{
+    const CacheKey key(kernelObject, binaryHash);
+
+    pthread_mutex_lock(&m_mutex);
+
+    bool isAdded = (m_entryIndex.find(key) == m_entryIndex.end());
+
+    if (isAdded)
+    {
+        InsertEntry(key, kernelName, std::string());
+        m_numPrefilled++;
+    }
+
+    pthread_mutex_unlock(&m_mutex);
+
+    return isAdded;
+}
+
+void AgentKernelBinaryCache::InsertEntry(const CacheKey& key, const std::string& kernelName, const std::string& isaText)
+{
+    std::map<CacheKey, CacheEntryList::iterator>::iterator indexIt = m_entryIndex.find(key);
+
+    if (indexIt != m_entryIndex.end())
+    {
+        RemoveEntry(indexIt->second);
+    }
+
+    CacheEntry entry;
+    entry.m_key = key;
+    entry.m_kernelName = kernelName;
+
+    const size_t entrySize = GetEntrySize(entry);
+
+    if (entrySize + isaText.size() > m_maxSize)
+    {
+        AGENT_LOG("AgentKernelBinaryCache: " << kernelName << " needs " << entrySize <<
+                  " bytes, more than the cache limit, not cached");
+        return;
+    }
+
+    // The ISA text is only counted if it is not shared with an entry in the cache,
+    // an eviction may free the text of the binary
+    while (!m_entries.empty() &&
+           m_size + entrySize + ((m_isaTexts.find(key.second) == m_isaTexts.end()) ? isaText.size() : 0) > m_maxSize)
+    {
+        CacheEntryList::iterator lastIt = m_entries.end();
+        --lastIt;
+
+        AGENT_LOG("AgentKernelBinaryCache: Evict " << lastIt->m_kernelName);
+
+        RemoveEntry(lastIt);
+        m_numEvictions++;
+    }
+
+    entry.m_pISAText = ReferenceISAText(key.second, isaText);
+
+    m_entries.push_front(entry);
+    m_entryIndex[key] = m_entries.begin();
+    m_size += entrySize;
+}
+
+void AgentKernelBinaryCache::LogStatistics() const
+{
+    pthread_mutex_lock(&m_mutex);
+
+    AGENT_LOG("Kernel binary cache statistics: " <<
+              "Entries: " << m_entries.size() << "\t" <<
+              "ISA texts: " << m_isaTexts.size() << "\t" <<
+              "Bytes: " << m_size << "\t" <<
+              "Limit: " << m_maxSize << "\t" <<
+              "Hits: " << m_numHits << "\t" <<
+              "Misses: " << m_numMisses << "\t" <<
+              "Evictions: " << m_numEvictions << "\t" <<
+              "Prefilled: " << m_numPrefilled);
+
+    pthread_mutex_unlock(&m_mutex);
+}
+
+} // End Namespace HwDbgAgent
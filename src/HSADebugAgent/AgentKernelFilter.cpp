@@ -0,0 +1,463 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Selection of the dispatches that are debugged
+//==============================================================================
+#include <algorithm>
+#include <cstdlib>
+#include <fnmatch.h>
+#include <pthread.h>
+#include <regex.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "AgentKernelFilter.h"
+#include "AgentLogging.h"
+
+namespace HwDbgAgent
+{
+
+/// A parsed filter, the clauses of each kind are kept in the form they are matched in
+class KernelFilter
+{
+public:
+    KernelFilter() {}
+
+    ~KernelFilter()
+    {
+        for (size_t i = 0; i < m_nameRegexes.size(); i++)
+        {
+            regfree(&m_nameRegexes[i]);
+        }
+    }
+
+    /// Shell patterns of the name clauses
+    std::vector<std::string> m_nameGlobs;
+
+    /// Compiled regex clauses
+    std::vector<regex_t> m_nameRegexes;
+
+    /// Inclusive dispatch ordinal ranges, sorted by their first ordinal and not overlapping
+    std::vector<std::pair<uint64_t, uint64_t> > m_dispatchRanges;
+
+    /// Sorted queue ids
+    std::vector<uint64_t> m_queueIds;
+
+    bool HasNameClauses() const { return !m_nameGlobs.empty() || !m_nameRegexes.empty(); }
+
+private:
+    /// Disable copy constructor
+    KernelFilter(const KernelFilter&);
+
+    /// Disable assignment operator
+    KernelFilter& operator=(const KernelFilter&);
+};
+
+/// Protects the filter, the kernel names and the name verdicts
+static pthread_mutex_t gs_KernelFilterMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/// The filter, nullptr if every dispatch is selected
+static KernelFilter* gs_pKernelFilter = nullptr;
+
+/// Set with the filter, read without the lock by the dispatches
+static bool gs_IsKernelFilterSet = false;
+
+/// Reads ROCM_GDB_KERNEL_FILTER once
+static pthread_once_t gs_KernelFilterEnvOnce = PTHREAD_ONCE_INIT;
+
+/// The names of the kernel objects
+static std::unordered_map<uint64_t, std::vector<std::string> > gs_KernelNames;
+
+/// The result of the name clauses for the kernel objects matched since the filter was set
+static std::unordered_map<uint64_t, bool> gs_KernelNameVerdicts;
+
+/// The ordinal of the last dispatch
+static uint64_t gs_NumDispatchesSeen = 0;
+
+static uint64_t gs_NumDispatchesSelected = 0;
+static uint64_t gs_NumNameMatches = 0;
+static uint64_t gs_NumNameVerdictsReused = 0;
+
+/// Remove the white space at the start and the end of a clause
+static std::string TrimClause(const std::string& clause)
+{
+    const char* pWhiteSpace = " \t\n";
+    size_t first = clause.find_first_not_of(pWhiteSpace);
+
+    if (first == std::string::npos)
+    {
+        return std::string();
+    }
+
+    size_t last = clause.find_last_not_of(pWhiteSpace);
+    return clause.substr(first, last - first + 1);
+}
+
+static bool ParseNumber(const std::string& text, uint64_t& numberOut)
+{
+    if (text.empty())
+    {
+        return false;
+    }
+
+    char* pEnd = nullptr;
+    numberOut = std::strtoull(text.c_str(), &pEnd, 0);
+
+    return (pEnd != nullptr && *pEnd == '\0');
+}
+
+/// Parse "N", "N-M" or "N-"
+static bool ParseDispatchRange(const std::string& text, std::pair<uint64_t, uint64_t>& rangeOut)
+{
+    size_t dashPos = text.find('-');
+
+    if (dashPos == std::string::npos)
+    {
+        if (!ParseNumber(text, rangeOut.first))
+        {
+            return false;
+        }
+
+        rangeOut.second = rangeOut.first;
+        return true;
+    }
+
+    if (!ParseNumber(text.substr(0, dashPos), rangeOut.first))
+    {
+        return false;
+    }
+
+    std::string lastText = text.substr(dashPos + 1);
+
+    if (lastText.empty())
+    {
+        rangeOut.second = UINT64_MAX;
+        return true;
+    }
+
+    return (ParseNumber(lastText, rangeOut.second) && rangeOut.first <= rangeOut.second);
+}
+
+/// Parse one clause into the filter
+static bool ParseClause(const std::string& clause, KernelFilter& filterOut)
+{
+    size_t equalPos = clause.find('=');
+
+    std::string kind = (equalPos == std::string::npos) ? "name" : TrimClause(clause.substr(0, equalPos));
+    std::string value = (equalPos == std::string::npos) ? clause : TrimClause(clause.substr(equalPos + 1));
+
+    if (value.empty())
+    {
+        AGENT_ERROR("AgentSetKernelFilter: Clause \"" << clause << "\" has no value");
+        return false;
+    }
+
+    if (kind == "name")
+    {
+        filterOut.m_nameGlobs.push_back(value);
+    }
+    else if (kind == "regex")
+    {
+        regex_t nameRegex;
+        int regStatus = regcomp(&nameRegex, value.c_str(), REG_EXTENDED | REG_NOSUB);
+
+        if (regStatus != 0)
+        {
+            char errorText[256];
+            regerror(regStatus, &nameRegex, errorText, sizeof(errorText));
+            AGENT_ERROR("AgentSetKernelFilter: Invalid regex \"" << value << "\": " << errorText);
+            return false;
+        }
+
+        filterOut.m_nameRegexes.push_back(nameRegex);
+    }
+    else if (kind == "dispatch")
+    {
+        std::pair<uint64_t, uint64_t> range;
+
+        if (!ParseDispatchRange(value, range))
+        {
+            AGENT_ERROR("AgentSetKernelFilter: Invalid dispatch range \"" << value << "\"");
+            return false;
+        }
+
+        filterOut.m_dispatchRanges.push_back(range);
+    }
+    else if (kind == "queue")
+    {
+        uint64_t queueId = 0;
+
+        if (!ParseNumber(value, queueId))
+        {
+            AGENT_ERROR("AgentSetKernelFilter: Invalid queue id \"" << value << "\"");
+            return false;
+        }
+
+        filterOut.m_queueIds.push_back(queueId);
+    }
+    else
+    {
+        AGENT_ERROR("AgentSetKernelFilter: Unknown clause \"" << kind << "\"");
+        return false;
+    }
+
+    return true;
+}
+
+/// Sort the ranges and merge the ones that overlap or touch
+static void MergeDispatchRanges(std::vector<std::pair<uint64_t, uint64_t> >& ranges)
+{
+    std::sort(ranges.begin(), ranges.end());
+
+    size_t numMerged = 0;
+
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        if (numMerged > 0 &&
+            (ranges[numMerged - 1].second == UINT64_MAX || ranges[i].first <= ranges[numMerged - 1].second + 1))
+        {
+            ranges[numMerged - 1].second = std::max(ranges[numMerged - 1].second, ranges[i].second);
+        }
+        else
+        {
+            ranges[numMerged++] = ranges[i];
+        }
+    }
+
+    ranges.resize(numMerged);
+}
+
+static bool IsDispatchOrdinalSelected(const KernelFilter& filter, const uint64_t ordinal)
+{
+    if (filter.m_dispatchRanges.empty())
+    {
+        return true;
+    }
+
+    // The last range that starts at or before the ordinal
+    std::vector<std::pair<uint64_t, uint64_t> >::const_iterator rangeIt =
+        std::upper_bound(filter.m_dispatchRanges.begin(),
+                         filter.m_dispatchRanges.end(),
+                         std::make_pair(ordinal, UINT64_MAX));
+
+    if (rangeIt == filter.m_dispatchRanges.begin())
+    {
+        return false;
+    }
+
+    --rangeIt;
+    return (ordinal <= rangeIt->second);
+}
+
+static bool IsKernelNameSelected(const KernelFilter& filter, const std::vector<std::string>& kernelNames)
+{
+    for (size_t i = 0; i < kernelNames.size(); i++)
+    {
+        for (size_t j = 0; j < filter.m_nameGlobs.size(); j++)
+        {
+            if (fnmatch(filter.m_nameGlobs[j].c_str(), kernelNames[i].c_str(), 0) == 0)
+            {
+                return true;
+            }
+        }
+
+        for (size_t j = 0; j < filter.m_nameRegexes.size(); j++)
+        {
+            if (regexec(&filter.m_nameRegexes[j], kernelNames[i].c_str(), 0, nullptr, 0) == 0)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+static void SetKernelFilterFromEnv()
+{
+    const char* pFilterEnvVar = std::getenv("ROCM_GDB_KERNEL_FILTER");
+
+    if (pFilterEnvVar != nullptr &&
+        AgentSetKernelFilter(pFilterEnvVar) != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_WARNING("Invalid ROCM_GDB_KERNEL_FILTER = " << pFilterEnvVar << ", all the dispatches are debugged");
+    }
+}
+
+HsailAgentStatus AgentSetKernelFilter(const std::string& filterText)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    KernelFilter* pFilter = new(std::nothrow) KernelFilter;
+
+    if (pFilter == nullptr)
+    {
+        AGENT_ERROR("AgentSetKernelFilter: Could not allocate the filter");
+        return status;
+    }
+
+    size_t clauseStart = 0;
+
+    while (clauseStart <= filterText.size())
+    {
+        size_t clauseEnd = filterText.find(';', clauseStart);
+
+        if (clauseEnd == std::string::npos)
+        {
+            clauseEnd = filterText.size();
+        }
+
+        std::string clause = TrimClause(filterText.substr(clauseStart, clauseEnd - clauseStart));
+
+        if (!clause.empty() && !ParseClause(clause, *pFilter))
+        {
+            delete pFilter;
+            return status;
+        }
+
+        clauseStart = clauseEnd + 1;
+    }
+
+    MergeDispatchRanges(pFilter->m_dispatchRanges);
+
+    std::sort(pFilter->m_queueIds.begin(), pFilter->m_queueIds.end());
+
+    bool isFilterSet = (pFilter->HasNameClauses() ||
+                        !pFilter->m_dispatchRanges.empty() ||
+                        !pFilter->m_queueIds.empty());
+
+    if (!isFilterSet)
+    {
+        delete pFilter;
+        pFilter = nullptr;
+    }
+
+    pthread_mutex_lock(&gs_KernelFilterMutex);
+
+    delete gs_pKernelFilter;
+    gs_pKernelFilter = pFilter;
+    gs_KernelNameVerdicts.clear();
+    __atomic_store_n(&gs_IsKernelFilterSet, isFilterSet, __ATOMIC_RELEASE);
+
+    pthread_mutex_unlock(&gs_KernelFilterMutex);
+
+    AGENT_LOG("AgentSetKernelFilter: \"" << filterText << "\"" << (isFilterSet ? "" : ", all the dispatches are debugged"));
+
+    status = HSAIL_AGENT_STATUS_SUCCESS;
+    return status;
+}
+
+bool AgentIsDispatchSelected(const uint64_t kernelObject, const uint64_t queueId)
+{
+    pthread_once(&gs_KernelFilterEnvOnce, SetKernelFilterFromEnv);
+
+    uint64_t ordinal = __atomic_add_fetch(&gs_NumDispatchesSeen, 1, __ATOMIC_RELAXED);
+
+    if (!__atomic_load_n(&gs_IsKernelFilterSet, __ATOMIC_ACQUIRE))
+    {
+        __atomic_add_fetch(&gs_NumDispatchesSelected, 1, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    pthread_mutex_lock(&gs_KernelFilterMutex);
+
+    bool isSelected = true;
+    const KernelFilter* pFilter = gs_pKernelFilter;
+
+    if (pFilter != nullptr)
+    {
+        isSelected = (pFilter->m_queueIds.empty() ||
+                      std::binary_search(pFilter->m_queueIds.begin(), pFilter->m_queueIds.end(), queueId)) &&
+                     IsDispatchOrdinalSelected(*pFilter, ordinal);
+
+        if (isSelected && pFilter->HasNameClauses())
+        {
+            std::unordered_map<uint64_t, bool>::const_iterator verdictIt = gs_KernelNameVerdicts.find(kernelObject);
+
+            if (verdictIt != gs_KernelNameVerdicts.end())
+            {
+                isSelected = verdictIt->second;
+                gs_NumNameVerdictsReused++;
+            }
+            else
+            {
+                std::unordered_map<uint64_t, std::vector<std::string> >::const_iterator namesIt =
+                    gs_KernelNames.find(kernelObject);
+
+                // Without a name the kernel is debugged, its name is recorded by the predispatch
+                if (namesIt != gs_KernelNames.end())
+                {
+                    isSelected = IsKernelNameSelected(*pFilter, namesIt->second);
+                    gs_KernelNameVerdicts[kernelObject] = isSelected;
+                    gs_NumNameMatches++;
+                }
+            }
+        }
+    }
+
+    if (isSelected)
+    {
+        __atomic_add_fetch(&gs_NumDispatchesSelected, 1, __ATOMIC_RELAXED);
+    }
+
+    pthread_mutex_unlock(&gs_KernelFilterMutex);
+
+    return isSelected;
+}
+
+bool AgentIsKernelNameKnown(const uint64_t kernelObject)
+{
+    pthread_mutex_lock(&gs_KernelFilterMutex);
+    bool isKnown = (gs_KernelNames.find(kernelObject) != gs_KernelNames.end());
+    pthread_mutex_unlock(&gs_KernelFilterMutex);
+
+    return isKnown;
+}
+
+void AgentRecordKernelName(const uint64_t kernelObject, const std::string& kernelName)
+{
+    if (kernelName.empty())
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&gs_KernelFilterMutex);
+
+    std::vector<std::string>& kernelNames = gs_KernelNames[kernelObject];
+
+    if (std::find(kernelNames.begin(), kernelNames.end(), kernelName) == kernelNames.end())
+    {
+        kernelNames.push_back(kernelName);
+
+        // Match the names again at the next dispatch
+        gs_KernelNameVerdicts.erase(kernelObject);
+    }
+
+    pthread_mutex_unlock(&gs_KernelFilterMutex);
+}
+
+void AgentForgetKernelNames()
+{
+    pthread_mutex_lock(&gs_KernelFilterMutex);
+    gs_KernelNames.clear();
+    gs_KernelNameVerdicts.clear();
+    pthread_mutex_unlock(&gs_KernelFilterMutex);
+}
+
+void AgentLogKernelFilterStatistics()
+{
+    pthread_mutex_lock(&gs_KernelFilterMutex);
+
+    AGENT_LOG("Kernel filter statistics: " <<
+              "Dispatches: " << gs_NumDispatchesSeen << "\t" <<
+              "Selected: " << gs_NumDispatchesSelected << "\t" <<
+              "Name matches: " << gs_NumNameMatches << "\t" <<
+              "Reused: " << gs_NumNameVerdictsReused);
+
+    pthread_mutex_unlock(&gs_KernelFilterMutex);
+}
+
+} // End Namespace HwDbgAgent
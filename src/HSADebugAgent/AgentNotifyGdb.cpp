@@ -17,8 +17,11 @@
 #include <syscall.h>
 #include <unistd.h>
 
+#include <vector>
+
 #include <hsa.h>
 
+#include "AgentFramedProtocol.h"
 #include "AgentLogging.h"
 #include "AgentNotifyGdb.h"
 #include "AgentUtils.h"
@@ -67,38 +70,224 @@ static const std::string AgentGetGDBNotificationString(const HsailNotification n
         case HSAIL_NOTIFY_DEVICES:
             return "HSAIL_NOTIFY_DEVICES";
 
+        case HSAIL_NOTIFY_SYNC_REQUEST:
+            return "HSAIL_NOTIFY_SYNC_REQUEST";
+
+        case HSAIL_NOTIFY_REUSE_BINARY:
+            return "HSAIL_NOTIFY_REUSE_BINARY";
+
+        case HSAIL_NOTIFY_ISA_READY:
+            return "HSAIL_NOTIFY_ISA_READY";
+
+        case HSAIL_NOTIFY_COMMAND_RING:
+            return "HSAIL_NOTIFY_COMMAND_RING";
+
         // Should never happen
         default:
             return "[UNKNOWN_NOTIFICATION_TYPE]";
     }
 }
 
-/// Push the notification on the FIFO
-static HsailAgentStatus PushGDBNotification(const HsailNotificationPayload& payload)
+/// Serializes the writes to the FIFO and protects the notification batch
+static pthread_mutex_t gs_NotificationMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/// Bytes of the notifications queued while a batch is open, flushed by AgentEndNotificationBatch
+static std::vector<char> gs_NotificationBatch;
+
+/// Number of notifications in gs_NotificationBatch
+static size_t gs_NumBatchedNotifications = 0;
+
+/// Nesting depth of the open batch, 0 if no batch is open
+static int gs_NotificationBatchDepth = 0;
+
+/// The thread that opened the batch, other threads write their notifications directly
+static pthread_t gs_NotificationBatchOwner;
+
+/// Statistics, logged by AgentLogNotificationStatistics
+static uint64_t gs_NumNotificationsPushed = 0;
+static uint64_t gs_NumSignalsRaised = 0;
+static uint64_t gs_NumBatchesFlushed = 0;
+static uint64_t gs_MaxNotificationsPerBatch = 0;
+static uint64_t gs_NumBytesWritten = 0;
+static uint64_t gs_NumWriteCalls = 0;
+static uint64_t gs_NumBinariesSent = 0;
+static uint64_t gs_NumBinariesReused = 0;
+static uint64_t gs_NumBinaryBytesSkipped = 0;
+
+/// Write whole notifications to the FIFO, the caller holds gs_NotificationMutex
+static HsailAgentStatus WriteGDBNotifications(const char* pBytes, const size_t numBytes)
+{
+    int fd = GetFifoWriteEnd();
+
+    size_t bytesLeft = numBytes;
+
+    while (bytesLeft > 0)
+    {
+        ssize_t bytesWritten = write(fd, pBytes, bytesLeft);
+        gs_NumWriteCalls++;
+
+        if (bytesWritten < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (bytesWritten <= 0)
+        {
+            int err_no = errno;
+            AGENT_ERROR ("Error in writing to FIFO: Errno = " << err_no << ", "<<strerror(err_no));
+
+            return HSAIL_AGENT_STATUS_FAILURE;
+        }
+
+        pBytes += bytesWritten;
+        bytesLeft -= bytesWritten;
+        gs_NumBytesWritten += bytesWritten;
+    }
+
+    return HSAIL_AGENT_STATUS_SUCCESS;
+}
+
+/// Push an encoded notification on the FIFO, or queue it if this thread has a batch open
+static HsailAgentStatus PushGDBNotificationBytes(const HsailNotification notification,
+                                                 const char*             pBytes,
+                                                 const size_t            numBytes)
 {
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    pthread_mutex_lock(&gs_NotificationMutex);
+
+    gs_NumNotificationsPushed++;
+
+    if (gs_NotificationBatchDepth > 0 && pthread_equal(gs_NotificationBatchOwner, pthread_self()))
+    {
+        gs_NotificationBatch.insert(gs_NotificationBatch.end(), pBytes, pBytes + numBytes);
+        gs_NumBatchedNotifications++;
+        pthread_mutex_unlock(&gs_NotificationMutex);
+
+        AGENT_LOG("Queued Notification of Type: " <<
+                  AgentGetGDBNotificationString(notification));
+
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+        return status;
+    }
+
     // An extra trigger to gdb so it gets out of whatever it is waiting on
     // and processes the HSAIL notification.
     AgentTriggerGDBEventLoop();
 
-    int fd = GetFifoWriteEnd();
+    status = WriteGDBNotifications(pBytes, numBytes);
+
+    pthread_mutex_unlock(&gs_NotificationMutex);
+
+    if (status == HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_LOG("Pushed Notification of Type: " <<
+                  AgentGetGDBNotificationString(notification) << ", " << numBytes << " bytes");
+    }
+
+    return status;
+}
+
+/// Push the notification, as a frame if gdb asked for framed messages
+static HsailAgentStatus PushGDBNotification(const HsailNotificationPayload& payload)
+{
+    if (HwDbgAgent::AgentGetGdbProtocolVersion() == 0)
+    {
+        return PushGDBNotificationBytes(payload.m_Notification,
+                                        reinterpret_cast<const char*>(&payload),
+                                        sizeof(HsailNotificationPayload));
+    }
+
+    std::vector<char> frame;
+    HwDbgAgent::AgentEncodeNotificationFrame(payload, frame);
+
+    return PushGDBNotificationBytes(payload.m_Notification, frame.data(), frame.size());
+}
+
+void AgentBeginNotificationBatch()
+{
+    pthread_mutex_lock(&gs_NotificationMutex);
+
+    if (gs_NotificationBatchDepth > 0 && !pthread_equal(gs_NotificationBatchOwner, pthread_self()))
+    {
+        // Another thread owns the batch, this thread keeps writing directly
+        pthread_mutex_unlock(&gs_NotificationMutex);
+        AGENT_LOG("AgentBeginNotificationBatch: A batch is already open in another thread");
+        return;
+    }
+
+    gs_NotificationBatchOwner = pthread_self();
+    gs_NotificationBatchDepth++;
 
-    int bytesWritten = 0;
+    pthread_mutex_unlock(&gs_NotificationMutex);
+}
+
+HsailAgentStatus AgentEndNotificationBatch(const bool triggerGdb)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_SUCCESS;
 
-    bytesWritten = write(fd, &payload, sizeof(HsailNotificationPayload));
+    pthread_mutex_lock(&gs_NotificationMutex);
 
-    if (bytesWritten != sizeof(HsailNotificationPayload))
+    if (gs_NotificationBatchDepth == 0 || !pthread_equal(gs_NotificationBatchOwner, pthread_self()))
     {
-        int err_no = errno;
-        AGENT_ERROR ("Error in writing to FIFO: Errno = " << err_no << ", "<<strerror(err_no));
+        pthread_mutex_unlock(&gs_NotificationMutex);
+        return status;
+    }
+
+    gs_NotificationBatchDepth--;
 
-        return HSAIL_AGENT_STATUS_FAILURE;
+    // Only the outermost batch writes to the FIFO
+    if (gs_NotificationBatchDepth > 0 || gs_NotificationBatch.empty())
+    {
+        pthread_mutex_unlock(&gs_NotificationMutex);
+        return status;
     }
-    else
+
+    size_t numPayloads = gs_NumBatchedNotifications;
+
+    // The notifications are contiguous in the vector, so they all go out in one write
+    status = WriteGDBNotifications(gs_NotificationBatch.data(), gs_NotificationBatch.size());
+    gs_NotificationBatch.clear();
+    gs_NumBatchedNotifications = 0;
+
+    gs_NumBatchesFlushed++;
+
+    if (numPayloads > gs_MaxNotificationsPerBatch)
     {
-        AGENT_LOG("Pushed Notification of Type: " <<
-                  AgentGetGDBNotificationString(payload.m_Notification));
-        return HSAIL_AGENT_STATUS_SUCCESS;
+        gs_MaxNotificationsPerBatch = numPayloads;
+    }
+
+    // Raise the signal after the write so gdb finds all the notifications in the FIFO
+    if (triggerGdb)
+    {
+        AgentTriggerGDBEventLoop();
     }
+
+    pthread_mutex_unlock(&gs_NotificationMutex);
+
+    AGENT_LOG("AgentEndNotificationBatch: Flushed " << numPayloads << " notifications");
+
+    return status;
+}
+
+void AgentLogNotificationStatistics()
+{
+    pthread_mutex_lock(&gs_NotificationMutex);
+
+    AGENT_LOG("Notification statistics: " <<
+              "Notifications pushed: " << gs_NumNotificationsPushed << "\t" <<
+              "Batches flushed: " << gs_NumBatchesFlushed << "\t" <<
+              "Max notifications per batch: " << gs_MaxNotificationsPerBatch << "\t" <<
+              "Bytes written: " << gs_NumBytesWritten << "\t" <<
+              "Write calls: " << gs_NumWriteCalls << "\t" <<
+              "Signals raised: " << __atomic_load_n(&gs_NumSignalsRaised, __ATOMIC_RELAXED));
+
+    AGENT_LOG("Binary statistics: " <<
+              "Binaries sent: " << __atomic_load_n(&gs_NumBinariesSent, __ATOMIC_RELAXED) << "\t" <<
+              "Binaries reused: " << __atomic_load_n(&gs_NumBinariesReused, __ATOMIC_RELAXED) << "\t" <<
+              "Binary bytes not sent: " << __atomic_load_n(&gs_NumBinaryBytesSkipped, __ATOMIC_RELAXED));
+
+    pthread_mutex_unlock(&gs_NotificationMutex);
 }
 
 // This is needed to push the event loop along in gdb so we move out of linux_nat_wait
@@ -116,6 +305,8 @@ void AgentTriggerGDBEventLoop()
 
     AGENT_LOG("AgentTriggerGDBEventLoop: Enter: Push the GDB Linux event loop");
 
+    __atomic_add_fetch(&gs_NumSignalsRaised, 1, __ATOMIC_RELAXED);
+
     if (kill(getpid(), SIGUSR1) == -1)
     {
         AGENT_ERROR("Could not raise the SIGUSR");
@@ -172,10 +363,27 @@ void AgentNotifyGDB()
 
 
 
+// Copy a kernel name into a notification, a name longer than the field is truncated.
+// The payload is zeroed before, so the terminating NUL is already in place
+static void CopyKernelName(char (&kernelNameOut)[AGENT_MAX_FUNC_NAME_LEN], const std::string& kernelName)
+{
+    size_t copySize = kernelName.size();
+
+    if (copySize > AGENT_MAX_FUNC_NAME_LEN - 1)
+    {
+        AGENT_LOG("CopyKernelName: Truncating the kernel name " << kernelName);
+        copySize = AGENT_MAX_FUNC_NAME_LEN - 1;
+    }
+
+    memcpy(kernelNameOut, kernelName.c_str(), copySize);
+    kernelNameOut[copySize] = '\0';
+}
+
 // Notify the parent that a new binary has been added
 // GDB will use the binary to set up debug facilities
 // \todo Add the hl symbol and the ll symbol
 HsailAgentStatus AgentNotifyNewBinary(const size_t                        binarySize,
+                                      const uint64_t                      binaryHash,
                                       const std::string&                  kernelName,
                                       const hsa_kernel_dispatch_packet_t* pAqlPacket,
                                       const uint64_t                      queueID,
@@ -188,10 +396,9 @@ HsailAgentStatus AgentNotifyNewBinary(const size_t                        binary
 
     newBinaryPayload.m_Notification = HSAIL_NOTIFY_NEW_BINARY;
     newBinaryPayload.payload.BinaryNotification.m_binarySize = reinterpret_cast<uint64_t>(binarySize);
+    newBinaryPayload.payload.BinaryNotification.m_binaryHash = binaryHash;
 
-    memcpy(newBinaryPayload.payload.BinaryNotification.m_KernelName,
-           kernelName.c_str(),
-           kernelName.size() + 1);
+    CopyKernelName(newBinaryPayload.payload.BinaryNotification.m_KernelName, kernelName);
 
     // Copy from the AQL packet to the HSAIL-GDB version (HsailDispatchPacket)
     CopyAQLToHsailDispatch(&newBinaryPayload.payload.BinaryNotification.m_packet, pAqlPacket);
@@ -207,6 +414,45 @@ HsailAgentStatus AgentNotifyNewBinary(const size_t                        binary
         return status;
     }
 
+    __atomic_add_fetch(&gs_NumBinariesSent, 1, __ATOMIC_RELAXED);
+
+    return status;
+}
+
+// Notify the parent that the dispatch uses a binary it already has
+HsailAgentStatus AgentNotifyReuseBinary(const size_t                        binarySize,
+                                        const uint64_t                      binaryHash,
+                                        const std::string&                  kernelName,
+                                        const hsa_kernel_dispatch_packet_t* pAqlPacket,
+                                        const uint64_t                      queueID,
+                                        const uint64_t                      packetID)
+{
+    HsailNotificationPayload reuseBinaryPayload;
+    memset(&reuseBinaryPayload, 0, sizeof(HsailNotificationPayload));
+
+    reuseBinaryPayload.m_Notification = HSAIL_NOTIFY_REUSE_BINARY;
+    reuseBinaryPayload.payload.ReuseBinaryNotification.m_binaryHash = binaryHash;
+
+    CopyKernelName(reuseBinaryPayload.payload.ReuseBinaryNotification.m_KernelName, kernelName);
+
+    CopyAQLToHsailDispatch(&reuseBinaryPayload.payload.ReuseBinaryNotification.m_packet, pAqlPacket);
+    reuseBinaryPayload.payload.ReuseBinaryNotification.m_packet.queue_id  = queueID;
+    reuseBinaryPayload.payload.ReuseBinaryNotification.m_packet.packet_id  = packetID;
+
+    HsailAgentStatus status =  PushGDBNotification(reuseBinaryPayload);
+
+    if (HSAIL_AGENT_STATUS_SUCCESS != status)
+    {
+        AgentErrorLog("Error in Pushing a reuse binary notification to GDB\n");
+        return status;
+    }
+
+    __atomic_add_fetch(&gs_NumBinariesReused, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&gs_NumBinaryBytesSkipped, static_cast<uint64_t>(binarySize), __ATOMIC_RELAXED);
+
+    AGENT_LOG("AgentNotifyReuseBinary: gdb already has the binary with hash " <<
+              std::hex << binaryHash << std::dec << ", " << binarySize << " bytes not sent");
+
     return status;
 }
 
@@ -227,19 +473,53 @@ HsailAgentStatus AgentNotfiyNewActiveWaves(const int numActiveWaves)
 }
 
 // Send the notification packet that we have hit a breakpoint, includes information about
-// the size of the wave info buffer
-HsailAgentStatus AgentNotifyBreakpointHit(const HsailNotificationPayload numWavesPayload)
+// the size of the wave info buffer and the hit count of every breakpoint that was hit
+HsailAgentStatus AgentNotifyBreakpointHit(const int                                    numActiveWaves,
+                                          const std::vector<HsailBreakpointHitRecord>& hits)
 {
-    // Just check the payload type and send it off
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
 
-    if (numWavesPayload.m_Notification != HSAIL_NOTIFY_BREAKPOINT_HIT)
+    if (HwDbgAgent::AgentGetGdbProtocolVersion() > 0)
     {
-        AgentErrorLog("Error in Pushing a breakpoint hit notification to GDB\n");
-        return status;
-    }
+        // The frame has room for any number of breakpoints
+        HwDbgAgent::AgentFrameWriter frame(HSAIL_NOTIFY_BREAKPOINT_HIT);
+        frame.AddInt32(HSAIL_FRAME_TAG_NUM_ACTIVE_WAVES, numActiveWaves);
 
-    status =  PushGDBNotification(numWavesPayload);
+        for (const HsailBreakpointHitRecord& hit : hits)
+        {
+            frame.AddBytes(HSAIL_FRAME_TAG_BREAKPOINT_HIT, &hit, sizeof(HsailBreakpointHitRecord));
+        }
+
+        status = PushGDBNotificationBytes(HSAIL_NOTIFY_BREAKPOINT_HIT, frame.GetFrame(), frame.GetFrameSize());
+    }
+    else
+    {
+        HsailNotificationPayload payload;
+        memset(&payload, 0, sizeof(HsailNotificationPayload));
+
+        payload.m_Notification = HSAIL_NOTIFY_BREAKPOINT_HIT;
+        payload.payload.BreakpointHit.m_numActiveWaves = numActiveWaves;
+
+        for (int i = 0; i < HSAIL_MAX_REPORTABLE_BREAKPOINTS; i++)
+        {
+            payload.payload.BreakpointHit.m_breakpointId[i] = -1;
+            payload.payload.BreakpointHit.m_hitCount[i] = -1;
+        }
+
+        if (hits.size() > static_cast<size_t>(HSAIL_MAX_REPORTABLE_BREAKPOINTS))
+        {
+            AGENT_WARNING("AgentNotifyBreakpointHit: Only " << HSAIL_MAX_REPORTABLE_BREAKPOINTS <<
+                          " of " << hits.size() << " breakpoints can be reported to this gdb");
+        }
+
+        for (size_t i = 0; i < hits.size() && i < static_cast<size_t>(HSAIL_MAX_REPORTABLE_BREAKPOINTS); i++)
+        {
+            payload.payload.BreakpointHit.m_breakpointId[i] = hits[i].m_breakpointId;
+            payload.payload.BreakpointHit.m_hitCount[i] = hits[i].m_hitCount;
+        }
+
+        status = PushGDBNotification(payload);
+    }
 
     if (HSAIL_AGENT_STATUS_SUCCESS != status)
     {
@@ -315,6 +595,66 @@ HsailAgentStatus AgentNotifyPredispatchState(const HsailPredispatchState ipState
     return status;
 }
 
+// Ask gdb to send a HSAIL_COMMAND_SYNC_MARKER once it has sent all its pending commands
+HsailAgentStatus AgentNotifySyncRequest(const uint64_t syncId)
+{
+    HsailNotificationPayload syncPayload;
+    memset(&syncPayload, 0, sizeof(HsailNotificationPayload));
+
+    syncPayload.m_Notification = HSAIL_NOTIFY_SYNC_REQUEST;
+    syncPayload.payload.SyncRequestNotification.m_syncId = syncId;
+    HsailAgentStatus status =  PushGDBNotification(syncPayload);
+
+    if (HSAIL_AGENT_STATUS_SUCCESS != status)
+    {
+        AGENT_ERROR("Error in Pushing a sync request notification to GDB\n");
+        return status;
+    }
+
+    return status;
+}
+
+// Reply to HSAIL_COMMAND_GET_ISA once the ISA buffer shared mem is written
+HsailAgentStatus AgentNotifyISAReady(const uint64_t binaryHash, const size_t isaSize)
+{
+    HsailNotificationPayload isaReadyPayload;
+    memset(&isaReadyPayload, 0, sizeof(HsailNotificationPayload));
+
+    isaReadyPayload.m_Notification = HSAIL_NOTIFY_ISA_READY;
+    isaReadyPayload.payload.IsaReadyNotification.m_binaryHash = binaryHash;
+    isaReadyPayload.payload.IsaReadyNotification.m_isaSize = static_cast<uint64_t>(isaSize);
+
+    HsailAgentStatus status =  PushGDBNotification(isaReadyPayload);
+
+    if (HSAIL_AGENT_STATUS_SUCCESS != status)
+    {
+        AGENT_ERROR("Error in Pushing an ISA ready notification to GDB\n");
+        return status;
+    }
+
+    return status;
+}
+
+// Reply to HSAIL_COMMAND_SET_PROTOCOL with the key the command ring was created with
+HsailAgentStatus AgentNotifyCommandRing(const key_t shmKey)
+{
+    HsailNotificationPayload commandRingPayload;
+    memset(&commandRingPayload, 0, sizeof(HsailNotificationPayload));
+
+    commandRingPayload.m_Notification = HSAIL_NOTIFY_COMMAND_RING;
+    commandRingPayload.payload.CommandRingNotification.m_shmKey = static_cast<int32_t>(shmKey);
+
+    HsailAgentStatus status =  PushGDBNotification(commandRingPayload);
+
+    if (HSAIL_AGENT_STATUS_SUCCESS != status)
+    {
+        AGENT_ERROR("Error in Pushing a command ring notification to GDB\n");
+        return status;
+    }
+
+    return status;
+}
+
 // Tell gdb that the dispatch is completed and to end debugging
 // This will restore how gdb prints exceptions and signal information back to the original style
 HsailAgentStatus AgentNotifyBeginDebugging(const bool setDeviceFocus)
@@ -18,8 +18,16 @@
 #include "AgentBreakpointManager.h"
 #include "AgentContext.h"
 #include "AgentFocusWaveControl.h"
+#include "AgentFramedProtocol.h"
+#include "AgentISABuffer.h"
+#include "AgentISAWorker.h"
+#include "AgentKernelFilter.h"
 #include "AgentLogging.h"
+#include "AgentNotifyGdb.h"
 #include "AgentProcessPacket.h"
+#include "AgentQueueContext.h"
+#include "AgentSegmentLoader.h"
+#include "AgentTiming.h"
 #include "CommunicationControl.h"
 
 // Add DBE (Version decided by Makefile)
@@ -144,6 +152,81 @@ static void DBEMomentaryBreakpoint(HwDbgAgent::AgentContext* pActiveContext,
     }
 }
 
+// Disassemble the binary gdb asks for and write its ISA to the ISA buffer shared mem.
+// Binaries are not disassembled at dispatch time for a gdb that sends this command
+static void PublishRequestedISA(HwDbgAgent::AgentContext*      pActiveContext,
+                                const HsailCommandPacket&      packet,
+                                const HsailCommandFrameFields& frameFields)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    size_t isaSize = 0;
+    std::string isaText;
+
+    // The copy of a deferred code object dropped under the memory limit is taken again
+    // from the load map, the code object is still loaded if gdb asks for its ISA
+    size_t evictedSize = 0;
+
+    if (HwDbgAgent::AgentIsDeferredISAEvicted(frameFields.m_binaryHash, evictedSize))
+    {
+        const void* pCodeObj = nullptr;
+        HwDbgAgent::AgentSegmentLoader* pSegmentLoader = pActiveContext->GetSegmentLoader();
+
+        if (pSegmentLoader != nullptr &&
+            pSegmentLoader->FindLoadedCodeObject(frameFields.m_binaryHash, evictedSize, pCodeObj))
+        {
+            HwDbgAgent::AgentDeferISADisassembly(frameFields.m_binaryHash, pCodeObj, evictedSize);
+        }
+        else
+        {
+            AGENT_WARNING("PublishRequestedISA: The dropped code object " << std::hex << frameFields.m_binaryHash <<
+                          std::dec << " is not in the load map");
+        }
+    }
+
+    // Only the instructions gdb shows are rendered if it sends a PC range,
+    // the whole binary is disassembled if the range can not be decoded
+    bool isISAReady = false;
+
+    if (frameFields.m_pcEnd > packet.m_pc)
+    {
+        isISAReady = HwDbgAgent::AgentGetISARange(frameFields.m_binaryHash, packet.m_pc, frameFields.m_pcEnd, isaText);
+    }
+
+    if (!isISAReady)
+    {
+        isISAReady = HwDbgAgent::AgentGetDisassembledISA(frameFields.m_binaryHash, isaText);
+    }
+
+    if (isISAReady)
+    {
+        HwDbgAgent::AgentISABuffer isaBuffer;
+        status = isaBuffer.PopulateISAFromText(isaText);
+
+        if (status == HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            status = isaBuffer.WriteToSharedMem(pActiveContext->GetSharedMemRegistry());
+        }
+
+        if (status == HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            isaSize = isaText.size();
+        }
+    }
+    else
+    {
+        AGENT_ERROR("PublishRequestedISA: No ISA for the binary " << std::hex << frameFields.m_binaryHash << std::dec);
+    }
+
+    // gdb waits for the reply, it is sent even if there is no ISA
+    status = AgentNotifyISAReady(frameFields.m_binaryHash, isaSize);
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("PublishRequestedISA: Could not notify gdb");
+    }
+}
+
 // Global pointer to active context used for the expression evaluator
 // Can be fixed soon by checking a static variable in the function
 HwDbgAgent::AgentContext* g_ActiveContext = nullptr;
@@ -485,8 +568,9 @@ void* GetVarValue(unsigned int reg_type, size_t var_size, unsigned int reg_num,
     return (void*)(*(size_t*)variableValues);
 }
 
-void AgentProcessPacket(HwDbgAgent::AgentContext* pActiveContext,
-                        const HsailCommandPacket& packet)
+void AgentProcessPacket(HwDbgAgent::AgentContext*      pActiveContext,
+                        const HsailCommandPacket&      packet,
+                        const HsailCommandFrameFields& frameFields)
 {
     switch (packet.m_command)
     {
@@ -526,6 +610,44 @@ void AgentProcessPacket(HwDbgAgent::AgentContext* pActiveContext,
             AgentLogSetFromConsole(packet.m_loggingInfo);
             break;
 
+        case HSAIL_COMMAND_SYNC_MARKER:
+            // Only a frame carries the sync id, a fixed size marker can not answer a request
+            if (frameFields.m_syncId != 0)
+            {
+                pActiveContext->m_LastSyncMarkerId = frameFields.m_syncId;
+            }
+
+            break;
+
+        case HSAIL_COMMAND_SET_PROTOCOL:
+            // The decoder has already switched the notifications to frames
+            AGENT_LOG("gdb framing version: " << HwDbgAgent::AgentGetGdbProtocolVersion());
+
+            // The command ring may not be at the key gdb derives from the session ID
+            if (HwDbgAgent::AgentGetGdbProtocolVersion() >= HSAIL_FRAME_PROTOCOL_VERSION_COMMAND_RING_KEY &&
+                AgentNotifyCommandRing(GetCommandRingShmKey()) != HSAIL_AGENT_STATUS_SUCCESS)
+            {
+                AGENT_ERROR("Could not send the key of the command ring to gdb");
+            }
+
+            break;
+
+        case HSAIL_COMMAND_GET_ISA:
+            PublishRequestedISA(pActiveContext, packet, frameFields);
+            break;
+
+        case HSAIL_COMMAND_SET_KERNEL_FILTER:
+            if (HwDbgAgent::AgentSetKernelFilter(frameFields.m_kernelFilter) != HSAIL_AGENT_STATUS_SUCCESS)
+            {
+                AGENT_ERROR("The kernel filter from gdb is not valid, the previous filter is kept");
+            }
+
+            break;
+
+        case HSAIL_COMMAND_LOG_TIMING:
+            HwDbgAgent::AgentLogTimingStatistics();
+            break;
+
         case HSAIL_COMMAND_UNKNOWN:
             pActiveContext->PrintDBEVersion();
             AgentErrorLog("Incomplete command packet error");
@@ -536,4 +658,7 @@ void AgentProcessPacket(HwDbgAgent::AgentContext* pActiveContext,
             AgentErrorLog("Incomplete command packet error");
             break;
     }
+
+    // Dispatches of other queues wait for the debug engine while a breakpoint can stop them
+    HwDbgAgent::AgentSetActiveBreakpoints(*pActiveContext->GetBpManager());
 }
@@ -0,0 +1,325 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Per-queue state of the dispatch callbacks and the debug engine they share
+//==============================================================================
+#include <algorithm>
+#include <cstdlib>
+#include <pthread.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AgentBreakpointManager.h"
+#include "AgentLogging.h"
+#include "AgentQueueContext.h"
+
+namespace HwDbgAgent
+{
+
+/// Protects the debug engine state, the prepared kernels and the queue contexts
+static pthread_mutex_t gs_DebugEngineMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/// Signaled when the last hold on the debug engine is dropped
+static pthread_cond_t gs_DebugEngineFreeCond = PTHREAD_COND_INITIALIZER;
+
+/// Holds on the debug engine: the predispatch callback and the debug thread of its dispatch
+static unsigned int gs_NumDebugEngineHolds = 0;
+
+/// The queue and the kernel object of the dispatch that holds the debug engine
+static uint64_t gs_DebugEngineQueueId = 0;
+static uint64_t gs_DebugEngineKernelObject = 0;
+
+/// A kernel object gdb has the binary of
+typedef struct
+{
+    bool     m_hasFunctionBreakpoint;   // True if the kernel name matched a function breakpoint
+    uint64_t m_codeStart;               // The PCs of the segment of the kernel
+    uint64_t m_codeEnd;
+} PreparedKernel;
+
+/// The kernel objects gdb has the binary of
+static std::unordered_map<uint64_t, PreparedKernel> gs_PreparedKernels;
+
+/// True while the engine is held for a DBE query outside of the dispatches, every dispatch waits for it
+static bool gs_IsDebugEngineQueried = false;
+
+/// The PCs of the enabled and pending breakpoints, sorted
+static std::vector<HwDbgCodeAddress> gs_ActiveBreakpointPCs;
+
+/// The names of the enabled and pending kernel name breakpoints, sorted.
+/// The function breakpoint verdicts of gs_PreparedKernels were taken with these names
+static std::vector<std::string> gs_ActiveKernelNameBreakpoints;
+
+static std::vector<AgentQueueContext*> gs_QueueContexts;
+
+/// Dispatches of other queues always wait while a dispatch is debugged if ROCM_GDB_DISABLE_QUEUE_OVERLAP is set
+static bool IsQueueOverlapEnabled()
+{
+    static const bool s_isEnabled = (std::getenv("ROCM_GDB_DISABLE_QUEUE_OVERLAP") == nullptr);
+    return s_isEnabled;
+}
+
+/// Check if an active breakpoint is at a PC of a code range
+static bool IsBreakpointInRange(const uint64_t codeStart, const uint64_t codeEnd)
+{
+    std::vector<HwDbgCodeAddress>::const_iterator pcIt =
+        std::lower_bound(gs_ActiveBreakpointPCs.begin(), gs_ActiveBreakpointPCs.end(), codeStart);
+
+    return (pcIt != gs_ActiveBreakpointPCs.end() && *pcIt < codeEnd);
+}
+
+AgentQueueContext::AgentQueueContext(AgentContext* pAgentContext, const hsa_queue_t* pQueue):
+    m_pAgentContext(pAgentContext),
+    m_queueId(pQueue->id),
+    m_numDispatches(0),
+    m_numDebugEngineWaits(0),
+    m_numDispatchesNotDebugged(0)
+{
+}
+
+bool AgentQueueContext::IsDebugEngineNeeded(const uint64_t kernelObject) const
+{
+    // The DBE is not called by two threads at the same time
+    if (gs_IsDebugEngineQueried)
+    {
+        return true;
+    }
+
+    // Dispatches of a queue are debugged in order
+    if (!IsQueueOverlapEnabled() || gs_DebugEngineQueueId == m_queueId)
+    {
+        return true;
+    }
+
+    // Another instance of the kernel being debugged can hit the same breakpoints
+    if (kernelObject == gs_DebugEngineKernelObject)
+    {
+        return true;
+    }
+
+    // gdb has to see the binary of a new kernel, a pending breakpoint may resolve in it
+    std::unordered_map<uint64_t, PreparedKernel>::const_iterator kernelIter = gs_PreparedKernels.find(kernelObject);
+
+    if (kernelIter == gs_PreparedKernels.end())
+    {
+        return true;
+    }
+
+    const PreparedKernel& preparedKernel = kernelIter->second;
+
+    if (preparedKernel.m_hasFunctionBreakpoint)
+    {
+        return true;
+    }
+
+    // The dispatch can only stop at a breakpoint in the segment of its code object
+    return IsBreakpointInRange(preparedKernel.m_codeStart, preparedKernel.m_codeEnd);
+}
+
+bool AgentQueueContext::AcquireDebugEngine(const uint64_t kernelObject)
+{
+    pthread_mutex_lock(&gs_DebugEngineMutex);
+
+    m_numDispatches++;
+
+    bool isAcquired = true;
+
+    if (gs_NumDebugEngineHolds > 0)
+    {
+        if (IsDebugEngineNeeded(kernelObject))
+        {
+            AGENT_LOG("AcquireDebugEngine: Queue " << m_queueId << " waits for the debug engine held by queue " <<
+                      gs_DebugEngineQueueId);
+            m_numDebugEngineWaits++;
+
+            while (gs_NumDebugEngineHolds > 0)
+            {
+                pthread_cond_wait(&gs_DebugEngineFreeCond, &gs_DebugEngineMutex);
+            }
+        }
+        else
+        {
+            m_numDispatchesNotDebugged++;
+            isAcquired = false;
+        }
+    }
+
+    if (isAcquired)
+    {
+        gs_NumDebugEngineHolds = 1;
+        gs_DebugEngineQueueId = m_queueId;
+        gs_DebugEngineKernelObject = kernelObject;
+    }
+
+    pthread_mutex_unlock(&gs_DebugEngineMutex);
+
+    return isAcquired;
+}
+
+void AgentQueueContext::LogStatistics() const
+{
+    AGENT_LOG("Queue " << m_queueId << " statistics: " <<
+              "Dispatches: " << m_numDispatches << "\t" <<
+              "Engine waits: " << m_numDebugEngineWaits << "\t" <<
+              "Not debugged: " << m_numDispatchesNotDebugged);
+}
+
+AgentQueueContext* AgentCreateQueueContext(AgentContext* pAgentContext, const hsa_queue_t* pQueue)
+{
+    if (pAgentContext == nullptr || pQueue == nullptr)
+    {
+        AGENT_ERROR("AgentCreateQueueContext: Invalid input");
+        return nullptr;
+    }
+
+    AgentQueueContext* pQueueContext = new(std::nothrow) AgentQueueContext(pAgentContext, pQueue);
+
+    if (pQueueContext == nullptr)
+    {
+        AGENT_ERROR("AgentCreateQueueContext: Could not allocate the context of queue " << pQueue->id);
+        return nullptr;
+    }
+
+    pthread_mutex_lock(&gs_DebugEngineMutex);
+    gs_QueueContexts.push_back(pQueueContext);
+    pthread_mutex_unlock(&gs_DebugEngineMutex);
+
+    return pQueueContext;
+}
+
+void AgentLogQueueStatistics()
+{
+    pthread_mutex_lock(&gs_DebugEngineMutex);
+
+    for (size_t i = 0; i < gs_QueueContexts.size(); i++)
+    {
+        gs_QueueContexts[i]->LogStatistics();
+    }
+
+    pthread_mutex_unlock(&gs_DebugEngineMutex);
+}
+
+void AgentDeleteQueueContexts()
+{
+    pthread_mutex_lock(&gs_DebugEngineMutex);
+
+    for (size_t i = 0; i < gs_QueueContexts.size(); i++)
+    {
+        delete gs_QueueContexts[i];
+    }
+
+    gs_QueueContexts.clear();
+
+    pthread_mutex_unlock(&gs_DebugEngineMutex);
+}
+
+void AgentRetainDebugEngine()
+{
+    pthread_mutex_lock(&gs_DebugEngineMutex);
+    gs_NumDebugEngineHolds++;
+    pthread_mutex_unlock(&gs_DebugEngineMutex);
+}
+
+bool AgentTryAcquireIdleDebugEngine()
+{
+    pthread_mutex_lock(&gs_DebugEngineMutex);
+
+    bool isAcquired = false;
+
+    if (gs_NumDebugEngineHolds == 0)
+    {
+        gs_NumDebugEngineHolds = 1;
+        gs_IsDebugEngineQueried = true;
+        isAcquired = true;
+    }
+
+    pthread_mutex_unlock(&gs_DebugEngineMutex);
+
+    return isAcquired;
+}
+
+void AgentAcquireIdleDebugEngine()
+{
+    pthread_mutex_lock(&gs_DebugEngineMutex);
+
+    while (gs_NumDebugEngineHolds > 0)
+    {
+        pthread_cond_wait(&gs_DebugEngineFreeCond, &gs_DebugEngineMutex);
+    }
+
+    gs_NumDebugEngineHolds = 1;
+    gs_IsDebugEngineQueried = true;
+
+    pthread_mutex_unlock(&gs_DebugEngineMutex);
+}
+
+void AgentReleaseDebugEngine()
+{
+    pthread_mutex_lock(&gs_DebugEngineMutex);
+
+    if (gs_NumDebugEngineHolds == 0)
+    {
+        AGENT_ERROR("AgentReleaseDebugEngine: The debug engine is not held");
+    }
+    else
+    {
+        gs_NumDebugEngineHolds--;
+
+        if (gs_NumDebugEngineHolds == 0)
+        {
+            gs_DebugEngineQueueId = 0;
+            gs_DebugEngineKernelObject = 0;
+            gs_IsDebugEngineQueried = false;
+            pthread_cond_broadcast(&gs_DebugEngineFreeCond);
+        }
+    }
+
+    pthread_mutex_unlock(&gs_DebugEngineMutex);
+}
+
+void AgentRecordPreparedKernel(const uint64_t kernelObject,
+                               const bool     hasFunctionBreakpoint,
+                               const uint64_t codeStart,
+                               const uint64_t codeEnd)
+{
+    PreparedKernel preparedKernel;
+    preparedKernel.m_hasFunctionBreakpoint = hasFunctionBreakpoint;
+    preparedKernel.m_codeStart = codeStart;
+    preparedKernel.m_codeEnd = codeEnd;
+
+    pthread_mutex_lock(&gs_DebugEngineMutex);
+    gs_PreparedKernels[kernelObject] = preparedKernel;
+    pthread_mutex_unlock(&gs_DebugEngineMutex);
+}
+
+void AgentForgetPreparedKernels()
+{
+    pthread_mutex_lock(&gs_DebugEngineMutex);
+    gs_PreparedKernels.clear();
+    pthread_mutex_unlock(&gs_DebugEngineMutex);
+}
+
+void AgentSetActiveBreakpoints(const AgentBreakpointManager& bpManager)
+{
+    std::vector<HwDbgCodeAddress> pcs;
+    std::vector<std::string> kernelNames;
+    bpManager.GetActiveBreakpoints(pcs, kernelNames);
+
+    pthread_mutex_lock(&gs_DebugEngineMutex);
+
+    gs_ActiveBreakpointPCs.swap(pcs);
+
+    // A kernel prepared with other function breakpoints has to be matched again
+    if (kernelNames != gs_ActiveKernelNameBreakpoints)
+    {
+        gs_ActiveKernelNameBreakpoints.swap(kernelNames);
+        gs_PreparedKernels.clear();
+    }
+
+    pthread_mutex_unlock(&gs_DebugEngineMutex);
+}
+
+} // End Namespace HwDbgAgent
@@ -5,205 +5,689 @@
 /// \file
 /// \brief Agent Segment Loader
 //==============================================================================
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 #include <libelf.h>
+#include <pthread.h>
 
 #include "AgentConfiguration.h"
 #include "AgentLogging.h"
+#include "AgentQueueContext.h"
 #include "AgentSegmentLoader.h"
+#include "AgentSharedMemRegistry.h"
 #include "CommunicationControl.h"
 #include "HSADebugAgent.h"
 
 namespace HwDbgAgent
 {
 
-AgentSegmentLoader::AgentSegmentLoader(hsa_kernel_dispatch_packet_t* pAqlPacket):
-                     m_pLoadedSegments(nullptr),
-                     m_numLoadedSegments(0),
-                     m_loadedSegmentShmKey(-1),
-                     m_loadedSegmentShmMaxSize(0),
-                     m_kernelObjectAddress(0)
+/// Incremented when an executable is loaded or destroyed, starts above the 0 of a new AgentSegmentLoader
+static uint64_t gs_LoadMapGeneration = 1;
+
+/// Serializes the DBE load map queries of the dispatches and of the code object ingestion
+static pthread_mutex_t gs_LoadMapQueryMutex = PTHREAD_MUTEX_INITIALIZER;
+
+void AgentInvalidateLoadMap()
+{
+    __atomic_add_fetch(&gs_LoadMapGeneration, 1, __ATOMIC_RELEASE);
+}
+
+uint64_t AgentGetLoadMapGeneration()
+{
+    return __atomic_load_n(&gs_LoadMapGeneration, __ATOMIC_ACQUIRE);
+}
+
+HsailAgentStatus AgentQueryLoadedSegments(std::vector<HwDbgLoaderSegmentDescriptor>& segmentsOut)
 {
-    GetActiveAgentConfig()->GetConfigShmKey(HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM, m_loadedSegmentShmKey);
-    GetActiveAgentConfig()->GetConfigShmSize(HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM, m_loadedSegmentShmMaxSize);
-    if (pAqlPacket != nullptr)
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    pthread_mutex_lock(&gs_LoadMapQueryMutex);
+
+    size_t numSegments = 0;
+    HwDbgStatus dbeStatus = HwDbgGetLoadedSegmentDescriptors(nullptr, &numSegments);
+
+    if (dbeStatus != HWDBG_STATUS_SUCCESS)
     {
-        m_kernelObjectAddress = pAqlPacket->kernel_object;
+        pthread_mutex_unlock(&gs_LoadMapQueryMutex);
+        AGENT_ERROR("AgentQueryLoadedSegments: Could not get the number of loaded segments");
+        return status;
     }
+
+    segmentsOut.resize(numSegments);
+
+    if (numSegments > 0)
+    {
+        dbeStatus = HwDbgGetLoadedSegmentDescriptors(segmentsOut.data(), &numSegments);
+
+        if (dbeStatus != HWDBG_STATUS_SUCCESS)
+        {
+            pthread_mutex_unlock(&gs_LoadMapQueryMutex);
+            AGENT_ERROR("AgentQueryLoadedSegments: Could not get the loaded segments");
+            return status;
+        }
+
+        segmentsOut.resize(std::min(numSegments, segmentsOut.size()));
+    }
+
+    pthread_mutex_unlock(&gs_LoadMapQueryMutex);
+
+    status = HSAIL_AGENT_STATUS_SUCCESS;
+    return status;
+}
+
+AgentSegmentLoader::AgentSegmentLoader(AgentSharedMemRegistry* pSharedMemRegistry):
+                     m_segments(),
+                     m_segmentIndex(),
+                     m_dbeLoadMap(),
+                     m_preparedLoadMap(),
+                     m_dirtySlots(),
+                     m_missedKernelObjects(),
+                     m_executedSlot(SIZE_MAX),
+                     m_generation(0),
+                     m_isFullWriteNeeded(true),
+                     m_isPublishedToLegacyBuffer(false),
+                     m_numPublishedSegments(0),
+                     m_pSharedMemRegistry(pSharedMemRegistry),
+                     m_numQueries(0),
+                     m_numQueriesForMiss(0),
+                     m_numMissesRemembered(0),
+                     m_numSegmentsAdded(0),
+                     m_numSegmentsRemoved(0),
+                     m_numUpdatesSkipped(0),
+                     m_numLoadMapsPrepared(0),
+                     m_numPreparedLoadMapsUsed(0)
+{
+    m_dbeLoadMap.m_generation = 0;
+    m_preparedLoadMap.m_generation = 0;
+
+    pthread_mutex_init(&m_preparedLoadMapMutex, nullptr);
 }
 
 AgentSegmentLoader::~AgentSegmentLoader()
 {
-    ClearLoadedSegments();
+    m_segments.clear();
+    m_segmentIndex.clear();
+
+    pthread_mutex_destroy(&m_preparedLoadMapMutex);
 }
 
-size_t AgentSegmentLoader::FindExecutedSegment() const
+bool AgentSegmentLoader::IsIndexEntryBefore(const SegmentIndexEntry& lhs, const SegmentIndexEntry& rhs)
 {
-    if (0 == m_numLoadedSegments || nullptr == m_pLoadedSegments)
+    if (lhs.m_segmentBase != rhs.m_segmentBase)
     {
-        return SIZE_MAX;
+        return lhs.m_segmentBase < rhs.m_segmentBase;
     }
 
-    for (size_t i = 0; i < m_numLoadedSegments; ++i)
+    if (lhs.m_segmentSize != rhs.m_segmentSize)
     {
-        uint64_t segmentAddress = reinterpret_cast<uint64_t>(m_pLoadedSegments[i].pSegmentBase);
-        uint64_t segmentSize = static_cast<uint64_t>(m_pLoadedSegments[i].segmentSize);
+        return lhs.m_segmentSize < rhs.m_segmentSize;
+    }
 
+    if (lhs.m_executable != rhs.m_executable)
+    {
+        return lhs.m_executable < rhs.m_executable;
+    }
 
-        if ( (m_kernelObjectAddress <= (segmentAddress + segmentSize)) &&
-             (m_kernelObjectAddress >= segmentAddress ))
-        {
-            return i;
-        }
+    return lhs.m_codeObjectStorageOffset < rhs.m_codeObjectStorageOffset;
+}
+
+size_t AgentSegmentLoader::FindSegmentSlot(const uint64_t address) const
+{
+    // The last segment that starts at or before the address
+    std::vector<SegmentIndexEntry>::const_iterator indexIt =
+        std::upper_bound(m_segmentIndex.begin(), m_segmentIndex.end(), address,
+                         [](const uint64_t value, const SegmentIndexEntry& entry)
+                         {
+                             return value < entry.m_segmentBase;
+                         });
+
+    if (indexIt == m_segmentIndex.begin())
+    {
+        return SIZE_MAX;
+    }
+
+    --indexIt;
+
+    if (address <= indexIt->m_segmentBase + indexIt->m_segmentSize)
+    {
+        return indexIt->m_slot;
     }
 
     return SIZE_MAX;
 }
 
+void AgentSegmentLoader::AddSegment(const HsailSegmentDescriptor& segment)
+{
+    SegmentIndexEntry entry;
+    entry.m_segmentBase = segment.segmentBase;
+    entry.m_segmentSize = segment.segmentSize;
+    entry.m_executable = segment.executable;
+    entry.m_codeObjectStorageOffset = segment.codeObjectStorageOffset;
+    entry.m_slot = m_segments.size();
+
+    m_segments.push_back(segment);
+    m_segmentIndex.insert(std::upper_bound(m_segmentIndex.begin(), m_segmentIndex.end(), entry, IsIndexEntryBefore),
+                          entry);
+
+    m_dirtySlots.insert(entry.m_slot);
+    m_numSegmentsAdded++;
+}
 
-HsailAgentStatus AgentSegmentLoader::UpdateLoadedSegments()
+void AgentSegmentLoader::RemoveSegment(const size_t indexPosition)
 {
-    ClearLoadedSegments();
+    const size_t slot = m_segmentIndex[indexPosition].m_slot;
+    const size_t lastSlot = m_segments.size() - 1;
 
-    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+    m_segmentIndex.erase(m_segmentIndex.begin() + indexPosition);
 
-    // Just test the load map
-    size_t numSegments=0;
-    HwDbgStatus dbeStatus  = HwDbgGetLoadedSegmentDescriptors(nullptr, &numSegments);
-    if ((numSegments == 0) && (dbeStatus == HWDBG_STATUS_SUCCESS))
+    if (m_executedSlot == slot)
     {
-        status = HSAIL_AGENT_STATUS_SUCCESS;
+        m_executedSlot = SIZE_MAX;
     }
-    else if ((0 < numSegments) && (dbeStatus == HWDBG_STATUS_SUCCESS))
+
+    // Keep the slots packed, the last descriptor moves to the free slot
+    if (slot != lastSlot)
     {
+        m_segments[slot] = m_segments[lastSlot];
+        m_dirtySlots.insert(slot);
 
-        m_pLoadedSegments = new (std::nothrow) HwDbgLoaderSegmentDescriptor[numSegments];
+        for (size_t i = 0; i < m_segmentIndex.size(); i++)
+        {
+            if (m_segmentIndex[i].m_slot == lastSlot)
+            {
+                m_segmentIndex[i].m_slot = slot;
+                break;
+            }
+        }
 
-        dbeStatus = HwDbgGetLoadedSegmentDescriptors(m_pLoadedSegments, &numSegments);
-        if (dbeStatus == HWDBG_STATUS_SUCCESS)
+        if (m_executedSlot == lastSlot)
         {
-            m_numLoadedSegments = numSegments;
+            m_executedSlot = slot;
+        }
+    }
+
+    m_segments.pop_back();
+    m_dirtySlots.erase(lastSlot);
+    m_numSegmentsRemoved++;
+}
+
+uint64_t AgentSegmentLoader::GetSegmentElfVA(const HwDbgLoaderSegmentDescriptor& segment)
+{
+    // Only a code object in memory can be read here
+    if (segment.codeObjectStorageType != HWDBG_LOADER_CODE_OBJECT_STORAGE_TYPE_MEMORY ||
+        segment.pCodeObjectStorageBase == nullptr ||
+        segment.codeObjectStorageSize < sizeof(Elf64_Ehdr))
+    {
+        return 0;
+    }
 
-            status = HSAIL_AGENT_STATUS_SUCCESS;
+    // Get elf structure at the start of the file, null checked above
+    const char* pCodeObj = static_cast<const char*>(segment.pCodeObjectStorageBase);
+    const Elf64_Ehdr* pElfEhDr = reinterpret_cast<const Elf64_Ehdr*>(pCodeObj);
+
+    size_t phdrOffsetinBytes = static_cast<size_t>(pElfEhDr->e_phoff);
+    size_t numTotalPhdrs = static_cast<size_t>(pElfEhDr->e_phnum);
+
+    if (phdrOffsetinBytes + numTotalPhdrs * sizeof(Elf64_Phdr) > segment.codeObjectStorageSize)
+    {
+        AGENT_ERROR("The value of phdrOffsetinBytes seems invalid \n" <<
+                    "phdrOffsetinBytes = " << phdrOffsetinBytes << "\t"
+                    "but code object size = " << segment.codeObjectStorageSize);
+        return 0;
+    }
+
+    // Get location of the list of pPhDrs array within the CodeObject ELF
+    const Elf64_Phdr* pPhdrList = reinterpret_cast<const Elf64_Phdr*>(pCodeObj + phdrOffsetinBytes);
+
+    // The program header of the loaded segment is the one at the same offset
+    for (size_t j = 0; j < numTotalPhdrs; j++)
+    {
+        if (pPhdrList[j].p_offset == segment.codeObjectStorageOffset)
+        {
+            return static_cast<uint64_t>(pPhdrList[j].p_vaddr);
         }
+    }
+
+    // The AgentLog function that logs the loadmap has more details
+    AGENT_LOG("Segment at " << std::hex << segment.pSegmentBase << std::dec << ": elf VA could not be found");
+
+    return 0;
+}
+
+HsailAgentStatus AgentSegmentLoader::QueryLoadMap(DbeLoadMap& loadMapOut)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    // A load or destroy during the query increments the generation again, so it is not missed
+    loadMapOut.m_generation = __atomic_load_n(&gs_LoadMapGeneration, __ATOMIC_ACQUIRE);
 
-        status = WriteToSharedMemory();
+    if (AgentQueryLoadedSegments(loadMapOut.m_segments) != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("QueryLoadMap: Could not get the loaded segments");
+        loadMapOut.m_generation = 0;
+        return status;
     }
 
+    IndexLoadMap(loadMapOut);
+
+    status = HSAIL_AGENT_STATUS_SUCCESS;
     return status;
 }
 
-HsailAgentStatus AgentSegmentLoader::WriteToSharedMemory() const
+void AgentSegmentLoader::IndexLoadMap(DbeLoadMap& loadMap)
 {
+    const std::vector<HwDbgLoaderSegmentDescriptor>& dbeSegments = loadMap.m_segments;
+
+    loadMap.m_segmentElfVAs.resize(dbeSegments.size());
+    loadMap.m_index.resize(dbeSegments.size());
+
+    for (size_t i = 0; i < dbeSegments.size(); i++)
+    {
+        loadMap.m_segmentElfVAs[i] = GetSegmentElfVA(dbeSegments[i]);
+
+        loadMap.m_index[i].m_segmentBase = reinterpret_cast<uint64_t>(dbeSegments[i].pSegmentBase);
+        loadMap.m_index[i].m_segmentSize = static_cast<uint64_t>(dbeSegments[i].segmentSize);
+        loadMap.m_index[i].m_executable = dbeSegments[i].executable;
+        loadMap.m_index[i].m_codeObjectStorageOffset = dbeSegments[i].codeObjectStorageOffset;
+        loadMap.m_index[i].m_slot = i;    // Position in m_segments of the load map
+    }
+
+    std::sort(loadMap.m_index.begin(), loadMap.m_index.end(), IsIndexEntryBefore);
+}
+
+void AgentSegmentLoader::KeepPreparedLoadMap(DbeLoadMap& loadMap)
+{
+    pthread_mutex_lock(&m_preparedLoadMapMutex);
+
+    if (loadMap.m_generation > m_preparedLoadMap.m_generation)
+    {
+        std::swap(m_preparedLoadMap, loadMap);
+        m_numLoadMapsPrepared++;
+    }
 
+    pthread_mutex_unlock(&m_preparedLoadMapMutex);
+}
+
+HsailAgentStatus AgentSegmentLoader::PrepareLoadMap()
+{
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
-    if (m_pLoadedSegments == nullptr || m_numLoadedSegments == 0)
+
+    const uint64_t generation = __atomic_load_n(&gs_LoadMapGeneration, __ATOMIC_ACQUIRE);
+
+    // Nothing to prepare if the load map gdb sees or the prepared one is up to date
+    if (__atomic_load_n(&m_generation, __ATOMIC_ACQUIRE) == generation)
     {
-        return status;
+        return HSAIL_AGENT_STATUS_SUCCESS;
     }
-    if (sizeof(HsailSegmentDescriptor)*m_numLoadedSegments > m_loadedSegmentShmMaxSize)
+
+    pthread_mutex_lock(&m_preparedLoadMapMutex);
+    bool isPrepared = (m_preparedLoadMap.m_generation == generation);
+    pthread_mutex_unlock(&m_preparedLoadMapMutex);
+
+    if (isPrepared)
     {
-        AGENT_ERROR("Too many segments to send to gdb");
+        return HSAIL_AGENT_STATUS_SUCCESS;
+    }
+
+    // The DBE may only be queried by the holder of the debug engine. While a dispatch is debugged,
+    // the load map is left to the UpdateLoadedSegments of the next dispatch, done with the engine held
+    if (!AgentTryAcquireIdleDebugEngine())
+    {
+        AGENT_LOG("PrepareLoadMap: The debug engine is held, the load map is not prepared");
+        return HSAIL_AGENT_STATUS_SUCCESS;
+    }
+
+    // The ELF parsing runs without the prepared load map lock
+    DbeLoadMap loadMap;
+
+    status = QueryLoadMap(loadMap);
+
+    AgentReleaseDebugEngine();
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("PrepareLoadMap: Could not prepare the load map");
         return status;
     }
-    void* pShm = AgentMapSharedMemBuffer(m_loadedSegmentShmKey, m_loadedSegmentShmMaxSize);
-    memset(pShm,0,m_loadedSegmentShmMaxSize);
 
-    if (pShm != nullptr)
+    KeepPreparedLoadMap(loadMap);
+
+    return HSAIL_AGENT_STATUS_SUCCESS;
+}
+
+void AgentSegmentLoader::OfferLoadMap(const uint64_t                                   generation,
+                                      const std::vector<HwDbgLoaderSegmentDescriptor>& segments)
+{
+    // The segments of a generation gdb already sees are not needed
+    if (__atomic_load_n(&m_generation, __ATOMIC_ACQUIRE) >= generation)
     {
-        size_t* pNumLoaded = reinterpret_cast<size_t*>(pShm);
-        *pNumLoaded = m_numLoadedSegments;
-        HsailSegmentDescriptor* pSegmentMem = reinterpret_cast<HsailSegmentDescriptor*>(pNumLoaded + 1);
-        for (size_t i=0; i < m_numLoadedSegments; i++)
+        return;
+    }
+
+    // The ELF parsing and the sort are done here, without the debug engine
+    DbeLoadMap loadMap;
+    loadMap.m_generation = generation;
+    loadMap.m_segments = segments;
+
+    IndexLoadMap(loadMap);
+
+    KeepPreparedLoadMap(loadMap);
+}
+
+HsailAgentStatus AgentSegmentLoader::RefreshLoadMap(const bool isPreparedLoadMapUsable)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    const uint64_t generation = __atomic_load_n(&gs_LoadMapGeneration, __ATOMIC_ACQUIRE);
+
+    bool isPrepared = false;
+
+    pthread_mutex_lock(&m_preparedLoadMapMutex);
+
+    // The prepared load map is taken, the buffer of the last query is left for the next PrepareLoadMap
+    if (isPreparedLoadMapUsable && m_preparedLoadMap.m_generation == generation)
+    {
+        std::swap(m_dbeLoadMap, m_preparedLoadMap);
+        m_preparedLoadMap.m_generation = 0;
+        m_numPreparedLoadMapsUsed++;
+        isPrepared = true;
+    }
+
+    pthread_mutex_unlock(&m_preparedLoadMapMutex);
+
+    if (!isPrepared)
+    {
+        m_numQueries++;
+
+        if (QueryLoadMap(m_dbeLoadMap) != HSAIL_AGENT_STATUS_SUCCESS)
         {
-            pSegmentMem[i].codeObjectStorageBase = reinterpret_cast<size_t>(m_pLoadedSegments[i].pCodeObjectStorageBase);
-            pSegmentMem[i].codeObjectStorageOffset =  m_pLoadedSegments[i].codeObjectStorageOffset;
-            pSegmentMem[i].codeObjectStorageType = static_cast<HsailLoaderCodeObjectStorageType>(m_pLoadedSegments[i].codeObjectStorageType);
-            pSegmentMem[i].codeObjectStorageSize = m_pLoadedSegments[i].codeObjectStorageSize;
-            pSegmentMem[i].device = m_pLoadedSegments[i].device;
-            pSegmentMem[i].executable = m_pLoadedSegments[i].executable;
-            pSegmentMem[i].segmentBase = reinterpret_cast<size_t>(m_pLoadedSegments[i].pSegmentBase);
-            pSegmentMem[i].segmentSize = m_pLoadedSegments[i].segmentSize;
+            AGENT_ERROR("RefreshLoadMap: Could not get the loaded segments");
+            return status;
         }
+    }
+
+    const std::vector<HwDbgLoaderSegmentDescriptor>& dbeSegments = m_dbeLoadMap.m_segments;
+    const std::vector<SegmentIndexEntry>& newIndex = m_dbeLoadMap.m_index;
 
-        AddElfVAForEachSegmentDescriptor(pSegmentMem);
+    // Both lists are sorted, walk them together to find the removed and the added segments
+    std::vector<size_t> removedPositions;
+    std::vector<size_t> addedSegments;
 
-        size_t executedSegmentIndex = FindExecutedSegment();
-        if  (executedSegmentIndex != SIZE_MAX)
+    size_t oldPosition = 0;
+    size_t newPosition = 0;
+
+    while (oldPosition < m_segmentIndex.size() || newPosition < newIndex.size())
+    {
+        if (newPosition == newIndex.size() ||
+            (oldPosition < m_segmentIndex.size() && IsIndexEntryBefore(m_segmentIndex[oldPosition], newIndex[newPosition])))
+        {
+            removedPositions.push_back(oldPosition++);
+        }
+        else if (oldPosition == m_segmentIndex.size() ||
+                 IsIndexEntryBefore(newIndex[newPosition], m_segmentIndex[oldPosition]))
         {
-            pSegmentMem[executedSegmentIndex].isSegmentExecuted = true;
+            addedSegments.push_back(newIndex[newPosition++].m_slot);
         }
+        else
+        {
+            oldPosition++;
+            newPosition++;
+        }
+    }
 
-        AgentLogLoadMap(pSegmentMem, m_numLoadedSegments);
+    // Remove from the back so the positions of the index stay valid
+    for (std::vector<size_t>::reverse_iterator removedIt = removedPositions.rbegin();
+         removedIt != removedPositions.rend();
+         ++removedIt)
+    {
+        RemoveSegment(*removedIt);
+    }
 
-        status = AgentUnMapSharedMemBuffer(pShm);
+    for (size_t i = 0; i < addedSegments.size(); i++)
+    {
+        const HwDbgLoaderSegmentDescriptor& dbeSegment = dbeSegments[addedSegments[i]];
+
+        HsailSegmentDescriptor segment;
+        memset(&segment, 0, sizeof(HsailSegmentDescriptor));
+
+        segment.codeObjectStorageBase = reinterpret_cast<size_t>(dbeSegment.pCodeObjectStorageBase);
+        segment.codeObjectStorageOffset = dbeSegment.codeObjectStorageOffset;
+        segment.codeObjectStorageType = static_cast<HsailLoaderCodeObjectStorageType>(dbeSegment.codeObjectStorageType);
+        segment.codeObjectStorageSize = dbeSegment.codeObjectStorageSize;
+        segment.device = dbeSegment.device;
+        segment.executable = dbeSegment.executable;
+        segment.segmentBase = reinterpret_cast<size_t>(dbeSegment.pSegmentBase);
+        segment.segmentSize = dbeSegment.segmentSize;
+        segment.segmentBaseElfVA = m_dbeLoadMap.m_segmentElfVAs[addedSegments[i]];
+
+        AddSegment(segment);
+    }
 
+    // A kernel_object missing from the old load map may be in the new one
+    if (m_dbeLoadMap.m_generation != m_generation)
+    {
+        m_missedKernelObjects.clear();
     }
 
+    __atomic_store_n(&m_generation, m_dbeLoadMap.m_generation, __ATOMIC_RELEASE);
+
+    if (!removedPositions.empty() || !addedSegments.empty())
+    {
+        AGENT_LOG("RefreshLoadMap: Generation " << m_dbeLoadMap.m_generation << "\t" <<
+                  "Added: " << addedSegments.size() << "\t" <<
+                  "Removed: " << removedPositions.size() << "\t" <<
+                  "Segments: " << m_segments.size());
+
+        AgentLogLoadMap(m_segments.data(), m_segments.size());
+    }
+
+    status = HSAIL_AGENT_STATUS_SUCCESS;
     return status;
 }
 
-void AgentSegmentLoader::AddElfVAForEachSegmentDescriptor(HsailSegmentDescriptor* pSegments) const
+HsailAgentStatus AgentSegmentLoader::UpdateLoadedSegments(const uint64_t kernelObjectAddress)
 {
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_SUCCESS;
 
-    if (pSegments != nullptr &&
-        m_numLoadedSegments > 0 &&
-        m_pLoadedSegments->pCodeObjectStorageBase != nullptr)
+    if (m_generation != __atomic_load_n(&gs_LoadMapGeneration, __ATOMIC_ACQUIRE))
     {
-        // Get elf structure at the start of the file, null checked above
-        const Elf64_Ehdr* pElfEhDr = static_cast<const Elf64_Ehdr*>(m_pLoadedSegments->pCodeObjectStorageBase);
-        size_t phdrOffsetinBytes = static_cast<size_t>(pElfEhDr->e_phoff);
+        status = RefreshLoadMap(true);
+    }
 
-        AGENT_LOG("Location of pPhDrs array (in bytes): phdrOffsetinBytes " << phdrOffsetinBytes);
+    size_t executedSlot = FindSegmentSlot(kernelObjectAddress);
 
-        if (phdrOffsetinBytes > m_pLoadedSegments->codeObjectStorageSize)
+    // The kernel was loaded by a path that is not intercepted, the load map is stale
+    if (executedSlot == SIZE_MAX && status == HSAIL_AGENT_STATUS_SUCCESS && kernelObjectAddress != 0)
+    {
+        if (m_missedKernelObjects.find(kernelObjectAddress) != m_missedKernelObjects.end())
         {
-            AGENT_ERROR("The value of phdrOffsetinBytes seems invalid \n" <<
-                        "phdrOffsetinBytes = " << phdrOffsetinBytes << "\t"
-                        "but code object size = " << m_pLoadedSegments->codeObjectStorageSize);
+            // The DBE did not know the segment at this generation either
+            m_numMissesRemembered++;
         }
+        else
+        {
+            m_numQueriesForMiss++;
+            status = RefreshLoadMap(false);
+            executedSlot = FindSegmentSlot(kernelObjectAddress);
 
-        // Get location of the list of pPhDrs array within the CodeObject ELF
-        Elf64_Phdr* pPhdrList = (Elf64_Phdr*)(
-                                    (char*)m_pLoadedSegments->pCodeObjectStorageBase + phdrOffsetinBytes);
+            if (executedSlot == SIZE_MAX && status == HSAIL_AGENT_STATUS_SUCCESS)
+            {
+                m_missedKernelObjects.insert(kernelObjectAddress);
+            }
+        }
+    }
 
-        // Size of the pPhDrs array, obtained from the elf structure at the start of the file
-        size_t numTotalPhdrs = static_cast<size_t>(pElfEhDr->e_phnum );
-        AGENT_LOG("No of total Phdrs: " << numTotalPhdrs);
+    if (executedSlot != m_executedSlot)
+    {
+        if (m_executedSlot < m_segments.size())
+        {
+            m_segments[m_executedSlot].isSegmentExecuted = false;
+            m_dirtySlots.insert(m_executedSlot);
+        }
 
-        // For each of the input descriptors
-        for (size_t i=0; i< m_numLoadedSegments; i++)
+        if (executedSlot < m_segments.size())
         {
-            // For each loaded GPU section, we find the corresponding program header
-            // The program header needs to be of type "LOAD" which is = 1 && the offset must match
-            bool isSegmentFound = false;
-            for (size_t j=0; j < numTotalPhdrs; j++)
-            {
-                if ((pPhdrList[j].p_offset == m_pLoadedSegments[i].codeObjectStorageOffset))
-                    //&&
-                    //(pPhdrList[j].p_type == 1))
-                {
-                    pSegments[i].segmentBaseElfVA = static_cast<uint64_t>(pPhdrList[j].p_vaddr);
-                    isSegmentFound = true;
-                    break;
-                }
-            }
-            if (!isSegmentFound)
-            {
-                // The AgentLog function that logs the loadmap has more details
-                AGENT_LOG("Segment " << i << " elf VA could not be found");
-            }
+            m_segments[executedSlot].isSegmentExecuted = true;
+            m_dirtySlots.insert(executedSlot);
         }
+
+        m_executedSlot = executedSlot;
+    }
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        return status;
     }
+
+    status = WriteToSharedMemory();
+
+    return status;
 }
-void AgentSegmentLoader::ClearLoadedSegments()
+
+bool AgentSegmentLoader::GetExecutedSegmentElfRange(uint64_t& elfVAStartOut, uint64_t& elfVAEndOut) const
 {
-    if (m_pLoadedSegments != nullptr)
+    if (m_executedSlot >= m_segments.size())
     {
-        delete [] m_pLoadedSegments;
-        m_numLoadedSegments = 0;
+        return false;
     }
+
+    const HsailSegmentDescriptor& segment = m_segments[m_executedSlot];
+
+    // GetSegmentElfVA only reads the program headers of a code object in memory
+    if (segment.codeObjectStorageType != HSAIL_LOADER_CODE_OBJECT_STORAGE_TYPE_MEMORY)
+    {
+        return false;
+    }
+
+    elfVAStartOut = segment.segmentBaseElfVA;
+    elfVAEndOut = segment.segmentBaseElfVA + segment.segmentSize;
+
+    return true;
+}
+
+bool AgentSegmentLoader::FindLoadedCodeObject(const uint64_t binaryHash,
+                                              const size_t   binarySize,
+                                              const void*&   pBinaryOut) const
+{
+    if (m_generation != __atomic_load_n(&gs_LoadMapGeneration, __ATOMIC_ACQUIRE))
+    {
+        AGENT_LOG("FindLoadedCodeObject: The load map changed since it was read");
+        return false;
+    }
+
+    // The segments of a code object share its storage, only hash each storage once
+    std::set<size_t> hashedStorage;
+
+    for (size_t i = 0; i < m_segments.size(); i++)
+    {
+        const HsailSegmentDescriptor& segment = m_segments[i];
+
+        if (segment.codeObjectStorageType != HSAIL_LOADER_CODE_OBJECT_STORAGE_TYPE_MEMORY ||
+            segment.codeObjectStorageSize != binarySize ||
+            segment.codeObjectStorageBase == 0 ||
+            !hashedStorage.insert(segment.codeObjectStorageBase).second)
+        {
+            continue;
+        }
+
+        const void* pBinary = reinterpret_cast<const void*>(segment.codeObjectStorageBase);
+
+        if (AgentComputeBinaryHash(pBinary, binarySize) == binaryHash)
+        {
+            pBinaryOut = pBinary;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+HsailAgentStatus AgentSegmentLoader::WriteToSharedMemory()
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (m_pSharedMemRegistry == nullptr)
+    {
+        AGENT_ERROR("WriteToSharedMemory: The shared mem registry is nullptr");
+        return status;
+    }
+
+    // The other buffer has none of the descriptors written so far
+    if (m_pSharedMemRegistry->IsLegacyRegionUpdate() != m_isPublishedToLegacyBuffer)
+    {
+        m_isFullWriteNeeded = true;
+    }
+
+    // Nothing changed since the last dispatch, gdb already has this load map
+    if (!m_isFullWriteNeeded && m_dirtySlots.empty() && m_numPublishedSegments == m_segments.size())
+    {
+        m_numUpdatesSkipped++;
+
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+        return status;
+    }
+
+    size_t payloadSize = sizeof(HsailSegmentDescriptor)*m_segments.size();
+
+    // The shared mem region grows if the segments do not fit, the descriptors written before are kept
+    void* pPayload = m_pSharedMemRegistry->BeginRegionUpdate(HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM, payloadSize);
+
+    if (pPayload == nullptr)
+    {
+        AGENT_ERROR("Too many segments to send to gdb");
+        return status;
+    }
+
+    HsailSegmentDescriptor* pSegmentMem = static_cast<HsailSegmentDescriptor*>(pPayload);
+
+    // gdb may have announced the buffers with a header since the check above
+    const bool isLegacyUpdate = m_pSharedMemRegistry->IsLegacyRegionUpdate();
+
+    if (m_isFullWriteNeeded || isLegacyUpdate != m_isPublishedToLegacyBuffer)
+    {
+        if (payloadSize > 0)
+        {
+            memcpy(pSegmentMem, m_segments.data(), payloadSize);
+        }
+    }
+    else
+    {
+        for (std::set<size_t>::const_iterator slotIt = m_dirtySlots.begin(); slotIt != m_dirtySlots.end(); ++slotIt)
+        {
+            if (*slotIt < m_segments.size())
+            {
+                pSegmentMem[*slotIt] = m_segments[*slotIt];
+            }
+        }
+    }
+
+    status = m_pSharedMemRegistry->EndRegionUpdate(HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM, payloadSize);
+
+    if (status == HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        m_dirtySlots.clear();
+        m_isFullWriteNeeded = false;
+        m_isPublishedToLegacyBuffer = isLegacyUpdate;
+        m_numPublishedSegments = m_segments.size();
+    }
+
+    return status;
+}
+
+void AgentSegmentLoader::LogStatistics() const
+{
+    AGENT_LOG("Load map statistics: " <<
+              "Segments: " << m_segments.size() << "\t" <<
+              "Generation: " << m_generation << "\t" <<
+              "Queries: " << m_numQueries << "\t" <<
+              "Queries for a missing kernel: " << m_numQueriesForMiss << "\t" <<
+              "Missing kernels not queried again: " << m_numMissesRemembered << "\t" <<
+              "Added: " << m_numSegmentsAdded << "\t" <<
+              "Removed: " << m_numSegmentsRemoved << "\t" <<
+              "Unchanged updates: " << m_numUpdatesSkipped << "\t" <<
+              "Prepared: " << m_numLoadMapsPrepared << "\t" <<
+              "Prepared and used: " << m_numPreparedLoadMapsUsed);
 }
 
 }
@@ -0,0 +1,610 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Registry of the shared memory regions used to communicate with gdb
+//==============================================================================
+#include <cstring>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "AgentConfiguration.h"
+#include "AgentFramedProtocol.h"
+#include "AgentLogging.h"
+#include "AgentSharedMemRegistry.h"
+#include "CommunicationControl.h"
+#include "CommunicationParams.h"
+#include "HSADebugAgent.h"
+
+namespace HwDbgAgent
+{
+
+/// The regions owned by the registry
+static const HsailDebugConfigParam gs_SHARED_MEM_REGIONS[] =
+{
+    HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM,
+    HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM,
+    HSAIL_DEBUG_CONFIG_WAVE_INFO_SHM,
+    HSAIL_DEBUG_CONFIG_ISA_BUFFER_SHM,
+    HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM
+};
+
+/// Round up to a multiple of the page size so the mapping covers the whole object
+static size_t RoundUpToPageSize(const size_t size)
+{
+    long pageSize = sysconf(_SC_PAGESIZE);
+    size_t alignment = (pageSize > 0) ? static_cast<size_t>(pageSize) : 4096;
+
+    return ((size + alignment - 1) / alignment) * alignment;
+}
+
+/// Unit of the size stored at the start of a region in the legacy layout
+static size_t GetLegacySizeUnit(const HsailDebugConfigParam param)
+{
+    switch (param)
+    {
+        case HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM:
+        case HSAIL_DEBUG_CONFIG_ISA_BUFFER_SHM:
+            return 1;
+
+        case HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM:
+            return sizeof(HsailSegmentDescriptor);
+
+        default:
+            // The number of waves is sent with the notification
+            return 0;
+    }
+}
+
+/// Size of the SysV segment of a region, the size the region had before it could grow
+static size_t GetLegacySize(const HsailDebugConfigParam param)
+{
+    switch (param)
+    {
+        case HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM:
+            return g_BINARY_BUFFER_MAXSIZE;
+
+        case HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM:
+            return g_MOMENTARY_BP_BUFFER_MAXSIZE;
+
+        case HSAIL_DEBUG_CONFIG_WAVE_INFO_SHM:
+            return g_WAVE_BUFFER_MAXSIZE;
+
+        case HSAIL_DEBUG_CONFIG_ISA_BUFFER_SHM:
+            return g_ISASTREAM_MAXSIZE;
+
+        case HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM:
+            return g_LOADMAP_MAXSIZE;
+
+        default:
+            return 0;
+    }
+}
+
+/// Check if gdb uses the POSIX objects and reads the regions written by the agent
+/// through a HsailSharedBufferHeader, an older gdb uses the SysV segments
+static bool IsSharedBufferHeaderUsed()
+{
+    return AgentGetGdbProtocolVersion() >= HSAIL_FRAME_PROTOCOL_VERSION_SHARED_BUFFERS;
+}
+
+AgentSharedMemRegistry::AgentSharedMemRegistry():
+    m_regions()
+{
+    for (const HsailDebugConfigParam param : gs_SHARED_MEM_REGIONS)
+    {
+        AgentSharedMemRegion region;
+        region.m_shmKey = -1;
+        region.m_name.clear();
+        region.m_initialSize = 0;
+        region.m_size = 0;
+        region.m_fd = -1;
+        region.m_pShm = nullptr;
+
+        // The momentary breakpoints are the only region written by gdb
+        region.m_hasBufferHeader = (param != HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM);
+
+        region.m_pLegacyShm = nullptr;
+        region.m_legacySize = GetLegacySize(param);
+        region.m_legacySizeUnit = GetLegacySizeUnit(param);
+        region.m_legacyUsedSize = 0;
+        region.m_isLegacyUpdate = false;
+
+        HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+        status = GetActiveAgentConfig()->GetConfigShmKey(param, region.m_shmKey);
+        if (status != HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            AGENT_ERROR("Could not get shared mem key");
+            continue;
+        }
+
+        status = GetActiveAgentConfig()->GetConfigShmSize(param, region.m_initialSize);
+        if (status != HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            AGENT_ERROR("Could not get shared mem initial size");
+            continue;
+        }
+
+        region.m_initialSize = RoundUpToPageSize(region.m_initialSize);
+
+        // The object is named after the debug session so that sessions do not share regions
+        region.m_name = GetActiveAgentConfig()->GetSessionShmName(region.m_shmKey);
+
+        m_regions[param] = region;
+    }
+}
+
+AgentSharedMemRegistry::~AgentSharedMemRegistry()
+{
+    HsailAgentStatus status = UnMapAllRegions();
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("~AgentSharedMemRegistry: Could not free all the shared mem regions");
+    }
+}
+
+HsailAgentStatus AgentSharedMemRegistry::MapRegion(AgentSharedMemRegion& region) const
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (region.m_pShm != nullptr)
+    {
+        // Already attached, nothing to do
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+        return status;
+    }
+
+    const std::string& regionName = region.m_name;
+
+    region.m_fd = shm_open(regionName.c_str(), O_CREAT | O_RDWR, 0666);
+    if (region.m_fd < 0)
+    {
+        int err_no = errno;
+        AGENT_ERROR("MapRegion: Could not create shared mem " << regionName << ", " << strerror(err_no));
+        return status;
+    }
+
+    // A stale object of an earlier run of the same session may be larger, start over
+    if (ftruncate(region.m_fd, region.m_initialSize) != 0)
+    {
+        int err_no = errno;
+        AGENT_ERROR("MapRegion: Could not size shared mem " << regionName << ", " << strerror(err_no));
+        close(region.m_fd);
+        region.m_fd = -1;
+        shm_unlink(regionName.c_str());
+        return status;
+    }
+
+    void* pShm = mmap(nullptr, region.m_initialSize, PROT_READ | PROT_WRITE, MAP_SHARED, region.m_fd, 0);
+    if (pShm == MAP_FAILED)
+    {
+        int err_no = errno;
+        AGENT_ERROR("MapRegion: Could not map shared mem " << regionName << ", " << strerror(err_no));
+        close(region.m_fd);
+        region.m_fd = -1;
+        shm_unlink(regionName.c_str());
+        return status;
+    }
+
+    region.m_pShm = pShm;
+    region.m_size = region.m_initialSize;
+
+    // Start with an empty payload, only the header is written
+    if (region.m_hasBufferHeader && region.m_size >= sizeof(HsailSharedBufferHeader))
+    {
+        HsailSharedBufferHeader* pHeader = static_cast<HsailSharedBufferHeader*>(region.m_pShm);
+        memset(pHeader, 0, sizeof(HsailSharedBufferHeader));
+        pHeader->m_regionSize = region.m_size;
+    }
+
+    status = MapLegacyRegion(region);
+    return status;
+}
+
+HsailAgentStatus AgentSharedMemRegistry::MapLegacyRegion(AgentSharedMemRegion& region) const
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (region.m_pLegacyShm != nullptr)
+    {
+        // Already attached, nothing to do
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+        return status;
+    }
+
+    status = AgentAllocSharedMemBuffer(region.m_shmKey, region.m_legacySize);
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("MapLegacyRegion: Could not allocate shared mem with key " << region.m_shmKey);
+        return status;
+    }
+
+    region.m_pLegacyShm = AgentMapSharedMemBuffer(region.m_shmKey, region.m_legacySize);
+    if (region.m_pLegacyShm == nullptr)
+    {
+        AGENT_ERROR("MapLegacyRegion: Could not attach shared mem with key " << region.m_shmKey);
+        status = HSAIL_AGENT_STATUS_FAILURE;
+        return status;
+    }
+
+    // A stale segment may hold anything, the first update in the legacy layout clears it all
+    region.m_legacyUsedSize = region.m_legacySize;
+
+    return status;
+}
+
+HsailAgentStatus AgentSharedMemRegistry::UnMapLegacyRegion(AgentSharedMemRegion& region) const
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_SUCCESS;
+
+    if (region.m_pLegacyShm == nullptr)
+    {
+        // Never attached, nothing to do
+        return status;
+    }
+
+    status = AgentUnMapSharedMemBuffer(region.m_pLegacyShm);
+    region.m_pLegacyShm = nullptr;
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("UnMapLegacyRegion: Could not detach shared mem with key " << region.m_shmKey);
+    }
+
+    // Remove the segment even if the detach failed, gdb would otherwise find a stale segment
+    if (AgentFreeSharedMemBuffer(region.m_shmKey, region.m_legacySize) != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("UnMapLegacyRegion: Could not free shared mem with key " << region.m_shmKey);
+        status = HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    return status;
+}
+
+HsailAgentStatus AgentSharedMemRegistry::UnMapRegion(AgentSharedMemRegion& region) const
+{
+    HsailAgentStatus status = UnMapLegacyRegion(region);
+
+    if (region.m_pShm == nullptr)
+    {
+        // Never attached, nothing to do
+        return status;
+    }
+
+    if (munmap(region.m_pShm, region.m_size) != 0)
+    {
+        AGENT_ERROR("UnMapRegion: Could not unmap shared mem with key " << region.m_shmKey);
+        status = HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    region.m_pShm = nullptr;
+    region.m_size = 0;
+
+    close(region.m_fd);
+    region.m_fd = -1;
+
+    // Remove the object even if the unmap failed, gdb would otherwise find a stale object
+    const std::string& regionName = region.m_name;
+    if (shm_unlink(regionName.c_str()) != 0)
+    {
+        AGENT_ERROR("UnMapRegion: Could not remove shared mem " << regionName);
+        status = HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    return status;
+}
+
+HsailAgentStatus AgentSharedMemRegistry::ResizeRegion(AgentSharedMemRegion& region, const size_t newSize) const
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (region.m_pShm == nullptr || region.m_fd < 0)
+    {
+        AGENT_ERROR("ResizeRegion: Shared mem with key " << region.m_shmKey << " is not attached");
+        return status;
+    }
+
+    if (newSize > region.m_size && ftruncate(region.m_fd, newSize) != 0)
+    {
+        int err_no = errno;
+        AGENT_ERROR("ResizeRegion: Could not grow shared mem with key " << region.m_shmKey <<
+                    " to " << newSize << " bytes, " << strerror(err_no));
+        return status;
+    }
+
+    // The pages are shared with gdb, so the payload stays in place even if the mapping moves
+    void* pShm = mremap(region.m_pShm, region.m_size, newSize, MREMAP_MAYMOVE);
+    if (pShm == MAP_FAILED)
+    {
+        int err_no = errno;
+        AGENT_ERROR("ResizeRegion: Could not remap shared mem with key " << region.m_shmKey <<
+                    " to " << newSize << " bytes, " << strerror(err_no));
+        return status;
+    }
+
+    AGENT_LOG("ResizeRegion: Shared mem with key " << region.m_shmKey <<
+              " grew from " << region.m_size << " to " << newSize << " bytes");
+
+    region.m_pShm = pShm;
+    region.m_size = newSize;
+
+    status = HSAIL_AGENT_STATUS_SUCCESS;
+    return status;
+}
+
+HsailAgentStatus AgentSharedMemRegistry::MapAllRegions()
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_SUCCESS;
+
+    if (m_regions.size() != sizeof(gs_SHARED_MEM_REGIONS) / sizeof(gs_SHARED_MEM_REGIONS[0]))
+    {
+        AGENT_ERROR("MapAllRegions: The configuration does not describe all the shared mem regions");
+        status = HSAIL_AGENT_STATUS_FAILURE;
+        return status;
+    }
+
+    for (auto& region : m_regions)
+    {
+        if (MapRegion(region.second) != HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            status = HSAIL_AGENT_STATUS_FAILURE;
+        }
+    }
+
+    if (status == HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_LOG("MapAllRegions: Attached " << m_regions.size() << " shared mem regions");
+    }
+
+    return status;
+}
+
+HsailAgentStatus AgentSharedMemRegistry::UnMapAllRegions()
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_SUCCESS;
+
+    for (auto& region : m_regions)
+    {
+        if (UnMapRegion(region.second) != HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            status = HSAIL_AGENT_STATUS_FAILURE;
+        }
+    }
+
+    return status;
+}
+
+void* AgentSharedMemRegistry::GetRegion(const HsailDebugConfigParam region) const
+{
+    std::map<HsailDebugConfigParam, AgentSharedMemRegion>::const_iterator it = m_regions.find(region);
+
+    if (it == m_regions.end() || it->second.m_pShm == nullptr)
+    {
+        AGENT_ERROR("GetRegion: Shared mem region " << region << " is not attached");
+        return nullptr;
+    }
+
+    if (!IsSharedBufferHeaderUsed())
+    {
+        return it->second.m_pLegacyShm;
+    }
+
+    return it->second.m_pShm;
+}
+
+size_t AgentSharedMemRegistry::GetRegionSize(const HsailDebugConfigParam region) const
+{
+    std::map<HsailDebugConfigParam, AgentSharedMemRegion>::const_iterator it = m_regions.find(region);
+
+    if (it == m_regions.end() || it->second.m_pShm == nullptr)
+    {
+        return 0;
+    }
+
+    if (!IsSharedBufferHeaderUsed())
+    {
+        return (it->second.m_pLegacyShm != nullptr) ? it->second.m_legacySize : 0;
+    }
+
+    return it->second.m_size;
+}
+
+HsailAgentStatus AgentSharedMemRegistry::ReserveRegion(AgentSharedMemRegion& region, const size_t payloadSize) const
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (payloadSize > g_SHARED_REGION_GROWTH_LIMIT - sizeof(HsailSharedBufferHeader))
+    {
+        AGENT_ERROR("ReserveRegion: " << payloadSize << " bytes is over the shared mem limit");
+        return status;
+    }
+
+    size_t requiredSize = sizeof(HsailSharedBufferHeader) + payloadSize;
+
+    if (requiredSize <= region.m_size)
+    {
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+        return status;
+    }
+
+    // Grow geometrically so a slowly growing payload does not resize at every update
+    size_t newSize = region.m_size;
+    while (newSize < requiredSize)
+    {
+        newSize *= 2;
+    }
+
+    if (newSize > g_SHARED_REGION_GROWTH_LIMIT)
+    {
+        newSize = g_SHARED_REGION_GROWTH_LIMIT;
+    }
+
+    newSize = RoundUpToPageSize(newSize);
+
+    status = ResizeRegion(region, newSize);
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    // Tell gdb to map the region again, the size is stored before the generation is bumped
+    HsailSharedBufferHeader* pHeader = static_cast<HsailSharedBufferHeader*>(region.m_pShm);
+    __atomic_store_n(&pHeader->m_regionSize, static_cast<uint64_t>(region.m_size), __ATOMIC_RELAXED);
+    __atomic_add_fetch(&pHeader->m_regionGeneration, 1, __ATOMIC_RELEASE);
+
+    return status;
+}
+
+void* AgentSharedMemRegistry::BeginRegionUpdate(const HsailDebugConfigParam region, const size_t payloadSize)
+{
+    std::map<HsailDebugConfigParam, AgentSharedMemRegion>::iterator it = m_regions.find(region);
+
+    if (it == m_regions.end() || it->second.m_pShm == nullptr || !it->second.m_hasBufferHeader)
+    {
+        AGENT_ERROR("BeginRegionUpdate: Shared mem region " << region << " can not be updated");
+        return nullptr;
+    }
+
+    AgentSharedMemRegion& shmRegion = it->second;
+
+    shmRegion.m_isLegacyUpdate = !IsSharedBufferHeaderUsed();
+
+    if (shmRegion.m_isLegacyUpdate)
+    {
+        size_t sizeFieldSize = (shmRegion.m_legacySizeUnit != 0) ? sizeof(size_t) : 0;
+
+        if (shmRegion.m_pLegacyShm == nullptr)
+        {
+            AGENT_ERROR("BeginRegionUpdate: The SysV segment of shared mem region " << region << " is not attached");
+            return nullptr;
+        }
+
+        // An older gdb does not know that a region can grow
+        if (payloadSize > shmRegion.m_legacySize - sizeFieldSize)
+        {
+            AGENT_ERROR("BeginRegionUpdate: " << payloadSize << " bytes do not fit in shared mem region " << region);
+            return nullptr;
+        }
+
+        return static_cast<char*>(shmRegion.m_pLegacyShm) + sizeFieldSize;
+    }
+
+    if (ReserveRegion(shmRegion, payloadSize) != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("BeginRegionUpdate: Could not make room for " << payloadSize << " bytes in shared mem region " << region);
+        return nullptr;
+    }
+
+    if (AgentBeginSharedBufferUpdate(shmRegion.m_pShm) != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        return nullptr;
+    }
+
+    return AgentGetSharedBufferPayload(shmRegion.m_pShm);
+}
+
+bool AgentSharedMemRegistry::IsLegacyRegionUpdate() const
+{
+    return !IsSharedBufferHeaderUsed();
+}
+
+HsailAgentStatus AgentSharedMemRegistry::EndRegionUpdate(const HsailDebugConfigParam region, const size_t payloadSize)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    std::map<HsailDebugConfigParam, AgentSharedMemRegion>::iterator it = m_regions.find(region);
+
+    if (it == m_regions.end() || it->second.m_pShm == nullptr || !it->second.m_hasBufferHeader)
+    {
+        AGENT_ERROR("EndRegionUpdate: Shared mem region " << region << " can not be updated");
+        return status;
+    }
+
+    AgentSharedMemRegion& shmRegion = it->second;
+
+    if (!shmRegion.m_isLegacyUpdate)
+    {
+        status = AgentEndSharedBufferUpdate(shmRegion.m_pShm, payloadSize);
+        return status;
+    }
+
+    char* pRegionBytes = static_cast<char*>(shmRegion.m_pLegacyShm);
+
+    if (pRegionBytes == nullptr)
+    {
+        AGENT_ERROR("EndRegionUpdate: The SysV segment of shared mem region " << region << " is not attached");
+        return status;
+    }
+
+    size_t usedSize = payloadSize;
+
+    if (shmRegion.m_legacySizeUnit != 0)
+    {
+        size_t legacySize = payloadSize / shmRegion.m_legacySizeUnit;
+        memcpy(pRegionBytes, &legacySize, sizeof(size_t));
+        usedSize += sizeof(size_t);
+    }
+
+    // An older gdb expects the bytes past the payload to be zero, only clear what the last update used
+    if (shmRegion.m_legacyUsedSize > usedSize)
+    {
+        memset(pRegionBytes + usedSize, 0, shmRegion.m_legacyUsedSize - usedSize);
+    }
+
+    shmRegion.m_legacyUsedSize = usedSize;
+
+    status = HSAIL_AGENT_STATUS_SUCCESS;
+    return status;
+}
+
+HsailAgentStatus AgentSharedMemRegistry::RefreshRegion(const HsailDebugConfigParam region)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    std::map<HsailDebugConfigParam, AgentSharedMemRegion>::iterator it = m_regions.find(region);
+
+    if (it == m_regions.end() || it->second.m_pShm == nullptr)
+    {
+        AGENT_ERROR("RefreshRegion: Shared mem region " << region << " is not attached");
+        return status;
+    }
+
+    // The SysV segment of an older gdb does not grow
+    if (!IsSharedBufferHeaderUsed())
+    {
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+        return status;
+    }
+
+    struct stat shmStat;
+    if (fstat(it->second.m_fd, &shmStat) != 0)
+    {
+        AGENT_ERROR("RefreshRegion: Could not get the size of shared mem region " << region);
+        return status;
+    }
+
+    size_t objectSize = static_cast<size_t>(shmStat.st_size);
+
+    if (objectSize <= it->second.m_size)
+    {
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+        return status;
+    }
+
+    if (objectSize > g_SHARED_REGION_GROWTH_LIMIT)
+    {
+        AGENT_ERROR("RefreshRegion: Shared mem region " << region << " is over the shared mem limit");
+        return status;
+    }
+
+    status = ResizeRegion(it->second, objectSize);
+    return status;
+}
+
+} // End Namespace HwDbgAgent
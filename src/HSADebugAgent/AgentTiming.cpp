@@ -0,0 +1,204 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Latency histograms of the debug phases
+//==============================================================================
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include "AgentLogging.h"
+#include "AgentTiming.h"
+
+namespace HwDbgAgent
+{
+
+/// One histogram for each AgentTimer, in the same order
+static AgentTimingHistogram gs_TimingHistograms[AGENT_TIMER_COUNT] =
+{
+    {"ISA disassembly"},
+    {"ISA wait"},
+    {"Predispatch"},
+    {"Predispatch BeginDebugging"},
+    {"Predispatch load map"},
+    {"Predispatch binary from DBE"},
+    {"Demangle"},
+    {"Predispatch ISA publication"},
+    {"Predispatch binary notification"},
+    {"Predispatch fifo"},
+    {"Enable PC breakpoints"},
+    {"Debug thread handoff"},
+    {"Debug thread wait for event"},
+    {"Debug thread breakpoint updates"},
+    {"Debug thread continue"},
+    {"Code object ingestion"},
+    {"Predispatch preparation"},
+    {"Predispatch debug engine wait"}
+};
+
+AgentTimingHistogram::AgentTimingHistogram(const char* pName):
+    m_pName(pName),
+    m_numSamples(0),
+    m_totalNs(0),
+    m_maxNs(0),
+    m_totalBytes(0)
+{
+    memset(m_buckets, 0, sizeof(m_buckets));
+}
+
+int AgentTimingHistogram::GetBucketIndex(const uint64_t durationNs)
+{
+    if (durationNs < 4)
+    {
+        return static_cast<int>(durationNs);
+    }
+
+    // The position of the highest bit selects the power of two,
+    // the two bits below it select the bucket within it
+    int highestBit = 63 - __builtin_clzll(durationNs);
+    int subBucket = static_cast<int>((durationNs >> (highestBit - 2)) & 0x3);
+
+    return (highestBit - 1) * 4 + subBucket;
+}
+
+uint64_t AgentTimingHistogram::GetBucketUpperBound(const int bucketIndex)
+{
+    if (bucketIndex < 4)
+    {
+        return static_cast<uint64_t>(bucketIndex);
+    }
+
+    int highestBit = bucketIndex / 4 + 1;
+    uint64_t subBucket = static_cast<uint64_t>(bucketIndex % 4);
+    uint64_t bucketWidth = 1ULL << (highestBit - 2);
+
+    return (4 + subBucket) * bucketWidth + (bucketWidth - 1);
+}
+
+void AgentTimingHistogram::AddSample(const uint64_t durationNs, const size_t numBytes)
+{
+    __atomic_add_fetch(&m_buckets[GetBucketIndex(durationNs)], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&m_numSamples, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&m_totalNs, durationNs, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&m_totalBytes, static_cast<uint64_t>(numBytes), __ATOMIC_RELAXED);
+
+    uint64_t maxNs = __atomic_load_n(&m_maxNs, __ATOMIC_RELAXED);
+
+    while (durationNs > maxNs &&
+           !__atomic_compare_exchange_n(&m_maxNs, &maxNs, durationNs, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+uint64_t AgentTimingHistogram::GetNumSamples() const
+{
+    return __atomic_load_n(&m_numSamples, __ATOMIC_RELAXED);
+}
+
+uint64_t AgentTimingHistogram::GetPercentile(const double percentile) const
+{
+    uint64_t numSamples = GetNumSamples();
+
+    if (numSamples == 0)
+    {
+        return 0;
+    }
+
+    // The rank of the sample at the percentile, counted from 1
+    uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(numSamples) + 0.5);
+
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+
+    uint64_t numSeen = 0;
+
+    for (int i = 0; i < ms_NUM_BUCKETS; i++)
+    {
+        numSeen += __atomic_load_n(&m_buckets[i], __ATOMIC_RELAXED);
+
+        if (numSeen >= rank)
+        {
+            return GetBucketUpperBound(i);
+        }
+    }
+
+    return __atomic_load_n(&m_maxNs, __ATOMIC_RELAXED);
+}
+
+void AgentTimingHistogram::Log() const
+{
+    uint64_t numSamples = GetNumSamples();
+
+    if (numSamples == 0)
+    {
+        return;
+    }
+
+    uint64_t totalNs = __atomic_load_n(&m_totalNs, __ATOMIC_RELAXED);
+    uint64_t totalBytes = __atomic_load_n(&m_totalBytes, __ATOMIC_RELAXED);
+
+    // Bytes per nanosecond is GB/s, the log uses MB/s
+    double throughputMBs = (totalNs > 0) ?
+                           (static_cast<double>(totalBytes) * 1000.0 / static_cast<double>(totalNs)) : 0.0;
+
+    AGENT_LOG("Timing " << m_pName << ": " <<
+              "Samples: " << numSamples << "\t" <<
+              "Mean: " << totalNs / numSamples << "ns\t" <<
+              "p50: <=" << GetPercentile(50.0) << "ns\t" <<
+              "p99: <=" << GetPercentile(99.0) << "ns\t" <<
+              "Max: " << __atomic_load_n(&m_maxNs, __ATOMIC_RELAXED) << "ns\t" <<
+              "Bytes: " << totalBytes << "\t" <<
+              "Throughput: " << throughputMBs << "MB/s");
+}
+
+bool AgentIsTimingEnabled()
+{
+    static const bool s_isEnabled = (std::getenv("ROCM_GDB_DISABLE_TIMING") == nullptr);
+    return s_isEnabled;
+}
+
+uint64_t AgentGetTimestampNs()
+{
+    if (!AgentIsTimingEnabled())
+    {
+        return 0;
+    }
+
+    struct timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    return static_cast<uint64_t>(currentTime.tv_sec) * 1000000000ULL + static_cast<uint64_t>(currentTime.tv_nsec);
+}
+
+void AgentRecordTime(const AgentTimer timer, const uint64_t startNs, const size_t numBytes)
+{
+    if (!AgentIsTimingEnabled())
+    {
+        return;
+    }
+
+    if (timer < 0 || timer >= AGENT_TIMER_COUNT)
+    {
+        AGENT_ERROR("AgentRecordTime: Invalid timer " << timer);
+        return;
+    }
+
+    uint64_t endNs = AgentGetTimestampNs();
+    uint64_t durationNs = (endNs > startNs) ? (endNs - startNs) : 0;
+
+    gs_TimingHistograms[timer].AddSample(durationNs, numBytes);
+}
+
+void AgentLogTimingStatistics()
+{
+    for (int i = 0; i < AGENT_TIMER_COUNT; i++)
+    {
+        gs_TimingHistograms[i].Log();
+    }
+}
+
+} // End Namespace HwDbgAgent
@@ -183,6 +183,21 @@ const std::string GetCommandTypeString(const HsailCommand ipCommand)
         case HSAIL_COMMAND_SET_LOGGING:
             return "HSAIL_COMMAND_CONTINUE";
 
+        case HSAIL_COMMAND_SYNC_MARKER:
+            return "HSAIL_COMMAND_SYNC_MARKER";
+
+        case HSAIL_COMMAND_SET_PROTOCOL:
+            return "HSAIL_COMMAND_SET_PROTOCOL";
+
+        case HSAIL_COMMAND_GET_ISA:
+            return "HSAIL_COMMAND_GET_ISA";
+
+        case HSAIL_COMMAND_SET_KERNEL_FILTER:
+            return "HSAIL_COMMAND_SET_KERNEL_FILTER";
+
+        case HSAIL_COMMAND_LOG_TIMING:
+            return "HSAIL_COMMAND_LOG_TIMING";
+
         default:
             return "[Unknown Command]";
     }
@@ -324,6 +339,30 @@ HsailAgentStatus AgentLoadFileAsSharedObject(const std::string& ipFilename)
     return status;
 }
 
+// FNV-1a, gdb can compute the same hash over the binaries it received
+uint64_t AgentComputeBinaryHash(const void* pBinary, const size_t binarySize)
+{
+    const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+    const uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+    uint64_t hash = FNV_OFFSET_BASIS;
+
+    if (pBinary == nullptr)
+    {
+        return hash;
+    }
+
+    const unsigned char* pBytes = static_cast<const unsigned char*>(pBinary);
+
+    for (size_t i = 0; i < binarySize; i++)
+    {
+        hash ^= pBytes[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
 HsailAgentStatus AgentWriteBinaryToFile(const void*  pBinary, size_t binarySize, const char*  pFilename)
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
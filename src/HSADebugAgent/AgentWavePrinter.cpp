@@ -15,6 +15,7 @@
 #include "AgentConfiguration.h"
 #include "AgentLogging.h"
 #include "AgentNotifyGdb.h"
+#include "AgentSharedMemRegistry.h"
 #include "AgentUtils.h"
 #include "AgentWavePrinter.h"
 #include "CommunicationControl.h"
@@ -81,30 +82,16 @@ bool AgentDbgWavefront::ContainsWorkItem(const int coord[3]) const
     return retVal;
 }
 
-AgentWavePrinter::AgentWavePrinter():
+AgentWavePrinter::AgentWavePrinter(AgentSharedMemRegistry* pSharedMemRegistry):
         m_currentWavefronts(),
         m_DispatchGlobalWorkDimensions(-1), // State is unknown initially
-        m_waveBufferShmKey(-1),
-        m_waveBufferMaxSize(0)
+        m_pSharedMemRegistry(pSharedMemRegistry)
 {
-    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
-    status = GetActiveAgentConfig()->GetConfigShmKey(HSAIL_DEBUG_CONFIG_WAVE_INFO_SHM, m_waveBufferShmKey);
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    if (m_pSharedMemRegistry == nullptr)
     {
-        AGENT_ERROR("Could not get shared mem key");
-        return;
+        AGENT_ERROR("AgentWavePrinter: The shared mem registry is nullptr");
     }
 
-    status = GetActiveAgentConfig()->GetConfigShmSize(HSAIL_DEBUG_CONFIG_WAVE_INFO_SHM, m_waveBufferMaxSize);
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
-    {
-        AGENT_ERROR("Could not get shared mem max size");
-        return;
-    }
-
-    // We create the shared memory for the IPC
-    InitializeWaveInfoShmem();
-
     AGENT_LOG("Initialize AgentWavePrinter");
 }
 
@@ -113,39 +100,8 @@ void AgentWavePrinter::ClearCurrentWavefronts()
     m_currentWavefronts.clear();
 }
 
-HsailAgentStatus AgentWavePrinter::FreeWaveInfoShmem()
-{
-    AGENT_LOG("FreeWaveInfoShmem: Free shared memory buffer");
-
-    HsailAgentStatus status;
-    status = AgentFreeSharedMemBuffer(m_waveBufferShmKey, m_waveBufferMaxSize);
-
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
-    {
-        AGENT_ERROR("FreeWaveInfoShmem: Failed to free shared memory buffer");
-    }
-
-    return status;
-
-}
-
-void AgentWavePrinter::InitializeWaveInfoShmem()
-{
-    AGENT_LOG("InitializeWaveInfoShmem: Initialize wave info shared mem");
-
-    HsailAgentStatus status;
-    status = AgentAllocSharedMemBuffer(m_waveBufferShmKey, m_waveBufferMaxSize);
-
-    if (status != HSAIL_AGENT_STATUS_SUCCESS)
-    {
-        AGENT_ERROR("InitializeWaveInfoShmem: Could not initialize wave info shared mem");
-    }
-
-}
-
 AgentWavePrinter::~AgentWavePrinter()
 {
-    FreeWaveInfoShmem();
 }
 
 HsailAgentStatus AgentWavePrinter::PrintActiveWaves(HwDbgEventType      dbeEventType,
@@ -258,34 +214,29 @@ HsailAgentStatus AgentWavePrinter::SendActiveWavesToGdb(HwDbgEventType      dbeE
         return status;
     }
 
-    // We still map and unmap the shared mem since we want to zero out the buffer
-    void* pShm = AgentMapSharedMemBuffer(m_waveBufferShmKey, m_waveBufferMaxSize);
-
-    if (pShm == (int*) - 1)
+    if (m_pSharedMemRegistry == nullptr)
     {
-        AGENT_ERROR("SendActiveWavesToGdb: Error mapping shared mem");
-        status = HSAIL_AGENT_STATUS_FAILURE;
+        AGENT_ERROR("SendActiveWavesToGdb: The shared mem registry is nullptr");
         return status;
     }
 
-    // First zero the whole region out, we dont know how much of this region will be used
-    // The next update to this logic may be smarter about what is written here
-    memset(pShm, 0, m_waveBufferMaxSize);
-
     AGENT_LOG("No of active waves: " << nWaves );
 
-    if (nWaves*sizeof(HsailAgentWaveInfo) > m_waveBufferMaxSize)
+    // The shared mem region grows if the waves do not fit
+    void* pPayload = m_pSharedMemRegistry->BeginRegionUpdate(HSAIL_DEBUG_CONFIG_WAVE_INFO_SHM,
+                                                             nWaves*sizeof(HsailAgentWaveInfo));
+    if (pPayload == nullptr)
     {
-        AGENT_LOG("Maximum number of waves possible in the wave info buffer "
-                    << m_waveBufferMaxSize/sizeof(HsailAgentWaveInfo));
-
         AGENT_ERROR("Wave info buffer cannot hold all the active waves");
+        status = HSAIL_AGENT_STATUS_FAILURE;
         return status;
     }
 
+    HsailAgentWaveInfo* pWaveBuffer = static_cast<HsailAgentWaveInfo*>(pPayload);
+
     for (size_t i = 0; i < nWaves; i++)
     {
-        HsailAgentWaveInfo* pLocn = (HsailAgentWaveInfo*)pShm + i;
+        HsailAgentWaveInfo* pLocn = pWaveBuffer + i;
         pLocn->waveAddress = pWaveInfo[i].wavefrontAddress;
         pLocn->execMask = pWaveInfo[i].executionMask;
         pLocn->pc = pWaveInfo[i].codeAddress;
@@ -304,10 +255,10 @@ HsailAgentStatus AgentWavePrinter::SendActiveWavesToGdb(HwDbgEventType      dbeE
         }
     }
 
-    status = AgentUnMapSharedMemBuffer(pShm);
+    status = m_pSharedMemRegistry->EndRegionUpdate(HSAIL_DEBUG_CONFIG_WAVE_INFO_SHM, nWaves*sizeof(HsailAgentWaveInfo));
     if (status != HSAIL_AGENT_STATUS_SUCCESS)
     {
-        AGENT_ERROR("Could not unmap the wave info shared memory");
+        AGENT_ERROR("SendActiveWavesToGdb: Could not publish the active waves");
         return status;
     }
 
@@ -6,6 +6,8 @@
 /// \brief Debug thread functions
 //==============================================================================
 #include <cassert>
+#include <ctime>
+#include <poll.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -22,9 +24,12 @@
 #include "AgentBreakpointManager.h"
 #include "AgentContext.h"
 #include "AgentFocusWaveControl.h"
+#include "AgentFramedProtocol.h"
 #include "AgentLogging.h"
 #include "AgentNotifyGdb.h"
 #include "AgentProcessPacket.h"
+#include "AgentQueueContext.h"
+#include "AgentTiming.h"
 #include "AgentUtils.h"
 #include "AgentWavePrinter.h"
 #include "CommandLoop.h"
@@ -42,6 +47,111 @@ static const pthread_t gs_UNKOWN_PTHREAD_HANDLER = UINT64_MAX;
 // the ESRCH code as expected when the handle is not available.
 static pthread_t DebugEventHandler = gs_UNKOWN_PTHREAD_HANDLER;
 
+/// Protects the state of the debug thread below
+static pthread_mutex_t gs_DebugEventThreadMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/// Signaled when a dispatch is handed to the debug thread or the debug thread has to stop
+static pthread_cond_t gs_DebugEventWorkCond = PTHREAD_COND_INITIALIZER;
+
+/// Signaled when the debug thread is done with a dispatch
+static pthread_cond_t gs_DebugEventIdleCond = PTHREAD_COND_INITIALIZER;
+
+/// The arguments of the dispatch handed to the debug thread, till the debug thread takes them
+static DebugEventThreadParams* gs_pPendingDebugThreadArgs = nullptr;
+
+/// True from the time a dispatch is handed to the debug thread till the debug thread is done with it
+static bool gs_IsDebugSessionActive = false;
+
+/// The debug thread is started by the first debugged dispatch and parks between dispatches
+static bool gs_IsDebugEventThreadRunning = false;
+static bool gs_IsDebugEventThreadStopping = false;
+
+/// Number of dispatches the debug thread was handed, only changed with the mutex held
+static uint64_t gs_NumDebugSessions = 0;
+
+/// Bytes read from the fifo that do not make up a whole packet yet.
+/// The fifo is read by the debug thread and by the predispatch callbacks, and
+/// IsGdbCommandPending looks at the decoder from any queue thread, so all of them lock the mutex.
+static AgentCommandStreamDecoder gs_FifoCommandDecoder;
+static pthread_mutex_t gs_FifoCommandDecoderMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/// Get the next packet gdb wrote to the fifo, gdb may write fixed size packets or frames
+/// \param[in]  fd             The read end of the fifo
+/// \param[out] packetOut      The packet
+/// \param[out] frameFieldsOut The fields only a frame carries
+/// \return true if a packet was read
+static bool ReadNextFifoPacket(const int fd, HsailCommandPacket& packetOut, HsailCommandFrameFields& frameFieldsOut)
+{
+    static const size_t gs_FIFO_READ_SIZE = 4096;
+
+    char readBuffer[gs_FIFO_READ_SIZE];
+
+    // The read is held under the lock too, so the bytes of two threads do not interleave in the decoder
+    pthread_mutex_lock(&gs_FifoCommandDecoderMutex);
+
+    bool isPacketRead = gs_FifoCommandDecoder.GetNextPacket(packetOut, frameFieldsOut);
+
+    while (!isPacketRead)
+    {
+        ssize_t bytesRead = read(fd, readBuffer, gs_FIFO_READ_SIZE);
+
+        if (bytesRead < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (bytesRead <= 0)
+        {
+            // Nothing more to read, an incomplete packet stays in the decoder
+            break;
+        }
+
+        gs_FifoCommandDecoder.Append(readBuffer, static_cast<size_t>(bytesRead));
+        isPacketRead = gs_FifoCommandDecoder.GetNextPacket(packetOut, frameFieldsOut);
+    }
+
+    pthread_mutex_unlock(&gs_FifoCommandDecoderMutex);
+
+    return isPacketRead;
+}
+
+bool IsGdbCommandPending()
+{
+    if (!IsCommandRingEmpty())
+    {
+        return true;
+    }
+
+    pthread_mutex_lock(&gs_FifoCommandDecoderMutex);
+    bool isDecoderPending = gs_FifoCommandDecoder.HasPendingBytes();
+    pthread_mutex_unlock(&gs_FifoCommandDecoderMutex);
+
+    if (isDecoderPending)
+    {
+        return true;
+    }
+
+    struct pollfd fifoFd;
+    fifoFd.fd = GetFifoReadEnd();
+    fifoFd.events = POLLIN;
+    fifoFd.revents = 0;
+
+    if (fifoFd.fd <= 0)
+    {
+        return false;
+    }
+
+    int pollStatus = 0;
+
+    do
+    {
+        pollStatus = poll(&fifoFd, 1, 0);
+    }
+    while (pollStatus < 0 && errno == EINTR);
+
+    return (pollStatus > 0 && (fifoFd.revents & POLLIN) != 0);
+}
+
 /// Check if the fifo is empty.
 /// \todo The problem with this function is that there is a side effect
 /// of the data actually getting read, a better way may be to poll the fifo.
@@ -50,10 +160,22 @@ static bool CheckFifoAtEndDebugging(AgentContext* pActiveContext)
     int fd  = GetFifoReadEnd();
 
     HsailCommandPacket incomingPacket;
+    HsailCommandFrameFields frameFields;
+    memset(&frameFields, 0, sizeof(HsailCommandFrameFields));
+
+    bool isPacketRead = false;
 
-    int bytesRead = read(fd, &incomingPacket, sizeof(HsailCommandPacket));
+    // Look at the command ring before the fifo, the same order as RunFifoCommandLoop
+    if (ReadCommandRing(&incomingPacket, 1) == 1)
+    {
+        isPacketRead = true;
+    }
+    else
+    {
+        isPacketRead = ReadNextFifoPacket(fd, incomingPacket, frameFields);
+    }
 
-    if (bytesRead <= 0)
+    if (!isPacketRead)
     {
         AGENT_LOG("CheckFifoAtEndDebugging: Fifo is empty");
         return true;
@@ -64,7 +186,7 @@ static bool CheckFifoAtEndDebugging(AgentContext* pActiveContext)
 
         // We shouldnt process this packet, see function declaration
         // for the reason why we added this
-        AgentProcessPacket(pActiveContext, incomingPacket);
+        AgentProcessPacket(pActiveContext, incomingPacket, frameFields);
 
         // We expect continue debugging packets since you may set a function breakpoint,
         // and then not set a kernel breakpoint, in this case the FIFO should only contain
@@ -90,21 +212,54 @@ void RunFifoCommandLoop(AgentContext* pActiveContext, unsigned int runCount)
     {
         RunFifoCommandLoop(pActiveContext);
 
-        // Sleep for 1ms
-        usleep(1000);
+        // Sleep for up to 1ms, a packet in the command ring wakes us up earlier
+        WaitForCommandRingDoorbell(1000);
     }
 }
 
+/// Process everything gdb wrote to the shared memory command ring.
+/// The packets are copied out in batches, so there is no system call per packet.
+static int RunCommandRingLoop(AgentContext* pActiveContext)
+{
+    static const unsigned int gs_COMMAND_RING_BATCH_SIZE = 16;
+
+    HsailCommandPacket incomingPackets[gs_COMMAND_RING_BATCH_SIZE];
+
+    // The ring only carries fixed size packets
+    HsailCommandFrameFields noFrameFields;
+    memset(&noFrameFields, 0, sizeof(HsailCommandFrameFields));
+    int numPackets = 0;
+    unsigned int numRead = 0;
+
+    do
+    {
+        numRead = ReadCommandRing(incomingPackets, gs_COMMAND_RING_BATCH_SIZE);
+
+        for (unsigned int i = 0; i < numRead; i++)
+        {
+            AgentLogPacketInfo(incomingPackets[i]);
+            AgentProcessPacket(pActiveContext, incomingPackets[i], noFrameFields);
+            ++numPackets;
+        }
+    }
+    while (numRead == gs_COMMAND_RING_BATCH_SIZE);
+
+    return numPackets;
+}
+
 void RunFifoCommandLoop(AgentContext* pActiveContext)
 {
     // Read Fifo descriptor, this should not change once created
     int fd  = GetFifoReadEnd();
     int exitSignal = 0;
-    int numPackets = 0;
+
+    // The command ring is drained first, the fifo stays as the fallback transport
+    int numPackets = RunCommandRingLoop(pActiveContext);
 
     do
     {
         HsailCommandPacket incomingPacket;
+        HsailCommandFrameFields frameFields;
 
         // Read a packet off the fifo
         assert(fd > 0);
@@ -115,9 +270,7 @@ void RunFifoCommandLoop(AgentContext* pActiveContext)
             break;
         }
 
-        int bytesRead = read(fd, &incomingPacket, sizeof(HsailCommandPacket));
-
-        if (bytesRead <= 0)
+        if (!ReadNextFifoPacket(fd, incomingPacket, frameFields))
         {
             //Nothing to read on fifo, exit this loop now
             exitSignal = 1;
@@ -125,7 +278,7 @@ void RunFifoCommandLoop(AgentContext* pActiveContext)
         else
         {
             AgentLogPacketInfo(incomingPacket);
-            AgentProcessPacket(pActiveContext, incomingPacket);
+            AgentProcessPacket(pActiveContext, incomingPacket, frameFields);
             ++numPackets;
         }
     }
@@ -150,46 +303,26 @@ static void CommandLoopStatusCheck(HsailAgentStatus status, const char* msg)
     }
 }
 
-/// Used in the signal interception code to check that the debug thread has completed
+/// Used in the signal interception code to check that the debug thread is done with its dispatch.
+/// The debug thread itself keeps running, parked till the next debugged dispatch
 HsailAgentStatus WaitForDebugThreadCompletion()
 {
-
-    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
     AGENT_LOG("WaitForDebugThreadCompletion: Start waiting for debug thread completion");
 
-    // Do the wait only if a handle was created.
-    if (DebugEventHandler != gs_UNKOWN_PTHREAD_HANDLER)
-    {
-        int pthreadStatus =  pthread_join(DebugEventHandler, nullptr);
+    pthread_mutex_lock(&gs_DebugEventThreadMutex);
 
-        AGENT_LOG("WaitForDebugThreadCompletion: Finished waiting for debug thread completion");
+    // Nothing to wait for if we went past a dispatch without setting or hitting
+    // a breakpoint, or if no dispatch was debugged yet
+    while (gs_IsDebugSessionActive)
+    {
+        pthread_cond_wait(&gs_DebugEventIdleCond, &gs_DebugEventThreadMutex);
+    }
 
-        // ESRCH is reasonable since we can call BeginDebugging
-        // and then call enddebugging, without starting the debug thread
-        // This case could come up if we went pass a HSAIL dispatch without setting or hitting
-        // the function breakpoint.
-        //
-        // ESRCH can also come up when we are in predispatchcallback for the first time
-        // and haven't yet started the debug thread
-        if (pthreadStatus == 0 || pthreadStatus == ESRCH)
-        {
-            status = HSAIL_AGENT_STATUS_SUCCESS;
-        }
-        else
-        {
-            AGENT_ERROR("WaitForDebugThreadCompletion: pthread_join error: " << pthreadStatus);
+    pthread_mutex_unlock(&gs_DebugEventThreadMutex);
 
-        }
+    AGENT_LOG("WaitForDebugThreadCompletion: Finished waiting for debug thread completion");
 
-        AGENT_LOG("WaitForDebugThreadCompletion: pthread_join returned: " << pthreadStatus);
-    }
-    else
-    {
-        AGENT_LOG("WaitForDebugThreadCompletion: Debug thread handle not initialized, skip pthread_join()");
-
-        status = HSAIL_AGENT_STATUS_SUCCESS;
-    }
-    return status;
+    return HSAIL_AGENT_STATUS_SUCCESS;
 }
 
 static HsailAgentStatus PostBreakpointEventUpdates(AgentContext*    pActiveContext,
@@ -267,6 +400,8 @@ static HsailAgentStatus PostBreakpointEventUpdates(AgentContext*    pActiveConte
     status = bpManager->ClearMomentaryBreakpoints(pActiveContext->GetActiveHwDebugContext());
     CommandLoopStatusCheck(status, "Error: ClearMomentaryBreakpoints");
 
+    AgentSetActiveBreakpoints(*bpManager);
+
     AGENT_LOG("PostBreakpointEventUpdates: Exit PostBreakpointEventUpdates");
 
     return status;
@@ -295,37 +430,172 @@ static int CheckTimeoutCount()
     return exitSignal;
 }
 
-// This function is similar to CheckTimeout count with the additional role
-// of checking the parent status by comparing parent PIDs
-static HsailParentStatus CheckParentStatus(const AgentContext* pActiveContext)
+/// Length of a single wait for gdb in the debug thread
+static const int gs_GDB_WAIT_SLICE_MS = 100;
+
+/// Number of wait slices without a continue packet before the debug thread gives up.
+/// Slices are counted instead of wall clock time since the process spends the time
+/// the user sits at a breakpoint stopped by ptrace.
+static const int gs_GDB_WAIT_MAX_SLICES = 100;
+
+/// Time gdb gets to answer a sync request once it is known to send sync markers
+static const int gs_SYNC_MARKER_TIMEOUT_MS = 1000;
+
+/// Longest time a frame gdb only sends through the fifo waits while the thread sleeps on the
+/// command ring doorbell, for a gdb that does not ring the doorbell after writing to the fifo
+static const unsigned int gs_FIFO_CHECK_SLICE_US = 10000;
+
+// Block till gdb sends something, the parent exits or the timeout expires.
+// The thread sleeps in poll() on the fifo and the parent's pidfd, or on the
+// command ring doorbell once gdb uses the ring, so it uses no CPU while idle.
+// The framed commands still come through the fifo when gdb uses the ring, so the
+// fifo is polled on every wake-up of the doorbell.
+static HsailParentStatus WaitForGdbCommands(const AgentContext* pActiveContext, const int timeoutMs)
 {
-    HsailParentStatus parentStatus;
+    HsailParentStatus parentStatus = HSAIL_PARENT_STATUS_GOOD;
+
+    struct pollfd waitFds[2];
+    nfds_t numWaitFds = 0;
+    int fifoIndex = -1;
+    int parentIndex = -1;
 
-    static const int maxCheckCount = 10000;
-    static int checkCount = 0;
+    int fifoFd = GetFifoReadEnd();
+
+    if (fifoFd > 0)
+    {
+        fifoIndex = numWaitFds;
+        waitFds[numWaitFds].fd = fifoFd;
+        waitFds[numWaitFds].events = POLLIN;
+        waitFds[numWaitFds].revents = 0;
+        numWaitFds++;
+    }
 
-    checkCount ++;
+    if (pActiveContext->GetParentPidFd() >= 0)
+    {
+        parentIndex = numWaitFds;
+        waitFds[numWaitFds].fd = pActiveContext->GetParentPidFd();
+        waitFds[numWaitFds].events = POLLIN;
+        waitFds[numWaitFds].revents = 0;
+        numWaitFds++;
+    }
 
-    if (checkCount < maxCheckCount)
+    if (IsCommandRingInUse())
     {
-        if (pActiveContext->CompareParentPID())
+        unsigned int remainingUs = static_cast<unsigned int>(timeoutMs) * 1000;
+
+        while (true)
         {
-            parentStatus = HSAIL_PARENT_STATUS_GOOD;
+            // Only check the descriptors, the doorbell does the waiting
+            int pollStatus = (numWaitFds != 0) ? poll(waitFds, numWaitFds, 0) : 0;
+
+            if (pollStatus != 0 || !IsCommandRingEmpty() || remainingUs == 0)
+            {
+                break;
+            }
+
+            unsigned int sliceUs = (remainingUs < gs_FIFO_CHECK_SLICE_US) ? remainingUs : gs_FIFO_CHECK_SLICE_US;
+
+            WaitForCommandRingDoorbell(sliceUs);
+            remainingUs -= sliceUs;
         }
-        else
+    }
+    else
+    {
+        int pollStatus = poll(waitFds, numWaitFds, timeoutMs);
+
+        if (pollStatus < 0 && errno != EINTR)
         {
+            AGENT_ERROR("WaitForGdbCommands: poll failed, errno: " << errno);
+        }
+    }
+
+    // The write end is held by gdb for the whole session, a hang up means gdb is gone
+    if (fifoIndex >= 0 &&
+        (waitFds[fifoIndex].revents & (POLLHUP | POLLERR)) != 0 &&
+        (waitFds[fifoIndex].revents & POLLIN) == 0)
+    {
+        AGENT_LOG("WaitForGdbCommands: gdb closed the command fifo");
+        parentStatus = HSAIL_PARENT_STATUS_TERMINATED;
+        return parentStatus;
+    }
+
+    if (parentIndex >= 0)
+    {
+        if ((waitFds[parentIndex].revents & POLLIN) != 0)
+        {
+            AGENT_ERROR("WaitForGdbCommands: The parent of the HSA application has exited");
             parentStatus = HSAIL_PARENT_STATUS_TERMINATED;
         }
     }
-    else
+    else if (!pActiveContext->CompareParentPID())
     {
-        parentStatus = HSAIL_PARENT_STATUS_CHECK_COUNT_MAX;
-        checkCount = 0;
+        parentStatus = HSAIL_PARENT_STATUS_TERMINATED;
     }
 
     return parentStatus;
 }
 
+void RunFifoCommandLoopTillSync(AgentContext* pActiveContext, unsigned int runCount)
+{
+    // The marker carries the sync id in a frame, a gdb that does not send frames
+    // does not know the request either and keeps the previous fixed wait of runCount ms
+    if (AgentGetGdbProtocolVersion() == 0)
+    {
+        RunFifoCommandLoop(pActiveContext, runCount);
+        return;
+    }
+
+    static uint64_t s_syncId = 0;
+    s_syncId++;
+
+    // A gdb may not answer the first request yet, it gets the fixed wait of runCount ms.
+    // Once gdb has answered a sync request we know the marker will come.
+    const bool isSyncSupported = (pActiveContext->m_LastSyncMarkerId != 0);
+    const unsigned int maxWaitMs = isSyncSupported ? gs_SYNC_MARKER_TIMEOUT_MS : runCount;
+
+    HsailAgentStatus status = AgentNotifySyncRequest(s_syncId);
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("RunFifoCommandLoopTillSync: Could not send the sync request");
+    }
+
+    struct timespec startTime;
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+    RunFifoCommandLoop(pActiveContext);
+
+    while (pActiveContext->m_LastSyncMarkerId < s_syncId)
+    {
+        struct timespec currentTime;
+        clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+        int64_t elapsedMs = (currentTime.tv_sec - startTime.tv_sec) * 1000 +
+                            (currentTime.tv_nsec - startTime.tv_nsec) / 1000000;
+
+        if (elapsedMs >= maxWaitMs)
+        {
+            if (isSyncSupported)
+            {
+                AGENT_WARNING("RunFifoCommandLoopTillSync: No sync marker for request " << s_syncId <<
+                              " after " << elapsedMs << "ms");
+            }
+
+            break;
+        }
+
+        if (WaitForGdbCommands(pActiveContext, static_cast<int>(maxWaitMs - elapsedMs)) != HSAIL_PARENT_STATUS_GOOD)
+        {
+            break;
+        }
+
+        RunFifoCommandLoop(pActiveContext);
+    }
+
+    AGENT_LOG("RunFifoCommandLoopTillSync: Sync request " << s_syncId <<
+              ", last marker " << pActiveContext->m_LastSyncMarkerId);
+}
+
 /// GDB will install a breakpoint on this function that will be used when
 /// a GPU kernel breakpoint is hit.
 /// It is defined as extern C to facilitate the name lookup by GDB. This
@@ -341,8 +611,8 @@ extern "C"
     }
 }
 
-/// The DebugEvent loop is run as a separate thread.
-/// It is launched from the predispatch callback.
+/// The DebugEvent loop of a dispatch, run by the debug thread.
+/// The dispatch is handed over from the predispatch callback.
 /// The predispatch callback will have created a breakpoint, so we can
 /// guarantee that the first pActiveContext->WaitForEvent call will hit
 void* DebugEventThread(void* pArgs)
@@ -352,8 +622,8 @@ void* DebugEventThread(void* pArgs)
     {
         AGENT_ERROR("DebugEventThread: pArgs is nullptr");
 
-        // Exit the pthread
-        pthread_exit(nullptr);
+        // Go back to the debug thread loop
+        return nullptr;
     }
 
     // Get the parameter structure and then  dig out the active context from the threadParams
@@ -367,8 +637,8 @@ void* DebugEventThread(void* pArgs)
     {
         AGENT_ERROR("DebugEventThread: pActivecontext is nullptr");
 
-        // Exit the pthread
-        pthread_exit(nullptr);
+        // Go back to the debug thread loop
+        return nullptr;
 
     }
 
@@ -376,8 +646,8 @@ void* DebugEventThread(void* pArgs)
     {
         AGENT_ERROR("DebugEventThread: Cannot enter DebugEventThread without BeginDebugging");
 
-        // Exit the pthread
-        pthread_exit(nullptr);
+        // Go back to the debug thread loop
+        return nullptr;
 
     }
 
@@ -389,8 +659,8 @@ void* DebugEventThread(void* pArgs)
     {
         AGENT_ERROR("DebugEventThread: pWavePrinter or pBPManager is nullptr");
 
-        // Exit the pthread since something is messed up.
-        pthread_exit(nullptr);
+        // Go back to the debug thread loop since something is messed up.
+        return nullptr;
     }
 
     AgentNotifyDebugThreadID();
@@ -406,7 +676,9 @@ void* DebugEventThread(void* pArgs)
         HwDbgEventType dbeEventType = HWDBG_EVENT_INVALID;
 
         // A blocking wait
+        uint64_t phaseStartNs = AgentGetTimestampNs();
         HsailAgentStatus waitStatus = pActiveContext->WaitForEvent(&dbeEventType);
+        AgentRecordTime(AGENT_TIMER_WAIT_FOR_EVENT, phaseStartNs, 0);
 
         if (waitStatus == HSAIL_AGENT_STATUS_FAILURE)
         {
@@ -422,10 +694,18 @@ void* DebugEventThread(void* pArgs)
         {
             // Do all the necessary updates for post breakpoint
             // Check if we want to stop
+            // The waves, focus and breakpoint notifications for this stop go out together.
+            // When we stop, the trigger before TriggerGPUBreakpointStop wakes up gdb.
             bool isStopNeeded = false;
+            AgentBeginNotificationBatch();
+            phaseStartNs = AgentGetTimestampNs();
             status = PostBreakpointEventUpdates(pActiveContext, dbeEventType, &isStopNeeded);
+            AgentRecordTime(AGENT_TIMER_BREAKPOINT_UPDATES, phaseStartNs, 0);
             CommandLoopStatusCheck(status, "Error: Post Breakpoint event updates");
 
+            status = AgentEndNotificationBatch(!isStopNeeded);
+            CommandLoopStatusCheck(status, "Error: Flushing the breakpoint notifications");
+
             if (isStopNeeded)
             {
                  // Hand control to GDB
@@ -436,6 +716,10 @@ void* DebugEventThread(void* pArgs)
                  // has been hit.
                  /// HSADBG-690, add an extra AgentTriggerGDBEventLoop() call before
                  ///             triggering GPU breakpoint so that gdb won't miss.
+                 // gdb reads the ISA when it is stopped, wait for its disassembly now
+                 status = pActiveContext->PublishKernelBinaryISA();
+                 CommandLoopStatusCheck(status, "Error: Publishing the ISA");
+
                  AgentTriggerGDBEventLoop();
                  TriggerGPUBreakpointStop();
                  AgentTriggerGDBEventLoop();
@@ -500,15 +784,16 @@ void* DebugEventThread(void* pArgs)
         AGENT_LOG("Spin till we get a Continue Packet from FIFO, " <<
                   "Context Ready to Continue bit = " << pActiveContext->m_ReadyToContinue);
 
-        // We spin below to ensure that the "continue" packet has come through.
+        // We wait below to ensure that the "continue" packet has come through.
         // Till the continue packet comes through, we are doing something else
         // like expression evaluation or stepping on the host side.
         //
         // Just because a packet has been seen sent by gdb, doesn't mean that
-        // the agent will see it instantly and thats why we spin reading the FIFO
+        // the agent will see it instantly and thats why we keep reading the FIFO
+        // every time the wait returns
         //
-        // As part of this interaction we also check the parent's status continuously.
-        // If we get a timeout, that means the check has been done way too many times
+        // As part of this interaction we also check the parent's status.
+        // If we get a timeout, that means the wait has expired way too many times
         // The only reason why this limit is there is because
         // we don't want this to become an infinite loop if something goes wrong
         // on the gdb side
@@ -517,20 +802,28 @@ void* DebugEventThread(void* pArgs)
         //
         // Note: even if the debug thread is not in focus or we are stepping on the
         // host side, the continue packet will be sent by continue_command() in gdb
-        HsailParentStatus parentStatus = HSAIL_PARENT_STATUS_UNKNOWN;
+        HsailParentStatus parentStatus = HSAIL_PARENT_STATUS_GOOD;
+        int waitSliceCount = 0;
+
+        RunFifoCommandLoop(pActiveContext);
 
-        do
+        while ((pActiveContext->m_ReadyToContinue == false) &&
+               (parentStatus == HSAIL_PARENT_STATUS_GOOD))
         {
-            RunFifoCommandLoop(pActiveContext);
-            parentStatus = CheckParentStatus(pActiveContext);
+            if (waitSliceCount >= gs_GDB_WAIT_MAX_SLICES)
+            {
+                parentStatus = HSAIL_PARENT_STATUS_CHECK_COUNT_MAX;
+                break;
+            }
 
+            waitSliceCount++;
+            parentStatus = WaitForGdbCommands(pActiveContext, gs_GDB_WAIT_SLICE_MS);
+            RunFifoCommandLoop(pActiveContext);
         }
-        while ((pActiveContext->m_ReadyToContinue == false) &&
-               (parentStatus == HSAIL_PARENT_STATUS_GOOD));
 
         if (parentStatus == HSAIL_PARENT_STATUS_CHECK_COUNT_MAX)
         {
-            AGENT_LOG("Debug thread read the FIFO till the max count\t" <<
+            AGENT_LOG("Debug thread waited for the FIFO till the max count\t" <<
                       "AgentContext state: " <<
                       pActiveContext->GetAgentStateString() << "\t"
                       "DBE event: " << GetDBEEventString(dbeEventType));
@@ -568,7 +861,9 @@ void* DebugEventThread(void* pArgs)
         if (pActiveContext->m_ReadyToContinue == true &&
             waitStatus == HSAIL_AGENT_STATUS_SUCCESS)
         {
+            phaseStartNs = AgentGetTimestampNs();
             status = pActiveContext->ContinueDebugging();
+            AgentRecordTime(AGENT_TIMER_CONTINUE, phaseStartNs, 0);
             CommandLoopStatusCheck(status, "Error: ContinueDebugging");
 
             AGENT_LOG("Call ContinueDebugging from HwDbgWaitForEvent");
@@ -608,20 +903,82 @@ void* DebugEventThread(void* pArgs)
     // predispatch callback
     delete pthreadParams;
 
-    AGENT_LOG("DebugEventThread: Exit debug event thread");
+    AGENT_LOG("DebugEventThread: Done with the dispatch, the debug thread parks");
 
-    // Exit the pthread
-    // We dont need to use  in the end Since it is called implicitly by any
-    // thread that is not the main thread
-    // Seems to cause a SIGABRT
-    //pthread_exit(nullptr);
     return nullptr;
 
 }
 
-// This function creates the debug thread that will wait for the debug event from the DBE
+/// End the debug session of a dispatch: the next predispatch callback may go on and
+/// so may the dispatches waiting for the debug engine. Also run if the thread calls pthread_exit
+static void EndDebugSession(void* pArgs)
+{
+    pthread_mutex_lock(&gs_DebugEventThreadMutex);
+    gs_IsDebugSessionActive = false;
+    pthread_cond_broadcast(&gs_DebugEventIdleCond);
+    pthread_mutex_unlock(&gs_DebugEventThreadMutex);
+
+    AgentReleaseDebugEngine();
+}
+
+/// Mark the debug thread as gone, a dispatch handed to it but not taken yet is dropped
+static void MarkDebugEventThreadExited(void* pArgs)
+{
+    pthread_mutex_lock(&gs_DebugEventThreadMutex);
+
+    gs_IsDebugEventThreadRunning = false;
+
+    DebugEventThreadParams* pDroppedArgs = gs_pPendingDebugThreadArgs;
+    gs_pPendingDebugThreadArgs = nullptr;
+
+    pthread_mutex_unlock(&gs_DebugEventThreadMutex);
+
+    if (pDroppedArgs != nullptr)
+    {
+        AGENT_ERROR("MarkDebugEventThreadExited: The debug thread exited before taking its dispatch");
+        delete pDroppedArgs;
+        EndDebugSession(nullptr);
+    }
+}
+
+/// The debug thread: parks till a dispatch is handed to it and runs DebugEventThread for it
+static void* DebugEventThreadMain(void* pArgs)
+{
+    pthread_cleanup_push(MarkDebugEventThreadExited, nullptr);
+
+    pthread_mutex_lock(&gs_DebugEventThreadMutex);
+
+    while (!gs_IsDebugEventThreadStopping)
+    {
+        if (gs_pPendingDebugThreadArgs == nullptr)
+        {
+            pthread_cond_wait(&gs_DebugEventWorkCond, &gs_DebugEventThreadMutex);
+            continue;
+        }
+
+        DebugEventThreadParams* pDebugThreadArgs = gs_pPendingDebugThreadArgs;
+        gs_pPendingDebugThreadArgs = nullptr;
+
+        pthread_mutex_unlock(&gs_DebugEventThreadMutex);
+
+        pthread_cleanup_push(EndDebugSession, nullptr);
+        DebugEventThread(pDebugThreadArgs);
+        pthread_cleanup_pop(1);
+
+        pthread_mutex_lock(&gs_DebugEventThreadMutex);
+    }
+
+    pthread_mutex_unlock(&gs_DebugEventThreadMutex);
+
+    pthread_cleanup_pop(1);
+
+    return nullptr;
+}
+
+// This function hands a dispatch to the debug thread that will wait for the debug event from the DBE.
+// The debug thread is created by the first call and parks between the dispatches.
 // The function is called from the predispatch callback.
-// \params Input arguments
+// \params Input arguments, the debug thread deletes them
 HsailAgentStatus CreateDebugEventThread(DebugEventThreadParams* pArgs)
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
@@ -629,22 +986,86 @@ HsailAgentStatus CreateDebugEventThread(DebugEventThreadParams* pArgs)
     if (pArgs == nullptr)
     {
         AGENT_ERROR("CreateDebugEventThread: pArgs cannot be nullptr");
+        return status;
     }
-    else
+
+    // The debug thread holds the debug engine of the predispatch callback till it is done with the dispatch
+    AgentRetainDebugEngine();
+
+    pthread_mutex_lock(&gs_DebugEventThreadMutex);
+
+    if (!gs_IsDebugEventThreadRunning)
     {
-        int retCode ;
-        retCode = pthread_create(&DebugEventHandler, nullptr, DebugEventThread, (void*) pArgs);
+        // Reap a debug thread that exited on its own
+        if (DebugEventHandler != gs_UNKOWN_PTHREAD_HANDLER)
+        {
+            pthread_join(DebugEventHandler, nullptr);
+            DebugEventHandler = gs_UNKOWN_PTHREAD_HANDLER;
+        }
+
+        gs_IsDebugEventThreadStopping = false;
+
+        int retCode = pthread_create(&DebugEventHandler, nullptr, DebugEventThreadMain, nullptr);
 
         if (retCode != 0)
         {
             AGENT_ERROR("Could not create DebugEventThread");
+            DebugEventHandler = gs_UNKOWN_PTHREAD_HANDLER;
         }
         else
         {
-            status = HSAIL_AGENT_STATUS_SUCCESS;
+            gs_IsDebugEventThreadRunning = true;
+        }
+    }
+
+    if (gs_IsDebugEventThreadRunning)
+    {
+        gs_pPendingDebugThreadArgs = pArgs;
+        gs_IsDebugSessionActive = true;
+        gs_NumDebugSessions++;
+        pthread_cond_signal(&gs_DebugEventWorkCond);
+
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+    }
+
+    pthread_mutex_unlock(&gs_DebugEventThreadMutex);
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        delete pArgs;
+        AgentReleaseDebugEngine();
+    }
+
+    return status;
+}
+
+HsailAgentStatus StopDebugEventThread()
+{
+    HsailAgentStatus status = WaitForDebugThreadCompletion();
+
+    pthread_mutex_lock(&gs_DebugEventThreadMutex);
+
+    pthread_t debugEventHandler = DebugEventHandler;
+    DebugEventHandler = gs_UNKOWN_PTHREAD_HANDLER;
+
+    gs_IsDebugEventThreadStopping = true;
+    pthread_cond_signal(&gs_DebugEventWorkCond);
+
+    pthread_mutex_unlock(&gs_DebugEventThreadMutex);
+
+    if (debugEventHandler != gs_UNKOWN_PTHREAD_HANDLER)
+    {
+        int pthreadStatus = pthread_join(debugEventHandler, nullptr);
+
+        if (pthreadStatus != 0)
+        {
+            AGENT_ERROR("StopDebugEventThread: pthread_join error: " << pthreadStatus);
+            status = HSAIL_AGENT_STATUS_FAILURE;
         }
     }
 
+    AGENT_LOG("StopDebugEventThread: The debug thread was handed " << gs_NumDebugSessions << " dispatches");
+
     return status;
 }
 }
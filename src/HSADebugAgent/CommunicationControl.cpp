@@ -16,16 +16,25 @@
 #include <sys/stat.h>
 #include <errno.h>
 
+// Headers for the command ring doorbell
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+
 // Regular headers
 #include <stdlib.h>
 #include <fcntl.h>
+#include <atomic>
 #include <cassert>
+#include <cstring>
 #include <iostream>
 
+#include "AgentConfiguration.h"
 #include "AgentLogging.h"
 #include "AgentUtils.h"
 #include "CommunicationControl.h"
 #include "CommunicationParams.h"
+#include "HSADebugAgent.h"
 
 /// The descriptor for the read end of the fifo
 /// The constant could be moved to the CommunicationParams header but it is not since
@@ -34,43 +43,67 @@
 static int gs_FIFO_READ_DESC = 0;
 static int gs_FIFO_WRITE_DESC = 0;
 
+/// The shared memory command ring, nullptr if it could not be created
+static HsailCommandRingHeader* gs_pCOMMAND_RING = nullptr;
+static key_t gs_COMMAND_RING_SHMKEY = 0;
+static size_t gs_COMMAND_RING_SHMSIZE = 0;
+
+/// The number of keys tried for the command ring, the session key is taken by another process
+/// if the session IDs of two sessions have the same 15 bit hash
+static const unsigned int gs_COMMAND_RING_KEY_PROBES = 16;
+
+
+/// Scope a fifo name to the debug session, so that sessions on one machine do not share fifos
+static std::string GetSessionFifoName(const char* pBaseName)
+{
+    HwDbgAgent::AgentConfiguration* pConfig = GetActiveAgentConfig();
+
+    if (pConfig == nullptr)
+    {
+        return std::string(pBaseName);
+    }
+
+    return pConfig->GetSessionFileName(pBaseName);
+}
 
 /// This function creates both the communication FIFOs that will be used
-/// \todo make FIFO naming randomly generated, use some combination of date and time
-/// FIFO naming is shown below:
+/// FIFO naming is shown below, the names get a -<session ID> suffix in a debug session:
 /// Data flow Direction     Filename
 /// agent <-- gdb           fifo-gdb-w-agent-r
 /// agent --> gdb           fifo-agent-w-gdb-r
 HsailAgentStatus CreateCommunicationFifos()
 {
-    int status = mkfifo(gs_GdbToAgentFifoName, g_FIFO_PERMISSIONS);
+    std::string gdbToAgentFifoName = GetSessionFifoName(gs_GdbToAgentFifoName);
+    std::string agentToGdbFifoName = GetSessionFifoName(gs_AgentToGdbFifoName);
+
+    int status = mkfifo(gdbToAgentFifoName.c_str(), g_FIFO_PERMISSIONS);
     int errno_value = errno;
 
     if (status != 0)
     {
         if (errno_value == EEXIST)
         {
-            AGENT_LOG("FIFO " <<  gs_GdbToAgentFifoName << " already exists");
+            AGENT_LOG("FIFO " <<  gdbToAgentFifoName << " already exists");
         }
         else
         {
-            AGENT_ERROR("Error creating FIFO " <<  gs_GdbToAgentFifoName);
+            AGENT_ERROR("Error creating FIFO " <<  gdbToAgentFifoName);
             return HSAIL_AGENT_STATUS_FAILURE;
         }
     }
 
-    status = mkfifo(gs_AgentToGdbFifoName, g_FIFO_PERMISSIONS);
+    status = mkfifo(agentToGdbFifoName.c_str(), g_FIFO_PERMISSIONS);
     errno_value = errno;
 
     if (status != 0)
     {
         if (errno_value == EEXIST)
         {
-            AGENT_LOG("FIFO " <<  gs_AgentToGdbFifoName << " already exists");
+            AGENT_LOG("FIFO " <<  agentToGdbFifoName << " already exists");
         }
         else
         {
-            AGENT_ERROR("Error creating FIFO " <<  gs_AgentToGdbFifoName);
+            AGENT_ERROR("Error creating FIFO " <<  agentToGdbFifoName);
             return HSAIL_AGENT_STATUS_FAILURE;
         }
 
@@ -91,7 +124,7 @@ HsailAgentStatus InitFifoReadEnd()
     // Open fifo,  make this blocking ?
     // This was the old call fd = open("fifo", O_RDONLY|O_NONBLOCK);
     // The Agent will read this fifo for things to do from GDB
-    gs_FIFO_READ_DESC = open(gs_GdbToAgentFifoName, O_RDONLY | O_NONBLOCK);
+    gs_FIFO_READ_DESC = open(GetSessionFifoName(gs_GdbToAgentFifoName).c_str(), O_RDONLY | O_NONBLOCK);
 
     if (gs_FIFO_READ_DESC <= 0)
     {
@@ -123,7 +156,7 @@ HsailAgentStatus InitFifoWriteEnd()
     gs_FIFO_WRITE_DESC = -1;
 
     AGENT_LOG("Opening FIFO GDB  <== Agent");
-    gs_FIFO_WRITE_DESC = open(gs_AgentToGdbFifoName, O_WRONLY);
+    gs_FIFO_WRITE_DESC = open(GetSessionFifoName(gs_AgentToGdbFifoName).c_str(), O_WRONLY);
 
     if (gs_FIFO_WRITE_DESC <= 0)
     {
@@ -135,6 +168,265 @@ HsailAgentStatus InitFifoWriteEnd()
     return HSAIL_AGENT_STATUS_SUCCESS ;
 }
 
+/// The ring lives in process shared memory, so the futex can not be a private futex
+static long AgentFutex(uint32_t* pWord, const int op, const uint32_t value, const struct timespec* pTimeout)
+{
+    return syscall(SYS_futex, pWord, op, value, pTimeout, nullptr, 0);
+}
+
+/// Packet slots of the command ring start right after the header
+static HsailCommandPacket* GetCommandRingSlots(HsailCommandRingHeader* pRing)
+{
+    return reinterpret_cast<HsailCommandPacket*>(pRing + 1);
+}
+
+/// The key of the probe-th attempt to create the command ring, only the session hash bits change
+static key_t GetCommandRingProbeKey(const key_t shmkey, const unsigned int probe)
+{
+    const uint32_t sessionBits = ((static_cast<uint32_t>(shmkey) >> 16) + probe) & 0x7FFF;
+
+    return static_cast<key_t>((static_cast<uint32_t>(shmkey) & 0xFFFF) | (sessionBits << 16));
+}
+
+/// Create a SysV shared memory segment that no other process has, the key of a segment
+/// left over by a previous session or used by another session is skipped
+/// \param[in]  shmkey     The key of the first attempt
+/// \param[in]  maxShmSize The size of the segment
+/// \param[out] shmKeyOut  The key of the created segment
+/// \return HSAIL agent status
+static HsailAgentStatus CreateCommandRingSegment(const key_t shmkey, const size_t maxShmSize, key_t& shmKeyOut)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    for (unsigned int probe = 0; probe < gs_COMMAND_RING_KEY_PROBES; probe++)
+    {
+        const key_t key = GetCommandRingProbeKey(shmkey, probe);
+
+        if (key == IPC_PRIVATE)
+        {
+            continue;
+        }
+
+        int shmid = shmget(key, maxShmSize, IPC_CREAT | IPC_EXCL | 0666);
+
+        if (shmid >= 0)
+        {
+            shmKeyOut = key;
+            status = HSAIL_AGENT_STATUS_SUCCESS;
+            return status;
+        }
+
+        if (errno != EEXIST)
+        {
+            AGENT_ERROR("CreateCommandRingSegment: Error with shmget, key " << key << ": " << strerror(errno));
+            return status;
+        }
+
+        AGENT_LOG("CreateCommandRingSegment: Key " << key << " is taken, trying the next one");
+    }
+
+    AGENT_ERROR("CreateCommandRingSegment: The " << gs_COMMAND_RING_KEY_PROBES << " keys from " <<
+                shmkey << " are taken");
+
+    return status;
+}
+
+HsailAgentStatus InitCommandRing(const key_t shmkey, const size_t maxShmSize)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (gs_pCOMMAND_RING != nullptr)
+    {
+        AGENT_LOG("InitCommandRing: Command ring already initialized");
+        status = HSAIL_AGENT_STATUS_SUCCESS;
+        return status;
+    }
+
+    // Largest power of 2 number of slots that fit after the header
+    uint32_t capacity = 0;
+    if (maxShmSize > sizeof(HsailCommandRingHeader))
+    {
+        size_t maxSlots = (maxShmSize - sizeof(HsailCommandRingHeader)) / sizeof(HsailCommandPacket);
+        capacity = 1;
+
+        while (capacity * 2 <= maxSlots)
+        {
+            capacity *= 2;
+        }
+
+        if (capacity > maxSlots)
+        {
+            capacity = 0;
+        }
+    }
+
+    if (capacity == 0)
+    {
+        AGENT_ERROR("InitCommandRing: Shared mem size " << maxShmSize << " is too small for a command ring");
+        return status;
+    }
+
+    // A segment of another session must not be cleared, the ring gets a key no one has
+    key_t ringShmKey = shmkey;
+    status = CreateCommandRingSegment(shmkey, maxShmSize, ringShmKey);
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("InitCommandRing: Could not allocate the command ring");
+        return status;
+    }
+
+    HsailCommandRingHeader* pRing = static_cast<HsailCommandRingHeader*>(AgentMapSharedMemBuffer(ringShmKey, maxShmSize));
+    if (pRing == nullptr)
+    {
+        AGENT_ERROR("InitCommandRing: Could not map the command ring");
+        AgentFreeSharedMemBuffer(ringShmKey, maxShmSize);
+        status = HSAIL_AGENT_STATUS_FAILURE;
+        return status;
+    }
+
+    memset(pRing, 0, sizeof(HsailCommandRingHeader));
+    pRing->m_capacity = capacity;
+
+    // gdb only uses the ring once it sees the magic
+    __atomic_store_n(&pRing->m_magic, HSAIL_COMMAND_RING_MAGIC, __ATOMIC_RELEASE);
+
+    gs_pCOMMAND_RING = pRing;
+    gs_COMMAND_RING_SHMKEY = ringShmKey;
+    gs_COMMAND_RING_SHMSIZE = maxShmSize;
+
+    AGENT_LOG("InitCommandRing: Command ring with " << capacity << " slots, key " << ringShmKey);
+
+    return status;
+}
+
+HsailAgentStatus CloseCommandRing()
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_SUCCESS;
+
+    if (gs_pCOMMAND_RING == nullptr)
+    {
+        return status;
+    }
+
+    // Let gdb know that it should go back to the fifo
+    __atomic_store_n(&gs_pCOMMAND_RING->m_magic, 0, __ATOMIC_RELEASE);
+
+    if (AgentUnMapSharedMemBuffer(gs_pCOMMAND_RING) != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("CloseCommandRing: Could not detach the command ring");
+        status = HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    gs_pCOMMAND_RING = nullptr;
+
+    if (AgentFreeSharedMemBuffer(gs_COMMAND_RING_SHMKEY, gs_COMMAND_RING_SHMSIZE) != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("CloseCommandRing: Could not free the command ring");
+        status = HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    return status;
+}
+
+key_t GetCommandRingShmKey()
+{
+    if (gs_pCOMMAND_RING == nullptr)
+    {
+        return 0;
+    }
+
+    return gs_COMMAND_RING_SHMKEY;
+}
+
+unsigned int ReadCommandRing(HsailCommandPacket* pPacketsOut, const unsigned int maxPackets)
+{
+    HsailCommandRingHeader* pRing = gs_pCOMMAND_RING;
+
+    if (pRing == nullptr || pPacketsOut == nullptr || maxPackets == 0)
+    {
+        return 0;
+    }
+
+    // Only the agent writes the read index
+    uint64_t readIndex = __atomic_load_n(&pRing->m_readIndex, __ATOMIC_RELAXED);
+
+    // Pairs with the release store of gdb, the slots up to the write index are complete
+    uint64_t writeIndex = __atomic_load_n(&pRing->m_writeIndex, __ATOMIC_ACQUIRE);
+
+    uint64_t available = writeIndex - readIndex;
+
+    if (available > pRing->m_capacity)
+    {
+        AGENT_ERROR("ReadCommandRing: Invalid ring indices, read " << readIndex <<
+                    " write " << writeIndex);
+        return 0;
+    }
+
+    unsigned int numPackets = (available < maxPackets) ? static_cast<unsigned int>(available) : maxPackets;
+    const HsailCommandPacket* pSlots = GetCommandRingSlots(pRing);
+    const uint64_t mask = pRing->m_capacity - 1;
+
+    for (unsigned int i = 0; i < numPackets; i++)
+    {
+        pPacketsOut[i] = pSlots[(readIndex + i) & mask];
+    }
+
+    // Hand the slots back to gdb once they have been copied
+    __atomic_store_n(&pRing->m_readIndex, readIndex + numPackets, __ATOMIC_RELEASE);
+
+    return numPackets;
+}
+
+bool IsCommandRingInUse()
+{
+    if (gs_pCOMMAND_RING == nullptr)
+    {
+        return false;
+    }
+
+    return __atomic_load_n(&gs_pCOMMAND_RING->m_writeIndex, __ATOMIC_ACQUIRE) != 0;
+}
+
+bool IsCommandRingEmpty()
+{
+    if (gs_pCOMMAND_RING == nullptr)
+    {
+        return true;
+    }
+
+    return __atomic_load_n(&gs_pCOMMAND_RING->m_writeIndex, __ATOMIC_ACQUIRE) ==
+           __atomic_load_n(&gs_pCOMMAND_RING->m_readIndex, __ATOMIC_RELAXED);
+}
+
+void WaitForCommandRingDoorbell(const unsigned int timeoutUs)
+{
+    HsailCommandRingHeader* pRing = gs_pCOMMAND_RING;
+
+    struct timespec timeout;
+    timeout.tv_sec = timeoutUs / 1000000;
+    timeout.tv_nsec = (timeoutUs % 1000000) * 1000;
+
+    if (pRing == nullptr)
+    {
+        // No ring, only the fifo can bring in commands
+        nanosleep(&timeout, nullptr);
+        return;
+    }
+
+    uint32_t doorbell = __atomic_load_n(&pRing->m_doorbell, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&pRing->m_consumerWaiting, 1, __ATOMIC_SEQ_CST);
+
+    // Do not sleep if a packet came in before gdb could see m_consumerWaiting
+    if (__atomic_load_n(&pRing->m_writeIndex, __ATOMIC_SEQ_CST) ==
+        __atomic_load_n(&pRing->m_readIndex, __ATOMIC_RELAXED))
+    {
+        // EAGAIN (doorbell already rung), ETIMEDOUT and EINTR are all fine here
+        AgentFutex(&pRing->m_doorbell, FUTEX_WAIT, doorbell, &timeout);
+    }
+
+    __atomic_store_n(&pRing->m_consumerWaiting, 0, __ATOMIC_RELEASE);
+}
+
 
 // Shared memory based initialization routines
 // The code and functions below were used when we did the shared memory based
@@ -321,6 +613,111 @@ HsailAgentStatus AgentAllocSharedMemBuffer(const key_t shmkey, const size_t maxS
     return status;
 }
 
+/// Adler-32 checksum, cheap enough to compute over a code object at every dispatch
+static uint32_t AgentComputeSharedBufferChecksum(const void* pData, const size_t size)
+{
+    const uint32_t ADLER_MOD = 65521;
+
+    // Largest block for which the sums can not overflow 32 bits before the modulo
+    const size_t ADLER_BLOCK = 5552;
+
+    const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+    uint32_t a = 1;
+    uint32_t b = 0;
+    size_t remaining = size;
+
+    while (remaining > 0)
+    {
+        size_t blockLen = (remaining < ADLER_BLOCK) ? remaining : ADLER_BLOCK;
+        remaining -= blockLen;
+
+        for (size_t i = 0; i < blockLen; i++)
+        {
+            a += pBytes[i];
+            b += a;
+        }
+
+        pBytes += blockLen;
+        a %= ADLER_MOD;
+        b %= ADLER_MOD;
+    }
+
+    return (b << 16) | a;
+}
+
+size_t AgentGetSharedBufferMaxPayloadSize(const size_t maxShmSize)
+{
+    if (maxShmSize <= sizeof(HsailSharedBufferHeader))
+    {
+        return 0;
+    }
+
+    return maxShmSize - sizeof(HsailSharedBufferHeader);
+}
+
+void* AgentGetSharedBufferPayload(void* pShm)
+{
+    if (pShm == nullptr)
+    {
+        return nullptr;
+    }
+
+    return static_cast<HsailSharedBufferHeader*>(pShm) + 1;
+}
+
+HsailAgentStatus AgentBeginSharedBufferUpdate(void* pShm)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (pShm == nullptr)
+    {
+        AGENT_ERROR("AgentBeginSharedBufferUpdate: invalid input");
+        return status;
+    }
+
+    HsailSharedBufferHeader* pHeader = static_cast<HsailSharedBufferHeader*>(pShm);
+
+    // Make the generation odd so that gdb can tell the payload is incomplete
+    uint64_t generation = __atomic_load_n(&pHeader->m_generation, __ATOMIC_RELAXED);
+    if ((generation & 1) == 0)
+    {
+        generation++;
+    }
+
+    __atomic_store_n(&pHeader->m_generation, generation, __ATOMIC_RELAXED);
+
+    // Seqlock writer, the odd generation must be visible before any of the payload stores
+    std::atomic_thread_fence(std::memory_order_release);
+
+    status = HSAIL_AGENT_STATUS_SUCCESS;
+    return status;
+}
+
+HsailAgentStatus AgentEndSharedBufferUpdate(void* pShm, const size_t payloadSize)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (pShm == nullptr)
+    {
+        AGENT_ERROR("AgentEndSharedBufferUpdate: invalid input");
+        return status;
+    }
+
+    HsailSharedBufferHeader* pHeader = static_cast<HsailSharedBufferHeader*>(pShm);
+
+    pHeader->m_payloadSize = payloadSize;
+    pHeader->m_checksum = AgentComputeSharedBufferChecksum(AgentGetSharedBufferPayload(pShm), payloadSize);
+
+    // Publish, the release store orders the payload and the header fields before the generation
+    uint64_t generation = __atomic_load_n(&pHeader->m_generation, __ATOMIC_RELAXED);
+    generation += ((generation & 1) == 1) ? 1 : 2;
+
+    __atomic_store_n(&pHeader->m_generation, generation, __ATOMIC_RELEASE);
+
+    status = HSAIL_AGENT_STATUS_SUCCESS;
+    return status;
+}
+
 // Waits for the shared memory update from GDB
 // This function will be called after an interrupt has been intercepted by GDB
 // Returns 1 if GDB has written into shared memory, 0 otherwise
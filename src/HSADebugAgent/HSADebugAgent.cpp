@@ -21,10 +21,15 @@
 
 // HSA Debug Agent headers and parameters for shmem and fifo
 #include "AgentContext.h"
+#include "AgentCodeObjectIngestion.h"
 #include "AgentConfiguration.h"
 #include "AgentISABuffer.h"
+#include "AgentISAWorker.h"
+#include "AgentKernelFilter.h"
 #include "AgentLogging.h"
 #include "AgentNotifyGdb.h"
+#include "AgentQueueContext.h"
+#include "AgentTiming.h"
 #include "AgentUtils.h"
 #include "CommunicationControl.h"
 #include "CommandLoop.h"
@@ -158,6 +163,31 @@ static void ClearAgentConfiguration()
     }
 }
 
+// Create the shared memory command ring that gdb can use instead of the fifo
+static void InitAgentCommandRing()
+{
+    if (psActiveAgentConfig == nullptr)
+    {
+        AGENT_ERROR("InitAgentCommandRing: Agent is not configured");
+        return;
+    }
+
+    int shmKey = 0;
+    size_t shmSize = 0;
+
+    if (psActiveAgentConfig->GetConfigShmKey(HSAIL_DEBUG_CONFIG_COMMAND_RING_SHM, shmKey) != HSAIL_AGENT_STATUS_SUCCESS ||
+        psActiveAgentConfig->GetConfigShmSize(HSAIL_DEBUG_CONFIG_COMMAND_RING_SHM, shmSize) != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("InitAgentCommandRing: Could not get the command ring configuration");
+        return;
+    }
+
+    if (InitCommandRing(shmKey, shmSize) != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_WARNING("Could not create the command ring, gdb commands will only be read from the fifo");
+    }
+}
+
 // Some of device info is not provided by the Runtime currently.
 // Disable dumping this data until this is fixed in the Runtime.
 #define  FULL_DEVICE_INFO   0
@@ -285,6 +315,9 @@ static void InitHsaAgent()
             AGENT_ERROR("Could not initialize the fifo read end");
         }
 
+        // The command ring is optional, gdb keeps using the fifo if it is not there
+        InitAgentCommandRing();
+
         AgentTriggerGDBEventLoop();
 
         AGENT_LOG("===== Fifos initialized===== ");
@@ -326,6 +359,10 @@ static void InitAgentContext()
         {
             AGENT_ERROR("Could not get devices info");
         }
+
+        // The executables frozen from now on are prepared before their first dispatch
+        HwDbgAgent::AgentStartCodeObjectIngestion(psAgentContext->GetKernelBinaryCache(),
+                                                  psAgentContext->GetSegmentLoader());
     }
 }
 
@@ -335,6 +372,9 @@ static void InitAgentContext()
 // (doesnt seem to be the case for now though)
 void ShutDownHsaAgentContext(const bool skipDbeShutDown)
 {
+    // The ingestion thread uses the kernel binary cache, the segment loader and the DBE
+    HwDbgAgent::AgentStopCodeObjectIngestion();
+
     HsailAgentStatus status = psAgentContext->ShutDown(skipDbeShutDown);
 
     if (status != HSAIL_AGENT_STATUS_SUCCESS)
@@ -384,6 +424,11 @@ static void CloseCommunicationFifo()
         // Close the Agent ==> GDB fifo
         int writeFifoDescriptor = GetFifoWriteEnd();
         close(writeFifoDescriptor);
+
+        if (CloseCommandRing() != HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            AGENT_ERROR("CloseCommunicationFifo: Could not close the command ring");
+        }
     }
 }
 
@@ -470,10 +515,18 @@ HsailAgentStatus InitDispatchCallbacks(hsa_queue_t* queue)
         return status;
     }
 
-    // Assign the agent state to the predispatchcallback's arguments
+    // Assign the state of the queue to the predispatchcallback's arguments
+    HwDbgAgent::AgentQueueContext* pQueueContext = HwDbgAgent::AgentCreateQueueContext(psAgentContext, queue);
+
+    if (pQueueContext == nullptr)
+    {
+        AGENT_ERROR("Could not create the context of the queue");
+        return status;
+    }
+
     hsaStatus = psDebuggerRTLoader->CreateHSADebuggerRTModule()
                 ->ext_tools_set_callback_arguments(queue,
-                                                   reinterpret_cast<void*>(psAgentContext),
+                                                   reinterpret_cast<void*>(pQueueContext),
                                                    nullptr);
 
     if (hsaStatus != HSA_STATUS_SUCCESS)
@@ -570,16 +623,27 @@ extern "C" void OnUnload()
         AGENT_ERROR("OnUnload:Error waiting for the debug thread to complete");
     }
 
+    HwDbgAgent::AgentLogQueueStatistics();
+    HwDbgAgent::AgentLogKernelFilterStatistics();
+
+    // The ISA workers use the agent configuration, stop them before it is deleted
+    HwDbgAgent::AgentLogISAWorkerStatistics();
+    HwDbgAgent::AgentStopISAWorkers();
+
     // We skip the DBE shutdown when we try to shutdown the AgentContext
     // since the HSA tools RT may already have been unloaded.
     ShutDownHsaAgentContext(true);
 
+    AgentLogNotificationStatistics();
+    HwDbgAgent::AgentLogTimingStatistics();
+
     CloseCommunicationFifo();
 
     // The agentcontext object is global here since the unload function
     // does not have an UserArg parameter
     // We need to be sure that all debug is over before we call this
     DeleteHsaAgentContext();
+    HwDbgAgent::AgentDeleteQueueContexts();
 
     if (psDebuggerRTLoader == nullptr)
     {
@@ -17,8 +17,14 @@
 
 #include <amd_hsa_tools_interfaces.h>
 
+#include "AgentBinary.h"
+#include "AgentCodeObjectIngestion.h"
+#include "AgentContext.h"
 #include "AgentISABuffer.h"
+#include "AgentKernelFilter.h"
 #include "AgentLogging.h"
+#include "AgentQueueContext.h"
+#include "AgentSegmentLoader.h"
 #include "AgentUtils.h"
 #include "CommunicationControl.h"
 #include "HSADebugAgent.h"
@@ -214,6 +220,102 @@ HsaDebugAgent_hsa_ext_program_finalize(hsa_ext_program_t            program,
 
 }
 
+hsa_status_t
+HsaDebugAgent_hsa_executable_freeze(hsa_executable_t executable,
+                                    const char*      options)
+{
+    AGENT_LOG("Interception: hsa_executable_freeze");
+
+    hsa_status_t rtStatus = g_OrigCoreApiTable.hsa_executable_freeze_fn(executable, options);
+
+    // The segments of the executable are loaded now, the load map is read again at the next dispatch
+    // and the code objects are prepared for their first dispatch in the background
+    if (rtStatus == HSA_STATUS_SUCCESS)
+    {
+        HwDbgAgent::AgentInvalidateLoadMap();
+        HwDbgAgent::AgentIngestExecutable(executable.handle);
+    }
+    else
+    {
+        AGENT_ERROR("Interception: Error in hsa_executable_freeze " << GetHsaStatusString(rtStatus));
+    }
+
+    AGENT_LOG("Interception: Exit hsa_executable_freeze");
+
+    return rtStatus;
+}
+
+hsa_status_t
+HsaDebugAgent_hsa_executable_destroy(hsa_executable_t executable)
+{
+    AGENT_LOG("Interception: hsa_executable_destroy");
+
+    hsa_status_t rtStatus = g_OrigCoreApiTable.hsa_executable_destroy_fn(executable);
+
+    // Even a failed destroy may have unloaded some segments,
+    // a later executable may get the kernel objects of the destroyed one
+    HwDbgAgent::AgentInvalidateLoadMap();
+    HwDbgAgent::AgentForgetPreparedKernels();
+    HwDbgAgent::AgentForgetKernelNames();
+    HwDbgAgent::AgentForgetPreparedBinaries();
+    HwDbgAgent::AgentForgetBinariesSentToGdb();
+
+    if (rtStatus != HSA_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("Interception: Error in hsa_executable_destroy " << GetHsaStatusString(rtStatus));
+    }
+
+    AGENT_LOG("Interception: Exit hsa_executable_destroy");
+
+    return rtStatus;
+}
+
+hsa_status_t
+HsaDebugAgent_hsa_executable_symbol_get_info(hsa_executable_symbol_t      executable_symbol,
+                                             hsa_executable_symbol_info_t attribute,
+                                             void*                        value)
+{
+    hsa_status_t rtStatus = g_OrigCoreApiTable.hsa_executable_symbol_get_info_fn(executable_symbol,
+                                                                                 attribute,
+                                                                                 value);
+
+    // The application asks for the kernel object it dispatches,
+    // remember the symbol name so the kernel filter can match it before the first dispatch
+    if (rtStatus != HSA_STATUS_SUCCESS || attribute != HSA_EXECUTABLE_SYMBOL_INFO_KERNEL_OBJECT)
+    {
+        return rtStatus;
+    }
+
+    uint64_t kernelObject = *reinterpret_cast<uint64_t*>(value);
+
+    if (HwDbgAgent::AgentIsKernelNameKnown(kernelObject))
+    {
+        return rtStatus;
+    }
+
+    uint32_t nameLength = 0;
+    hsa_status_t nameStatus = g_OrigCoreApiTable.hsa_executable_symbol_get_info_fn(executable_symbol,
+                                                                                   HSA_EXECUTABLE_SYMBOL_INFO_NAME_LENGTH,
+                                                                                   &nameLength);
+
+    if (nameStatus == HSA_STATUS_SUCCESS && nameLength > 0)
+    {
+        // The name is not null terminated
+        std::string symbolName(nameLength, '\0');
+        nameStatus = g_OrigCoreApiTable.hsa_executable_symbol_get_info_fn(executable_symbol,
+                                                                         HSA_EXECUTABLE_SYMBOL_INFO_NAME,
+                                                                         &symbolName[0]);
+
+        if (nameStatus == HSA_STATUS_SUCCESS)
+        {
+            AGENT_LOG("Interception: Kernel object " << kernelObject << " is symbol " << symbolName);
+            HwDbgAgent::AgentRecordKernelName(kernelObject, symbolName);
+        }
+    }
+
+    return rtStatus;
+}
+
 static void UpdateHSAFunctionTable(HsaApiTable* pTable)
 {
     if (pTable == nullptr)
@@ -226,6 +328,11 @@ static void UpdateHSAFunctionTable(HsaApiTable* pTable)
     pTable->core_->hsa_queue_create_fn = HsaDebugAgent_hsa_queue_create;
     pTable->core_->hsa_shut_down_fn    = HsaDebugAgent_hsa_shut_down;
 
+    pTable->core_->hsa_executable_freeze_fn  = HsaDebugAgent_hsa_executable_freeze;
+    pTable->core_->hsa_executable_destroy_fn = HsaDebugAgent_hsa_executable_destroy;
+
+    pTable->core_->hsa_executable_symbol_get_info_fn = HsaDebugAgent_hsa_executable_symbol_get_info;
+
     pTable->finalizer_ext_->hsa_ext_program_finalize_fn = HsaDebugAgent_hsa_ext_program_finalize;
 }
 
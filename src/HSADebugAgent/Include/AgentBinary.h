@@ -21,6 +21,31 @@ namespace HwDbgAgent
 
 // forward declaration:
 class AgentISABuffer;
+class AgentKernelBinaryCache;
+class AgentSharedMemRegistry;
+
+/// The binary of a kernel object as known before the DBE is asked for it
+typedef struct
+{
+    uint64_t m_binaryHash;  // Hash of the binary
+    size_t   m_binarySize;  // Size of the binary, checked against the binary of the DBE
+} AgentPreparedBinary;
+
+/// Record the binary of a kernel object, so the next dispatch of the kernel does not hash it again.
+/// Called by the code object ingestion and by PopulateBinaryFromDBE, on any thread
+/// \param[in] kernelObject The kernel_object of the AQL packet
+/// \param[in] binaryHash   The hash of the binary
+/// \param[in] binarySize   The size of the binary
+void AgentRecordPreparedBinary(const uint64_t kernelObject, const uint64_t binaryHash, const size_t binarySize);
+
+/// Find the binary recorded for a kernel object, does not need the debug engine
+/// \param[in]  kernelObject       The kernel_object of the AQL packet
+/// \param[out] preparedBinaryOut  The hash and size of the binary
+/// \return true if the binary of the kernel object was recorded
+bool AgentFindPreparedBinary(const uint64_t kernelObject, AgentPreparedBinary& preparedBinaryOut);
+
+/// Forget the recorded binaries, a destroyed executable may have its kernel objects reused
+void AgentForgetPreparedBinaries();
 
 /// A class that maintains a single binary from the debug back end library
 /// Obtains the binary from the back end library and sends it to GDB
@@ -34,14 +59,20 @@ private:
     /// Size of binary
     size_t m_binarySize;
 
+    /// Hash of the binary, gdb keeps the binaries it received by this hash
+    uint64_t m_binaryHash;
+
+    /// The kernel_object of the AQL packet, 0 if the binary was populated without a packet
+    uint64_t m_kernelObject;
+
     /// The dispatched kernel name
     std::string m_kernelName;
 
-    /// Key for the code object buffer's shared memory
-    int m_codeObjBufferShmKey;
+    /// The shared memory regions of the agent context, the binary is written to one of them
+    AgentSharedMemRegistry* m_pSharedMemRegistry;
 
-    /// Max size for the code object buffer's shared memory
-    size_t m_codeObjBufferMaxSize;
+    /// The kernel name and ISA of the binaries populated before, nullptr if not used
+    AgentKernelBinaryCache* m_pBinaryCache;
 
     /// The ISA for this code object, populated by a syscall to amdhsacod
     AgentISABuffer* m_pIsaBuffer;
@@ -50,22 +81,33 @@ private:
     /// Needed for platforms like KV where system() fails when in the predispatch
     bool m_enableISADisassemble;
 
+    /// True if gdb asks for the ISA with HSAIL_COMMAND_GET_ISA, nothing is disassembled at dispatch time
+    bool m_isISADeferred;
+
+    /// True once the ISA was written to the ISA dump file read by gdb
+    bool m_isISAPublished;
+
+    /// Disable default constructor, the shared memory registry is needed
+    AgentBinary();
+
     /// Disable copy constructor
     AgentBinary(const AgentBinary&);
 
     /// Disable assignment operator
     AgentBinary& operator=(const AgentBinary&);
 
-    /// Demangle the input kernel name using c++filt
-    HsailAgentStatus DemangleKernelName(const std::string& ipKernelName, std::string& demangledNameOut) const;
-
-    /// Write the binary to shared mem
-    /// \param[in] shmKey the key for shared memory used where the binary will be written  to
+    /// Write the binary to the code object shared mem
     HsailAgentStatus WriteBinaryToSharedMem() const;
 
 public:
-    /// Default constructor
-    AgentBinary();
+    /// Demangle the input kernel name with the C++ runtime demangler, the results are memoized.
+    /// The code object ingestion demangles the kernel symbols at load time
+    static HsailAgentStatus DemangleKernelName(const std::string& ipKernelName, std::string& demangledNameOut);
+
+    /// Constructor
+    /// \param[in] pSharedMemRegistry The shared memory regions used to send the binary to gdb
+    /// \param[in] pBinaryCache       The cache of kernel names and ISA, may be nullptr
+    AgentBinary(AgentSharedMemRegistry* pSharedMemRegistry, AgentKernelBinaryCache* pBinaryCache);
 
     /// Destructor
     ~AgentBinary();
@@ -75,13 +117,27 @@ public:
     ///
     /// \param[in] ipHandle The DBE context handle
     /// \param[in] pAqlPacket The AQL packet for the dispatch
+    /// \param[in] pPreparedBinary The binary found for the kernel object before the debug engine
+    ///                            was acquired, nullptr if none. Its hash is used if the size matches
     /// \return HSAIL agent status
-    HsailAgentStatus PopulateBinaryFromDBE(HwDbgContextHandle ipHandle, const hsa_kernel_dispatch_packet_t* pAqlPacket);
+    HsailAgentStatus PopulateBinaryFromDBE(HwDbgContextHandle                  ipHandle,
+                                           const hsa_kernel_dispatch_packet_t* pAqlPacket,
+                                           const AgentPreparedBinary*          pPreparedBinary);
+
+    /// Write the ISA to the ISA dump file read by gdb, called before gdb takes control.
+    /// The binary is disassembled by an ISA worker thread, this waits for that job if it is not done.
+    /// Does nothing if gdb asks for the ISA with HSAIL_COMMAND_GET_ISA.
+    /// \return HSAIL agent status
+    HsailAgentStatus PublishISA();
 
     /// Write the Notification payload to gdb
+    /// \param[in] isBinaryKnownToGdb True if a binary with the same hash was sent earlier
+    ///                               in the session, the binary is then only referenced by
+    ///                               its hash if gdb supports it
     HsailAgentStatus NotifyGDB(const hsa_kernel_dispatch_packet_t* pAqlPacket,
                                const uint64_t                      queueID,
-                               const uint64_t                      packetID) const;
+                               const uint64_t                      packetID,
+                               const bool                          isBinaryKnownToGdb) const;
 
     /// Write the binary to a file, useful for debug
     /// \param[in] pFilenamePrefix Input filename prefix
@@ -91,6 +147,11 @@ public:
     ///
     /// \return The kernel name for this code object
     const std::string GetKernelName() const;
+
+    /// Return the hash of the binary
+    ///
+    /// \return The hash computed when the binary was populated
+    uint64_t GetBinaryHash() const;
 };
 } // End Namespace HwDbgAgent
 
@@ -10,6 +10,7 @@
 #define AGENT_BREAKPOINT_H_
 
 #include <string>
+#include <vector>
 
 #include "AMDGPUDebug.h"
 #include "CommunicationControl.h"
@@ -144,10 +145,10 @@ public:
     /// Construct an Agent breakpoint
     AgentBreakpoint();
 
-    /// Update an empty slot in the notification payload with the AgentBreakpoint's
-    /// information such as hitcount.
-    /// \param[in] payload The notification payload
-    HsailAgentStatus UpdateNotificationPayload(HsailNotificationPayload* pNotify) const;
+    /// Add the AgentBreakpoint's information such as hitcount to the hit report,
+    /// or update its entry if the breakpoint is already in the report.
+    /// \param[in,out] pHits The breakpoint hit report sent to gdb
+    HsailAgentStatus UpdateHitRecords(std::vector<HsailBreakpointHitRecord>* pHits) const;
 
     /// Print the appropriate message for the breakpoint type using AGENT_OP
     void PrintHitMessage() const;
@@ -23,6 +23,7 @@ namespace HwDbgAgent
 
 class AgentBreakpoint;
 class AgentFocusWaveControl;
+class AgentSharedMemRegistry;
 
 /// A class that works with HSAIL packets and DBE context information
 /// and maintains a vector of AgentBreakpoint
@@ -43,17 +44,39 @@ private:
     /// Name of the file where the hsail kernel source is saved
     std::string m_kernelSourceFilename;
 
-    /// Allocate the shared mem for the momentary breakpoints
-    HsailAgentStatus AllocateMomentaryBPBuffer() const;
+    /// The shared memory regions of the owning agent context,
+    /// gdb writes the momentary breakpoints into one of them
+    AgentSharedMemRegistry* m_pSharedMemRegistry;
 
-    /// Free the shared mem for the momentary breakpoints
-    HsailAgentStatus FreeMomentaryBPBuffer() const;
+    /// An entry of the PC index of a breakpoint vector
+    typedef struct
+    {
+        HwDbgCodeAddress m_pc;
+        int              m_position;    // Position of the breakpoint in its vector
+    } PCIndexEntry;
 
-    /// Key for the momentary breakpoints shared memory location
-    int m_momentaryBPShmKey;
+    /// The breakpoints of m_pBreakpoints sorted by PC, then by position.
+    /// A stop looks up the PC of every active wave, a scan of the vectors would cost waves x breakpoints
+    mutable std::vector<PCIndexEntry> m_breakpointPCIndex;
 
-    /// Max size for the momentary breakpoints shared memory location
-    size_t m_momentaryBPShmMaxSize;
+    /// The breakpoints of m_pMomentaryBreakpoints sorted by PC, then by position
+    mutable std::vector<PCIndexEntry> m_momentaryPCIndex;
+
+    /// True if a breakpoint was added, removed or moved since the PC indices were built
+    mutable bool m_isPCIndexStale;
+
+    /// Rebuild the PC indices if they are stale
+    void UpdatePCIndex() const;
+
+    /// Fill a PC index with the breakpoints of a vector
+    static void BuildPCIndex(const std::vector<AgentBreakpoint*>& breakpoints, std::vector<PCIndexEntry>& indexOut);
+
+    /// Find the first entry of a PC index for a PC
+    /// \return The position of the entry in the index, the index size if no breakpoint has the PC
+    static size_t FindFirstPCIndexEntry(const std::vector<PCIndexEntry>& index, const HwDbgCodeAddress pc);
+
+    /// Order the PC index by PC, then by position in the breakpoint vector
+    static bool IsPCIndexEntryBefore(const PCIndexEntry& lhs, const PCIndexEntry& rhs);
 
     /// Check for duplicate source and function breakpoints from the input packet.
     /// \return true if any duplicates present
@@ -96,6 +119,9 @@ private:
     /// Utility function to print the wave info for the breakpoint we just hit
     void PrintWaveInfo(const HwDbgWavefrontInfo* pWaveInfo, const HwDbgDim3* pFocusWI = nullptr) const;
 
+    /// Disable default constructor, the shared memory registry is needed
+    AgentBreakpointManager();
+
     /// Disable copy constructor
     AgentBreakpointManager(const AgentBreakpointManager&);
 
@@ -104,8 +130,9 @@ private:
 
 public:
 
-    /// Construct a breakpoint manager, also allocate the shared memory needed for momentary breakpoints
-    AgentBreakpointManager();
+    /// Construct a breakpoint manager
+    /// \param[in] pSharedMemRegistry The shared memory regions, used to read the momentary breakpoints
+    AgentBreakpointManager(AgentSharedMemRegistry* pSharedMemRegistry);
 
     /// Destructor
     ~AgentBreakpointManager();
@@ -137,6 +164,15 @@ public:
     int GetNumMomentaryBreakpointsInState(const HsailBkptState ipState,
                                           const HsailBkptType  type = HSAIL_BREAKPOINT_TYPE_PC_BP) const;
 
+    /// Check if any breakpoint, of any type and including the momentary breakpoints,
+    /// is enabled or pending. A dispatch can not stop without one
+    bool HasActiveBreakpoints() const;
+
+    /// Get what an enabled or pending breakpoint can stop at
+    /// \param[out] pcsOut         The PCs of the PC and momentary breakpoints, sorted
+    /// \param[out] kernelNamesOut The names of the kernel name breakpoints, sorted
+    void GetActiveBreakpoints(std::vector<HwDbgCodeAddress>& pcsOut, std::vector<std::string>& kernelNamesOut) const;
+
     /// Returns true iff there is a kernel name breakpoint set against the input parameter name
     bool CheckAgainstKernelNameBreakpoints(const std::string& kernelName, int* pBpPositionOut) const;
 
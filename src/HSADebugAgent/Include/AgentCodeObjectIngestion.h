@@ -0,0 +1,39 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Preparation of the code objects of an executable when it is loaded
+//==============================================================================
+#ifndef AGENT_CODE_OBJECT_INGESTION_H_
+#define AGENT_CODE_OBJECT_INGESTION_H_
+
+#include <cstdint>
+
+namespace HwDbgAgent
+{
+class AgentKernelBinaryCache;
+class AgentSegmentLoader;
+
+/// Start the thread that prepares the code objects of the frozen executables.
+/// For every code object the thread hands a copy to the ISA workers, demangles the kernel
+/// symbols, adds the kernels to the kernel binary cache, gives their names to the kernel filter
+/// and records the hash of their binary. The load map it queries is given to the segment loader,
+/// so the first dispatch of a kernel finds all of it ready.
+/// Does nothing if ROCM_GDB_DISABLE_LOAD_INGESTION is set.
+/// \param[in] pBinaryCache   The kernel binary cache of the agent context
+/// \param[in] pSegmentLoader The segment loader of the agent context
+void AgentStartCodeObjectIngestion(AgentKernelBinaryCache* pBinaryCache, AgentSegmentLoader* pSegmentLoader);
+
+/// Queue a frozen executable for the ingestion thread, does nothing if the thread is not running.
+/// Called by the interception of hsa_executable_freeze
+/// \param[in] executable The handle of the executable
+void AgentIngestExecutable(const uint64_t executable);
+
+/// Stop the ingestion thread, the executables it has not started are dropped.
+/// Must be called before the kernel binary cache and the segment loader are deleted and the DBE is shut down
+void AgentStopCodeObjectIngestion();
+
+} // End Namespace HwDbgAgent
+
+#endif // AGENT_CODE_OBJECT_INGESTION_H_
@@ -44,6 +44,20 @@ public:
     HsailAgentStatus GetConfigShmSize(const HsailDebugConfigParam requestedParam,
                                             size_t&               outMaxSize) const;
 
+    /// Get the debug session ID, see CommunicationParams.h
+    /// \return The session ID, empty if ROCM_GDB_DEBUG_SESSION_ID is not set
+    const std::string& GetSessionID() const;
+
+    /// Scope a fifo or file name to the debug session
+    /// \param[in] pBaseName The name used when there is no session ID
+    /// \return The name for this session
+    std::string GetSessionFileName(const char* pBaseName) const;
+
+    /// Get the name of the POSIX shared memory object for a shared memory key
+    /// \param[in] shmKey The key returned by GetConfigShmKey
+    /// \return The name for this session
+    std::string GetSessionShmName(const int shmKey) const;
+
 private:
 
     /// Map of each parameter and its data
@@ -55,8 +69,17 @@ private:
     /// Configure the defaults, from the shared header.
     bool ReadDefaultConfiguration();
 
+    /// Read and clean up ROCM_GDB_DEBUG_SESSION_ID
+    void ReadSessionID();
+
+    /// Scope a shared memory key to the debug session
+    int GetSessionShmKey(const int baseKey) const;
+
     /// The config file
     std::string m_configFileName;
+
+    /// The debug session ID, empty if there is none
+    std::string m_sessionID;
 };
 }
 #endif // AGENT_CONFIG_H_
@@ -8,6 +8,8 @@
 #ifndef AGENT_CONTEXT_H_
 #define AGENT_CONTEXT_H_
 
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -25,6 +27,9 @@ namespace HwDbgAgent
 class AgentBinary;
 class AgentBreakpointManager;
 class AgentFocusWaveControl;
+class AgentKernelBinaryCache;
+class AgentSegmentLoader;
+class AgentSharedMemRegistry;
 class AgentWavePrinter;
 
 typedef enum
@@ -32,7 +37,7 @@ typedef enum
     HSAIL_PARENT_STATUS_UNKNOWN,        /// Parent status is unknown
     HSAIL_PARENT_STATUS_GOOD,           /// The getppid() function OP matches the saved ppid
     HSAIL_PARENT_STATUS_TERMINATED,     /// getppid() function does not match the saved ppid
-    HSAIL_PARENT_STATUS_CHECK_COUNT_MAX /// This check happened too many times
+    HSAIL_PARENT_STATUS_CHECK_COUNT_MAX /// The wait for gdb timed out too many times
 } HsailParentStatus;
 
 /// The AgentContext includes functionality to start and stop debug.
@@ -78,17 +83,27 @@ private:
     /// The parent process ID
     int m_ParentPID;
 
-    /// Key for the code object buffer's shared memory
-    int m_codeObjBufferShmKey;
+    /// A pidfd for the parent process, it becomes readable when the parent exits.
+    /// -1 if the kernel does not support pidfd_open, CompareParentPID is used then
+    int m_ParentPidFd;
 
-    /// Max size for the code object buffer's shared memory
-    size_t m_codeObjBufferMaxSize;
+    /// The shared memory regions used to send data to gdb, mapped once in Initialize
+    AgentSharedMemRegistry* m_pSharedMemRegistry;
 
-    /// Key for the code object buffer's shared memory
-    int m_loadMapBufferShmKey;
+    /// The kernel names and ISA of the binaries dispatched before, created in Initialize
+    AgentKernelBinaryCache* m_pKernelBinaryCache;
 
-    /// Max size for the code object buffer's shared memory
-    size_t m_loadMapBufferMaxSize;
+    /// The load map shared with gdb, kept across dispatches, created in Initialize
+    AgentSegmentLoader* m_pSegmentLoader;
+
+    /// Hashes of the binaries sent to gdb in this session
+    std::set<uint64_t> m_binaryHashesSentToGdb;
+
+    /// The kernel objects whose binary was sent to gdb in this session, with the hash of the binary
+    std::map<uint64_t, uint64_t> m_kernelObjectsSentToGdb;
+
+    /// The executable destroy count the binaries sent to gdb were recorded at
+    uint64_t m_sentToGdbGeneration;
 
     /// Disable copy constructor
     AgentContext(const AgentContext&);
@@ -103,20 +118,13 @@ private:
     /// Called when we do EndDebug with HWDBG_BEHAVIOR_NONE or when we register any new binary
     HsailAgentStatus ReleaseKernelBinary();
 
-    /// These functions are called only once irrespective of how many ever binaries
-    /// are encountered by the application. Thats why this func is part of the context
-    /// rather than the AgentBinary class.
-    /// The key is not passed since its global
-    /// Private function to initialize the shared memory buffer for the binary
-    HsailAgentStatus AllocateBinaryandLoadMapSharedMem();
-
-    /// Private function to free the shared memory buffer for the binary
-    HsailAgentStatus FreeBinaryandLoadMapSharedMem();
-
 public:
     /// A bit to track that we have received the continue command from the host
     bool m_ReadyToContinue;
 
+    /// The sync request answered by the last sync marker from the host, 0 if gdb never sent one
+    uint64_t m_LastSyncMarkerId;
+
     /// The active dispatch dimensions populated from the Aqlpacket when begin debug
     HwDbgDim3 m_workGroupSize;
 
@@ -173,6 +181,10 @@ public:
     /// Save the code object in the AgentContext
     HsailAgentStatus AddKernelBinaryToContext(AgentBinary* pAgentBinary);
 
+    /// Write the ISA of the latest kernel binary for gdb, waits for its disassembly if needed.
+    /// Called before gdb takes control
+    HsailAgentStatus PublishKernelBinaryISA();
+
     /// The wrapper around the DBE's function
     HsailAgentStatus WaitForEvent(HwDbgEventType* pEventTypeOut);
 
@@ -193,6 +205,15 @@ public:
     /// Accessor method to return the focus wave controller for this context
     AgentFocusWaveControl* GetFocusWaveControl() const;
 
+    /// Accessor method to return the shared memory regions for this context
+    AgentSharedMemRegistry* GetSharedMemRegistry() const;
+
+    /// Accessor method to return the kernel binary cache for this context
+    AgentKernelBinaryCache* GetKernelBinaryCache() const;
+
+    /// Accessor method to return the load map of this context
+    AgentSegmentLoader* GetSegmentLoader() const;
+
     /// Return true if HwDebug has started
     bool HasHwDebugStarted() const;
 
@@ -202,6 +223,10 @@ public:
     /// Compare parent PID saved at object creation with present parent PID
     bool CompareParentPID() const;
 
+    /// Get a descriptor that can be polled for the parent's exit
+    /// \return The pidfd of the parent, -1 if not available
+    int GetParentPidFd() const;
+
     /// Add a device info to the list of available devices
     /// \param[in] handle    New device handle to be added to the list of handles.
     /// \param[in] device    New device descriptor to be added to the list of descriptors.
@@ -210,8 +235,39 @@ public:
     /// Set active device
     /// \param[in] handle    The devide handle corresponding to the currently active device.
     void SetActiveDevice(uint64_t handle);
+
+    /// Check if a binary was already sent to gdb in this session
+    /// \param[in] binaryHash The hash of the binary
+    bool IsBinarySentToGdb(const uint64_t binaryHash) const;
+
+    /// Record that a binary was sent to gdb
+    /// \param[in] binaryHash The hash of the binary
+    void AddBinarySentToGdb(const uint64_t binaryHash);
+
+    /// Check if the binary of a kernel was already sent to gdb in this session
+    /// \param[in] kernelObject The kernel_object of the AQL packet
+    bool IsKernelObjectSentToGdb(const uint64_t kernelObject) const;
+
+    /// Check if a binary was already sent to gdb for a kernel in this session
+    /// \param[in] kernelObject The kernel_object of the AQL packet
+    /// \param[in] binaryHash   The hash of the binary of the kernel
+    bool IsKernelObjectSentToGdb(const uint64_t kernelObject, const uint64_t binaryHash) const;
+
+    /// Record that the binary of a kernel was sent to gdb
+    /// \param[in] kernelObject The kernel_object of the AQL packet
+    /// \param[in] binaryHash   The hash of the binary of the kernel
+    void AddKernelObjectSentToGdb(const uint64_t kernelObject, const uint64_t binaryHash);
+
+    /// Forget the binaries and kernel objects sent to gdb if an executable was destroyed since
+    /// they were recorded, its kernel objects may be reused by another binary.
+    /// Called from the predispatch callback, with the debug engine held
+    void RefreshSentToGdb();
 };
 
+/// Record that an executable was destroyed, the binaries sent to gdb are forgotten
+/// by the next RefreshSentToGdb. Can be called from any thread
+void AgentForgetBinariesSentToGdb();
+
 } // End Namespace HwDbgAgent
 
 #endif // AGENT_CONTEXT_H_
@@ -0,0 +1,125 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Encoding and decoding of the framed messages exchanged with gdb
+//==============================================================================
+#ifndef AGENT_FRAMED_PROTOCOL_H_
+#define AGENT_FRAMED_PROTOCOL_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "CommunicationControl.h"
+
+/// The fields of a command that only a frame carries.
+/// They are not part of HsailCommandPacket, so the fixed size packets of an older gdb
+/// keep their size and layout
+typedef struct _HsailCommandFrameFields
+{
+    uint64_t m_syncId;                              // The sync request answered by a HSAIL_COMMAND_SYNC_MARKER
+    uint64_t m_binaryHash;                          // The binary whose ISA is asked for by HSAIL_COMMAND_GET_ISA
+    uint64_t m_pcEnd;                               // End of the PC range of HSAIL_COMMAND_GET_ISA, 0 for the whole binary
+    char m_kernelFilter[AGENT_MAX_SOURCE_LINE_LEN]; // The filter of HSAIL_COMMAND_SET_KERNEL_FILTER
+} HsailCommandFrameFields;
+
+namespace HwDbgAgent
+{
+
+/// Builds one framed message, see HsailFrameHeader for the layout.
+/// The header's length is kept up to date as fields are added, so the
+/// frame can be written out at any time.
+class AgentFrameWriter
+{
+public:
+    /// Constructor
+    /// \param[in] frameType The HsailCommand or HsailNotification value of the frame
+    explicit AgentFrameWriter(const uint16_t frameType);
+
+    /// Add a field of any size
+    void AddBytes(const HsailFrameTag tag, const void* pValue, const size_t valueSize);
+
+    /// Add a boolean field
+    void AddBool(const HsailFrameTag tag, const bool value);
+
+    /// Add a 32 bit integer field
+    void AddInt32(const HsailFrameTag tag, const int32_t value);
+
+    /// Add a 32 bit unsigned integer field
+    void AddUInt32(const HsailFrameTag tag, const uint32_t value);
+
+    /// Add a 64 bit unsigned integer field
+    void AddUInt64(const HsailFrameTag tag, const uint64_t value);
+
+    /// Add a string field, the null terminator is not written
+    void AddString(const HsailFrameTag tag, const std::string& value);
+
+    /// Get the start of the frame
+    const char* GetFrame() const;
+
+    /// Get the size of the frame, including the header
+    size_t GetFrameSize() const;
+
+private:
+    /// The frame bytes, starts with a HsailFrameHeader
+    std::vector<char> m_frame;
+
+    /// Disable default constructor
+    AgentFrameWriter();
+};
+
+/// Splits the bytes read from the gdb --> agent fifo into command packets.
+/// Both HsailCommandPacket structures and frames are accepted, a frame is
+/// translated into a HsailCommandPacket and the HsailCommandFrameFields of the
+/// fields that only frames carry, so AgentProcessPacket does not need
+/// to know which one gdb sent.
+class AgentCommandStreamDecoder
+{
+public:
+    /// Constructor
+    AgentCommandStreamDecoder();
+
+    /// Add bytes read from the fifo
+    void Append(const char* pBytes, const size_t numBytes);
+
+    /// Get the next complete packet
+    /// \param[out] packetOut      The decoded packet
+    /// \param[out] frameFieldsOut The fields only a frame carries, zero for a fixed size packet
+    /// \return true if a complete packet was available
+    bool GetNextPacket(HsailCommandPacket& packetOut, HsailCommandFrameFields& frameFieldsOut);
+
+    /// Check if there are bytes of an incomplete packet
+    bool HasPendingBytes() const;
+
+private:
+    /// Bytes that have not been decoded yet
+    std::vector<char> m_buffer;
+
+    /// Translate the fields of a frame into a packet
+    bool DecodeFrame(const HsailFrameHeader& header, const char* pFields,
+                     HsailCommandPacket& packetOut, HsailCommandFrameFields& frameFieldsOut) const;
+
+    /// Disable copy constructor
+    AgentCommandStreamDecoder(const AgentCommandStreamDecoder&);
+
+    /// Disable assignment operator
+    AgentCommandStreamDecoder& operator=(const AgentCommandStreamDecoder&);
+};
+
+/// Save the framing version announced by gdb, 0 means gdb only reads fixed size structures
+void AgentSetGdbProtocolVersion(const uint32_t version);
+
+/// Get the framing version announced by gdb
+uint32_t AgentGetGdbProtocolVersion();
+
+/// Translate a fixed size notification into a frame, this is the compatibility
+/// path for the notifications that are still built as HsailNotificationPayload
+/// \param[in]  payload  The notification
+/// \param[out] frameOut The frame, sized to the fields that the notification uses
+void AgentEncodeNotificationFrame(const HsailNotificationPayload& payload, std::vector<char>& frameOut);
+
+} // End Namespace HwDbgAgent
+
+#endif // AGENT_FRAMED_PROTOCOL_H_
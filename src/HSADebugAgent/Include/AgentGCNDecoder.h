@@ -0,0 +1,116 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief In process decoder of the GCN instructions of a code object
+//==============================================================================
+#ifndef AGENT_GCN_DECODER_H_
+#define AGENT_GCN_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "CommunicationControl.h"
+
+namespace HwDbgAgent
+{
+
+/// The instruction encodings of GCN3 (VI), the ISA of the fiji devices
+typedef enum
+{
+    AGENT_GCN_ENCODING_UNKNOWN,     /// Not a valid encoding, decoded as a single data word
+    AGENT_GCN_ENCODING_SOP2,
+    AGENT_GCN_ENCODING_SOPK,
+    AGENT_GCN_ENCODING_SOP1,
+    AGENT_GCN_ENCODING_SOPC,
+    AGENT_GCN_ENCODING_SOPP,
+    AGENT_GCN_ENCODING_SMEM,
+    AGENT_GCN_ENCODING_VOP2,
+    AGENT_GCN_ENCODING_VOP1,
+    AGENT_GCN_ENCODING_VOPC,
+    AGENT_GCN_ENCODING_VOP3,
+    AGENT_GCN_ENCODING_VINTRP,
+    AGENT_GCN_ENCODING_DS,
+    AGENT_GCN_ENCODING_MUBUF,
+    AGENT_GCN_ENCODING_MTBUF,
+    AGENT_GCN_ENCODING_MIMG,
+    AGENT_GCN_ENCODING_FLAT,
+    AGENT_GCN_ENCODING_EXP
+} AgentGCNEncoding;
+
+/// One decoded instruction
+typedef struct
+{
+    uint64_t         m_pc;          // Address of the instruction in the code object
+    uint32_t         m_words[2];    // The instruction words, a literal constant or a SDWA/DPP word is the second one
+    uint8_t          m_numWords;    // Number of valid words in m_words
+    AgentGCNEncoding m_encoding;
+    uint16_t         m_opcode;      // The opcode field of the encoding
+} AgentGCNInstruction;
+
+/// Decodes the .text section of a code object to instruction records sorted by PC,
+/// without calling an external disassembler.
+/// The decoding is table driven, each encoding is found from the high bits of the first word
+/// and gives the instruction size and the opcode field.
+/// Text is only rendered for the PC ranges asked for, the syntax follows llvm-objdump.
+class AgentGCNDecoder
+{
+public:
+    AgentGCNDecoder();
+
+    ~AgentGCNDecoder();
+
+    /// Decode all the instructions of the .text section.
+    /// The amd_kernel_code_t header at the start of every kernel symbol is skipped.
+    /// \param[in] pCodeObj The code object, an ELF64 file
+    /// \param[in] size     The size of the code object
+    /// \return HSAIL_AGENT_STATUS_FAILURE if the code object is not for a GFX8 device,
+    ///         from its ISA note or the machine in e_flags, or has no .text section
+    HsailAgentStatus Decode(const void* pCodeObj, const size_t size);
+
+    /// Decode the instructions in a buffer of instruction words
+    /// \param[in] pWords   The instruction words
+    /// \param[in] size     The size of the buffer in bytes
+    /// \param[in] startPC  The address of the first word
+    void DecodeWords(const void* pWords, const size_t size, const uint64_t startPC);
+
+    /// Get the decoded instructions, sorted by PC
+    const std::vector<AgentGCNInstruction>& GetInstructions() const;
+
+    /// Find the instruction that contains an address
+    /// \param[in] pc The address
+    /// \return The instruction, nullptr if no decoded instruction contains the address
+    const AgentGCNInstruction* FindInstruction(const uint64_t pc) const;
+
+    /// Render the instructions whose address is in [startPC, endPC) and the symbols at those addresses
+    /// \param[in]  startPC The first address
+    /// \param[in]  endPC   The address after the last one
+    /// \param[out] textOut The text, one instruction per line
+    void RenderText(const uint64_t startPC, const uint64_t endPC, std::string& textOut) const;
+
+    /// Render one instruction, without the address and the instruction words
+    /// \param[in]  instruction The decoded instruction
+    /// \param[out] textOut     The instruction mnemonic and its operands
+    static void RenderInstruction(const AgentGCNInstruction& instruction, std::string& textOut);
+
+private:
+    /// The decoded instructions, sorted by PC
+    std::vector<AgentGCNInstruction> m_instructions;
+
+    /// The kernel and function symbols of the .text section, keyed by address
+    std::map<uint64_t, std::string> m_symbols;
+
+    /// Disable copy constructor
+    AgentGCNDecoder(const AgentGCNDecoder&);
+
+    /// Disable assignment operator
+    AgentGCNDecoder& operator=(const AgentGCNDecoder&);
+};
+
+} // End Namespace HwDbgAgent
+
+#endif // AGENT_GCN_DECODER_H_
@@ -13,6 +13,7 @@
 
 namespace HwDbgAgent
 {
+class AgentSharedMemRegistry;
 
 /// A class that maintains a single ISA buffer
 class AgentISABuffer
@@ -25,13 +26,36 @@ public:
     /// Check if the kernel name exists in the ISA buffer text
     bool CheckForKernelName(const std::string& kernelName) const;
 
+    /// Disassemble the code object to the ISA dump file read by gdb and keep the text.
+    /// The GCN decoder is used, llvm-objdump if the decoder fails or ROCM_GDB_USE_LLVM_OBJDUMP is set
     HsailAgentStatus PopulateISAFromCodeObj(const size_t size, const void* codeObj);
 
+    /// Disassemble the code object and keep the text, the ISA dump file read by gdb is not changed.
+    /// The temporary files of llvm-objdump get the suffix, so calls with different suffixes can run in parallel
+    /// \param[in] fileNameSuffix Appended to the names of the temporary files
+    HsailAgentStatus PopulateISAFromCodeObj(const size_t       size,
+                                            const void*        codeObj,
+                                            const std::string& fileNameSuffix);
+
     /// Populate form the file given
     HsailAgentStatus PopulateISAFromFile(const std::string& filename);
 
-    /// Write the ISA text to a shared mem location provided
-    HsailAgentStatus WriteToSharedMem(const int isaBufferShmKey, const size_t m_isaBufferShmSize) const;
+    /// Populate from text disassembled earlier
+    HsailAgentStatus PopulateISAFromText(const std::string& isaText);
+
+    /// Write the ISA text to the ISA dump file read by gdb
+    HsailAgentStatus WriteToISADumpFile() const;
+
+    /// Get the ISA text, empty if the ISA has not been populated
+    std::string GetISAText() const;
+
+    /// Write the ISA text to the ISA buffer shared mem
+    /// \param[in] pSharedMemRegistry The shared memory regions of the agent context
+    HsailAgentStatus WriteToSharedMem(AgentSharedMemRegistry* pSharedMemRegistry) const;
+
+    /// Check if ROCM_GDB_USE_LLVM_OBJDUMP asks for llvm-objdump instead of the GCN decoder.
+    /// If its value is the path of a file, that file is run as llvm-objdump
+    static bool IsLLVMObjDumpForced();
 
 private:
 
@@ -48,14 +72,23 @@ private:
     AgentISABuffer& operator=(const AgentISABuffer&);
 
     /// Disassemble the code object using amdhsacod and save the ISA
-    HsailAgentStatus  DisassembleAMDHsaCod(const size_t size, const void* codeObj);
+    HsailAgentStatus  DisassembleAMDHsaCod(const size_t       size,
+                                           const void*        codeObj,
+                                           const std::string& codeObjFilename,
+                                           const std::string& isatextFilename);
 
     /// Disassemble the code object using llvm-objdump and save the ISA
-    HsailAgentStatus  DisassembleLLVMObjDump(const size_t size, const void* codeObj);
+    HsailAgentStatus  DisassembleLLVMObjDump(const size_t       size,
+                                             const void*        codeObj,
+                                             const std::string& codeObjFilename,
+                                             const std::string& isatextFilename);
 
     /// Check if the amdhsacod exists, by calling "which amdhsacod"
     bool TestForAMDHsaCod();
 
+    /// Disassemble the code object with the in process GCN decoder and save the ISA
+    HsailAgentStatus DisassembleGCNDecoder(const size_t size, const void* codeObj);
+
 };
 
 }
@@ -0,0 +1,85 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Background threads that disassemble code objects
+//==============================================================================
+#ifndef AGENT_ISA_WORKER_H_
+#define AGENT_ISA_WORKER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "CommunicationControl.h"
+
+namespace HwDbgAgent
+{
+
+/// Queue a code object to be disassembled by the ISA worker threads.
+/// The threads are started by the first call, their number is given by
+/// ROCM_GDB_ISA_WORKER_THREADS (1 by default). A code object with the same hash
+/// already queued or disassembled is not queued again, a deferred one is queued.
+/// The code object is copied, the caller can release it when the call returns.
+/// If no thread could be started the code object is disassembled before the call returns.
+/// \param[in] binaryHash The hash of the code object
+/// \param[in] pBinary    The code object
+/// \param[in] binarySize The size of the code object
+/// \return HSAIL agent status
+HsailAgentStatus AgentQueueISADisassembly(const uint64_t binaryHash,
+                                          const void*    pBinary,
+                                          const size_t   binarySize);
+
+/// Keep a copy of a code object so it can be disassembled if gdb asks for its ISA.
+/// Nothing is disassembled, AgentGetDisassembledISA queues the job.
+/// Deferred code objects count against the same limit as the ISA text of the done jobs,
+/// the oldest are dropped first. A dropped code object can be deferred again, see AgentIsDeferredISAEvicted.
+/// \param[in] binaryHash The hash of the code object
+/// \param[in] pBinary    The code object
+/// \param[in] binarySize The size of the code object
+/// \return HSAIL agent status
+HsailAgentStatus AgentDeferISADisassembly(const uint64_t binaryHash,
+                                          const void*    pBinary,
+                                          const size_t   binarySize);
+
+/// Get the ISA text of a queued or deferred code object.
+/// Returns at once if the text is ready, otherwise only waits for the job of that code object,
+/// which is moved to the front of the queue if no thread has started it.
+/// A deferred code object is queued at the front of the queue.
+/// \param[in]  binaryHash The hash of the code object
+/// \param[out] isaTextOut The ISA text
+/// \return true if the code object was disassembled
+bool AgentGetDisassembledISA(const uint64_t binaryHash, std::string& isaTextOut);
+
+/// Check if the deferred copy of a code object was dropped under the memory limit.
+/// gdb can only get its ISA once the code object is given to AgentDeferISADisassembly again
+/// \param[in]  binaryHash     The hash of the code object
+/// \param[out] codeObjSizeOut The size of the code object
+/// \return true if the code object was dropped and not deferred again
+bool AgentIsDeferredISAEvicted(const uint64_t binaryHash, size_t& codeObjSizeOut);
+
+/// Get the ISA text of the instructions of a code object in [startPC, endPC).
+/// Only that range is rendered, the code object of a deferred or queued job is decoded
+/// with the GCN decoder on the calling thread and the job is left as it is.
+/// \param[in]  binaryHash The hash of the code object
+/// \param[in]  startPC    The first address, relative to the code object
+/// \param[in]  endPC      The address after the last one
+/// \param[out] isaTextOut The ISA text
+/// \return false if the code object is not kept anymore or could not be decoded,
+///         AgentGetDisassembledISA gives the whole text then
+bool AgentGetISARange(const uint64_t binaryHash,
+                      const uint64_t startPC,
+                      const uint64_t endPC,
+                      std::string&   isaTextOut);
+
+/// Stop and join the ISA worker threads, the jobs not started are dropped
+void AgentStopISAWorkers();
+
+/// Log the jobs queued, reused, completed, the waits for a job,
+/// the deferred jobs that were never disassembled and the ranges decoded
+void AgentLogISAWorkerStatistics();
+
+} // End Namespace HwDbgAgent
+
+#endif // AGENT_ISA_WORKER_H_
@@ -0,0 +1,143 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Cache of the data the agent derives from a kernel binary
+//==============================================================================
+#ifndef AGENT_KERNEL_BINARY_CACHE_H_
+#define AGENT_KERNEL_BINARY_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <pthread.h>
+#include <string>
+#include <utility>
+
+namespace HwDbgAgent
+{
+
+/// Keeps the demangled kernel name and the ISA text of the kernels dispatched before,
+/// so a repeated dispatch does not run c++filt and the disassembler again.
+/// An entry is keyed by the kernel_object of the AQL packet and the hash of the binary,
+/// a code object loaded again at the same address with a different content is a miss.
+/// The ISA text is disassembled from the whole binary, so it is stored once per binary hash
+/// and shared by the entries of all the kernels of the binary.
+/// The least recently used entries are evicted once the cached text exceeds the limit
+/// given by ROCM_GDB_KERNEL_BINARY_CACHE_MB (64MB by default, 0 disables the cache).
+/// The cache is filled by the dispatches and by the code object ingestion thread, all the calls lock it.
+class AgentKernelBinaryCache
+{
+public:
+    AgentKernelBinaryCache();
+
+    ~AgentKernelBinaryCache();
+
+    /// Look for a kernel, a hit makes the entry the most recently used one
+    /// \param[in]  kernelObject     The kernel_object of the AQL packet
+    /// \param[in]  binaryHash       The hash of the binary
+    /// \param[out] kernelNameOut    The demangled kernel name
+    /// \param[out] pISATextOut      The ISA text of the binary, nullptr if the ISA was not disassembled
+    /// \return true if the kernel is in the cache
+    bool Find(const uint64_t                       kernelObject,
+              const uint64_t                       binaryHash,
+              std::string&                         kernelNameOut,
+              std::shared_ptr<const std::string>&  pISATextOut);
+
+    /// Add or replace the entry of a kernel, evicts old entries if needed
+    /// \param[in] kernelObject The kernel_object of the AQL packet
+    /// \param[in] binaryHash   The hash of the binary
+    /// \param[in] kernelName   The demangled kernel name
+    /// \param[in] isaText      The ISA text, empty if the ISA was not disassembled.
+    ///                         The text of the binary is kept if it is already cached
+    void Add(const uint64_t     kernelObject,
+             const uint64_t     binaryHash,
+             const std::string& kernelName,
+             const std::string& isaText);
+
+    /// Add the entry of a kernel with no ISA text if there is no entry for it yet
+    /// \param[in] kernelObject The kernel_object the kernel is dispatched with
+    /// \param[in] binaryHash   The hash of the binary
+    /// \param[in] kernelName   The demangled kernel name
+    /// \return true if the entry was added
+    bool AddKernelName(const uint64_t     kernelObject,
+                       const uint64_t     binaryHash,
+                       const std::string& kernelName);
+
+    /// Log the hits, misses, evictions and the memory used
+    void LogStatistics() const;
+
+private:
+    typedef std::pair<uint64_t, uint64_t> CacheKey;
+
+    typedef struct
+    {
+        CacheKey    m_key;          // kernel_object and binary hash
+        std::string m_kernelName;   // Demangled kernel name
+        std::shared_ptr<const std::string> m_pISAText;  // ISA text of the binary, nullptr if not disassembled
+    } CacheEntry;
+
+    /// The ISA text of a binary and the number of entries that reference it
+    typedef struct
+    {
+        std::shared_ptr<const std::string> m_pISAText;
+        size_t m_numEntries;
+    } ISATextEntry;
+
+    typedef std::list<CacheEntry> CacheEntryList;
+
+    /// The entries, the most recently used first
+    CacheEntryList m_entries;
+
+    /// Position of every entry in m_entries
+    std::map<CacheKey, CacheEntryList::iterator> m_entryIndex;
+
+    /// The ISA text of every binary referenced by an entry, keyed by the binary hash
+    std::map<uint64_t, ISATextEntry> m_isaTexts;
+
+    /// Bytes of text held by the entries, the ISA text of a binary is counted once
+    size_t m_size;
+
+    /// Limit of m_size
+    size_t m_maxSize;
+
+    uint64_t m_numHits;
+    uint64_t m_numMisses;
+    uint64_t m_numEvictions;
+    uint64_t m_numPrefilled;
+
+    /// Protects all the members
+    mutable pthread_mutex_t m_mutex;
+
+    /// Bytes counted against m_maxSize for an entry, not counting the ISA text
+    static size_t GetEntrySize(const CacheEntry& entry);
+
+    /// Get the ISA text of a binary to reference from a new entry, stores the text if the binary has none yet.
+    /// Called with m_mutex held
+    /// \return The shared ISA text, nullptr if the binary has no ISA text
+    std::shared_ptr<const std::string> ReferenceISAText(const uint64_t binaryHash, const std::string& isaText);
+
+    /// Drop the reference of an entry to the ISA text of its binary, the text is freed with the last reference.
+    /// Called with m_mutex held
+    void ReleaseISAText(const CacheEntry& entry);
+
+    /// Remove an entry
+    void RemoveEntry(const CacheEntryList::iterator& entryIt);
+
+    /// Add an entry, replaces the entry of the same key and evicts old entries if needed
+    /// Called with m_mutex held
+    void InsertEntry(const CacheKey& key, const std::string& kernelName, const std::string& isaText);
+
+    /// Disable copy constructor
+    AgentKernelBinaryCache(const AgentKernelBinaryCache&);
+
+    /// Disable assignment operator
+    AgentKernelBinaryCache& operator=(const AgentKernelBinaryCache&);
+};
+
+} // End Namespace HwDbgAgent
+
+#endif // AGENT_KERNEL_BINARY_CACHE_H_
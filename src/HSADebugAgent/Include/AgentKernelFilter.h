@@ -0,0 +1,60 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Selection of the dispatches that are debugged
+//==============================================================================
+#ifndef AGENT_KERNEL_FILTER_H_
+#define AGENT_KERNEL_FILTER_H_
+
+#include <cstdint>
+#include <string>
+
+#include "CommunicationControl.h"
+
+namespace HwDbgAgent
+{
+
+/// Set the kernel filter, only the dispatches it selects enter the debug engine.
+/// The filter is a list of clauses separated by ';':
+///     name=GLOB       The kernel name matches the shell pattern (a clause without '=' is a name too)
+///     regex=ERE       The kernel name matches the POSIX extended regular expression
+///     dispatch=N      The dispatch is the Nth one of the process, counted from 1 over all the queues
+///     dispatch=N-M    The dispatch is one of the Nth to the Mth, "N-" has no upper bound
+///     queue=ID        The dispatch is on the queue with this id
+/// A dispatch is selected if it matches one clause of each kind the filter has.
+/// A kernel name is the symbol name the application asked the kernel object for,
+/// or the demangled name gdb shows once the kernel was debugged.
+/// An empty filter selects every dispatch, the initial filter is ROCM_GDB_KERNEL_FILTER.
+/// \param[in] filterText The filter
+/// \return HSAIL agent status, the previous filter is kept if the filter is not valid
+HsailAgentStatus AgentSetKernelFilter(const std::string& filterText);
+
+/// Check if the kernel filter selects a dispatch, counts the dispatch ordinal.
+/// Without a filter, no lock is taken. The name clauses are only matched
+/// once per kernel object, a kernel object without a known name is selected.
+/// \param[in] kernelObject The kernel_object of the AQL packet
+/// \param[in] queueId      The id of the queue of the dispatch
+/// \return true if the dispatch is debugged
+bool AgentIsDispatchSelected(const uint64_t kernelObject, const uint64_t queueId);
+
+/// Check if a name is known for a kernel object
+bool AgentIsKernelNameKnown(const uint64_t kernelObject);
+
+/// Add a name of a kernel object, the name clauses are matched against all the names of a kernel object
+/// \param[in] kernelObject The kernel_object of the AQL packet
+/// \param[in] kernelName   The symbol or the demangled name of the kernel
+void AgentRecordKernelName(const uint64_t kernelObject, const std::string& kernelName);
+
+/// Forget the kernel names and the name verdicts, a destroyed executable may have its kernel
+/// objects reused by a kernel of another name. The kernels of the executables that are
+/// still loaded are selected till their names are recorded again by the predispatch
+void AgentForgetKernelNames();
+
+/// Log the number of selected dispatches and of name matches
+void AgentLogKernelFilterStatistics();
+
+} // End Namespace HwDbgAgent
+
+#endif // AGENT_KERNEL_FILTER_H_
@@ -19,7 +19,28 @@ void AgentNotifyGDB();
 /// Trigger the GDB event loop
 void AgentTriggerGDBEventLoop();
 
-HsailAgentStatus AgentNotifyBreakpointHit(const HsailNotificationPayload payload);
+/// Queue the notifications pushed by this thread till AgentEndNotificationBatch.
+/// Batches can be nested, only the outermost AgentEndNotificationBatch writes to the FIFO.
+/// Do not open a batch around a notification the agent then waits for an answer to.
+void AgentBeginNotificationBatch();
+
+/// Write all the queued notifications with a single write
+/// \param[in] triggerGdb Raise one signal to trigger the GDB event loop after the write,
+///                       false when the caller triggers gdb itself right after
+/// \return HSAIL agent status
+HsailAgentStatus AgentEndNotificationBatch(const bool triggerGdb);
+
+/// Log the number of notifications, batches, bytes, signals and binaries sent to gdb so far
+void AgentLogNotificationStatistics();
+
+/// Let gdb know that breakpoints were hit
+/// A gdb that reads frames gets every hit, an older gdb gets the first
+/// HSAIL_MAX_REPORTABLE_BREAKPOINTS hits
+/// \param[in] numActiveWaves The number of waves written to shared mem
+/// \param[in] hits           The breakpoints hit and their hit counts
+/// \return HSAIL agent status
+HsailAgentStatus AgentNotifyBreakpointHit(const int                                    numActiveWaves,
+                                          const std::vector<HsailBreakpointHitRecord>& hits);
 
 // Let gdb know how many active waves we have now
 HsailAgentStatus AgentNotfiyNewActiveWaves(const int numActiveWaves);
@@ -30,11 +51,24 @@ HsailAgentStatus AgentNotfiyNewActiveWaves(const int numActiveWaves);
 /// the GDB is notified multiple times with for the same binary or
 /// 1 binary doesn't describe one dispatch sufficiently in the future.
 HsailAgentStatus AgentNotifyNewBinary(const size_t                        binarySize,
+                                      const uint64_t                      binaryHash,
                                       const std::string&                  kernelName,
                                       const hsa_kernel_dispatch_packet_t* pAqlPacket,
                                       const uint64_t                      queueID,
                                       const uint64_t                      packetID);
 
+/// Let GDB know that a dispatch uses a binary it received earlier in the session,
+/// the binary is not written to shared memory again.
+/// Only valid if gdb announced HSAIL_FRAME_PROTOCOL_VERSION_REUSE_BINARY
+/// \param[in] binarySize The size of the binary, only used for the statistics
+/// \param[in] binaryHash The hash sent with the HSAIL_NOTIFY_NEW_BINARY of the binary
+HsailAgentStatus AgentNotifyReuseBinary(const size_t                        binarySize,
+                                        const uint64_t                      binaryHash,
+                                        const std::string&                  kernelName,
+                                        const hsa_kernel_dispatch_packet_t* pAqlPacket,
+                                        const uint64_t                      queueID,
+                                        const uint64_t                      packetID);
+
 /// Let GDB know about a change in the focus workgroup and workitem
 HsailAgentStatus AgentNotifyFocusChange(const HwDbgDim3& focusWorkGroup,
                                         const HwDbgDim3& focusWorkItem);
@@ -51,6 +85,19 @@ HsailAgentStatus AgentNotifyEndDebugging(const bool hasDispatchCompleted);
 /// Let GDB know if the application is in the predispatch callback
 HsailAgentStatus AgentNotifyPredispatchState(const HsailPredispatchState ipState);
 
+/// Ask GDB to reply with a sync marker once all its pending commands have been sent
+HsailAgentStatus AgentNotifySyncRequest(const uint64_t syncId);
+
+/// Reply to HSAIL_COMMAND_GET_ISA
+/// \param[in] binaryHash The binary gdb asked for
+/// \param[in] isaSize    Bytes of ISA text written to the ISA buffer shared mem, 0 if not disassembled
+HsailAgentStatus AgentNotifyISAReady(const uint64_t binaryHash, const size_t isaSize);
+
+/// Let gdb know the key of the command ring, only for a gdb that announced
+/// HSAIL_FRAME_PROTOCOL_VERSION_COMMAND_RING_KEY
+/// \param[in] shmKey The key the command ring was created with, 0 if there is no ring
+HsailAgentStatus AgentNotifyCommandRing(const key_t shmKey);
+
 /// Let GDB know about the debug threads ID. We use the debug thread ID to single step accordingly
 HsailAgentStatus AgentNotifyDebugThreadID();
 
@@ -15,14 +15,17 @@
 #include "AMDGPUDebug.h"
 
 // HSA Agent includes
+#include "AgentFramedProtocol.h"
 #include "CommunicationControl.h"
 
 
 // Process agent packet. This function is called from the command loop.
 // Within this function we break down the packet and call the appropriate
 // functions in the file
-void AgentProcessPacket(HwDbgAgent::AgentContext* pActiveContext,
-                        const HsailCommandPacket& packet);
+// The frame fields are zero for a fixed size packet
+void AgentProcessPacket(HwDbgAgent::AgentContext*      pActiveContext,
+                        const HsailCommandPacket&      packet,
+                        const HsailCommandFrameFields& frameFields);
 
 void SetEvaluatorActiveContext(HwDbgAgent::AgentContext* activeContext);
 
@@ -0,0 +1,130 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Per-queue state of the dispatch callbacks and the debug engine they share
+//==============================================================================
+#ifndef AGENT_QUEUE_CONTEXT_H_
+#define AGENT_QUEUE_CONTEXT_H_
+
+#include <cstdint>
+
+#include <hsa.h>
+
+#include "CommunicationControl.h"
+
+namespace HwDbgAgent
+{
+class AgentBreakpointManager;
+class AgentContext;
+
+/// The state of one queue, passed as the argument of its dispatch callbacks.
+///
+/// The DBE, the gdb session and the debug thread can only debug one dispatch at a time,
+/// all the queues share them as "the debug engine". The engine is held from the start of
+/// a predispatch callback till the debug thread of that dispatch exits, and for the DBE
+/// queries done outside of the dispatches.
+/// A dispatch of another queue runs without being debugged while the engine is held
+/// if it can not stop: its kernel is not the one being debugged, gdb has seen its binary,
+/// it did not match a function breakpoint when it was prepared and no enabled or pending
+/// breakpoint is at a PC of the segment of its code object. A queue then does not stall while
+/// a dispatch of another queue is debugged.
+/// Setting ROCM_GDB_DISABLE_QUEUE_OVERLAP makes every dispatch wait for the engine.
+class AgentQueueContext
+{
+public:
+
+    AgentQueueContext(AgentContext* pAgentContext, const hsa_queue_t* pQueue);
+
+    AgentContext* GetAgentContext() const { return m_pAgentContext; }
+
+    uint64_t GetQueueId() const { return m_queueId; }
+
+    /// Acquire the debug engine for a dispatch of this queue, waits while it is held
+    /// unless the dispatch can not stop.
+    /// \param[in] kernelObject The kernel_object of the AQL packet
+    /// \return true if the engine was acquired, AgentReleaseDebugEngine must be called,
+    ///         false if the dispatch runs without the debug engine
+    bool AcquireDebugEngine(const uint64_t kernelObject);
+
+    /// Log the number of dispatches, of engine waits and of dispatches that were not debugged
+    void LogStatistics() const;
+
+private:
+
+    AgentQueueContext();
+
+    /// Disable copy constructor
+    AgentQueueContext(const AgentQueueContext&);
+
+    /// Disable assignment operator
+    AgentQueueContext& operator=(const AgentQueueContext&);
+
+    /// Check if a dispatch needs the engine held by a dispatch of another queue
+    /// Called with the engine mutex held
+    bool IsDebugEngineNeeded(const uint64_t kernelObject) const;
+
+    AgentContext* m_pAgentContext;
+
+    uint64_t m_queueId;
+
+    // Counters, only changed with the engine mutex held
+    uint64_t m_numDispatches;
+    uint64_t m_numDebugEngineWaits;
+    uint64_t m_numDispatchesNotDebugged;
+};
+
+/// Create the context of a queue, it is kept till AgentDeleteQueueContexts
+/// \param[in] pAgentContext The agent context
+/// \param[in] pQueue        The queue
+/// \return The queue context, nullptr if it could not be allocated
+AgentQueueContext* AgentCreateQueueContext(AgentContext* pAgentContext, const hsa_queue_t* pQueue);
+
+/// Log the statistics of all the queue contexts
+void AgentLogQueueStatistics();
+
+/// Delete all the queue contexts, no dispatch callback may run anymore
+void AgentDeleteQueueContexts();
+
+/// Take another hold on the acquired debug engine, for the debug thread of the dispatch
+void AgentRetainDebugEngine();
+
+/// Take the debug engine for a DBE query outside of a dispatch if nothing holds it.
+/// The DBE is only called by the holder of the engine, every dispatch waits for the query
+/// \return true if the engine was acquired, AgentReleaseDebugEngine must be called
+bool AgentTryAcquireIdleDebugEngine();
+
+/// Wait till nothing holds the debug engine and take it for a DBE query outside of a dispatch,
+/// AgentReleaseDebugEngine must be called. Must not be called with the engine held
+void AgentAcquireIdleDebugEngine();
+
+/// Drop a hold on the debug engine, the waiting dispatches are woken up once there is no hold
+void AgentReleaseDebugEngine();
+
+/// Record that gdb has the binary of a kernel object, if it matched a function breakpoint
+/// and the PCs of the segment of its code object.
+/// A dispatch of a recorded kernel object that did not match and has no breakpoint in its
+/// segment does not wait for the engine.
+/// \param[in] kernelObject           The kernel_object of the AQL packet
+/// \param[in] hasFunctionBreakpoint  true if the kernel name matched a function breakpoint
+/// \param[in] codeStart              The first PC of the segment of the kernel
+/// \param[in] codeEnd                The PC just past the segment, UINT64_MAX with a codeStart of 0
+///                                   if the segment is not known
+void AgentRecordPreparedKernel(const uint64_t kernelObject,
+                               const bool     hasFunctionBreakpoint,
+                               const uint64_t codeStart,
+                               const uint64_t codeEnd);
+
+/// Forget the prepared kernel objects, a destroyed executable may have its kernel objects reused
+void AgentForgetPreparedKernels();
+
+/// Record the enabled and pending breakpoints of gdb, called after the breakpoints may have changed.
+/// A dispatch waits for the engine if one of them is at a PC of its segment, the kernels are
+/// matched against the function breakpoints again if those changed
+/// \param[in] bpManager The breakpoint manager of the agent context
+void AgentSetActiveBreakpoints(const AgentBreakpointManager& bpManager);
+
+} // End Namespace HwDbgAgent
+
+#endif // AGENT_QUEUE_CONTEXT_H_
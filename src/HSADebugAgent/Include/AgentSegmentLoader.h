@@ -5,6 +5,10 @@
 /// \file
 /// \brief Agent Segment Loader
 //==============================================================================
+#include <pthread.h>
+#include <set>
+#include <vector>
+
 #include "AMDGPUDebug.h"
 
 #include "AgentUtils.h"
@@ -12,41 +16,181 @@
 
 namespace HwDbgAgent
 {
+class AgentSharedMemRegistry;
+
+/// Record that an executable was loaded or destroyed, the next UpdateLoadedSegments
+/// asks the DBE for the load map again.
+/// Called by the interception of hsa_executable_freeze and hsa_executable_destroy, on any thread
+void AgentInvalidateLoadMap();
+
+/// Get the load map generation, read before a query of the loaded segments to tag its result
+uint64_t AgentGetLoadMapGeneration();
 
-/// Class to manage the presently loaded segments for a particular dispatch
-/// and share the information with gdb via shared mem
+/// Ask the DBE for the loaded segments, the queries of all the threads are serialized
+/// \param[out] segmentsOut The segments
+/// \return HSAIL agent status
+HsailAgentStatus AgentQueryLoadedSegments(std::vector<HwDbgLoaderSegmentDescriptor>& segmentsOut);
+
+/// Class to manage the loaded segments and share them with gdb via shared mem.
+/// The load map is kept for the whole session, the DBE is only asked for it when
+/// the load map generation changed. Only the segments added or removed since the
+/// last dispatch and the executed segment flag are written to the shared mem.
 class AgentSegmentLoader
 {
 public:
 
-    /// Initialize with the dispatch packet
-    AgentSegmentLoader(hsa_kernel_dispatch_packet_t* pAqlPacket);
+    /// Initialize with the shared memory regions of the agent context
+    AgentSegmentLoader(AgentSharedMemRegistry* pSharedMemRegistry);
 
     ~AgentSegmentLoader();
 
-    /// Query the runtime for the latest loaded segments and notify gdb
-    HsailAgentStatus UpdateLoadedSegments();
+    /// Update the load map if it changed, mark the segment of the dispatched kernel and notify gdb
+    /// \param[in] kernelObjectAddress The kernel_object of the AQL packet
+    HsailAgentStatus UpdateLoadedSegments(const uint64_t kernelObjectAddress);
+
+    /// Query the DBE for the load map ahead of UpdateLoadedSegments if the load map changed.
+    /// Does not touch the load map gdb sees. The query is skipped while the debug engine is held
+    /// \return HSAIL agent status
+    HsailAgentStatus PrepareLoadMap();
+
+    /// Prepare the load map from segments another thread read from the DBE, so a dispatch
+    /// finds it prepared even if the debug engine was held when it started.
+    /// Called by the code object ingestion thread after its query, does not touch the load map gdb sees
+    /// \param[in] generation The load map generation read before the segments were queried
+    /// \param[in] segments   The loaded segments
+    void OfferLoadMap(const uint64_t generation, const std::vector<HwDbgLoaderSegmentDescriptor>& segments);
+
+    /// Get the ELF virtual address range of the segment of the last dispatched kernel,
+    /// the PCs gdb sets breakpoints at in that code object. Called after UpdateLoadedSegments
+    /// \param[out] elfVAStartOut The ELF virtual address of the start of the segment
+    /// \param[out] elfVAEndOut   The ELF virtual address just past the end of the segment
+    /// \return false if the segment is not known or its code object is not in memory
+    bool GetExecutedSegmentElfRange(uint64_t& elfVAStartOut, uint64_t& elfVAEndOut) const;
+
+    /// Find a code object of the load map gdb sees by the hash of its content.
+    /// Called by the holder of the debug engine, fails if an executable was loaded or destroyed since
+    /// the load map was read so that the storage of an unloaded code object is never read
+    /// \param[in]  binaryHash  The hash of the code object
+    /// \param[in]  binarySize  The size of the code object
+    /// \param[out] pBinaryOut  The code object in the memory of the runtime
+    /// \return true if the code object was found
+    bool FindLoadedCodeObject(const uint64_t binaryHash, const size_t binarySize, const void*& pBinaryOut) const;
+
+    /// Log the number of load map queries and of the segments added and removed
+    void LogStatistics() const;
+
+    /// Get the ELF virtual address of a segment from the program headers of its code object
+    /// \return The address, 0 if the code object is not in memory or has no program header for the segment
+    static uint64_t GetSegmentElfVA(const HwDbgLoaderSegmentDescriptor& segment);
 
 private:
 
+    /// A segment in the address index
+    typedef struct
+    {
+        uint64_t m_segmentBase;
+        uint64_t m_segmentSize;
+        uint64_t m_executable;
+        uint64_t m_codeObjectStorageOffset;
+        size_t   m_slot;        // Position of the descriptor in m_segments and in the shared mem
+    } SegmentIndexEntry;
+
+    /// A load map read from the DBE, not applied yet
+    typedef struct
+    {
+        uint64_t m_generation;                                  // The load map generation it was read at
+        std::vector<HwDbgLoaderSegmentDescriptor> m_segments;   // The segments in the order of the DBE
+        std::vector<uint64_t> m_segmentElfVAs;                  // The ELF virtual address of each segment
+        std::vector<SegmentIndexEntry> m_index;                 // Sorted, m_slot is the position in m_segments
+    } DbeLoadMap;
+
     AgentSegmentLoader();
 
-    void ClearLoadedSegments();
+    /// Disable copy constructor
+    AgentSegmentLoader(const AgentSegmentLoader&);
+
+    /// Disable assignment operator
+    AgentSegmentLoader& operator=(const AgentSegmentLoader&);
+
+    /// Ask the DBE for the loaded segments and apply the difference with the present load map.
+    /// A load map prepared at the present generation is applied without a new query
+    /// \param[in] isPreparedLoadMapUsable false if the load map must be queried again
+    HsailAgentStatus RefreshLoadMap(const bool isPreparedLoadMapUsable);
+
+    /// Ask the DBE for the loaded segments, get their ELF virtual addresses and sort them
+    /// \param[out] loadMapOut The load map
+    static HsailAgentStatus QueryLoadMap(DbeLoadMap& loadMapOut);
+
+    /// Get the ELF virtual addresses of the segments of a load map and build its sorted index
+    static void IndexLoadMap(DbeLoadMap& loadMap);
+
+    /// Keep a load map as the prepared one if it is newer, the load map is swapped out
+    void KeepPreparedLoadMap(DbeLoadMap& loadMap);
+
+    /// Append a segment, its descriptor is written to the shared mem
+    void AddSegment(const HsailSegmentDescriptor& segment);
+
+    /// Remove the segment at a position of the index, the last descriptor takes its slot
+    void RemoveSegment(const size_t indexPosition);
+
+    /// Find the slot of the segment that contains an address with a binary search of the index
+    /// \return The slot, SIZE_MAX if no segment contains the address
+    size_t FindSegmentSlot(const uint64_t address) const;
+
+    /// Write the changed descriptors to the load map shared mem
+    HsailAgentStatus WriteToSharedMemory();
+
+    /// Order the index by base address, then by the other fields that identify a segment
+    static bool IsIndexEntryBefore(const SegmentIndexEntry& lhs, const SegmentIndexEntry& rhs);
+
+    /// The descriptors in the order of the shared mem
+    std::vector<HsailSegmentDescriptor> m_segments;
+
+    /// The segments sorted by IsIndexEntryBefore
+    std::vector<SegmentIndexEntry> m_segmentIndex;
+
+    /// Buffer for the DBE query, kept to avoid an allocation per query
+    DbeLoadMap m_dbeLoadMap;
+
+    /// The load map prepared by PrepareLoadMap, m_generation is 0 if there is none
+    DbeLoadMap m_preparedLoadMap;
+
+    /// Protects m_preparedLoadMap and the counters of PrepareLoadMap
+    mutable pthread_mutex_t m_preparedLoadMapMutex;
+
+    /// Slots written since the last update of the shared mem
+    std::set<size_t> m_dirtySlots;
 
-    HsailAgentStatus WriteToSharedMemory() const;
+    /// The kernel_objects found in no segment after querying the DBE again,
+    /// they are not queried for again till the load map generation changes
+    std::set<uint64_t> m_missedKernelObjects;
 
-    size_t FindExecutedSegment() const;
+    /// The slot of the segment of the last dispatched kernel, SIZE_MAX if not known
+    size_t m_executedSlot;
 
-    void AddElfVAForEachSegmentDescriptor(HsailSegmentDescriptor* pSegments) const;
+    /// The load map generation m_segments was read at, 0 before the first query.
+    /// Read atomically by PrepareLoadMap
+    uint64_t m_generation;
 
-    HwDbgLoaderSegmentDescriptor* m_pLoadedSegments;
+    /// True until the whole load map has been written to the shared mem once,
+    /// and when the updates move from the legacy SysV segment to the buffer with a header
+    bool m_isFullWriteNeeded;
 
-    size_t m_numLoadedSegments;
+    /// True if the load map gdb has is in the legacy SysV segment
+    bool m_isPublishedToLegacyBuffer;
 
-    int m_loadedSegmentShmKey;
+    /// The number of descriptors gdb has in the shared mem
+    size_t m_numPublishedSegments;
 
-    size_t m_loadedSegmentShmMaxSize;
+    AgentSharedMemRegistry* m_pSharedMemRegistry;
 
-    uint64_t m_kernelObjectAddress;
+    uint64_t m_numQueries;
+    uint64_t m_numQueriesForMiss;
+    uint64_t m_numMissesRemembered;
+    uint64_t m_numSegmentsAdded;
+    uint64_t m_numSegmentsRemoved;
+    uint64_t m_numUpdatesSkipped;
+    uint64_t m_numLoadMapsPrepared;
+    uint64_t m_numPreparedLoadMapsUsed;
 };
 }
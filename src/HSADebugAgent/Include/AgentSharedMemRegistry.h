@@ -0,0 +1,159 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Registry of the shared memory regions used to communicate with gdb
+//==============================================================================
+#ifndef AGENT_SHARED_MEM_REGISTRY_H_
+#define AGENT_SHARED_MEM_REGISTRY_H_
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+#include "CommunicationControl.h"
+
+namespace HwDbgAgent
+{
+
+/// A class that owns all the shared memory regions used to exchange data with gdb.
+/// The registry is part of the AgentContext. Every region is allocated and attached
+/// once when the AgentContext is initialized, and stays attached until the AgentContext
+/// is shut down.
+/// The regions are POSIX shared memory objects, they start small and grow when the data
+/// does not fit. Growing a region may move it, so writers use the address returned by
+/// BeginRegionUpdate and do not keep it past EndRegionUpdate.
+/// A gdb older than HSAIL_FRAME_PROTOCOL_VERSION_SHARED_BUFFERS only knows the fixed size
+/// SysV segments, so every region also has a SysV segment that is used till gdb announces
+/// a newer version.
+class AgentSharedMemRegistry
+{
+public:
+    /// Constructor, reads the key and size of each region from the active configuration
+    AgentSharedMemRegistry();
+
+    /// Destructor, detaches and frees the regions if not done already
+    ~AgentSharedMemRegistry();
+
+    /// Allocate and attach all the shared memory regions
+    /// \return HSAIL agent status
+    HsailAgentStatus MapAllRegions();
+
+    /// Detach and free all the shared memory regions
+    /// \return HSAIL agent status
+    HsailAgentStatus UnMapAllRegions();
+
+    /// Get the attached address of a region, the SysV segment for an older gdb
+    /// \param[in] region The requested shared memory region
+    /// \return The address of the region, nullptr if the region is not attached
+    void* GetRegion(const HsailDebugConfigParam region) const;
+
+    /// Get the size of a region
+    /// \param[in] region The requested shared memory region
+    /// \return The present size of the region in bytes, 0 if the region is not attached
+    size_t GetRegionSize(const HsailDebugConfigParam region) const;
+
+    /// Start an update of a region written by the agent.
+    /// The payload is laid out after a HsailSharedBufferHeader for a gdb that announced
+    /// HSAIL_FRAME_PROTOCOL_VERSION_SHARED_BUFFERS, and in the legacy layout otherwise.
+    /// The region grows if the payload does not fit, the payload of the last update is kept.
+    /// \param[in] region      The shared memory region
+    /// \param[in] payloadSize The number of payload bytes that will be written
+    /// \return The address to write the payload to, valid till EndRegionUpdate. nullptr on failure
+    void* BeginRegionUpdate(const HsailDebugConfigParam region, const size_t payloadSize);
+
+    /// Check if region updates go to the legacy SysV segments of an older gdb, rather than
+    /// to the buffers with a HsailSharedBufferHeader. gdb may announce
+    /// HSAIL_FRAME_PROTOCOL_VERSION_SHARED_BUFFERS after the first updates, so a writer that
+    /// only writes its changes has to write everything again when this changes
+    bool IsLegacyRegionUpdate() const;
+
+    /// Publish the payload written since BeginRegionUpdate
+    /// \param[in] region      The shared memory region
+    /// \param[in] payloadSize The number of valid payload bytes
+    /// \return HSAIL agent status
+    HsailAgentStatus EndRegionUpdate(const HsailDebugConfigParam region, const size_t payloadSize);
+
+    /// Map the part of a region written by gdb that was added since the region was mapped
+    /// \param[in] region The shared memory region
+    /// \return HSAIL agent status
+    HsailAgentStatus RefreshRegion(const HsailDebugConfigParam region);
+
+private:
+
+    /// The information we keep for each region
+    typedef struct
+    {
+        /// Key for the shared memory
+        int m_shmKey;
+
+        /// Name of the shared memory object, derived from the key and the debug session
+        std::string m_name;
+
+        /// The size the shared memory object is created with
+        size_t m_initialSize;
+
+        /// The present size of the shared memory object and of the mapping
+        size_t m_size;
+
+        /// The descriptor of the shared memory object, -1 if the region is not attached
+        int m_fd;
+
+        /// The attached address, nullptr if the region is not attached
+        void* m_pShm;
+
+        /// True if the region starts with a HsailSharedBufferHeader (written by the agent),
+        /// false if gdb writes the region
+        bool m_hasBufferHeader;
+
+        /// The SysV segment used by an older gdb, nullptr if the segment is not attached
+        void* m_pLegacyShm;
+
+        /// The fixed size of the SysV segment
+        size_t m_legacySize;
+
+        /// The legacy layout starts with a size_t holding the payload size in units of this
+        /// many bytes, 0 if the legacy layout has no size
+        size_t m_legacySizeUnit;
+
+        /// Bytes of the region used by the last update in the legacy layout
+        size_t m_legacyUsedSize;
+
+        /// True if the update in progress uses the legacy layout
+        bool m_isLegacyUpdate;
+
+    } AgentSharedMemRegion;
+
+    /// Map of each region and its data
+    std::map<HsailDebugConfigParam, AgentSharedMemRegion> m_regions;
+
+    /// Allocate and attach a single region
+    HsailAgentStatus MapRegion(AgentSharedMemRegion& region) const;
+
+    /// Detach and free a single region
+    HsailAgentStatus UnMapRegion(AgentSharedMemRegion& region) const;
+
+    /// Allocate and attach the SysV segment of a region
+    HsailAgentStatus MapLegacyRegion(AgentSharedMemRegion& region) const;
+
+    /// Detach and free the SysV segment of a region
+    HsailAgentStatus UnMapLegacyRegion(AgentSharedMemRegion& region) const;
+
+    /// Grow a region written by the agent so that a payload of the given size fits after
+    /// the HsailSharedBufferHeader. gdb is told about the new size through the header.
+    HsailAgentStatus ReserveRegion(AgentSharedMemRegion& region, const size_t payloadSize) const;
+
+    /// Resize the shared memory object of a region and move the mapping to the new size
+    HsailAgentStatus ResizeRegion(AgentSharedMemRegion& region, const size_t newSize) const;
+
+    /// Disable copy constructor
+    AgentSharedMemRegistry(const AgentSharedMemRegistry&);
+
+    /// Disable assignment operator
+    AgentSharedMemRegistry& operator=(const AgentSharedMemRegistry&);
+};
+
+} // End Namespace HwDbgAgent
+
+#endif // AGENT_SHARED_MEM_REGISTRY_H_
@@ -0,0 +1,115 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Latency histograms of the debug phases
+//==============================================================================
+#ifndef AGENT_TIMING_H_
+#define AGENT_TIMING_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace HwDbgAgent
+{
+
+/// The measured operations, each one has its own histogram
+typedef enum
+{
+    AGENT_TIMER_ISA_DISASSEMBLY,        /// Disassembling a code object on an ISA worker thread
+    AGENT_TIMER_ISA_WAIT,               /// Waiting for the ISA of a code object when gdb takes control
+    AGENT_TIMER_PREDISPATCH,            /// A predispatch callback that entered the debug engine
+    AGENT_TIMER_BEGIN_DEBUGGING,        /// BeginDebugging in the predispatch callback
+    AGENT_TIMER_LOAD_MAP_UPDATE,        /// Updating the load map in the predispatch callback
+    AGENT_TIMER_BINARY_FROM_DBE,        /// Getting the kernel binary from the DBE
+    AGENT_TIMER_DEMANGLE,               /// Demangling a kernel name that was not demangled before
+    AGENT_TIMER_ISA_PUBLICATION,        /// Publishing the ISA before a function breakpoint stop
+    AGENT_TIMER_BINARY_NOTIFICATION,    /// Notifying gdb of the kernel binary
+    AGENT_TIMER_PREDISPATCH_FIFO,       /// Reading the gdb commands in the predispatch callback
+    AGENT_TIMER_ENABLE_BREAKPOINTS,     /// Enabling the PC breakpoints in the DBE
+    AGENT_TIMER_DEBUG_THREAD_CREATION,  /// Handing the dispatch to the debug thread
+    AGENT_TIMER_WAIT_FOR_EVENT,         /// Waiting for a DBE event on the debug thread
+    AGENT_TIMER_BREAKPOINT_UPDATES,     /// Processing a breakpoint event on the debug thread
+    AGENT_TIMER_CONTINUE,               /// Resuming the dispatch after a breakpoint event
+    AGENT_TIMER_CODE_OBJECT_INGESTION,  /// Preparing the code objects of a frozen executable
+    AGENT_TIMER_DISPATCH_PREPARATION,   /// The predispatch work done before taking the debug engine
+    AGENT_TIMER_DEBUG_ENGINE_WAIT,      /// Waiting for the debug engine in the predispatch callback
+    AGENT_TIMER_COUNT                   /// Number of timers, not a timer
+} AgentTimer;
+
+/// A log scale histogram of durations in nanoseconds.
+/// Every power of two is split in 4 buckets, so a percentile is known within 25%.
+/// Samples can be added from any thread.
+class AgentTimingHistogram
+{
+public:
+    /// Constructor
+    /// \param[in] pName The name used when the histogram is logged
+    AgentTimingHistogram(const char* pName);
+
+    /// Add one duration
+    /// \param[in] durationNs The duration in nanoseconds
+    /// \param[in] numBytes   The bytes transferred in that time, 0 if not relevant
+    void AddSample(const uint64_t durationNs, const size_t numBytes);
+
+    /// Get the number of durations added
+    uint64_t GetNumSamples() const;
+
+    /// Get an upper bound of a percentile
+    /// \param[in] percentile A value between 0 and 100
+    /// \return The upper bound in nanoseconds of the bucket the percentile falls in, 0 if there are no samples
+    uint64_t GetPercentile(const double percentile) const;
+
+    /// Log the number of samples, the mean, p50, p99, the max and the throughput
+    void Log() const;
+
+private:
+    /// 4 buckets for each of the 63 powers of two above 3 and one for each of 0 to 3
+    static const int ms_NUM_BUCKETS = 256;
+
+    /// The name used when the histogram is logged
+    const char* m_pName;
+
+    /// Number of durations in every bucket
+    uint64_t m_buckets[ms_NUM_BUCKETS];
+
+    uint64_t m_numSamples;
+    uint64_t m_totalNs;
+    uint64_t m_maxNs;
+    uint64_t m_totalBytes;
+
+    /// Get the bucket a duration is counted in
+    static int GetBucketIndex(const uint64_t durationNs);
+
+    /// Get the largest duration counted in a bucket
+    static uint64_t GetBucketUpperBound(const int bucketIndex);
+
+    /// Disable default constructor
+    AgentTimingHistogram();
+
+    /// Disable copy constructor
+    AgentTimingHistogram(const AgentTimingHistogram&);
+
+    /// Disable assignment operator
+    AgentTimingHistogram& operator=(const AgentTimingHistogram&);
+};
+
+/// Check if the timers are enabled, they are unless ROCM_GDB_DISABLE_TIMING is set
+bool AgentIsTimingEnabled();
+
+/// Get the monotonic clock in nanoseconds, 0 if the timers are disabled
+uint64_t AgentGetTimestampNs();
+
+/// Add the time since startNs to the histogram of a timer, nothing is done if the timers are disabled
+/// \param[in] timer    The measured operation
+/// \param[in] startNs  The AgentGetTimestampNs value when the operation started
+/// \param[in] numBytes The bytes transferred by the operation, 0 if not relevant
+void AgentRecordTime(const AgentTimer timer, const uint64_t startNs, const size_t numBytes);
+
+/// Log the histograms of all the timers that have samples
+void AgentLogTimingStatistics();
+
+} // End Namespace HwDbgAgent
+
+#endif // AGENT_TIMING_H_
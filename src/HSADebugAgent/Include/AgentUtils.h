@@ -61,6 +61,9 @@ bool AgentIsFileExists(const char *fileName);
 /// Delete a file
 HsailAgentStatus AgentDeleteFile(const char* ipFilename);
 
+/// Compute the hash that identifies a binary sent to gdb
+uint64_t AgentComputeBinaryHash(const void* pBinary, const size_t binarySize);
+
 /// Write a binary buffer to file
 HsailAgentStatus AgentWriteBinaryToFile(const void*  pBinary, const size_t binarySize, const char*  pFilename);
 
@@ -15,6 +15,8 @@
 
 namespace HwDbgAgent
 {
+class AgentSharedMemRegistry;
+
 const int g_KERNEL_DEBUG_WORKITEMS_PER_WAVEFRONT = 64;
 
 /// This class mirrors the hdKernelDebugWavefront structure in CodeXL
@@ -56,8 +58,8 @@ public:
 /// 1) Calls the DBE to get active waves and print the OP.
 /// 2) Calls the DBE to get active waves and Send the waves to gdb
 /// This class will need to always query the DBE for whatever waves are active,
-/// This class is part of the agentcontext and the shared memory to send to gdb
-/// is initialized and destroyed in this class
+/// This class is part of the agentcontext, the shared memory to send to gdb
+/// is owned by the agentcontext's shared memory registry
 class AgentWavePrinter
 {
 private:
@@ -68,29 +70,31 @@ private:
     int m_DispatchGlobalWorkDimensions;
     HsailWaveDim3 m_debuggedKernelHSAWorkgroupSize;
 
-    /// Key for the wave info buffer shared memory
-    int m_waveBufferShmKey;
-
-    /// Max size for the wave info buffer shared memory
-    size_t m_waveBufferMaxSize;
+    /// The shared memory regions of the owning agentcontext
+    AgentSharedMemRegistry* m_pSharedMemRegistry;
 
     void ClearCurrentWavefronts();
 
-    /// Free the shared memory
-    HsailAgentStatus FreeWaveInfoShmem();
-
-    /// Allocate the shared memory
-    void InitializeWaveInfoShmem();
-
     /// Private function that prints out data using the AgentOP() utility function
     HsailAgentStatus PrintWaveInfoBuffer(int nWaves, const HwDbgWavefrontInfo* pWaveInfo);
 
     /// Needs a DBE context handle and a event type and then calls private printwaveinfo
     HsailAgentStatus PrintActiveWaves(HwDbgEventType dbeEventType, HwDbgContextHandle pHandle);
 
-public:
+    /// Disable default constructor, the shared memory registry is needed
     AgentWavePrinter();
 
+    /// Disable copy constructor
+    AgentWavePrinter(const AgentWavePrinter&);
+
+    /// Disable assignment operator
+    AgentWavePrinter& operator=(const AgentWavePrinter&);
+
+public:
+    /// Constructor
+    /// \param[in] pSharedMemRegistry The shared memory regions used to send the waves to gdb
+    AgentWavePrinter(AgentSharedMemRegistry* pSharedMemRegistry);
+
     ~AgentWavePrinter();
 
     /// Needs a DBE context handle and a event type and sends the active wave info to gdb
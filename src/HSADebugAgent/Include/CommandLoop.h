@@ -30,10 +30,24 @@ void RunFifoCommandLoop(AgentContext* pActiveContext);
 /// Read the FIFO and check for any new packets multiple times
 void RunFifoCommandLoop(AgentContext* pActiveContext, unsigned int runCount);
 
+/// Ask gdb for a sync marker and read the FIFO till the marker arrives.
+/// A gdb that does not send frames is not asked, it gets the fixed wait of runCount ms,
+/// as does a framing gdb that has not answered a request yet
+void RunFifoCommandLoopTillSync(AgentContext* pActiveContext, unsigned int runCount);
+
+/// Check if gdb has sent commands that were not processed yet, nothing is read
+/// \return true if the command ring, the fifo or a partly read fifo packet has bytes
+bool IsGdbCommandPending();
+
+/// Wait till the debug thread is done with its dispatch, the debug thread keeps running
 HsailAgentStatus WaitForDebugThreadCompletion();
 
+/// Hand a dispatch to the debug thread, the debug thread is created by the first call
 HsailAgentStatus CreateDebugEventThread(DebugEventThreadParams* pArgs);
 
+/// Wait till the debug thread is done with its dispatch and end the debug thread
+HsailAgentStatus StopDebugEventThread();
+
 } // End Namespace HwDbgAgent
 
 /// GDB will install a breakpoint on this function that will be used when
@@ -31,7 +31,16 @@ typedef enum
     HSAIL_COMMAND_MOMENTARY_BREAKPOINT, // Set an HSAIL momentary breakpoint (which is automatically deleted)
     HSAIL_COMMAND_CONTINUE,             // Continue the inferior process
     HSAIL_COMMAND_SET_LOGGING,          // Configure the logging in the Agent
-    HSAIL_COMMAND_SET_ISA_DUMP          // Configure dumping of ISA
+    HSAIL_COMMAND_SET_ISA_DUMP,         // Configure dumping of ISA
+    HSAIL_COMMAND_SYNC_MARKER,          // All the commands for the sync request HSAIL_FRAME_TAG_SYNC_ID have been sent
+                                        // (only sent as a frame)
+    HSAIL_COMMAND_SET_PROTOCOL,         // gdb understands framed messages (only sent as a frame)
+    HSAIL_COMMAND_GET_ISA,              // Disassemble the binary HSAIL_FRAME_TAG_BINARY_HASH to the ISA buffer shared mem,
+                                        // only [HSAIL_FRAME_TAG_PC, HSAIL_FRAME_TAG_PC_END) if the end is set
+                                        // (only sent as a frame)
+    HSAIL_COMMAND_SET_KERNEL_FILTER,    // Only debug the dispatches selected by HSAIL_FRAME_TAG_KERNEL_FILTER, empty to debug all
+                                        // (only sent as a frame)
+    HSAIL_COMMAND_LOG_TIMING            // Write the timing histograms to the agent log (only sent as a frame)
 } HsailCommand;
 
 typedef enum
@@ -57,7 +66,12 @@ typedef enum
     HSAIL_NOTIFY_AGENT_ERROR,       // Some error from the agent or the DBE - let gdb know
     HSAIL_NOTIFY_KILL_COMPLETE,     // Notification to let GDB know about kill finishing
     HSAIL_NOTIFY_NEW_ACTIVE_WAVES,  // Set the number of active waves
-    HSAIL_NOTIFY_DEVICES            // Notification to send the devices info to the GDB
+    HSAIL_NOTIFY_DEVICES,           // Notification to send the devices info to the GDB
+    HSAIL_NOTIFY_SYNC_REQUEST,      // The agent waits for commands, gdb replies with a HSAIL_COMMAND_SYNC_MARKER frame
+                                    // (only sent once gdb has sent HSAIL_COMMAND_SET_PROTOCOL)
+    HSAIL_NOTIFY_REUSE_BINARY,      // Same as HSAIL_NOTIFY_NEW_BINARY for a binary gdb already has, nothing is written to shared mem
+    HSAIL_NOTIFY_ISA_READY,         // Reply to HSAIL_COMMAND_GET_ISA, the ISA buffer shared mem has been written
+    HSAIL_NOTIFY_COMMAND_RING       // The SysV key of the command ring, reply to HSAIL_COMMAND_SET_PROTOCOL (only sent as a frame)
 } HsailNotification;
 
 typedef enum
@@ -77,6 +91,7 @@ typedef enum
     HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM,
     HSAIL_DEBUG_CONFIG_FIFO_GDB_TO_AGENT,
     HSAIL_DEBUG_CONFIG_FIFO_AGENT_TO_GDB,
+    HSAIL_DEBUG_CONFIG_COMMAND_RING_SHM,
 } HsailDebugConfigParam;
 
 typedef enum
@@ -128,7 +143,7 @@ typedef struct _HsailConfigParam
         struct
         {
             int m_shmKey;       // Shared mem key
-            size_t m_maxSize;   // Shared mem size
+            size_t m_maxSize;   // Shared mem size, the initial size for the regions that grow
         } shmemParam;
 
         // FIFO file name options
@@ -305,8 +320,19 @@ typedef struct _HsailNotificationPayload
             char m_KernelName[AGENT_MAX_FUNC_NAME_LEN];    // The kernel name
             uint64_t m_binarySize;
             HsailDispatchPacket m_packet;
+            uint64_t m_binaryHash;                          // FNV-1a 64 bit hash of the binary
         } BinaryNotification;
 
+        // HSAIL_NOTIFY_REUSE_BINARY
+        // Only sent to a gdb that announced HSAIL_FRAME_PROTOCOL_VERSION_REUSE_BINARY.
+        // The binary was sent earlier in the session with the same m_binaryHash
+        struct
+        {
+            char m_KernelName[AGENT_MAX_FUNC_NAME_LEN];    // The kernel name
+            uint64_t m_binaryHash;                          // Hash of a binary sent with HSAIL_NOTIFY_NEW_BINARY
+            HsailDispatchPacket m_packet;
+        } ReuseBinaryNotification;
+
         // HSAIL_NOTIFY_PREDISPATCH_STATE
         struct
         {
@@ -366,6 +392,26 @@ typedef struct _HsailNotificationPayload
             int               m_devicesNum;
             RocmDeviceDesc    m_deviceDescriptors[AGENT_MAX_DEVICES_NUM];
         } DevicesNotification;
+
+        // HSAIL_NOTIFY_SYNC_REQUEST
+        struct
+        {
+            uint64_t m_syncId;  // To be copied into the HSAIL_FRAME_TAG_SYNC_ID of the HSAIL_COMMAND_SYNC_MARKER frame
+        } SyncRequestNotification;
+
+        // HSAIL_NOTIFY_ISA_READY
+        struct
+        {
+            uint64_t m_binaryHash;  // The binary of the HSAIL_COMMAND_GET_ISA
+            uint64_t m_isaSize;     // Bytes of ISA text in the ISA buffer shared mem, 0 if not disassembled
+        } IsaReadyNotification;
+
+        // HSAIL_NOTIFY_COMMAND_RING
+        // Only sent to a gdb that announced HSAIL_FRAME_PROTOCOL_VERSION_COMMAND_RING_KEY
+        struct
+        {
+            int32_t m_shmKey;       // The key of the command ring, 0 if there is no ring
+        } CommandRingNotification;
     } payload;
 } HsailNotificationPayload;
 
@@ -425,6 +471,169 @@ typedef struct _HsailAgentWaveInfo
 
 } HsailAgentWaveInfo;
 
+// One entry of a breakpoint hit report
+typedef struct _HsailBreakpointHitRecord
+{
+    int32_t m_breakpointId;     // The gdb breakpoint ID
+    int32_t m_hitCount;         // Number of times the breakpoint was hit
+} HsailBreakpointHitRecord;
+
+// Framed messages
+// Both fifos can carry framed messages next to the fixed size HsailCommandPacket and
+// HsailNotificationPayload structures. A frame starts with HSAIL_FRAME_MAGIC, a fixed size
+// structure starts with a small HsailCommand or HsailNotification value, so the reader can
+// tell them apart from the first 4 bytes.
+// HsailCommandPacket keeps the layout an older gdb writes, the fields of the newer commands
+// (sync id, binary hash, PC range end, kernel filter) are only sent in frames.
+// The agent reads frames from gdb at any time. The agent only writes frames once gdb has
+// sent a HSAIL_COMMAND_SET_PROTOCOL frame.
+//
+// A frame is a HsailFrameHeader followed by m_length bytes of fields.
+// Every field is a HsailFrameFieldHeader followed by m_length bytes of value, with no padding.
+// Unknown tags must be skipped, fields of the same tag can repeat.
+#define HSAIL_FRAME_MAGIC 0x4D415246
+
+// The framing version written by this agent
+#define HSAIL_FRAME_PROTOCOL_VERSION 5
+
+// The first framing version in which gdb keeps the binaries it received, keyed by their hash.
+// The agent only sends HSAIL_NOTIFY_REUSE_BINARY to a gdb that announced this version
+#define HSAIL_FRAME_PROTOCOL_VERSION_REUSE_BINARY 2
+
+// The first framing version in which gdb asks for the ISA with HSAIL_COMMAND_GET_ISA.
+// The agent does not disassemble binaries at dispatch time for a gdb that announced this version
+#define HSAIL_FRAME_PROTOCOL_VERSION_LAZY_ISA 3
+
+// The first framing version in which gdb reads the shared buffers written by the agent
+// through a HsailSharedBufferHeader, see below
+#define HSAIL_FRAME_PROTOCOL_VERSION_SHARED_BUFFERS 4
+
+// The first framing version in which gdb takes the key of the command ring from the
+// HSAIL_NOTIFY_COMMAND_RING the agent sends after HSAIL_COMMAND_SET_PROTOCOL.
+// An older gdb only looks for the ring at the session key of g_COMMAND_RING_SHMKEY
+#define HSAIL_FRAME_PROTOCOL_VERSION_COMMAND_RING_KEY 5
+
+typedef struct _HsailFrameHeader
+{
+    uint32_t m_magic;       // HSAIL_FRAME_MAGIC
+    uint16_t m_version;     // HSAIL_FRAME_PROTOCOL_VERSION of the writer
+    uint16_t m_type;        // A HsailCommand or HsailNotification value
+    uint32_t m_length;      // Number of bytes of fields after the header
+} HsailFrameHeader;
+
+typedef struct _HsailFrameFieldHeader
+{
+    uint16_t m_tag;         // A HsailFrameTag value
+    uint16_t m_reserved;
+    uint32_t m_length;      // Number of bytes of value after the field header
+} HsailFrameFieldHeader;
+
+typedef enum
+{
+    HSAIL_FRAME_TAG_UNKNOWN,
+    HSAIL_FRAME_TAG_PROTOCOL_VERSION,   // uint32_t, highest framing version gdb understands
+    HSAIL_FRAME_TAG_LOGGING_INFO,       // uint32_t, HsailLogCommand
+    HSAIL_FRAME_TAG_GDB_BREAKPOINT_ID,  // int32_t
+    HSAIL_FRAME_TAG_PC,                 // uint64_t
+    HSAIL_FRAME_TAG_HIT_COUNT,          // int32_t
+    HSAIL_FRAME_TAG_LINE_NUM,           // int32_t
+    HSAIL_FRAME_TAG_NUM_MOMENTARY_BP,   // int32_t
+    HSAIL_FRAME_TAG_CONDITION,          // HsailConditionPacket
+    HSAIL_FRAME_TAG_SOURCE_LINE,        // characters, not null terminated
+    HSAIL_FRAME_TAG_KERNEL_NAME,        // characters, not null terminated
+    HSAIL_FRAME_TAG_SYNC_ID,            // uint64_t
+    HSAIL_FRAME_TAG_NUM_ACTIVE_WAVES,   // int32_t
+    HSAIL_FRAME_TAG_BREAKPOINT_HIT,     // HsailBreakpointHitRecord, one field per breakpoint
+    HSAIL_FRAME_TAG_BINARY_SIZE,        // uint64_t
+    HSAIL_FRAME_TAG_DISPATCH_PACKET,    // HsailDispatchPacket
+    HSAIL_FRAME_TAG_PREDISPATCH_STATE,  // uint32_t, HsailPredispatchState
+    HSAIL_FRAME_TAG_THREAD_ID,          // int32_t, the dispatching or the debug thread
+    HSAIL_FRAME_TAG_SET_DEVICE_FOCUS,   // uint8_t, bool
+    HSAIL_FRAME_TAG_DISPATCH_COMPLETED, // uint8_t, bool
+    HSAIL_FRAME_TAG_KILL_SUCCESSFUL,    // uint8_t, bool
+    HSAIL_FRAME_TAG_QUIT_ISSUED,        // uint8_t, bool
+    HSAIL_FRAME_TAG_ERROR_CODE,         // int32_t
+    HSAIL_FRAME_TAG_FOCUS_WORK_GROUP,   // HsailWaveDim3
+    HSAIL_FRAME_TAG_FOCUS_WORK_ITEM,    // HsailWaveDim3
+    HSAIL_FRAME_TAG_DEVICE,             // RocmDeviceDesc, one field per device
+    HSAIL_FRAME_TAG_BINARY_HASH,        // uint64_t
+    HSAIL_FRAME_TAG_ISA_SIZE,           // uint64_t
+    HSAIL_FRAME_TAG_PC_END,             // uint64_t
+    HSAIL_FRAME_TAG_KERNEL_FILTER,      // characters, not null terminated
+    HSAIL_FRAME_TAG_SHM_KEY             // int32_t, a SysV shared memory key
+} HsailFrameTag;
+
+// Header at the start of every shared memory buffer the agent writes for gdb
+// (code object, ISA, wave info and load map buffers), once gdb has announced
+// HSAIL_FRAME_PROTOCOL_VERSION_SHARED_BUFFERS.
+// Only the m_payloadSize bytes after the header are valid, the rest of the buffer
+// is not cleared between updates.
+//
+// An older gdb reads the buffers from the fixed size SysV segments of the same keys,
+// in their legacy layout with no header:
+//   Code object and ISA: a size_t number of bytes followed by the bytes
+//   Load map:            a size_t number of HsailSegmentDescriptor followed by the descriptors
+//   Wave info:           the HsailAgentWaveInfo, their number is sent with the notification
+// The bytes past the payload are zero.
+// m_generation is odd while the agent is writing the payload and even once the
+// payload and checksum are complete. A reader should read m_generation, then the payload,
+// and retry if m_generation changed or is odd.
+//
+// With the header, the buffers are POSIX shared memory objects that grow when a payload does not fit.
+// The agent grows the object before it starts the update, then stores the new size in
+// m_regionSize and increments m_regionGeneration. A reader that sees a m_regionGeneration
+// different from the one of its mapping maps the object again with m_regionSize bytes.
+typedef struct _HsailSharedBufferHeader
+{
+    uint64_t m_generation;      // Incremented before and after every update
+    uint64_t m_payloadSize;     // Number of valid bytes after the header
+    uint32_t m_checksum;        // Adler-32 checksum of the payload bytes
+    uint32_t m_regionGeneration;    // Incremented every time the region grows
+    uint64_t m_regionSize;      // Size of the whole region, including the header
+} HsailSharedBufferHeader;
+
+// Value of HsailCommandRingHeader::m_magic once the agent has initialized the ring
+#define HSAIL_COMMAND_RING_MAGIC 0x48435247
+
+// Size used to keep the producer and consumer fields of the ring on separate cache lines
+#define HSAIL_COMMAND_RING_CACHE_LINE_SIZE 64
+
+// Header of the single producer / single consumer ring used by gdb to send commands.
+// The ring is an alternative to the gdb --> agent fifo, the fifo is still read by the agent
+// so a gdb that does not know about the ring keeps working.
+// The agent creates the ring at the session key of g_COMMAND_RING_SHMKEY. If a segment of another
+// process already has that key, the agent tries the next session hash values and reports the key
+// it got with HSAIL_NOTIFY_COMMAND_RING. A gdb older than that notification only looks for the ring
+// at the session key.
+// The header is followed by m_capacity HsailCommandPacket slots, m_capacity is a power of 2.
+//
+// Producer (gdb):
+//   1. Check that m_writeIndex - m_readIndex (acquire load) is less than m_capacity
+//   2. Copy the packet to slot (m_writeIndex & (m_capacity - 1))
+//   3. Store m_writeIndex + 1 with release semantics
+//   4. Increment m_doorbell with a sequentially consistent atomic add, then load m_consumerWaiting
+//      and FUTEX_WAKE on m_doorbell if it is set. A plain increment, or a load of m_consumerWaiting
+//      before the add, can leave a packet in the ring till the wait of the agent times out
+//   The frames are still sent through the fifo. The agent polls the fifo every time it wakes up,
+//   so a gdb that rings the doorbell after writing a frame gets it read without delay
+// Consumer (agent):
+//   Acquire load m_writeIndex, copy the slots up to it and release store m_readIndex
+typedef struct _HsailCommandRingHeader
+{
+    uint32_t m_magic;               // HSAIL_COMMAND_RING_MAGIC once the ring is usable
+    uint32_t m_capacity;            // Number of packet slots after the header
+    uint8_t  m_pad0[HSAIL_COMMAND_RING_CACHE_LINE_SIZE - 2 * sizeof(uint32_t)];
+
+    uint64_t m_writeIndex;          // Total number of packets written by gdb
+    uint8_t  m_pad1[HSAIL_COMMAND_RING_CACHE_LINE_SIZE - sizeof(uint64_t)];
+
+    uint64_t m_readIndex;           // Total number of packets consumed by the agent
+    uint8_t  m_pad2[HSAIL_COMMAND_RING_CACHE_LINE_SIZE - sizeof(uint64_t)];
+
+    uint32_t m_doorbell;            // Futex word, incremented by gdb after every write
+    uint32_t m_consumerWaiting;     // Non-zero while the agent sleeps on m_doorbell
+    uint8_t  m_pad3[HSAIL_COMMAND_RING_CACHE_LINE_SIZE - 2 * sizeof(uint32_t)];
+} HsailCommandRingHeader;
 
 // A constant value to use when we send a packet that doesnt use the m_pc field
 static const uint64_t HSAIL_ISA_PC_UNKOWN = (uint64_t)(-1);
@@ -455,10 +664,47 @@ void* AgentMapSharedMemBuffer(const key_t shmkey, const size_t maxShmSize);
 /// Shared mem unmap utility
 HsailAgentStatus AgentUnMapSharedMemBuffer(void* pShm);
 
+/// Max number of payload bytes that fit in a shared buffer that starts with a HsailSharedBufferHeader
+size_t AgentGetSharedBufferMaxPayloadSize(const size_t maxShmSize);
+
+/// Location of the payload within a shared buffer that starts with a HsailSharedBufferHeader
+void* AgentGetSharedBufferPayload(void* pShm);
+
+/// Mark the shared buffer as being updated (the generation becomes odd)
+HsailAgentStatus AgentBeginSharedBufferUpdate(void* pShm);
+
+/// Stamp the payload size and checksum and publish the update (the generation becomes even)
+HsailAgentStatus AgentEndSharedBufferUpdate(void* pShm, const size_t payloadSize);
+
 /// Used by the agent to wait for the shared memory update from GDB
 /// \return 1 if the update is visible to the agent
 HsailAgentStatus WaitForSharedMemoryUpdate(const key_t shmkey, const int maxShmSize);
 
+/// Create the shared memory command ring, gdb falls back to the fifo if this fails
+HsailAgentStatus InitCommandRing(const key_t shmkey, const size_t maxShmSize);
+
+/// Detach and remove the shared memory command ring
+HsailAgentStatus CloseCommandRing();
+
+/// Get the key the command ring was created with
+/// \return The key, 0 if there is no command ring
+key_t GetCommandRingShmKey();
+
+/// Copy the packets available in the command ring, without any system call
+/// \return The number of packets copied to pPacketsOut, at most maxPackets
+unsigned int ReadCommandRing(HsailCommandPacket* pPacketsOut, const unsigned int maxPackets);
+
+/// Check if gdb sends its commands through the command ring
+/// \return true once gdb has written at least one packet to the ring
+bool IsCommandRingInUse();
+
+/// Check if gdb has written packets to the command ring that were not read yet, without reading them
+/// \return true if there is no ring or all its packets were read
+bool IsCommandRingEmpty();
+
+/// Sleep on the command ring doorbell till gdb writes a packet or the timeout expires
+void WaitForCommandRingDoorbell(const unsigned int timeoutUs);
+
 /// Get descriptor of the read fifo
 int GetFifoReadEnd();
 
@@ -8,6 +8,18 @@
 #ifndef COMMUNICATION_PARAMS_H_
 #define COMMUNICATION_PARAMS_H_
 
+// A debug session is named by the ROCM_GDB_DEBUG_SESSION_ID environment variable of the
+// HSA application. Characters other than [A-Za-z0-9._-] in the session ID are replaced by '_'.
+// When the session ID is set, every IPC object below is scoped to the session so that
+// several debug sessions can run on one machine:
+//   Fifos and files:       <name>-<session ID>, this includes the temporary files of the agent
+//   Shared memory keys:    <key> | ((FNV-1a 32 bit hash of the session ID & 0x7FFF) << 16)
+//                          The command ring moves to the next hash values if its key is taken,
+//                          its key is sent to gdb with HSAIL_NOTIFY_COMMAND_RING
+//   Shared memory objects: <gs_SharedRegionNamePrefix>-<session ID>-<scoped key>
+// Without a session ID the names and keys below are used as they are, and the shared
+// memory objects use the pid of the HSA application in place of the session ID.
+
 // Value for Fifo permissions, more research necessary to figure out right values
 const int g_FIFO_PERMISSIONS = 0666;
 
@@ -22,6 +34,21 @@ const int g_ISASTREAM_SHMKEY = 4567;
 
 const int g_LOADMAP_SHMKEY =7890;
 
+const int g_COMMAND_RING_SHMKEY = 3333;
+
+// The shared memory regions below start at these sizes and grow when the data does not fit
+const size_t g_MOMENTARY_BP_BUFFER_INITIAL_SIZE = 1024 * 64;
+
+const size_t g_BINARY_BUFFER_INITIAL_SIZE = 1024 * 1024;
+
+const size_t g_WAVE_BUFFER_INITIAL_SIZE = 1024 * 256;
+
+const size_t g_ISASTREAM_INITIAL_SIZE = 1024 * 1024;
+
+const size_t g_LOADMAP_INITIAL_SIZE = 1024 * 64;
+
+// A gdb older than HSAIL_FRAME_PROTOCOL_VERSION_SHARED_BUFFERS reads the regions from SysV
+// segments of the same keys, these keep the fixed sizes below
 const size_t g_MOMENTARY_BP_BUFFER_MAXSIZE = 1024 * 1024 * 20;
 
 const size_t g_BINARY_BUFFER_MAXSIZE = 1024 * 1024 * 10;
@@ -32,6 +59,16 @@ const size_t g_ISASTREAM_MAXSIZE = 1024 * 1024 * 20;
 
 const size_t g_LOADMAP_MAXSIZE = 1024 * 1024 * 10;
 
+// A region never grows beyond this size, larger requests are treated as bad input
+const size_t g_SHARED_REGION_GROWTH_LIMIT = (size_t)1024 * 1024 * 1024 * 4;
+
+// The command ring does not grow
+const size_t g_COMMAND_RING_MAXSIZE = 1024 * 1024;
+
+// The shared memory regions are POSIX shared memory objects, see above for their names.
+// They are only used by a gdb that announced HSAIL_FRAME_PROTOCOL_VERSION_SHARED_BUFFERS
+const char gs_SharedRegionNamePrefix[] = "/hsail-gdb-shm";
+
 // The names of the Fifos - opened in GDB and the agent
 
 // The FIFO written to by the agent and read by GDB (For things like bp statistics)
@@ -10,15 +10,19 @@
 #include <sys/wait.h>
 
 #include <cassert>
+#include <cstdlib>
 #include <pthread.h>
 
 #include "AgentBinary.h"
 #include "AgentBreakpointManager.h"
 #include "AgentContext.h"
+#include "AgentKernelFilter.h"
 #include "AgentLogging.h"
 #include "AgentNotifyGdb.h"
 #include "AgentProcessPacket.h"
+#include "AgentQueueContext.h"
 #include "AgentSegmentLoader.h"
+#include "AgentTiming.h"
 #include "AgentUtils.h"
 #include "CommandLoop.h"
 
@@ -33,45 +37,65 @@ static void PredispatchCheckStatus(const HsailAgentStatus status, const char* ip
     }
 }
 
-void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArgs)
+/// The fast path can be turned off by setting ROCM_GDB_DISABLE_PREDISPATCH_FAST_PATH
+static bool IsPredispatchFastPathEnabled()
 {
-    AGENT_LOG("== Start Pre-dispatch callback ==");
-
-    if (pRTParam == nullptr || !pRTParam->pre_dispatch)
-    {
-        AGENT_ERROR("PreDispatchCallback: Invalid input RT parameters");
-        return;
-    }
+    static const bool s_isEnabled = (std::getenv("ROCM_GDB_DISABLE_PREDISPATCH_FAST_PATH") == nullptr);
+    return s_isEnabled;
+}
 
-    hsa_kernel_dispatch_packet_t* pAqlPacket = pRTParam->aql_packet;
+/// Check if a dispatch can skip the predispatch work because it can not stop:
+/// gdb already has its binary, no breakpoint is set and gdb has not sent any
+/// command since the last dispatch.
+/// Only used with a gdb that answers sync requests, an older gdb may only send
+/// its commands once it sees the predispatch notifications.
+static bool CanSkipPredispatch(const AgentContext*                 pActiveContext,
+                               const AgentBreakpointManager*       pBpManager,
+                               const hsa_kernel_dispatch_packet_t* pAqlPacket)
+{
+    return (IsPredispatchFastPathEnabled() &&
+            pActiveContext->m_LastSyncMarkerId != 0 &&
+            pActiveContext->IsKernelObjectSentToGdb(pAqlPacket->kernel_object) &&
+            !pBpManager->HasActiveBreakpoints() &&
+            !IsGdbCommandPending());
+}
 
-    if (pAqlPacket == nullptr)
-    {
-        AGENT_ERROR("No AQL packet present.");
-        return;
-    }
+/// The predispatch work done before the debug engine is acquired, it overlaps the
+/// debugging of a dispatch of another queue.
+/// The binary hash of a kernel object dispatched or ingested before is looked up here,
+/// RunPredispatch then only gets the binary pointer from the DBE.
+/// The load map prepared by the code object ingestion is used as it is, the DBE is only
+/// queried for a changed load map if no dispatch is being debugged.
+/// \param[out] preparedBinaryOut The binary of the kernel object
+/// \return true if the binary of the kernel object is known
+static bool PrepareDispatch(AgentContext*                       pActiveContext,
+                            const hsa_kernel_dispatch_packet_t* pAqlPacket,
+                            AgentPreparedBinary&                preparedBinaryOut)
+{
+    AgentSegmentLoader* pSegmentLoader = pActiveContext->GetSegmentLoader();
 
-    if (!ValidateAQL(*pAqlPacket))
+    if (pSegmentLoader == nullptr)
     {
-        AGENT_ERROR("Invalid AQL packet.");
-        return;
+        AGENT_ERROR("PrepareDispatch: Invalid segment loader from pActiveContext");
     }
-
-    if (pUserArgs == nullptr)
+    else
     {
-        AGENT_ERROR("AgentContext pointer is not valid");
-        return;
+        // The DBE query and the ELF parsing of a changed load map, gdb only sees it in RunPredispatch
+        HsailAgentStatus status = pSegmentLoader->PrepareLoadMap();
+        PredispatchCheckStatus(status, "Error in preparing the load map");
     }
 
-    AgentContext* pActiveContext = reinterpret_cast<AgentContext*>(pUserArgs);
-
-    if (pActiveContext == nullptr)
-    {
-        AGENT_ERROR("Invalid AgentContext from PredispatchCallback");
-        return;
-    }
+    return AgentFindPreparedBinary(pAqlPacket->kernel_object, preparedBinaryOut);
+}
 
-    // Wait for the debug thread that has been spawned previously to complete
+/// The predispatch work of a dispatch that holds the debug engine
+/// \param[in] pPreparedBinary The binary found by PrepareDispatch, nullptr if none
+static void RunPredispatch(const hsa_dispatch_callback_t* pRTParam,
+                           hsa_kernel_dispatch_packet_t*  pAqlPacket,
+                           AgentContext*                  pActiveContext,
+                           const AgentPreparedBinary*     pPreparedBinary)
+{
+    // Wait for the debug thread to be done with the previous dispatch
     HsailAgentStatus status = WaitForDebugThreadCompletion();
 
     if (status != HSAIL_AGENT_STATUS_SUCCESS)
@@ -91,15 +115,27 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
         return;
     }
 
+    // A kernel object of a destroyed executable may now be the kernel of another binary
+    pActiveContext->RefreshSentToGdb();
+
+    if (CanSkipPredispatch(pActiveContext, pBpManager, pAqlPacket))
+    {
+        AGENT_LOG("PredispatchCallback: No breakpoints and gdb already has the binary of kernel object " <<
+                  pAqlPacket->kernel_object << ", skipping the predispatch");
+        return;
+    }
+
     AgentLogAQLPacket(pAqlPacket);
 
     // We always have to start debugging and send the binary to GDB now
     // We will check if we have any function breakpoints pending and will accordingly stop
     // We pass the parameters from the predispatch callback to the Agent Context
+    uint64_t phaseStartNs = AgentGetTimestampNs();
     status = pActiveContext->BeginDebugging(pRTParam->agent,
                                             pRTParam->queue,
                                             pAqlPacket,
                                             HWDBG_BEHAVIOR_DISABLE_DISPATCH_DEBUGGING);
+    AgentRecordTime(AGENT_TIMER_BEGIN_DEBUGGING, phaseStartNs, 0);
     PredispatchCheckStatus(status, "Error in BeginDebugging");
 
     if (status != HSAIL_AGENT_STATUS_SUCCESS || pActiveContext->HasHwDebugStarted() == false)
@@ -109,8 +145,12 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
 
     // We should read the fifo command loop and check for any function or source breakpoints
     // We will consume everything in the FIFO but stop in the predispatch only if any kernel
-    // function breakpoints are set, 50 is just a heuristic for now.
-    RunFifoCommandLoop(pActiveContext, 50);
+    // function breakpoints are set.
+    // gdb answers with a sync marker once it has sent everything, 50ms is only
+    // the wait used with a gdb that does not send sync markers.
+    phaseStartNs = AgentGetTimestampNs();
+    RunFifoCommandLoopTillSync(pActiveContext, 50);
+    AgentRecordTime(AGENT_TIMER_PREDISPATCH_FIFO, phaseStartNs, 0);
 
     // Check if we have any pending function breakpoints
     int pendingFunctionNameBP =
@@ -128,7 +168,8 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
 
     // Do all the Binary handling
     AgentBinary* pBinary = nullptr;
-    pBinary = new(std::nothrow) AgentBinary;
+    pBinary = new(std::nothrow) AgentBinary(pActiveContext->GetSharedMemRegistry(),
+                                            pActiveContext->GetKernelBinaryCache());
 
     if (pBinary == nullptr)
     {
@@ -136,16 +177,26 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
         return;
     }
 
+    // The predispatch, binary and function breakpoint notifications go out together
+    AgentBeginNotificationBatch();
+
     status = AgentNotifyPredispatchState(HSAIL_PREDISPATCH_ENTERED_PREDISPATCH);
     PredispatchCheckStatus(status, "Error notifying predispatch state!");
 
-    AgentSegmentLoader segmentLoader(pAqlPacket);
-    segmentLoader.UpdateLoadedSegments();
+    // The load map is only read from the DBE again if an executable was loaded or destroyed
+    phaseStartNs = AgentGetTimestampNs();
+    status = pActiveContext->GetSegmentLoader()->UpdateLoadedSegments(pAqlPacket->kernel_object);
+    AgentRecordTime(AGENT_TIMER_LOAD_MAP_UPDATE, phaseStartNs, 0);
     PredispatchCheckStatus(status, "Error in Getting Loadmap");
 
-    status = pBinary->PopulateBinaryFromDBE(pActiveContext->GetActiveHwDebugContext(), pAqlPacket);
+    phaseStartNs = AgentGetTimestampNs();
+    status = pBinary->PopulateBinaryFromDBE(pActiveContext->GetActiveHwDebugContext(), pAqlPacket, pPreparedBinary);
+    AgentRecordTime(AGENT_TIMER_BINARY_FROM_DBE, phaseStartNs, 0);
     PredispatchCheckStatus(status, "Error in Populating Binary");
 
+    // The kernel filter matches the name gdb shows too
+    AgentRecordKernelName(pAqlPacket->kernel_object, pBinary->GetKernelName());
+
     // Logging, save the binary and the ISA (if enabled)
     AgentLogSaveBinaryToFile(pBinary, pAqlPacket);
 
@@ -157,11 +208,22 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
     // We notify gdb since this is a new binary, we still don't know
     // if we will use it for kernel debugging yet though.
     // This is because we don't know if there are any kernel breakpoints set yet
+    // A binary gdb received for an earlier dispatch is only referenced by its hash
+    const bool isBinaryKnownToGdb = pActiveContext->IsBinarySentToGdb(pBinary->GetBinaryHash());
+    phaseStartNs = AgentGetTimestampNs();
     status = pBinary->NotifyGDB(pAqlPacket,
                                 pRTParam->queue->id,
-                                pRTParam->packet_id);
+                                pRTParam->packet_id,
+                                isBinaryKnownToGdb);
+    AgentRecordTime(AGENT_TIMER_BINARY_NOTIFICATION, phaseStartNs, 0);
     PredispatchCheckStatus(status, "Error in notifying GDB!");
 
+    if (HSAIL_AGENT_STATUS_SUCCESS == status)
+    {
+        pActiveContext->AddBinarySentToGdb(pBinary->GetBinaryHash());
+        pActiveContext->AddKernelObjectSentToGdb(pAqlPacket->kernel_object, pBinary->GetBinaryHash());
+    }
+
     AGENT_LOG("PredispatchCallback: Check for Function breakpoints");
     // Search for a kernel name match if any function breakpoints present
     bool isFuncBPStopNeeded = false;
@@ -188,27 +250,52 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
     }
 
 
-    if (isFuncBPStopNeeded)
+    if (pActiveContext->IsKernelObjectSentToGdb(pAqlPacket->kernel_object, pBinary->GetBinaryHash()))
     {
-        AgentTriggerGDBEventLoop();
-        TriggerGPUBreakpointStop();
+        // Any PC may be in the kernel if its segment is not known
+        uint64_t codeStart = 0;
+        uint64_t codeEnd = UINT64_MAX;
+
+        if (!pActiveContext->GetSegmentLoader()->GetExecutedSegmentElfRange(codeStart, codeEnd))
+        {
+            codeStart = 0;
+            codeEnd = UINT64_MAX;
+        }
+
+        AgentRecordPreparedKernel(pAqlPacket->kernel_object, isFuncBPStopNeeded, codeStart, codeEnd);
     }
-    else
+
+    // When we stop, the trigger before TriggerGPUBreakpointStop wakes up gdb
+    status = AgentEndNotificationBatch(!isFuncBPStopNeeded);
+    PredispatchCheckStatus(status, "Error flushing the predispatch notifications");
+
+    if (isFuncBPStopNeeded)
     {
+        // gdb reads the ISA when it is stopped, wait for its disassembly now
+        phaseStartNs = AgentGetTimestampNs();
+        status = pBinary->PublishISA();
+        AgentRecordTime(AGENT_TIMER_ISA_PUBLICATION, phaseStartNs, 0);
+        PredispatchCheckStatus(status, "Error publishing the ISA");
+
         AgentTriggerGDBEventLoop();
+        TriggerGPUBreakpointStop();
     }
 
     // We are going to enter kernel debugging
     // Set all the existing breakpoints again, do this before you run the FIFO
     // since the FIFO may include commands to disable breakpoints
+    phaseStartNs = AgentGetTimestampNs();
     status = pBpManager->EnableAllPCBreakpoints(pActiveContext->GetActiveHwDebugContext());
+    AgentRecordTime(AGENT_TIMER_ENABLE_BREAKPOINTS, phaseStartNs, 0);
     PredispatchCheckStatus(status, "Error in Enabling existing PC Breakpoints");
 
     // We should check the fifo and set the breakpoints in this thread itself.
     //
     // This is necessary so that the appropriate source breakpoints
     // are ready before the kernel starts
-    RunFifoCommandLoop(pActiveContext, 50);
+    phaseStartNs = AgentGetTimestampNs();
+    RunFifoCommandLoopTillSync(pActiveContext, 50);
+    AgentRecordTime(AGENT_TIMER_PREDISPATCH_FIFO, phaseStartNs, 0);
 
     // We need to check again if any breakpoints were created
     // In case the user set any breakpoints or asked to step
@@ -234,21 +321,25 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
     }
     else
     {
+        phaseStartNs = AgentGetTimestampNs();
         status = pActiveContext->BeginDebugging(pRTParam->agent,
                                                 pRTParam->queue,
                                                 pAqlPacket,
                                                 HWDBG_BEHAVIOR_NONE);
+        AgentRecordTime(AGENT_TIMER_BEGIN_DEBUGGING, phaseStartNs, 0);
         PredispatchCheckStatus(status, "Error in Begin Debugging the second time in the predispatch");
 
         AGENT_LOG("Debug thread will be needed for this dispatch, "
                   << numPendingSrcBP << " source breakpoints enabled");
 
+        phaseStartNs = AgentGetTimestampNs();
         status = pBpManager->EnableAllPCBreakpoints(pActiveContext->GetActiveHwDebugContext());
+        AgentRecordTime(AGENT_TIMER_ENABLE_BREAKPOINTS, phaseStartNs, 0);
         PredispatchCheckStatus(status, "Error in Enabling existing PC Breakpoints");
 
     }
 
-    // Start Debug Thread Stage
+    // Hand the dispatch to the debug thread
     // We allocate the DebugEventThreadParams on the heap
     // The memory allocated here is freed in DebugEventThread, once the data is consumed
     DebugEventThreadParams* pDebugThreadArgs = new(std::nothrow) DebugEventThreadParams;
@@ -272,7 +363,9 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
 
         SetKernelParametersBuffers(pAqlPacket);
 
+        phaseStartNs = AgentGetTimestampNs();
         status = CreateDebugEventThread(pDebugThreadArgs);
+        AgentRecordTime(AGENT_TIMER_DEBUG_THREAD_CREATION, phaseStartNs, 0);
         PredispatchCheckStatus(status, "Error in CreateDebugEventThread");
     }
 
@@ -283,6 +376,83 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
 }
 
 
+void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArgs)
+{
+    AGENT_LOG("== Start Pre-dispatch callback ==");
+
+    if (pRTParam == nullptr || !pRTParam->pre_dispatch)
+    {
+        AGENT_ERROR("PreDispatchCallback: Invalid input RT parameters");
+        return;
+    }
+
+    hsa_kernel_dispatch_packet_t* pAqlPacket = pRTParam->aql_packet;
+
+    if (pAqlPacket == nullptr)
+    {
+        AGENT_ERROR("No AQL packet present.");
+        return;
+    }
+
+    if (!ValidateAQL(*pAqlPacket))
+    {
+        AGENT_ERROR("Invalid AQL packet.");
+        return;
+    }
+
+    if (pUserArgs == nullptr)
+    {
+        AGENT_ERROR("AgentQueueContext pointer is not valid");
+        return;
+    }
+
+    AgentQueueContext* pQueueContext = reinterpret_cast<AgentQueueContext*>(pUserArgs);
+    AgentContext* pActiveContext = pQueueContext->GetAgentContext();
+
+    if (pActiveContext == nullptr)
+    {
+        AGENT_ERROR("Invalid AgentContext from PredispatchCallback");
+        return;
+    }
+
+    // A dispatch the kernel filter does not select never enters the debug engine,
+    // unless gdb has sent commands, which are read by the predispatch
+    if (!AgentIsDispatchSelected(pAqlPacket->kernel_object, pRTParam->queue->id) && !IsGdbCommandPending())
+    {
+        AGENT_LOG("PredispatchCallback: Kernel object " << pAqlPacket->kernel_object <<
+                  " is not selected by the kernel filter");
+        return;
+    }
+
+    AgentPreparedBinary preparedBinary;
+
+    uint64_t phaseStartNs = AgentGetTimestampNs();
+    const bool isBinaryPrepared = PrepareDispatch(pActiveContext, pAqlPacket, preparedBinary);
+    AgentRecordTime(AGENT_TIMER_DISPATCH_PREPARATION, phaseStartNs, 0);
+
+    // Only a dispatch that could stop waits for a dispatch of another queue being debugged.
+    // The debug engine is free once the previous debugged dispatch has ended
+    phaseStartNs = AgentGetTimestampNs();
+    const bool isDebugEngineAcquired = pQueueContext->AcquireDebugEngine(pAqlPacket->kernel_object);
+    AgentRecordTime(AGENT_TIMER_DEBUG_ENGINE_WAIT, phaseStartNs, 0);
+
+    if (!isDebugEngineAcquired)
+    {
+        AGENT_LOG("PredispatchCallback: The debug engine is held by another queue, kernel object " <<
+                  pAqlPacket->kernel_object << " of queue " << pQueueContext->GetQueueId() <<
+                  " runs without being debugged");
+        return;
+    }
+
+    uint64_t predispatchStartNs = AgentGetTimestampNs();
+    RunPredispatch(pRTParam, pAqlPacket, pActiveContext, isBinaryPrepared ? &preparedBinary : nullptr);
+    AgentRecordTime(AGENT_TIMER_PREDISPATCH, predispatchStartNs, 0);
+
+    // The debug thread has its own hold on the debug engine
+    AgentReleaseDebugEngine();
+}
+
+
 // Note: We cannot use HSAWaitOnSignal here to close the debug Event thread
 // since the words *PostDispatch* mean just that, they do not mean PostCompletion
 void PostDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArgs)
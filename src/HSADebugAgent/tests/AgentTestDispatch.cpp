@@ -0,0 +1,135 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief An agent context with one device and one queue, the dispatches of the tests
+///        go through the predispatch callback like the ones of the runtime
+//==============================================================================
+#include <cstdio>
+#include <cstring>
+
+#include "hsa.h"
+#include "amd_hsa_tools_interfaces.h"
+
+#include "AgentContext.h"
+#include "AgentQueueContext.h"
+#include "CommandLoop.h"
+#include "CommunicationControl.h"
+#include "PrePostDispatchCallback.h"
+
+#include "AgentTestDispatch.h"
+#include "AgentTestEngine.h"
+#include "AgentTestSupport.h"
+
+namespace HwDbgAgentTest
+{
+
+/// The handle of the only device
+static const uint64_t gs_TEST_DEVICE_HANDLE = 0x1234;
+
+TestDispatcher::TestDispatcher():
+    m_pAgentContext(nullptr),
+    m_pQueueContext(nullptr)
+{
+    memset(&m_queue, 0, sizeof(m_queue));
+    memset(&m_packet, 0, sizeof(m_packet));
+    memset(&m_callbackParams, 0, sizeof(m_callbackParams));
+
+    m_pAgentContext = new HwDbgAgent::AgentContext;
+
+    if (m_pAgentContext->Initialize() != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "TestDispatcher: Could not initialize the agent context\n");
+        return;
+    }
+
+    RocmDeviceDesc device;
+    memset(&device, 0, sizeof(device));
+    m_pAgentContext->AddDeviceInfo(gs_TEST_DEVICE_HANDLE, device);
+
+    m_queue.id = 1;
+    m_pQueueContext = new HwDbgAgent::AgentQueueContext(m_pAgentContext, &m_queue);
+
+    m_callbackParams.agent.handle = gs_TEST_DEVICE_HANDLE;
+    m_callbackParams.queue = &m_queue;
+    m_callbackParams.aql_packet = &m_packet;
+    m_callbackParams.pre_dispatch = true;
+}
+
+TestDispatcher::~TestDispatcher()
+{
+    m_pAgentContext->ShutDown(true);
+
+    delete m_pQueueContext;
+    delete m_pAgentContext;
+}
+
+void TestDispatcher::Dispatch(const uint64_t kernelObject, const uint32_t numWaves)
+{
+    TestMakeDispatchPacket(kernelObject, numWaves, m_packet);
+    m_callbackParams.packet_id++;
+
+    HwDbgAgent::PreDispatchCallback(&m_callbackParams, m_pQueueContext);
+}
+
+void TestDispatcher::WaitForDispatch()
+{
+    HwDbgAgent::WaitForDebugThreadCompletion();
+}
+
+void TestDispatcher::CreatePCBreakpoint(const uint64_t pc, const int gdbBreakpointID)
+{
+    HsailConditionPacket condition;
+    memset(&condition, 0, sizeof(condition));
+    condition.m_conditionCode = HSAIL_BREAKPOINT_CONDITION_ANY;
+
+    SendPCBreakpoint(pc, gdbBreakpointID, condition);
+}
+
+void TestDispatcher::CreateConditionalPCBreakpoint(const uint64_t       pc,
+                                                   const int            gdbBreakpointID,
+                                                   const HsailWaveDim3& workGroupID,
+                                                   const HsailWaveDim3& workItemID)
+{
+    HsailConditionPacket condition;
+    memset(&condition, 0, sizeof(condition));
+    condition.m_conditionCode = HSAIL_BREAKPOINT_CONDITION_EQUAL;
+    condition.m_workgroupID = workGroupID;
+    condition.m_workitemID = workItemID;
+
+    SendPCBreakpoint(pc, gdbBreakpointID, condition);
+}
+
+void TestDispatcher::SendPCBreakpoint(const uint64_t              pc,
+                                      const int                   gdbBreakpointID,
+                                      const HsailConditionPacket& condition)
+{
+    HsailCommandPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.m_command = HSAIL_COMMAND_CREATE_BREAKPOINT;
+    packet.m_pc = pc;
+    packet.m_gdbBreakpointID = gdbBreakpointID;
+    packet.m_conditionPacket = condition;
+
+    // The agent logs an error for a PC breakpoint without its source line
+    packet.m_lineNum = gdbBreakpointID;
+    snprintf(packet.m_sourceLine, sizeof(packet.m_sourceLine), "out[i] = in[i];");
+
+    TestWriteGdbCommand(reinterpret_cast<const char*>(&packet), sizeof(packet));
+}
+
+void TestDispatcher::CreateKernelNameBreakpoint(const char* pKernelName, const int gdbBreakpointID)
+{
+    HsailCommandPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.m_command = HSAIL_COMMAND_CREATE_BREAKPOINT;
+    packet.m_pc = HSAIL_ISA_PC_UNKOWN;
+    packet.m_gdbBreakpointID = gdbBreakpointID;
+    packet.m_conditionPacket.m_conditionCode = HSAIL_BREAKPOINT_CONDITION_ANY;
+    snprintf(packet.m_kernelName, sizeof(packet.m_kernelName), "%s", pKernelName);
+
+    TestWriteGdbCommand(reinterpret_cast<const char*>(&packet), sizeof(packet));
+}
+
+} // End Namespace HwDbgAgentTest
@@ -0,0 +1,94 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief An agent context with one device and one queue, the dispatches of the tests
+///        go through the predispatch callback like the ones of the runtime
+//==============================================================================
+#ifndef AGENT_TEST_DISPATCH_H_
+#define AGENT_TEST_DISPATCH_H_
+
+#include <cstdint>
+
+#include "hsa.h"
+#include "amd_hsa_tools_interfaces.h"
+
+#include "CommunicationControl.h"
+
+namespace HwDbgAgent
+{
+class AgentContext;
+class AgentQueueContext;
+}
+
+namespace HwDbgAgentTest
+{
+
+/// The agent context and the queue of a test.
+/// The stand-in DBE answers the dispatches, a stand-in gdb started with TestStartGdb
+/// must be running before the first dispatch
+class TestDispatcher
+{
+public:
+    TestDispatcher();
+
+    /// Shut down the agent context, the debug thread is stopped
+    ~TestDispatcher();
+
+    /// Check if the agent context was initialized
+    bool IsReady() const { return m_pQueueContext != nullptr; }
+
+    HwDbgAgent::AgentContext* GetAgentContext() const { return m_pAgentContext; }
+
+    /// Run the predispatch callback of a dispatch, the debug thread runs the dispatch if it stops
+    /// \param[in] kernelObject The kernel_object of the AQL packet
+    /// \param[in] numWaves     The number of waves of the grid
+    void Dispatch(const uint64_t kernelObject, const uint32_t numWaves);
+
+    /// Wait for the debug thread to be done with the last dispatch
+    void WaitForDispatch();
+
+    /// Send a PC breakpoint as gdb does between two dispatches,
+    /// the agent creates it in the predispatch callback of the next dispatch
+    /// \param[in] pc              The code address
+    /// \param[in] gdbBreakpointID The number of the breakpoint in gdb
+    void CreatePCBreakpoint(const uint64_t pc, const int gdbBreakpointID);
+
+    /// Send a PC breakpoint that only stops the waves of a work-item
+    /// \param[in] pc              The code address
+    /// \param[in] gdbBreakpointID The number of the breakpoint in gdb
+    /// \param[in] workGroupID     The work-group of the work-item
+    /// \param[in] workItemID      The work-item in the work-group
+    void CreateConditionalPCBreakpoint(const uint64_t       pc,
+                                       const int            gdbBreakpointID,
+                                       const HsailWaveDim3& workGroupID,
+                                       const HsailWaveDim3& workItemID);
+
+    /// Send a kernel name breakpoint as gdb does between two dispatches
+    /// \param[in] pKernelName     The demangled kernel name
+    /// \param[in] gdbBreakpointID The number of the breakpoint in gdb
+    void CreateKernelNameBreakpoint(const char* pKernelName, const int gdbBreakpointID);
+
+private:
+    /// Disable copy constructor
+    TestDispatcher(const TestDispatcher&);
+
+    /// Disable assignment operator
+    TestDispatcher& operator=(const TestDispatcher&);
+
+    /// Send a HSAIL_COMMAND_CREATE_BREAKPOINT of a PC breakpoint
+    void SendPCBreakpoint(const uint64_t pc, const int gdbBreakpointID, const HsailConditionPacket& condition);
+
+    HwDbgAgent::AgentContext* m_pAgentContext;
+    HwDbgAgent::AgentQueueContext* m_pQueueContext;
+
+    /// The queue and the packet of the last dispatch, the debug thread reads them
+    hsa_queue_t m_queue;
+    hsa_kernel_dispatch_packet_t m_packet;
+    hsa_dispatch_callback_t m_callbackParams;
+};
+
+} // End Namespace HwDbgAgentTest
+
+#endif // AGENT_TEST_DISPATCH_H_
@@ -0,0 +1,391 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief A stand-in for the DBE library, so the agent runs in the tests without a GPU
+//==============================================================================
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "AgentTestEngine.h"
+#include "AgentTestSupport.h"
+
+namespace HwDbgAgentTest
+{
+
+/// The state the DBE entry points answer with
+static TestDebugEngine gs_DebugEngine;
+
+/// The context handle returned by HwDbgBeginDebugContext
+static int gs_DebugContext = 0;
+
+/// The code address of every breakpoint created, keyed by its handle
+static std::map<HwDbgCodeBreakpointHandle, HwDbgCodeAddress> gs_CodeBreakpoints;
+
+/// Handle of the next code breakpoint
+static uintptr_t gs_NextCodeBreakpoint = 1;
+
+/// Protects the breakpoints, the DBE is called by the predispatch callback and by the debug thread
+static pthread_mutex_t gs_CodeBreakpointMutex = PTHREAD_MUTEX_INITIALIZER;
+
+TestDebugEngine& TestGetDebugEngine()
+{
+    return gs_DebugEngine;
+}
+
+void TestResetDebugEngine()
+{
+    gs_DebugEngine.m_kernelBinary.clear();
+    gs_DebugEngine.m_kernelName.clear();
+    gs_DebugEngine.m_segments.clear();
+    gs_DebugEngine.m_waves.clear();
+    gs_DebugEngine.m_events.clear();
+    gs_DebugEngine.m_eventDelayUs = 0;
+
+    gs_DebugEngine.m_numBeginDebugContext = 0;
+    gs_DebugEngine.m_numEndDebugContext = 0;
+    gs_DebugEngine.m_numLoadMapQueries = 0;
+    gs_DebugEngine.m_numBinaryQueries = 0;
+    gs_DebugEngine.m_numWaveQueries = 0;
+    gs_DebugEngine.m_numBreakpointsCreated = 0;
+    gs_DebugEngine.m_numBreakpointsDeleted = 0;
+    gs_DebugEngine.m_numContinues = 0;
+    gs_DebugEngine.m_lastContinueNs = 0;
+
+    pthread_mutex_lock(&gs_CodeBreakpointMutex);
+    gs_CodeBreakpoints.clear();
+    pthread_mutex_unlock(&gs_CodeBreakpointMutex);
+}
+
+bool TestReadFile(const char* pPath, std::vector<char>& bytesOut)
+{
+    std::ifstream file(pPath, std::ios::binary);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    bytesOut.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    return !bytesOut.empty();
+}
+
+void TestMakeWaves(const uint32_t numWaves, const HwDbgCodeAddress pc, std::vector<HwDbgWavefrontInfo>& wavesOut)
+{
+    wavesOut.resize(numWaves);
+
+    for (uint32_t i = 0; i < numWaves; i++)
+    {
+        HwDbgWavefrontInfo& wave = wavesOut[i];
+        memset(&wave, 0, sizeof(HwDbgWavefrontInfo));
+
+        wave.workGroupId.x = i / 4;
+
+        for (uint32_t j = 0; j < HWDBG_WAVEFRONT_SIZE; j++)
+        {
+            wave.workItemId[j].x = (i % 4) * HWDBG_WAVEFRONT_SIZE + j;
+        }
+
+        wave.executionMask = UINT64_MAX;
+        wave.wavefrontAddress = i;
+        wave.codeAddress = pc;
+        wave.breakpointType = HWDBG_BREAKPOINT_TYPE_CODE;
+    }
+}
+
+void TestMakeDispatchPacket(const uint64_t kernelObject, const uint32_t numWaves, hsa_kernel_dispatch_packet_t& packetOut)
+{
+    memset(&packetOut, 0, sizeof(hsa_kernel_dispatch_packet_t));
+
+    packetOut.setup = 1 << HSA_KERNEL_DISPATCH_PACKET_SETUP_DIMENSIONS;
+    packetOut.workgroup_size_x = HWDBG_WAVEFRONT_SIZE;
+    packetOut.workgroup_size_y = 1;
+    packetOut.workgroup_size_z = 1;
+    packetOut.grid_size_x = numWaves * HWDBG_WAVEFRONT_SIZE;
+    packetOut.grid_size_y = 1;
+    packetOut.grid_size_z = 1;
+    packetOut.kernel_object = kernelObject;
+}
+
+} // End Namespace HwDbgAgentTest
+
+using HwDbgAgentTest::gs_DebugEngine;
+
+extern "C"
+{
+
+HwDbgStatus HWDBG_API_CALL HwDbgSetLoggingCallback(uint32_t types, HwDbgLoggingCallback pCallback, void* pUserData)
+{
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgGetAPIVersion(uint32_t* pVersionMajorOut,
+                                              uint32_t* pVersionMinorOut,
+                                              uint32_t* pVersionBuildOut)
+{
+    if (pVersionMajorOut == nullptr || pVersionMinorOut == nullptr || pVersionBuildOut == nullptr)
+    {
+        return HWDBG_STATUS_NULL_POINTER;
+    }
+
+    *pVersionMajorOut = AMDGPUDEBUG_VERSION_MAJOR;
+    *pVersionMinorOut = AMDGPUDEBUG_VERSION_MINOR;
+    *pVersionBuildOut = AMDGPUDEBUG_VERSION_BUILD;
+
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgInit(void* pApiTable)
+{
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgShutDown()
+{
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgBeginDebugContext(const HwDbgState state, HwDbgContextHandle* pDebugContextOut)
+{
+    if (pDebugContextOut == nullptr)
+    {
+        return HWDBG_STATUS_NULL_POINTER;
+    }
+
+    __atomic_add_fetch(&gs_DebugEngine.m_numBeginDebugContext, 1, __ATOMIC_RELAXED);
+    *pDebugContextOut = &HwDbgAgentTest::gs_DebugContext;
+
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgEndDebugContext(HwDbgContextHandle hDebugContext)
+{
+    __atomic_add_fetch(&gs_DebugEngine.m_numEndDebugContext, 1, __ATOMIC_RELAXED);
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgWaitForEvent(HwDbgContextHandle hDebugContext,
+                                             const uint32_t     timeout,
+                                             HwDbgEventType*    pEventTypeOut)
+{
+    if (pEventTypeOut == nullptr)
+    {
+        return HWDBG_STATUS_NULL_POINTER;
+    }
+
+    if (gs_DebugEngine.m_eventDelayUs > 0)
+    {
+        usleep(gs_DebugEngine.m_eventDelayUs);
+    }
+
+    if (gs_DebugEngine.m_events.empty())
+    {
+        *pEventTypeOut = HWDBG_EVENT_END_DEBUGGING;
+    }
+    else
+    {
+        *pEventTypeOut = gs_DebugEngine.m_events.front();
+        gs_DebugEngine.m_events.pop_front();
+    }
+
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgContinueEvent(HwDbgContextHandle hDebugContext, const HwDbgCommand command)
+{
+    __atomic_store_n(&gs_DebugEngine.m_lastContinueNs, HwDbgAgentTest::TestNowNs(), __ATOMIC_RELAXED);
+    __atomic_add_fetch(&gs_DebugEngine.m_numContinues, 1, __ATOMIC_RELEASE);
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgCreateCodeBreakpoint(HwDbgContextHandle         hDebugContext,
+                                                     const HwDbgCodeAddress     codeAddress,
+                                                     HwDbgCodeBreakpointHandle* pBreakpointOut)
+{
+    if (pBreakpointOut == nullptr)
+    {
+        return HWDBG_STATUS_NULL_POINTER;
+    }
+
+    pthread_mutex_lock(&HwDbgAgentTest::gs_CodeBreakpointMutex);
+
+    HwDbgCodeBreakpointHandle hBreakpoint = reinterpret_cast<HwDbgCodeBreakpointHandle>(HwDbgAgentTest::gs_NextCodeBreakpoint++);
+    HwDbgAgentTest::gs_CodeBreakpoints[hBreakpoint] = codeAddress;
+
+    pthread_mutex_unlock(&HwDbgAgentTest::gs_CodeBreakpointMutex);
+
+    __atomic_add_fetch(&gs_DebugEngine.m_numBreakpointsCreated, 1, __ATOMIC_RELAXED);
+    *pBreakpointOut = hBreakpoint;
+
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgDeleteCodeBreakpoint(HwDbgContextHandle hDebugContext, HwDbgCodeBreakpointHandle hBreakpoint)
+{
+    pthread_mutex_lock(&HwDbgAgentTest::gs_CodeBreakpointMutex);
+    size_t numErased = HwDbgAgentTest::gs_CodeBreakpoints.erase(hBreakpoint);
+    pthread_mutex_unlock(&HwDbgAgentTest::gs_CodeBreakpointMutex);
+
+    if (numErased == 0)
+    {
+        return HWDBG_STATUS_INVALID_HANDLE;
+    }
+
+    __atomic_add_fetch(&gs_DebugEngine.m_numBreakpointsDeleted, 1, __ATOMIC_RELAXED);
+
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgDeleteAllCodeBreakpoints(HwDbgContextHandle hDebugContext)
+{
+    pthread_mutex_lock(&HwDbgAgentTest::gs_CodeBreakpointMutex);
+    size_t numBreakpoints = HwDbgAgentTest::gs_CodeBreakpoints.size();
+    HwDbgAgentTest::gs_CodeBreakpoints.clear();
+    pthread_mutex_unlock(&HwDbgAgentTest::gs_CodeBreakpointMutex);
+
+    __atomic_add_fetch(&gs_DebugEngine.m_numBreakpointsDeleted, numBreakpoints, __ATOMIC_RELAXED);
+
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgGetCodeBreakpointAddress(const HwDbgContextHandle        hDebugContext,
+                                                         const HwDbgCodeBreakpointHandle hBreakpoint,
+                                                         HwDbgCodeAddress*               pCodeAddressOut)
+{
+    if (pCodeAddressOut == nullptr)
+    {
+        return HWDBG_STATUS_NULL_POINTER;
+    }
+
+    HwDbgStatus status = HWDBG_STATUS_INVALID_HANDLE;
+
+    pthread_mutex_lock(&HwDbgAgentTest::gs_CodeBreakpointMutex);
+
+    std::map<HwDbgCodeBreakpointHandle, HwDbgCodeAddress>::const_iterator bpIt =
+        HwDbgAgentTest::gs_CodeBreakpoints.find(hBreakpoint);
+
+    if (bpIt != HwDbgAgentTest::gs_CodeBreakpoints.end())
+    {
+        *pCodeAddressOut = bpIt->second;
+        status = HWDBG_STATUS_SUCCESS;
+    }
+
+    pthread_mutex_unlock(&HwDbgAgentTest::gs_CodeBreakpointMutex);
+
+    return status;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgGetKernelBinary(const HwDbgContextHandle hDebugContext,
+                                                const void**             ppBinaryOut,
+                                                size_t*                  pBinarySizeOut)
+{
+    if (ppBinaryOut == nullptr || pBinarySizeOut == nullptr)
+    {
+        return HWDBG_STATUS_NULL_POINTER;
+    }
+
+    if (gs_DebugEngine.m_kernelBinary.empty())
+    {
+        return HWDBG_STATUS_ERROR;
+    }
+
+    __atomic_add_fetch(&gs_DebugEngine.m_numBinaryQueries, 1, __ATOMIC_RELAXED);
+
+    *ppBinaryOut = gs_DebugEngine.m_kernelBinary.data();
+    *pBinarySizeOut = gs_DebugEngine.m_kernelBinary.size();
+
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgGetDispatchedKernelName(const HwDbgContextHandle hDebugContext,
+                                                        const char**             ppKernelNameOut)
+{
+    if (ppKernelNameOut == nullptr)
+    {
+        return HWDBG_STATUS_NULL_POINTER;
+    }
+
+    *ppKernelNameOut = gs_DebugEngine.m_kernelName.c_str();
+
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgGetLoadedSegmentDescriptors(HwDbgLoaderSegmentDescriptor* pSegmentDescriptorListOut,
+                                                            size_t*                       pSegmentDescriptorCountOut)
+{
+    if (pSegmentDescriptorCountOut == nullptr)
+    {
+        return HWDBG_STATUS_NULL_POINTER;
+    }
+
+    // The agent asks for the count first, then for the descriptors
+    if (pSegmentDescriptorListOut == nullptr)
+    {
+        __atomic_add_fetch(&gs_DebugEngine.m_numLoadMapQueries, 1, __ATOMIC_RELAXED);
+        *pSegmentDescriptorCountOut = gs_DebugEngine.m_segments.size();
+        return HWDBG_STATUS_SUCCESS;
+    }
+
+    size_t numSegments = std::min(*pSegmentDescriptorCountOut, gs_DebugEngine.m_segments.size());
+
+    if (numSegments > 0)
+    {
+        memcpy(pSegmentDescriptorListOut, gs_DebugEngine.m_segments.data(), numSegments * sizeof(HwDbgLoaderSegmentDescriptor));
+    }
+
+    *pSegmentDescriptorCountOut = numSegments;
+
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgGetActiveWavefronts(const HwDbgContextHandle   hDebugContext,
+                                                    const HwDbgWavefrontInfo** ppWavefrontInfoOut,
+                                                    uint32_t*                  pNumWavefrontsOut)
+{
+    if (ppWavefrontInfoOut == nullptr || pNumWavefrontsOut == nullptr)
+    {
+        return HWDBG_STATUS_NULL_POINTER;
+    }
+
+    __atomic_add_fetch(&gs_DebugEngine.m_numWaveQueries, 1, __ATOMIC_RELAXED);
+
+    *ppWavefrontInfoOut = gs_DebugEngine.m_waves.empty() ? nullptr : gs_DebugEngine.m_waves.data();
+    *pNumWavefrontsOut = static_cast<uint32_t>(gs_DebugEngine.m_waves.size());
+
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgReadMemory(const HwDbgContextHandle hDebugContext,
+                                           const uint32_t           memoryRegion,
+                                           const HwDbgDim3          workGroupId,
+                                           const HwDbgDim3          workItemId,
+                                           const size_t             offset,
+                                           const size_t             numBytesToRead,
+                                           void*                    pMemOut,
+                                           size_t*                  pNumBytesOut)
+{
+    if (pMemOut == nullptr || pNumBytesOut == nullptr)
+    {
+        return HWDBG_STATUS_NULL_POINTER;
+    }
+
+    // The stand-in device memory is all zero
+    memset(pMemOut, 0, numBytesToRead);
+    *pNumBytesOut = numBytesToRead;
+
+    return HWDBG_STATUS_SUCCESS;
+}
+
+HwDbgStatus HWDBG_API_CALL HwDbgKillAll(const HwDbgContextHandle hDebugContext)
+{
+    return HWDBG_STATUS_SUCCESS;
+}
+
+} // extern "C"
@@ -0,0 +1,74 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief A stand-in for the DBE library, so the agent runs in the tests without a GPU
+//==============================================================================
+#ifndef AGENT_TEST_ENGINE_H_
+#define AGENT_TEST_ENGINE_H_
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "hsa.h"
+
+#include "AMDGPUDebug.h"
+
+namespace HwDbgAgentTest
+{
+
+/// What the stand-in DBE answers the agent with.
+/// A test sets it before it dispatches, the agent only calls the DBE from the holder
+/// of the debug engine, except for the load map queries which are serialized by the agent.
+/// The counters are updated atomically and can be read at any time.
+typedef struct
+{
+    std::vector<char>                         m_kernelBinary;   // Returned by HwDbgGetKernelBinary
+    std::string                               m_kernelName;     // Returned by HwDbgGetDispatchedKernelName
+    std::vector<HwDbgLoaderSegmentDescriptor> m_segments;       // Returned by HwDbgGetLoadedSegmentDescriptors
+    std::vector<HwDbgWavefrontInfo>           m_waves;          // Returned by HwDbgGetActiveWavefronts
+    std::deque<HwDbgEventType>                m_events;         // Returned in order by HwDbgWaitForEvent,
+                                                                // HWDBG_EVENT_END_DEBUGGING once it is empty
+    uint32_t                                  m_eventDelayUs;   // Time HwDbgWaitForEvent sleeps before it returns
+
+    uint64_t m_numBeginDebugContext;
+    uint64_t m_numEndDebugContext;
+    uint64_t m_numLoadMapQueries;
+    uint64_t m_numBinaryQueries;
+    uint64_t m_numWaveQueries;
+    uint64_t m_numBreakpointsCreated;
+    uint64_t m_numBreakpointsDeleted;
+    uint64_t m_numContinues;
+    uint64_t m_lastContinueNs;                                  // TestNowNs of the last HwDbgContinueEvent
+} TestDebugEngine;
+
+/// Get the state of the stand-in DBE
+TestDebugEngine& TestGetDebugEngine();
+
+/// Clear the state and the counters of the stand-in DBE
+void TestResetDebugEngine();
+
+/// Read a whole file, used to load the code objects of the tests
+/// \param[in]  pPath    The path of the file
+/// \param[out] bytesOut The content of the file
+/// \return false if the file could not be read
+bool TestReadFile(const char* pPath, std::vector<char>& bytesOut);
+
+/// Make the waves of a dispatch, all stopped at a PC with every work-item active
+/// \param[in]  numWaves The number of waves
+/// \param[in]  pc       The code address of every wave
+/// \param[out] wavesOut The waves, work-group i / 4 and work-items of wave i % 4
+void TestMakeWaves(const uint32_t numWaves, const HwDbgCodeAddress pc, std::vector<HwDbgWavefrontInfo>& wavesOut);
+
+/// Make a 1D dispatch packet the agent accepts without warnings
+/// \param[in]  kernelObject The kernel_object of the packet
+/// \param[in]  numWaves     The number of waves of 64 work-items in the grid
+/// \param[out] packetOut    The packet
+void TestMakeDispatchPacket(const uint64_t kernelObject, const uint32_t numWaves, hsa_kernel_dispatch_packet_t& packetOut);
+
+} // End Namespace HwDbgAgentTest
+
+#endif // AGENT_TEST_ENGINE_H_
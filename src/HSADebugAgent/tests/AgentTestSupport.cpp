@@ -0,0 +1,401 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Checks, latency reports and a stand-in gdb shared by the agent tests and benchmarks
+//==============================================================================
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "hsa.h"
+
+#include "AgentConfiguration.h"
+#include "AgentFramedProtocol.h"
+#include "AgentLogging.h"
+#include "CommunicationControl.h"
+#include "CommunicationParams.h"
+#include "HSADebugAgent.h"
+
+#include "AgentTestSupport.h"
+
+/// The configuration of the test process, the agent creates it in OnLoad
+static HwDbgAgent::AgentConfiguration* gs_pTestAgentConfig = nullptr;
+
+HwDbgAgent::AgentConfiguration* GetActiveAgentConfig()
+{
+    return gs_pTestAgentConfig;
+}
+
+/// The runtime only provides the status strings, the agent only logs them
+hsa_status_t hsa_status_string(hsa_status_t status, const char** status_string)
+{
+    *status_string = "HSA status string not available in the tests";
+    return HSA_STATUS_SUCCESS;
+}
+
+namespace HwDbgAgentTest
+{
+
+/// Number of TEST_CHECK that failed
+static int gs_NumFailedChecks = 0;
+
+/// The process of the stand-in gdb, 0 if it is not running
+static pid_t gs_GdbPid = 0;
+
+/// Read end of the pipe the stand-in gdb reports the notifications it read on
+static int gs_GdbReportFd = -1;
+
+/// Write end of the gdb --> agent fifo kept by the test process
+static int gs_TestCommandFd = -1;
+
+void TestCheck(const bool isTrue, const char* pCondition, const char* pFile, const int line)
+{
+    if (!isTrue)
+    {
+        gs_NumFailedChecks++;
+        fprintf(stderr, "%s:%d: check failed: %s\n", pFile, line, pCondition);
+    }
+}
+
+int TestResult(const char* pTestName)
+{
+    if (gs_NumFailedChecks != 0)
+    {
+        printf("FAIL %s: %d checks failed\n", pTestName, gs_NumFailedChecks);
+        return 1;
+    }
+
+    printf("PASS %s\n", pTestName);
+    return 0;
+}
+
+uint64_t TestNowNs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+TestLatencies::TestLatencies():
+    m_durationsNs(),
+    m_isSorted(true)
+{
+}
+
+void TestLatencies::Add(const uint64_t durationNs)
+{
+    m_durationsNs.push_back(durationNs);
+    m_isSorted = false;
+}
+
+uint64_t TestLatencies::GetPercentile(const double percentile)
+{
+    if (m_durationsNs.empty())
+    {
+        return 0;
+    }
+
+    if (!m_isSorted)
+    {
+        std::sort(m_durationsNs.begin(), m_durationsNs.end());
+        m_isSorted = true;
+    }
+
+    size_t index = static_cast<size_t>(percentile / 100 * (m_durationsNs.size() - 1) + 0.5);
+
+    return m_durationsNs[std::min(index, m_durationsNs.size() - 1)];
+}
+
+void TestLatencies::Report(const char* pName)
+{
+    printf("  %-44s n %6zu  p50 %10.1f  p99 %10.1f  max %10.1f us\n", pName, m_durationsNs.size(),
+           GetPercentile(50) / 1000.0, GetPercentile(99) / 1000.0, GetPercentile(100) / 1000.0);
+}
+
+void TestInitAgent()
+{
+    // The agent signals gdb with SIGUSR1, there is no gdb to catch it
+    signal(SIGUSR1, SIG_IGN);
+
+    std::stringstream sessionID;
+    sessionID << "test" << getpid();
+    setenv("ROCM_GDB_DEBUG_SESSION_ID", sessionID.str().c_str(), 1);
+
+    AgentInitLogger();
+
+    gs_pTestAgentConfig = new HwDbgAgent::AgentConfiguration;
+}
+
+/// Read all the bytes asked for from a fifo
+static bool ReadAll(const int fd, void* pBytes, const size_t numBytes)
+{
+    size_t numRead = 0;
+
+    while (numRead < numBytes)
+    {
+        ssize_t readStatus = read(fd, static_cast<char*>(pBytes) + numRead, numBytes - numRead);
+
+        if (readStatus <= 0)
+        {
+            if (readStatus < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            return false;
+        }
+
+        numRead += readStatus;
+    }
+
+    return true;
+}
+
+/// Write all the bytes to a fifo
+static void WriteAll(const int fd, const void* pBytes, const size_t numBytes)
+{
+    size_t numWritten = 0;
+
+    while (numWritten < numBytes)
+    {
+        ssize_t writeStatus = write(fd, static_cast<const char*>(pBytes) + numWritten, numBytes - numWritten);
+
+        if (writeStatus <= 0)
+        {
+            if (writeStatus < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            return;
+        }
+
+        numWritten += writeStatus;
+    }
+}
+
+/// Read one notification the agent wrote, a frame or a HsailNotificationPayload
+/// \param[in]  fd              The read end of the agent --> gdb fifo
+/// \param[out] notificationOut The type and size of the notification
+/// \param[out] syncIdOut       The sync ID of a HSAIL_NOTIFY_SYNC_REQUEST frame
+/// \return false once the agent closed the fifo
+static bool ReadNotification(const int fd, TestGdbNotification& notificationOut, uint64_t& syncIdOut)
+{
+    uint32_t magic = 0;
+
+    if (!ReadAll(fd, &magic, sizeof(magic)))
+    {
+        return false;
+    }
+
+    if (magic != HSAIL_FRAME_MAGIC)
+    {
+        HsailNotificationPayload payload;
+        memcpy(&payload, &magic, sizeof(magic));
+
+        if (!ReadAll(fd, reinterpret_cast<char*>(&payload) + sizeof(magic), sizeof(payload) - sizeof(magic)))
+        {
+            return false;
+        }
+
+        notificationOut.m_notification = payload.m_Notification;
+        notificationOut.m_size = sizeof(payload);
+        syncIdOut = payload.payload.SyncRequestNotification.m_syncId;
+
+        return true;
+    }
+
+    HsailFrameHeader header;
+    header.m_magic = magic;
+
+    if (!ReadAll(fd, reinterpret_cast<char*>(&header) + sizeof(magic), sizeof(header) - sizeof(magic)))
+    {
+        return false;
+    }
+
+    std::vector<char> fields(header.m_length);
+
+    if (!ReadAll(fd, fields.data(), fields.size()))
+    {
+        return false;
+    }
+
+    notificationOut.m_notification = header.m_type;
+    notificationOut.m_size = sizeof(header) + header.m_length;
+    syncIdOut = 0;
+
+    size_t offset = 0;
+
+    while (offset + sizeof(HsailFrameFieldHeader) <= fields.size())
+    {
+        HsailFrameFieldHeader field;
+        memcpy(&field, &fields[offset], sizeof(field));
+        offset += sizeof(field);
+
+        if (field.m_tag == HSAIL_FRAME_TAG_SYNC_ID && field.m_length == sizeof(uint64_t))
+        {
+            memcpy(&syncIdOut, &fields[offset], sizeof(uint64_t));
+        }
+
+        offset += field.m_length;
+    }
+
+    return true;
+}
+
+/// The stand-in gdb, run in the child process till the agent closes its fifo
+static void RunGdb(const TestGdbScript& script, const int reportFd)
+{
+    HwDbgAgent::AgentConfiguration* pConfig = GetActiveAgentConfig();
+
+    // The agent opens its read end without blocking, then blocks on its write end
+    int commandFd = open(pConfig->GetSessionFileName(gs_GdbToAgentFifoName).c_str(), O_WRONLY);
+    int notificationFd = open(pConfig->GetSessionFileName(gs_AgentToGdbFifoName).c_str(), O_RDONLY);
+
+    if (commandFd < 0 || notificationFd < 0)
+    {
+        _exit(1);
+    }
+
+    if (script.m_protocolVersion != 0)
+    {
+        HwDbgAgent::AgentFrameWriter frame(HSAIL_COMMAND_SET_PROTOCOL);
+        frame.AddUInt32(HSAIL_FRAME_TAG_PROTOCOL_VERSION, script.m_protocolVersion);
+        WriteAll(commandFd, frame.GetFrame(), frame.GetFrameSize());
+    }
+
+    TestGdbNotification notification;
+    uint64_t syncId = 0;
+
+    while (ReadNotification(notificationFd, notification, syncId))
+    {
+        notification.m_receiveNs = TestNowNs();
+
+        // The report pipe does not block, reports a test does not read are dropped once it is full.
+        // The sync requests are still answered.
+        ssize_t reportStatus = write(reportFd, &notification, sizeof(notification));
+        (void)reportStatus;
+
+        if (notification.m_notification != HSAIL_NOTIFY_SYNC_REQUEST || !script.m_isSyncAnswered)
+        {
+            continue;
+        }
+
+        // Commands gdb still has queued when it sees the request, continue does the least work
+        HsailCommandPacket packet;
+        memset(&packet, 0, sizeof(packet));
+        packet.m_command = HSAIL_COMMAND_CONTINUE;
+
+        for (uint32_t i = 0; i < script.m_numCommandsBeforeMarker; i++)
+        {
+            WriteAll(commandFd, &packet, sizeof(packet));
+        }
+
+        if (script.m_markerDelayUs > 0)
+        {
+            usleep(script.m_markerDelayUs);
+        }
+
+        HwDbgAgent::AgentFrameWriter marker(HSAIL_COMMAND_SYNC_MARKER);
+        marker.AddUInt64(HSAIL_FRAME_TAG_SYNC_ID, syncId);
+        WriteAll(commandFd, marker.GetFrame(), marker.GetFrameSize());
+    }
+
+    _exit(0);
+}
+
+bool TestStartGdb(const TestGdbScript& script)
+{
+    if (CreateCommunicationFifos() != HSAIL_AGENT_STATUS_SUCCESS ||
+        InitFifoReadEnd() != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        return false;
+    }
+
+    int reportFds[2];
+
+    if (pipe(reportFds) != 0)
+    {
+        return false;
+    }
+
+    fcntl(reportFds[1], F_SETFL, O_NONBLOCK);
+
+    gs_GdbPid = fork();
+
+    if (gs_GdbPid == 0)
+    {
+        close(reportFds[0]);
+        RunGdb(script, reportFds[1]);
+    }
+
+    close(reportFds[1]);
+    gs_GdbReportFd = reportFds[0];
+
+    if (gs_GdbPid < 0 || InitFifoWriteEnd() != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        return false;
+    }
+
+    // A second writer, so the test can send commands of its own
+    gs_TestCommandFd = open(GetActiveAgentConfig()->GetSessionFileName(gs_GdbToAgentFifoName).c_str(), O_WRONLY);
+
+    return gs_TestCommandFd >= 0;
+}
+
+bool TestWaitForGdbNotification(TestGdbNotification& notificationOut, const int timeoutMs)
+{
+    struct pollfd reportFd;
+    reportFd.fd = gs_GdbReportFd;
+    reportFd.events = POLLIN;
+    reportFd.revents = 0;
+
+    if (poll(&reportFd, 1, timeoutMs) <= 0)
+    {
+        return false;
+    }
+
+    return ReadAll(gs_GdbReportFd, &notificationOut, sizeof(notificationOut));
+}
+
+void TestWriteGdbCommand(const char* pFrame, const size_t frameSize)
+{
+    WriteAll(gs_TestCommandFd, pFrame, frameSize);
+}
+
+void TestStopGdb()
+{
+    // gdb reads till the agent closes its write end
+    close(GetFifoWriteEnd());
+    close(GetFifoReadEnd());
+    close(gs_TestCommandFd);
+    gs_TestCommandFd = -1;
+
+    if (gs_GdbPid > 0)
+    {
+        waitpid(gs_GdbPid, nullptr, 0);
+        gs_GdbPid = 0;
+    }
+
+    close(gs_GdbReportFd);
+    gs_GdbReportFd = -1;
+
+    HwDbgAgent::AgentConfiguration* pConfig = GetActiveAgentConfig();
+    unlink(pConfig->GetSessionFileName(gs_GdbToAgentFifoName).c_str());
+    unlink(pConfig->GetSessionFileName(gs_AgentToGdbFifoName).c_str());
+}
+
+} // End Namespace HwDbgAgentTest
@@ -0,0 +1,99 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Checks, latency reports and a stand-in gdb shared by the agent tests and benchmarks
+//==============================================================================
+#ifndef AGENT_TEST_SUPPORT_H_
+#define AGENT_TEST_SUPPORT_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "CommunicationControl.h"
+
+/// Count a failure and print the condition if it is false, the test goes on
+#define TEST_CHECK(condition) HwDbgAgentTest::TestCheck((condition), #condition, __FILE__, __LINE__)
+
+namespace HwDbgAgentTest
+{
+
+/// Count a failure and print it if a condition is false, used by TEST_CHECK
+void TestCheck(const bool isTrue, const char* pCondition, const char* pFile, const int line);
+
+/// Print the result of a test
+/// \param[in] pTestName The name of the test
+/// \return The exit code of the test, 0 if no check failed
+int TestResult(const char* pTestName);
+
+/// Get the monotonic clock in nanoseconds, the same clock in every process
+uint64_t TestNowNs();
+
+/// Durations of one measured operation, reported as exact percentiles
+class TestLatencies
+{
+public:
+    TestLatencies();
+
+    /// Add one duration in nanoseconds
+    void Add(const uint64_t durationNs);
+
+    /// Get a percentile in nanoseconds, 0 if there are no durations
+    /// \param[in] percentile A value between 0 and 100
+    uint64_t GetPercentile(const double percentile);
+
+    /// Print the number of durations, p50, p99 and the max in microseconds
+    /// \param[in] pName The name of the measured operation
+    void Report(const char* pName);
+
+private:
+    std::vector<uint64_t> m_durationsNs;
+    bool m_isSorted;
+};
+
+/// Create the agent configuration of the test process and the logger, with a debug session ID
+/// of the process, so the fifos and shared memory of tests run in parallel are not shared.
+/// The agent log is written like in a debug session if ROCM_GDB_ENABLE_LOG is set
+void TestInitAgent();
+
+/// How the stand-in gdb answers the agent
+typedef struct
+{
+    uint32_t m_protocolVersion;             // Announced with a HSAIL_COMMAND_SET_PROTOCOL frame, 0 for an old gdb
+    bool     m_isSyncAnswered;              // Answer a sync request with a HSAIL_COMMAND_SYNC_MARKER frame
+    uint32_t m_numCommandsBeforeMarker;     // HSAIL_COMMAND_CONTINUE packets written before the marker
+    uint32_t m_markerDelayUs;               // Time waited before the marker is written
+} TestGdbScript;
+
+/// A notification the stand-in gdb read
+typedef struct
+{
+    uint32_t m_notification;    // The HsailNotification value
+    uint64_t m_receiveNs;       // TestNowNs when gdb had read all of it
+    uint32_t m_size;            // Bytes read from the fifo
+} TestGdbNotification;
+
+/// Create the fifos, start the stand-in gdb in a child process and open the agent ends of the fifos.
+/// The child answers the agent as the script says and reports every notification it reads
+/// \param[in] script How the stand-in gdb answers
+/// \return false if the fifos could not be opened
+bool TestStartGdb(const TestGdbScript& script);
+
+/// Get the next notification the stand-in gdb read
+/// \param[out] notificationOut The notification
+/// \param[in]  timeoutMs       Longest wait for it
+/// \return false if there was none in time
+bool TestWaitForGdbNotification(TestGdbNotification& notificationOut, const int timeoutMs);
+
+/// Write a command to the agent as gdb does, from the test process
+/// \param[in] pFrame    The bytes of a frame or of a HsailCommandPacket
+/// \param[in] frameSize The number of bytes
+void TestWriteGdbCommand(const char* pFrame, const size_t frameSize);
+
+/// Close the agent ends of the fifos, stop the stand-in gdb and remove the fifos
+void TestStopGdb();
+
+} // End Namespace HwDbgAgentTest
+
+#endif // AGENT_TEST_SUPPORT_H_
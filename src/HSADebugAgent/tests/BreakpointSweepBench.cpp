@@ -0,0 +1,268 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief The breakpoint statistics of a stop, every active wave is looked up in the
+///        PC index of the breakpoints, swept over the number of waves and of breakpoints
+//==============================================================================
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "hsa.h"
+
+#include "AgentBreakpointManager.h"
+#include "AgentContext.h"
+#include "AgentSharedMemRegistry.h"
+#include "CommunicationControl.h"
+
+#include "AgentTestDispatch.h"
+#include "AgentTestEngine.h"
+#include "AgentTestSupport.h"
+
+using namespace HwDbgAgent;
+using namespace HwDbgAgentTest;
+
+/// Any non-null handle, the stand-in DBE has a single context
+static const HwDbgContextHandle gs_DEBUG_CONTEXT = reinterpret_cast<HwDbgContextHandle>(0x1);
+
+/// The user breakpoint, the momentary breakpoints of a step follow it, no breakpoint is at the miss
+static const uint64_t gs_USER_BREAKPOINT_PC = 0x1000;
+static const uint64_t gs_FIRST_MOMENTARY_PC = 0x2000;
+static const uint64_t gs_MISSED_PC = 0x900;
+
+/// The waves looked up at every stop of a cell of the sweep, spread over the stops
+static const uint64_t gs_NUM_WAVE_LOOKUPS = 2000000;
+
+/// Look up a PC like GetBreakpointFromPC did before the index, the user breakpoints first
+/// \return true if a breakpoint is at the PC
+static bool ScanBreakpoints(const std::vector<uint64_t>& userPCs,
+                            const std::vector<uint64_t>& momentaryPCs,
+                            const uint64_t               pc,
+                            int&                         positionOut,
+                            bool&                        isMomentaryOut)
+{
+    for (size_t i = 0; i < userPCs.size(); i++)
+    {
+        if (userPCs[i] == pc)
+        {
+            positionOut = static_cast<int>(i);
+            isMomentaryOut = false;
+            return true;
+        }
+    }
+
+    for (size_t i = 0; i < momentaryPCs.size(); i++)
+    {
+        if (momentaryPCs[i] == pc)
+        {
+            positionOut = static_cast<int>(i);
+            isMomentaryOut = true;
+            return true;
+        }
+    }
+
+    positionOut = -1;
+    isMomentaryOut = false;
+    return false;
+}
+
+/// Read the notifications of the stops
+static void DrainNotifications()
+{
+    TestGdbNotification notification;
+
+    while (TestWaitForGdbNotification(notification, 0))
+    {
+    }
+}
+
+/// Replace the momentary breakpoints like gdb does for a step
+static void CreateMomentaryBreakpoints(AgentContext* pContext, const std::vector<uint64_t>& momentaryPCs)
+{
+    AgentBreakpointManager* pBpManager = pContext->GetBpManager();
+    TEST_CHECK(pBpManager->ClearMomentaryBreakpoints(gs_DEBUG_CONTEXT) == HSAIL_AGENT_STATUS_SUCCESS);
+
+    if (momentaryPCs.empty())
+    {
+        return;
+    }
+
+    HsailMomentaryBP* pMomentaryBPs = static_cast<HsailMomentaryBP*>(
+        pContext->GetSharedMemRegistry()->GetRegion(HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM));
+
+    if (pMomentaryBPs == nullptr)
+    {
+        TEST_CHECK(false);
+        return;
+    }
+
+    for (size_t i = 0; i < momentaryPCs.size(); i++)
+    {
+        pMomentaryBPs[i].m_pc = momentaryPCs[i];
+        pMomentaryBPs[i].m_lineNum = static_cast<int>(i);
+    }
+
+    HsailCommandPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.m_command = HSAIL_COMMAND_MOMENTARY_BREAKPOINT;
+    packet.m_numMomentaryBP = static_cast<int>(momentaryPCs.size());
+
+    TEST_CHECK(pBpManager->CreateMomentaryBreakpoints(gs_DEBUG_CONTEXT, packet) == HSAIL_AGENT_STATUS_SUCCESS);
+}
+
+/// One cell of the sweep, the user breakpoint and numBreakpoints - 1 momentary breakpoints
+static void RunStops(AgentContext* pContext, const uint32_t numBreakpoints, const uint32_t numWaves)
+{
+    std::vector<uint64_t> userPCs(1, gs_USER_BREAKPOINT_PC);
+    std::vector<uint64_t> momentaryPCs(numBreakpoints - 1);
+
+    for (size_t i = 0; i < momentaryPCs.size(); i++)
+    {
+        momentaryPCs[i] = gs_FIRST_MOMENTARY_PC + 8 * i;
+    }
+
+    CreateMomentaryBreakpoints(pContext, momentaryPCs);
+
+    AgentBreakpointManager* pBpManager = pContext->GetBpManager();
+    TestDebugEngine& engine = TestGetDebugEngine();
+
+    // Every breakpoint must be found on its own
+    TestMakeWaves(1, gs_USER_BREAKPOINT_PC, engine.m_waves);
+    TEST_CHECK(pBpManager->UpdateBreakpointStatistics(HWDBG_EVENT_POST_BREAKPOINT, gs_DEBUG_CONTEXT) ==
+               HSAIL_AGENT_STATUS_SUCCESS);
+
+    for (size_t i = 0; i < momentaryPCs.size(); i++)
+    {
+        engine.m_waves[0].codeAddress = momentaryPCs[i];
+        TEST_CHECK(pBpManager->UpdateBreakpointStatistics(HWDBG_EVENT_POST_BREAKPOINT, gs_DEBUG_CONTEXT) ==
+                   HSAIL_AGENT_STATUS_SUCCESS);
+        DrainNotifications();
+    }
+
+    // The waves are spread over the breakpoints and a PC without one
+    TestMakeWaves(numWaves, gs_USER_BREAKPOINT_PC, engine.m_waves);
+    std::mt19937 random(numWaves + numBreakpoints);
+
+    for (uint32_t i = 0; i < numWaves; i++)
+    {
+        uint32_t slot = random() % (numBreakpoints + 1);
+
+        if (slot < momentaryPCs.size())
+        {
+            engine.m_waves[i].codeAddress = momentaryPCs[slot];
+        }
+        else if (slot == numBreakpoints)
+        {
+            engine.m_waves[i].codeAddress = gs_MISSED_PC;
+        }
+    }
+
+    const int numStops = static_cast<int>(gs_NUM_WAVE_LOOKUPS / numWaves);
+    TestLatencies indexLatencies;
+    TestLatencies scanLatencies;
+    uint64_t numScanHits = 0;
+
+    for (int stop = 0; stop < numStops; stop++)
+    {
+        uint64_t startNs = TestNowNs();
+        HsailAgentStatus status = pBpManager->UpdateBreakpointStatistics(HWDBG_EVENT_POST_BREAKPOINT,
+                                                                         gs_DEBUG_CONTEXT);
+        indexLatencies.Add(TestNowNs() - startNs);
+        TEST_CHECK(status == HSAIL_AGENT_STATUS_SUCCESS);
+
+        DrainNotifications();
+
+        startNs = TestNowNs();
+
+        for (uint32_t i = 0; i < numWaves; i++)
+        {
+            int position = -1;
+            bool isMomentary = false;
+            numScanHits += ScanBreakpoints(userPCs, momentaryPCs, engine.m_waves[i].codeAddress, position,
+                                           isMomentary) ? 1 : 0;
+        }
+
+        scanLatencies.Add(TestNowNs() - startNs);
+    }
+
+    TEST_CHECK(numScanHits > 0);
+
+    // The whole stop, with its hit report, takes less than the lookups of the scan alone
+    if (numBreakpoints >= 256)
+    {
+        TEST_CHECK(indexLatencies.GetPercentile(50) < scanLatencies.GetPercentile(50));
+    }
+
+    const double indexP50Us = indexLatencies.GetPercentile(50) / 1000.0;
+    const double scanP50Us = scanLatencies.GetPercentile(50) / 1000.0;
+
+    printf("  %6u %6u %12.1f %12.1f %12.1f %12.1f\n", numBreakpoints, numWaves, indexP50Us,
+           indexLatencies.GetPercentile(99) / 1000.0, scanP50Us, indexP50Us * 1000.0 / numWaves);
+}
+
+int main()
+{
+    TestInitAgent();
+    TestResetDebugEngine();
+
+    // An old gdb, the hit report is one fixed size notification
+    TestGdbScript script;
+    memset(&script, 0, sizeof(script));
+
+    if (!TestStartGdb(script))
+    {
+        TEST_CHECK(false);
+        return TestResult("BreakpointSweepBench");
+    }
+
+    {
+        TestDispatcher dispatcher;
+        AgentContext* pContext = dispatcher.GetAgentContext();
+
+        if (dispatcher.IsReady())
+        {
+            HsailCommandPacket packet;
+            memset(&packet, 0, sizeof(packet));
+            packet.m_command = HSAIL_COMMAND_CREATE_BREAKPOINT;
+            packet.m_pc = gs_USER_BREAKPOINT_PC;
+            packet.m_gdbBreakpointID = 1;
+            packet.m_lineNum = 1;
+            packet.m_conditionPacket.m_conditionCode = HSAIL_BREAKPOINT_CONDITION_ANY;
+            snprintf(packet.m_sourceLine, sizeof(packet.m_sourceLine), "out[i] = in[i];");
+
+            TEST_CHECK(pContext->GetBpManager()->CreateBreakpoint(gs_DEBUG_CONTEXT, nullptr, packet,
+                                                                  HSAIL_BREAKPOINT_TYPE_PC_BP) ==
+                       HSAIL_AGENT_STATUS_SUCCESS);
+
+            printf("BreakpointSweepBench: UpdateBreakpointStatistics of a stop, 1 user breakpoint and momentary ones\n");
+            printf("  %6s %6s %12s %12s %12s %12s\n", "bps", "waves", "p50 us", "p99 us", "scan p50 us",
+                   "ns per wave");
+
+            const uint32_t breakpointCounts[] = { 1, 16, 64, 256, 1024 };
+            const uint32_t waveCounts[] = { 1000, 10000, 40000 };
+
+            for (size_t i = 0; i < sizeof(breakpointCounts) / sizeof(breakpointCounts[0]); i++)
+            {
+                for (size_t j = 0; j < sizeof(waveCounts) / sizeof(waveCounts[0]); j++)
+                {
+                    RunStops(pContext, breakpointCounts[i], waveCounts[j]);
+                }
+            }
+
+            TEST_CHECK(pContext->GetBpManager()->ClearMomentaryBreakpoints(gs_DEBUG_CONTEXT) ==
+                       HSAIL_AGENT_STATUS_SUCCESS);
+        }
+        else
+        {
+            TEST_CHECK(false);
+        }
+    }
+
+    TestStopGdb();
+
+    return TestResult("BreakpointSweepBench");
+}
@@ -0,0 +1,335 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Throughput and arrival latency of the gdb --> agent commands, through the
+///        shared memory command ring and through the fifo read one packet at a time
+//==============================================================================
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/shm.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "hsa.h"
+
+#include "AgentConfiguration.h"
+#include "CommunicationControl.h"
+#include "CommunicationParams.h"
+#include "HSADebugAgent.h"
+
+#include "AgentTestSupport.h"
+
+using namespace HwDbgAgent;
+using namespace HwDbgAgentTest;
+
+/// Packets sent as fast as the agent takes them
+static const uint64_t gs_NUM_BULK_PACKETS = 1000000;
+
+/// Packets sent one at a time, the agent waits for each of them
+static const int gs_NUM_LATENCY_PACKETS = 2000;
+
+/// Time gdb waits between two of the packets sent one at a time
+static const useconds_t gs_LATENCY_PACKET_GAP_US = 200;
+
+/// The packets the agent takes from the ring at once, the batch of RunCommandRingLoop
+static const unsigned int gs_RING_BATCH_SIZE = 16;
+
+/// Write one packet as gdb does, the producer protocol of HsailCommandRingHeader
+static void WriteRingPacket(HsailCommandRingHeader* pRing, const HsailCommandPacket& packet)
+{
+    HsailCommandPacket* pSlots = reinterpret_cast<HsailCommandPacket*>(pRing + 1);
+    uint64_t writeIndex = __atomic_load_n(&pRing->m_writeIndex, __ATOMIC_RELAXED);
+
+    while (writeIndex - __atomic_load_n(&pRing->m_readIndex, __ATOMIC_ACQUIRE) >= pRing->m_capacity)
+    {
+        sched_yield();
+    }
+
+    pSlots[writeIndex & (pRing->m_capacity - 1)] = packet;
+    __atomic_store_n(&pRing->m_writeIndex, writeIndex + 1, __ATOMIC_RELEASE);
+
+    __atomic_add_fetch(&pRing->m_doorbell, 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&pRing->m_consumerWaiting, __ATOMIC_SEQ_CST) != 0)
+    {
+        syscall(SYS_futex, &pRing->m_doorbell, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+    }
+}
+
+/// The stand-in gdb of the ring: the bulk packets carry their sequence number in m_pc,
+/// the packets sent one at a time carry the time they were written
+static void RunRingProducer(const key_t ringShmKey)
+{
+    int shmId = shmget(ringShmKey, 0, 0);
+    HsailCommandRingHeader* pRing = static_cast<HsailCommandRingHeader*>(shmat(shmId, nullptr, 0));
+
+    if (shmId < 0 || pRing == reinterpret_cast<void*>(-1) ||
+        __atomic_load_n(&pRing->m_magic, __ATOMIC_ACQUIRE) != HSAIL_COMMAND_RING_MAGIC)
+    {
+        _exit(1);
+    }
+
+    HsailCommandPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.m_command = HSAIL_COMMAND_CONTINUE;
+
+    for (uint64_t i = 0; i < gs_NUM_BULK_PACKETS; i++)
+    {
+        packet.m_pc = i;
+        WriteRingPacket(pRing, packet);
+    }
+
+    for (int i = 0; i < gs_NUM_LATENCY_PACKETS; i++)
+    {
+        usleep(gs_LATENCY_PACKET_GAP_US);
+        packet.m_pc = TestNowNs();
+        WriteRingPacket(pRing, packet);
+    }
+
+    shmdt(pRing);
+    _exit(0);
+}
+
+/// The stand-in gdb of the fifo, the same packets as RunRingProducer
+static void RunFifoProducer()
+{
+    int fd = open(GetActiveAgentConfig()->GetSessionFileName(gs_GdbToAgentFifoName).c_str(), O_WRONLY);
+
+    if (fd < 0)
+    {
+        _exit(1);
+    }
+
+    HsailCommandPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.m_command = HSAIL_COMMAND_CONTINUE;
+
+    for (uint64_t i = 0; i < gs_NUM_BULK_PACKETS + gs_NUM_LATENCY_PACKETS; i++)
+    {
+        if (i >= gs_NUM_BULK_PACKETS)
+        {
+            usleep(gs_LATENCY_PACKET_GAP_US);
+        }
+
+        packet.m_pc = (i < gs_NUM_BULK_PACKETS) ? i : TestNowNs();
+
+        if (write(fd, &packet, sizeof(packet)) != sizeof(packet))
+        {
+            _exit(1);
+        }
+    }
+
+    close(fd);
+    _exit(0);
+}
+
+static void ReportBulk(const char* pName, const uint64_t durationNs, const uint64_t numReads)
+{
+    printf("  %-44s %6.2f M packets/s, %6.1f packets per read\n", pName,
+           gs_NUM_BULK_PACKETS * 1000.0 / durationNs, static_cast<double>(gs_NUM_BULK_PACKETS) / numReads);
+}
+
+/// The agent side of the ring, ReadCommandRing in batches and WaitForCommandRingDoorbell when it is empty
+static void RunRing()
+{
+    int shmKey = 0;
+    size_t shmSize = 0;
+    GetActiveAgentConfig()->GetConfigShmKey(HSAIL_DEBUG_CONFIG_COMMAND_RING_SHM, shmKey);
+    GetActiveAgentConfig()->GetConfigShmSize(HSAIL_DEBUG_CONFIG_COMMAND_RING_SHM, shmSize);
+
+    if (InitCommandRing(shmKey, shmSize) != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        TEST_CHECK(false);
+        return;
+    }
+
+    pid_t producerPid = fork();
+
+    if (producerPid == 0)
+    {
+        RunRingProducer(GetCommandRingShmKey());
+    }
+
+    HsailCommandPacket packets[gs_RING_BATCH_SIZE];
+    uint64_t numReceived = 0;
+    uint64_t numOutOfOrder = 0;
+    uint64_t numReads = 0;
+    uint64_t startNs = 0;
+
+    while (numReceived < gs_NUM_BULK_PACKETS)
+    {
+        unsigned int numRead = ReadCommandRing(packets, gs_RING_BATCH_SIZE);
+
+        if (numRead == 0)
+        {
+            WaitForCommandRingDoorbell(1000);
+            continue;
+        }
+
+        if (startNs == 0)
+        {
+            startNs = TestNowNs();
+        }
+
+        numReads++;
+
+        for (unsigned int i = 0; i < numRead; i++)
+        {
+            numOutOfOrder += (packets[i].m_pc != numReceived++);
+        }
+    }
+
+    ReportBulk("ring, bulk", TestNowNs() - startNs, numReads);
+    TEST_CHECK(numOutOfOrder == 0);
+
+    TestLatencies latencies;
+
+    while (numReceived < gs_NUM_BULK_PACKETS + gs_NUM_LATENCY_PACKETS)
+    {
+        unsigned int numRead = ReadCommandRing(packets, gs_RING_BATCH_SIZE);
+
+        if (numRead == 0)
+        {
+            WaitForCommandRingDoorbell(10000);
+            continue;
+        }
+
+        uint64_t nowNs = TestNowNs();
+
+        for (unsigned int i = 0; i < numRead; i++)
+        {
+            latencies.Add(nowNs - packets[i].m_pc);
+            numReceived++;
+        }
+    }
+
+    latencies.Report("ring, one packet, doorbell wake-up");
+
+    int exitStatus = 0;
+    waitpid(producerPid, &exitStatus, 0);
+    TEST_CHECK(WIFEXITED(exitStatus) && WEXITSTATUS(exitStatus) == 0);
+
+    CloseCommandRing();
+}
+
+/// Read one packet off the agent end of the fifo like the command loop, poll if it is empty.
+/// The fifo reads as empty till gdb opens it and once gdb closed it
+/// \return false if no packet came for a second
+static bool ReadFifoPacket(const int fd, HsailCommandPacket& packetOut)
+{
+    const uint64_t deadlineNs = TestNowNs() + 1000000000;
+
+    while (TestNowNs() < deadlineNs)
+    {
+        ssize_t readStatus = read(fd, &packetOut, sizeof(packetOut));
+
+        if (readStatus == sizeof(packetOut))
+        {
+            return true;
+        }
+
+        if (readStatus > 0 || (readStatus < 0 && errno != EAGAIN && errno != EINTR))
+        {
+            return false;
+        }
+
+        // A fifo without a writer polls as readable, wait for gdb to open it
+        if (readStatus == 0)
+        {
+            sched_yield();
+            continue;
+        }
+
+        struct pollfd fifoFd;
+        fifoFd.fd = fd;
+        fifoFd.events = POLLIN;
+        fifoFd.revents = 0;
+        poll(&fifoFd, 1, 1000);
+    }
+
+    return false;
+}
+
+/// The agent side of the fifo, one read per packet
+static void RunFifo()
+{
+    if (CreateCommunicationFifos() != HSAIL_AGENT_STATUS_SUCCESS ||
+        InitFifoReadEnd() != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        TEST_CHECK(false);
+        return;
+    }
+
+    pid_t producerPid = fork();
+
+    if (producerPid == 0)
+    {
+        RunFifoProducer();
+    }
+
+    const int fd = GetFifoReadEnd();
+    HsailCommandPacket packet;
+    uint64_t numOutOfOrder = 0;
+    uint64_t startNs = 0;
+
+    for (uint64_t i = 0; i < gs_NUM_BULK_PACKETS; i++)
+    {
+        if (!ReadFifoPacket(fd, packet))
+        {
+            TEST_CHECK(false);
+            break;
+        }
+
+        if (startNs == 0)
+        {
+            startNs = TestNowNs();
+        }
+
+        numOutOfOrder += (packet.m_pc != i);
+    }
+
+    ReportBulk("fifo, bulk", TestNowNs() - startNs, gs_NUM_BULK_PACKETS);
+    TEST_CHECK(numOutOfOrder == 0);
+
+    TestLatencies latencies;
+
+    for (int i = 0; i < gs_NUM_LATENCY_PACKETS && ReadFifoPacket(fd, packet); i++)
+    {
+        latencies.Add(TestNowNs() - packet.m_pc);
+    }
+
+    latencies.Report("fifo, one packet, poll wake-up");
+
+    int exitStatus = 0;
+    waitpid(producerPid, &exitStatus, 0);
+    TEST_CHECK(WIFEXITED(exitStatus) && WEXITSTATUS(exitStatus) == 0);
+
+    close(fd);
+
+    HwDbgAgent::AgentConfiguration* pConfig = GetActiveAgentConfig();
+    unlink(pConfig->GetSessionFileName(gs_GdbToAgentFifoName).c_str());
+    unlink(pConfig->GetSessionFileName(gs_AgentToGdbFifoName).c_str());
+}
+
+int main()
+{
+    TestInitAgent();
+
+    printf("CommandRingBench: %llu packets of %zu bytes in bulk, %d one at a time every %u us\n",
+           static_cast<unsigned long long>(gs_NUM_BULK_PACKETS), sizeof(HsailCommandPacket),
+           gs_NUM_LATENCY_PACKETS, gs_LATENCY_PACKET_GAP_US);
+
+    RunRing();
+    RunFifo();
+
+    return TestResult("CommandRingBench");
+}
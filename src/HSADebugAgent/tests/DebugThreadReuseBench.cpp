@@ -0,0 +1,152 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Latency of a debugged dispatch that does not stop, handed to the parked debug
+///        thread, against a debug thread created for the dispatch and joined after it
+//==============================================================================
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "hsa.h"
+
+#include "AgentContext.h"
+#include "CommandLoop.h"
+#include "CommunicationControl.h"
+
+#include "AgentTestDispatch.h"
+#include "AgentTestEngine.h"
+#include "AgentTestSupport.h"
+
+using namespace HwDbgAgent;
+using namespace HwDbgAgentTest;
+
+/// The code address of the breakpoint and of every wave
+static const uint64_t gs_BREAKPOINT_PC = 0x1000;
+
+/// The work-group the breakpoint stops, the 64 waves are in work-groups 0 to 15
+static const uint32_t gs_STOPPED_WORK_GROUP = 1000;
+
+/// Dispatches of each way of running the debug thread
+static const int gs_NUM_DISPATCHES = 2000;
+
+/// Run one debugged dispatch, it gets its events from the stand-in DBE
+/// \param[in] isThreadStopped Stop and join the debug thread after the dispatch, like the
+///                            debug thread created for every dispatch and joined by the next one
+/// \return The time from the predispatch callback to the end of the dispatch
+static uint64_t RunDispatch(TestDispatcher& dispatcher, const uint32_t numBreakpointEvents, const bool isThreadStopped)
+{
+    TestDebugEngine& engine = TestGetDebugEngine();
+    engine.m_events.assign(numBreakpointEvents, HWDBG_EVENT_POST_BREAKPOINT);
+    engine.m_events.push_back(HWDBG_EVENT_END_DEBUGGING);
+
+    uint64_t startNs = TestNowNs();
+    dispatcher.Dispatch(0x100000, 64);
+    dispatcher.WaitForDispatch();
+
+    if (isThreadStopped)
+    {
+        StopDebugEventThread();
+    }
+
+    uint64_t endNs = TestNowNs();
+
+    TestGdbNotification notification;
+
+    while (TestWaitForGdbNotification(notification, 0))
+    {
+    }
+
+    return endNs - startNs;
+}
+
+/// Run debugged dispatches with the parked debug thread and with a debug thread created
+/// for each of them, in turn so both see the same state of the machine
+/// \param[in] numBreakpointEvents The HWDBG_EVENT_POST_BREAKPOINT before HWDBG_EVENT_END_DEBUGGING
+static void RunDispatches(const uint32_t numBreakpointEvents)
+{
+    TestGdbScript script;
+    memset(&script, 0, sizeof(script));
+    script.m_protocolVersion = HSAIL_FRAME_PROTOCOL_VERSION;
+    script.m_isSyncAnswered = true;
+
+    if (!TestStartGdb(script))
+    {
+        TEST_CHECK(false);
+        return;
+    }
+
+    TestDebugEngine& engine = TestGetDebugEngine();
+    TestLatencies parkedLatencies;
+    TestLatencies createdLatencies;
+    uint64_t numContinues = 0;
+
+    {
+        TestDispatcher dispatcher;
+        TEST_CHECK(dispatcher.IsReady());
+
+        // Every wave is at the breakpoint, its condition stops none of them
+        HsailWaveDim3 workGroupID = { gs_STOPPED_WORK_GROUP, 0, 0 };
+        HsailWaveDim3 workItemID = { 0, 0, 0 };
+        dispatcher.CreateConditionalPCBreakpoint(gs_BREAKPOINT_PC, 1, workGroupID, workItemID);
+
+        // Sends the binary, creates the breakpoint and the debug thread
+        RunDispatch(dispatcher, numBreakpointEvents, false);
+
+        uint64_t continuesBefore = engine.m_numContinues;
+
+        for (int dispatch = 0; dispatch < gs_NUM_DISPATCHES && dispatcher.IsReady(); dispatch++)
+        {
+            parkedLatencies.Add(RunDispatch(dispatcher, numBreakpointEvents, false));
+
+            // The debug thread is parked, stop it so the next dispatch creates one
+            StopDebugEventThread();
+            createdLatencies.Add(RunDispatch(dispatcher, numBreakpointEvents, true));
+
+            RunDispatch(dispatcher, numBreakpointEvents, false);
+        }
+
+        numContinues = engine.m_numContinues - continuesBefore;
+    }
+
+    TestStopGdb();
+
+    char name[64];
+    snprintf(name, sizeof(name), "%u events, parked thread", numBreakpointEvents);
+    parkedLatencies.Report(name);
+    snprintf(name, sizeof(name), "%u events, thread per dispatch", numBreakpointEvents);
+    createdLatencies.Report(name);
+
+    const uint64_t parkedP50Ns = parkedLatencies.GetPercentile(50);
+    const uint64_t createdP50Ns = createdLatencies.GetPercentile(50);
+    printf("    %.1f us saved per dispatch at p50\n",
+           (static_cast<double>(createdP50Ns) - static_cast<double>(parkedP50Ns)) / 1000.0);
+
+    // The condition is false for every wave, the debug thread continues every event
+    TEST_CHECK(numContinues == 3 * static_cast<uint64_t>(gs_NUM_DISPATCHES) * numBreakpointEvents);
+    TEST_CHECK(parkedP50Ns < createdP50Ns);
+}
+
+int main()
+{
+    // The predispatch of every dispatch is measured, not only of those in a code object with breakpoints
+    setenv("ROCM_GDB_DISABLE_PREDISPATCH_FAST_PATH", "1", 1);
+    setenv("ROCM_GDB_DISABLE_ISA_DISASSEMBLE", "1", 1);
+
+    TestInitAgent();
+    TestResetDebugEngine();
+
+    TestDebugEngine& engine = TestGetDebugEngine();
+    engine.m_kernelBinary.assign(64 * 1024, 0x5a);
+    engine.m_kernelName = "_Z10vectorCopyPKfPfj";
+    TestMakeWaves(64, gs_BREAKPOINT_PC, engine.m_waves);
+
+    printf("DebugThreadReuseBench: debugged dispatch, predispatch to the end of the debug session\n");
+
+    RunDispatches(0);
+    RunDispatches(4);
+
+    return TestResult("DebugThreadReuseBench");
+}
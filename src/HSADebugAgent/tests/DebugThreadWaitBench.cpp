@@ -0,0 +1,195 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief CPU used by the debug thread while the user sits at a breakpoint, and the time
+///        from the continue packet of gdb to the continue of the DBE
+//==============================================================================
+#include <cstdio>
+#include <cstring>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "hsa.h"
+
+#include "CommunicationControl.h"
+
+#include "AgentTestDispatch.h"
+#include "AgentTestEngine.h"
+#include "AgentTestSupport.h"
+
+using namespace HwDbgAgentTest;
+
+/// The code address of the breakpoint and of every wave
+static const uint64_t gs_BREAKPOINT_PC = 0x1000;
+
+/// Stops the CPU is measured over, and the time gdb leaves each of them stopped
+static const int gs_NUM_IDLE_STOPS = 10;
+static const useconds_t gs_IDLE_STOP_US = 300000;
+
+/// Stops the wake-up is measured over, gdb sends the continue a millisecond into the stop
+static const int gs_NUM_WAKE_STOPS = 200;
+static const useconds_t gs_WAKE_STOP_US = 1000;
+
+/// User and system CPU time of the process
+static uint64_t GetProcessCpuNs()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return (static_cast<uint64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+            usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000;
+}
+
+/// Dispatch a kernel that hits the breakpoint, return once gdb was told about the stop
+static bool StopAtBreakpoint(TestDispatcher& dispatcher)
+{
+    TestDebugEngine& engine = TestGetDebugEngine();
+    engine.m_events.clear();
+    engine.m_events.push_back(HWDBG_EVENT_POST_BREAKPOINT);
+    engine.m_events.push_back(HWDBG_EVENT_END_DEBUGGING);
+
+    dispatcher.Dispatch(0, static_cast<uint32_t>(engine.m_waves.size()));
+
+    TestGdbNotification notification;
+
+    while (TestWaitForGdbNotification(notification, 5000))
+    {
+        if (notification.m_notification == HSAIL_NOTIFY_BREAKPOINT_HIT)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// Send the continue of gdb and wait for the debug thread to be done with the dispatch
+/// \return The time the DBE was continued, 0 if the debug thread did not continue
+static uint64_t ContinueFromBreakpoint(TestDispatcher& dispatcher)
+{
+    const uint64_t numContinues = __atomic_load_n(&TestGetDebugEngine().m_numContinues, __ATOMIC_ACQUIRE);
+
+    HsailCommandPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.m_command = HSAIL_COMMAND_CONTINUE;
+    TestWriteGdbCommand(reinterpret_cast<const char*>(&packet), sizeof(packet));
+
+    dispatcher.WaitForDispatch();
+
+    if (__atomic_load_n(&TestGetDebugEngine().m_numContinues, __ATOMIC_ACQUIRE) == numContinues)
+    {
+        return 0;
+    }
+
+    return __atomic_load_n(&TestGetDebugEngine().m_lastContinueNs, __ATOMIC_RELAXED);
+}
+
+/// The debug thread waits for the continue while the test process does nothing else,
+/// so the CPU of the process over the stop is the CPU of the wait
+static void RunIdleStops(TestDispatcher& dispatcher)
+{
+    uint64_t idleWallNs = 0;
+    uint64_t idleCpuNs = 0;
+
+    for (int stop = 0; stop < gs_NUM_IDLE_STOPS; stop++)
+    {
+        if (!StopAtBreakpoint(dispatcher))
+        {
+            TEST_CHECK(false);
+            return;
+        }
+
+        uint64_t startWallNs = TestNowNs();
+        uint64_t startCpuNs = GetProcessCpuNs();
+        usleep(gs_IDLE_STOP_US);
+        idleCpuNs += GetProcessCpuNs() - startCpuNs;
+        idleWallNs += TestNowNs() - startWallNs;
+
+        TEST_CHECK(ContinueFromBreakpoint(dispatcher) != 0);
+    }
+
+    double idleCpuPercent = 100.0 * idleCpuNs / idleWallNs;
+
+    printf("  %-44s %6.2f %% of a core, %.1f ms CPU over %.1f s stopped\n", "stopped at a breakpoint",
+           idleCpuPercent, idleCpuNs / 1e6, idleWallNs / 1e9);
+
+    // A spinning wait uses the whole core, the wait in poll only wakes up for its timeout
+    TEST_CHECK(idleCpuPercent < 5.0);
+}
+
+/// The time from the write of the continue packet to HwDbgContinueEvent
+static void RunWakeStops(TestDispatcher& dispatcher)
+{
+    TestLatencies latencies;
+
+    for (int stop = 0; stop < gs_NUM_WAKE_STOPS; stop++)
+    {
+        if (!StopAtBreakpoint(dispatcher))
+        {
+            TEST_CHECK(false);
+            return;
+        }
+
+        usleep(gs_WAKE_STOP_US);
+
+        uint64_t continueNs = TestNowNs();
+        uint64_t engineContinueNs = ContinueFromBreakpoint(dispatcher);
+
+        if (engineContinueNs < continueNs)
+        {
+            TEST_CHECK(false);
+            continue;
+        }
+
+        latencies.Add(engineContinueNs - continueNs);
+    }
+
+    latencies.Report("continue packet to HwDbgContinueEvent");
+}
+
+int main()
+{
+    TestInitAgent();
+    TestResetDebugEngine();
+
+    TestGdbScript script;
+    memset(&script, 0, sizeof(script));
+    script.m_protocolVersion = HSAIL_FRAME_PROTOCOL_VERSION;
+    script.m_isSyncAnswered = true;
+
+    if (!TestStartGdb(script))
+    {
+        TEST_CHECK(false);
+        return TestResult("DebugThreadWaitBench");
+    }
+
+    TestDebugEngine& engine = TestGetDebugEngine();
+    engine.m_kernelBinary.assign(64 * 1024, 0x5a);
+    engine.m_kernelName = "_Z10vectorCopyPKfPfj";
+    TestMakeWaves(64, gs_BREAKPOINT_PC, engine.m_waves);
+
+    {
+        TestDispatcher dispatcher;
+
+        if (dispatcher.IsReady())
+        {
+            dispatcher.CreatePCBreakpoint(gs_BREAKPOINT_PC, 1);
+
+            printf("DebugThreadWaitBench: %d stops of %u ms, %d stops continued after %u us\n",
+                   gs_NUM_IDLE_STOPS, gs_IDLE_STOP_US / 1000, gs_NUM_WAKE_STOPS, gs_WAKE_STOP_US);
+
+            RunIdleStops(dispatcher);
+            RunWakeStops(dispatcher);
+        }
+        else
+        {
+            TEST_CHECK(false);
+        }
+    }
+
+    TestStopGdb();
+
+    return TestResult("DebugThreadWaitBench");
+}
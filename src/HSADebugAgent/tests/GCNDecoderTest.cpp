@@ -0,0 +1,212 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief The GCN decoder against the text and sizes llvm-mc gives for a corpus of
+///        instruction words, and its check of the target of a code object
+//==============================================================================
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "AgentGCNDecoder.h"
+
+#include "AgentTestSupport.h"
+
+using namespace HwDbgAgent;
+using namespace HwDbgAgentTest;
+
+/// The instructions with their encodings, disassembled by llvm-mc for fiji
+static const char* gs_CORPUS_FILE_NAME = "gcn/GCNDecoderCorpus.s";
+
+/// Code objects of "s_mov_b32 s0, s1; s_endpgm" assembled by llvm-mc, see CheckTargets
+static const char* gs_TARGET_FILE_DIR = "gcn/";
+
+/// Replace every run of spaces and tabs by one space, llvm-mc pads the text to the encoding
+static std::string NormalizeSpaces(const std::string& text)
+{
+    std::string normalizedText;
+    bool isSpace = false;
+
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        if (text[i] == ' ' || text[i] == '\t')
+        {
+            isSpace = true;
+            continue;
+        }
+
+        if (isSpace && !normalizedText.empty())
+        {
+            normalizedText += ' ';
+        }
+
+        isSpace = false;
+        normalizedText += text[i];
+    }
+
+    return normalizedText;
+}
+
+/// Decode the encoding of every line of the corpus, it must give one instruction of
+/// the size of the encoding with the text of llvm-mc
+static void CheckCorpus()
+{
+    std::ifstream corpus(gs_CORPUS_FILE_NAME);
+
+    if (!corpus.is_open())
+    {
+        printf("Could not open %s\n", gs_CORPUS_FILE_NAME);
+        TEST_CHECK(false);
+        return;
+    }
+
+    static const std::string ENCODING_PREFIX = "; encoding: [";
+
+    int numInstructions = 0;
+    int numSizesMatched = 0;
+    int numTextsMatched = 0;
+    std::string line;
+
+    while (std::getline(corpus, line))
+    {
+        size_t encodingPosition = line.find(ENCODING_PREFIX);
+
+        // The comments of the corpus start at the first column
+        if (encodingPosition == std::string::npos || line[0] != '\t')
+        {
+            continue;
+        }
+
+        const std::string llvmText = NormalizeSpaces(line.substr(0, encodingPosition));
+
+        size_t bytesStart = encodingPosition + ENCODING_PREFIX.size();
+        std::stringstream encoding(line.substr(bytesStart, line.find(']', bytesStart) - bytesStart));
+        std::vector<unsigned char> words;
+        std::string byte;
+
+        while (std::getline(encoding, byte, ','))
+        {
+            words.push_back(static_cast<unsigned char>(strtoul(byte.c_str(), nullptr, 16)));
+        }
+
+        AgentGCNDecoder decoder;
+        decoder.DecodeWords(words.data(), words.size(), 0x100);
+
+        const std::vector<AgentGCNInstruction>& instructions = decoder.GetInstructions();
+        numInstructions++;
+
+        if (instructions.size() != 1)
+        {
+            printf("  %-50s decoded to %zu instructions\n", llvmText.c_str(), instructions.size());
+            continue;
+        }
+
+        if (instructions[0].m_numWords * sizeof(uint32_t) == words.size())
+        {
+            numSizesMatched++;
+        }
+        else
+        {
+            printf("  %-50s decoded to %u words, not %zu\n", llvmText.c_str(), instructions[0].m_numWords,
+                   words.size() / sizeof(uint32_t));
+        }
+
+        std::string agentText;
+        AgentGCNDecoder::RenderInstruction(instructions[0], agentText);
+        agentText = NormalizeSpaces(agentText);
+
+        if (agentText == llvmText)
+        {
+            numTextsMatched++;
+        }
+        else
+        {
+            printf("  %-50s rendered as %s\n", llvmText.c_str(), agentText.c_str());
+        }
+    }
+
+    printf("GCNDecoderTest: %d instructions, %d sizes and %d texts match llvm-mc\n", numInstructions,
+           numSizesMatched, numTextsMatched);
+
+    TEST_CHECK(numInstructions > 0);
+    TEST_CHECK(numSizesMatched == numInstructions);
+    TEST_CHECK(numTextsMatched == numInstructions);
+}
+
+/// Decode a code object file
+/// \param[in]  pFileName  The name of the file in gs_TARGET_FILE_DIR
+/// \param[out] isaTextOut The text of the whole .text section if it was decoded
+/// \return true if the decoder took the code object
+static bool DecodeFile(const char* pFileName, std::string& isaTextOut)
+{
+    std::string path = std::string(gs_TARGET_FILE_DIR) + pFileName;
+    std::ifstream codeObjFile(path.c_str(), std::ios::binary);
+
+    if (!codeObjFile.is_open())
+    {
+        printf("Could not open %s\n", path.c_str());
+        TEST_CHECK(false);
+        return false;
+    }
+
+    std::vector<char> codeObj((std::istreambuf_iterator<char>(codeObjFile)), std::istreambuf_iterator<char>());
+
+    AgentGCNDecoder decoder;
+
+    if (decoder.Decode(codeObj.data(), codeObj.size()) != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        return false;
+    }
+
+    decoder.RenderText(0, UINT64_MAX, isaTextOut);
+    return true;
+}
+
+/// Only GFX8 code objects are decoded, the others are left to llvm-objdump.
+/// The ISA note of a code object v2 is used before the machine in e_flags
+static void CheckTargets()
+{
+    typedef struct
+    {
+        const char* m_pFileName;
+        bool        m_isDecoded;
+    } TargetCase;
+
+    static const TargetCase TARGET_CASES[] =
+    {
+        { "target_gfx803.o",              true },
+        { "target_gfx701.o",              false },
+        { "target_gfx900.o",              false },
+        { "target_gfx803_isa_note_803.o", true },
+        { "target_gfx803_isa_note_900.o", false },
+    };
+
+    for (size_t i = 0; i < sizeof(TARGET_CASES) / sizeof(TARGET_CASES[0]); i++)
+    {
+        std::string isaText;
+        bool isDecoded = DecodeFile(TARGET_CASES[i].m_pFileName, isaText);
+
+        printf("  %-30s %s\n", TARGET_CASES[i].m_pFileName, isDecoded ? "decoded" : "rejected");
+        TEST_CHECK(isDecoded == TARGET_CASES[i].m_isDecoded);
+
+        if (isDecoded)
+        {
+            TEST_CHECK(isaText.find("s_mov_b32 s0, s1") != std::string::npos);
+            TEST_CHECK(isaText.find("s_endpgm") != std::string::npos);
+        }
+    }
+}
+
+int main()
+{
+    CheckCorpus();
+    CheckTargets();
+
+    return TestResult("GCNDecoderTest");
+}
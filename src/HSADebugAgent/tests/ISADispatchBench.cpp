@@ -0,0 +1,247 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief The disassembler is off the dispatch critical path: dispatches of new code
+///        objects with a stand-in llvm-objdump that sleeps, and the stops that need
+///        the ISA while the ISA worker has a backlog
+//==============================================================================
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "hsa.h"
+
+#include "AgentISABuffer.h"
+#include "AgentISAWorker.h"
+#include "CommunicationControl.h"
+
+#include "AgentTestDispatch.h"
+#include "AgentTestEngine.h"
+#include "AgentTestSupport.h"
+
+using namespace HwDbgAgent;
+using namespace HwDbgAgentTest;
+
+/// The time the stand-in llvm-objdump takes for every code object
+static const uint64_t gs_DISASSEMBLY_US = 50000;
+
+static const int gs_NUM_DIRECT_DISASSEMBLIES = 10;
+static const int gs_NUM_DISPATCHES = 40;
+static const int gs_NUM_STOPS = 5;
+
+/// The code address of the breakpoint and of every wave
+static const uint64_t gs_BREAKPOINT_PC = 0x1000;
+
+static const size_t gs_CODE_OBJECT_SIZE = 64 * 1024;
+
+/// Write a script that sleeps and prints a line of ISA, in place of llvm-objdump
+/// \return The path of the script, empty if it could not be written
+static std::string WriteSleepingDisassembler()
+{
+    std::stringstream path;
+    path << "/tmp/fake-llvm-objdump-" << getpid();
+
+    std::ofstream script(path.str().c_str());
+
+    if (!script.is_open())
+    {
+        return std::string();
+    }
+
+    script << "#!/bin/sh\n"
+           << "sleep " << gs_DISASSEMBLY_US / 1e6 << "\n"
+           << "echo \"0000000000001000 _Z10vectorCopyPKfPfj:\"\n"
+           << "echo \"\ts_endpgm // 000000001000: BF810000\"\n";
+    script.close();
+
+    if (chmod(path.str().c_str(), 0700) != 0)
+    {
+        unlink(path.str().c_str());
+        return std::string();
+    }
+
+    return path.str();
+}
+
+/// A code object that was never dispatched before, loaded at its own address
+/// \return The kernel object of its kernel
+static uint64_t MakeNewCodeObject(const int index, std::vector<char>& codeObjOut)
+{
+    codeObjOut.assign(gs_CODE_OBJECT_SIZE, 0x5a);
+    memcpy(codeObjOut.data(), &index, sizeof(index));
+
+    return 0x100000 + (static_cast<uint64_t>(index) << 32);
+}
+
+/// What a dispatch paid when the disassembler ran on the dispatching thread
+static void RunDirectDisassemblies()
+{
+    TestLatencies latencies;
+    std::vector<char> codeObj;
+
+    for (int i = 0; i < gs_NUM_DIRECT_DISASSEMBLIES; i++)
+    {
+        MakeNewCodeObject(-1 - i, codeObj);
+
+        AgentISABuffer isaBuffer;
+        uint64_t startNs = TestNowNs();
+        TEST_CHECK(isaBuffer.PopulateISAFromCodeObj(codeObj.size(), codeObj.data(), "-bench") ==
+                   HSAIL_AGENT_STATUS_SUCCESS);
+        latencies.Add(TestNowNs() - startNs);
+
+        TEST_CHECK(!isaBuffer.GetISAText().empty());
+    }
+
+    latencies.Report("disassembly on the calling thread");
+    TEST_CHECK(latencies.GetPercentile(50) >= gs_DISASSEMBLY_US * 1000);
+}
+
+/// Dispatches of new code objects that do not stop, their ISA is queued to the worker
+static void RunDispatches(TestDispatcher& dispatcher, int& codeObjIndexInOut)
+{
+    TestDebugEngine& engine = TestGetDebugEngine();
+    TestLatencies latencies;
+
+    // The first dispatch gets the first sync marker of gdb
+    for (int dispatch = -1; dispatch < gs_NUM_DISPATCHES && dispatcher.IsReady(); dispatch++)
+    {
+        uint64_t kernelObject = MakeNewCodeObject(codeObjIndexInOut++, engine.m_kernelBinary);
+
+        uint64_t startNs = TestNowNs();
+        dispatcher.Dispatch(kernelObject, 64);
+        dispatcher.WaitForDispatch();
+        uint64_t endNs = TestNowNs();
+
+        if (dispatch >= 0)
+        {
+            latencies.Add(endNs - startNs);
+        }
+
+        TestGdbNotification notification;
+
+        while (TestWaitForGdbNotification(notification, 0))
+        {
+        }
+    }
+
+    latencies.Report("dispatch of a new code object");
+    TEST_CHECK(latencies.GetPercentile(50) < gs_DISASSEMBLY_US * 1000 / 10);
+}
+
+/// Dispatches of new code objects that stop, the agent publishes the ISA before it hands
+/// control to gdb and takes the continue. The worker still has the code objects of
+/// RunDispatches queued, only the job of the stopped dispatch and the one a thread is busy
+/// with are waited for
+static void RunStops(TestDispatcher& dispatcher, int& codeObjIndexInOut)
+{
+    TestDebugEngine& engine = TestGetDebugEngine();
+    TestLatencies latencies;
+
+    dispatcher.CreatePCBreakpoint(gs_BREAKPOINT_PC, 1);
+
+    HsailCommandPacket continuePacket;
+    memset(&continuePacket, 0, sizeof(continuePacket));
+    continuePacket.m_command = HSAIL_COMMAND_CONTINUE;
+
+    for (int stop = 0; stop < gs_NUM_STOPS && dispatcher.IsReady(); stop++)
+    {
+        uint64_t kernelObject = MakeNewCodeObject(codeObjIndexInOut++, engine.m_kernelBinary);
+
+        engine.m_events.clear();
+        engine.m_events.push_back(HWDBG_EVENT_POST_BREAKPOINT);
+        engine.m_events.push_back(HWDBG_EVENT_END_DEBUGGING);
+
+        uint64_t startNs = TestNowNs();
+        dispatcher.Dispatch(kernelObject, 64);
+
+        TestGdbNotification notification;
+        bool isStopped = false;
+
+        while (!isStopped && TestWaitForGdbNotification(notification, 10000))
+        {
+            isStopped = (notification.m_notification == HSAIL_NOTIFY_BREAKPOINT_HIT);
+        }
+
+        if (!isStopped)
+        {
+            TEST_CHECK(false);
+            break;
+        }
+
+        // gdb continues at once, the dispatch ends once the agent read the continue
+        TestWriteGdbCommand(reinterpret_cast<const char*>(&continuePacket), sizeof(continuePacket));
+        dispatcher.WaitForDispatch();
+        latencies.Add(TestNowNs() - startNs);
+
+        while (TestWaitForGdbNotification(notification, 0))
+        {
+        }
+    }
+
+    latencies.Report("dispatch that stops, with its ISA");
+
+    // The backlog of RunDispatches alone would take gs_NUM_DISPATCHES times as long
+    TEST_CHECK(latencies.GetPercentile(50) < 3 * gs_DISASSEMBLY_US * 1000);
+}
+
+int main()
+{
+    std::string disassemblerPath = WriteSleepingDisassembler();
+
+    if (disassemblerPath.empty())
+    {
+        TEST_CHECK(false);
+        return TestResult("ISADispatchBench");
+    }
+
+    // Every code object goes to the stand-in llvm-objdump, the predispatch is not skipped
+    setenv("ROCM_GDB_USE_LLVM_OBJDUMP", disassemblerPath.c_str(), 1);
+    setenv("ROCM_GDB_DISABLE_PREDISPATCH_FAST_PATH", "1", 1);
+
+    TestInitAgent();
+    TestResetDebugEngine();
+
+    TestDebugEngine& engine = TestGetDebugEngine();
+    engine.m_kernelName = "_Z10vectorCopyPKfPfj";
+    TestMakeWaves(64, gs_BREAKPOINT_PC, engine.m_waves);
+
+    printf("ISADispatchBench: llvm-objdump takes %.0f ms, %zu KB code objects, 1 ISA worker thread\n",
+           gs_DISASSEMBLY_US / 1000.0, gs_CODE_OBJECT_SIZE / 1024);
+
+    RunDirectDisassemblies();
+
+    // A gdb older than the lazy ISA gets the ISA of every stop, it is not deferred till gdb asks for it
+    TestGdbScript script;
+    memset(&script, 0, sizeof(script));
+    script.m_protocolVersion = HSAIL_FRAME_PROTOCOL_VERSION_REUSE_BINARY;
+    script.m_isSyncAnswered = true;
+
+    if (TestStartGdb(script))
+    {
+        TestDispatcher dispatcher;
+        TEST_CHECK(dispatcher.IsReady());
+
+        int codeObjIndex = 0;
+        RunDispatches(dispatcher, codeObjIndex);
+        RunStops(dispatcher, codeObjIndex);
+    }
+    else
+    {
+        TEST_CHECK(false);
+    }
+
+    TestStopGdb();
+    AgentStopISAWorkers();
+
+    unlink(disassemblerPath.c_str());
+
+    return TestResult("ISADispatchBench");
+}
@@ -0,0 +1,92 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Deferred code objects dropped under the ISA memory limit can be deferred again
+///        from the load map when gdb asks for their ISA
+//==============================================================================
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "AgentISAWorker.h"
+#include "AgentSegmentLoader.h"
+#include "AgentSharedMemRegistry.h"
+#include "AgentUtils.h"
+
+#include "AgentTestEngine.h"
+#include "AgentTestSupport.h"
+
+using namespace HwDbgAgent;
+using namespace HwDbgAgentTest;
+
+/// More code objects than the 64MB the ISA results are limited to
+static const size_t gs_NUM_CODE_OBJECTS = 70;
+static const size_t gs_CODE_OBJECT_SIZE = 1024 * 1024;
+
+int main()
+{
+    TestInitAgent();
+
+    std::vector<std::vector<char>> codeObjects(gs_NUM_CODE_OBJECTS);
+    std::vector<uint64_t> hashes(gs_NUM_CODE_OBJECTS);
+
+    for (size_t i = 0; i < gs_NUM_CODE_OBJECTS; i++)
+    {
+        codeObjects[i].assign(gs_CODE_OBJECT_SIZE, static_cast<char>(i));
+        hashes[i] = AgentComputeBinaryHash(codeObjects[i].data(), codeObjects[i].size());
+
+        TEST_CHECK(AgentDeferISADisassembly(hashes[i], codeObjects[i].data(), codeObjects[i].size()) ==
+                   HSAIL_AGENT_STATUS_SUCCESS);
+    }
+
+    // The oldest deferred copies are dropped, their size is kept
+    size_t evictedSize = 0;
+    TEST_CHECK(AgentIsDeferredISAEvicted(hashes[0], evictedSize));
+    TEST_CHECK(evictedSize == gs_CODE_OBJECT_SIZE);
+    TEST_CHECK(!AgentIsDeferredISAEvicted(hashes[gs_NUM_CODE_OBJECTS - 1], evictedSize));
+
+    // The dropped code object is still loaded, the segment loader finds it by its hash
+    HwDbgLoaderSegmentDescriptor segment;
+    memset(&segment, 0, sizeof(segment));
+    segment.device = 1;
+    segment.executable = 1;
+    segment.codeObjectStorageType = HWDBG_LOADER_CODE_OBJECT_STORAGE_TYPE_MEMORY;
+    segment.pCodeObjectStorageBase = codeObjects[0].data();
+    segment.codeObjectStorageSize = codeObjects[0].size();
+    segment.pSegmentBase = reinterpret_cast<const void*>(0x100000);
+    segment.segmentSize = 0x1000;
+    TestGetDebugEngine().m_segments.push_back(segment);
+
+    AgentSharedMemRegistry sharedMemRegistry;
+    TEST_CHECK(sharedMemRegistry.MapAllRegions() == HSAIL_AGENT_STATUS_SUCCESS);
+
+    AgentSegmentLoader segmentLoader(&sharedMemRegistry);
+    AgentInvalidateLoadMap();
+    segmentLoader.UpdateLoadedSegments(0x100000);
+
+    const void* pCodeObj = nullptr;
+    TEST_CHECK(segmentLoader.FindLoadedCodeObject(hashes[0], gs_CODE_OBJECT_SIZE, pCodeObj));
+    TEST_CHECK(pCodeObj == codeObjects[0].data());
+    TEST_CHECK(!segmentLoader.FindLoadedCodeObject(hashes[1], gs_CODE_OBJECT_SIZE, pCodeObj));
+
+    // Deferred again, gdb gets the ISA of it like of any deferred code object
+    TEST_CHECK(AgentDeferISADisassembly(hashes[0], pCodeObj, gs_CODE_OBJECT_SIZE) == HSAIL_AGENT_STATUS_SUCCESS);
+    TEST_CHECK(!AgentIsDeferredISAEvicted(hashes[0], evictedSize));
+
+    // The storage of a code object is not read once an executable was loaded or destroyed since the query
+    AgentInvalidateLoadMap();
+    TEST_CHECK(!segmentLoader.FindLoadedCodeObject(hashes[0], gs_CODE_OBJECT_SIZE, pCodeObj));
+
+    // A dropped code object that is not found again has no ISA, it is only reported once
+    std::string isaText;
+    TEST_CHECK(AgentIsDeferredISAEvicted(hashes[1], evictedSize));
+    TEST_CHECK(!AgentGetDisassembledISA(hashes[1], isaText));
+    TEST_CHECK(!AgentIsDeferredISAEvicted(hashes[1], evictedSize));
+
+    AgentStopISAWorkers();
+    sharedMemRegistry.UnMapAllRegions();
+
+    return TestResult("ISAWorkerTest");
+}
@@ -0,0 +1,220 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Latency of the agent <--> gdb channel: the sync round trip, the delivery of a
+///        notification, and the publication of the waves and of a code object, each one
+///        till the stand-in gdb has read its notification
+//==============================================================================
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "hsa.h"
+
+#include "AgentBinary.h"
+#include "AgentContext.h"
+#include "AgentFramedProtocol.h"
+#include "AgentNotifyGdb.h"
+#include "AgentWavePrinter.h"
+#include "CommandLoop.h"
+#include "CommunicationControl.h"
+
+#include "AgentTestDispatch.h"
+#include "AgentTestEngine.h"
+#include "AgentTestSupport.h"
+
+using namespace HwDbgAgent;
+using namespace HwDbgAgentTest;
+
+/// Any non-null handle, the stand-in DBE has a single context
+static const HwDbgContextHandle gs_DEBUG_CONTEXT = reinterpret_cast<HwDbgContextHandle>(0x1);
+
+static const int gs_NUM_ROUND_TRIPS = 2000;
+static const int gs_NUM_NOTIFICATIONS = 2000;
+static const int gs_NUM_WAVE_PUBLICATIONS = 100;
+static const int gs_NUM_CODE_OBJECT_PUBLICATIONS = 30;
+
+/// Wait till the stand-in gdb has read a notification of a type
+/// \return The time gdb read it, 0 if it did not come
+static uint64_t WaitForNotification(const HsailNotification type)
+{
+    TestGdbNotification notification;
+
+    while (TestWaitForGdbNotification(notification, 5000))
+    {
+        if (notification.m_notification == type)
+        {
+            return notification.m_receiveNs;
+        }
+    }
+
+    return 0;
+}
+
+/// A sync request to gdb and its marker back, through RunFifoCommandLoopTillSync
+static void RunRoundTrips(AgentContext* pContext)
+{
+    TestLatencies latencies;
+    const uint64_t firstSyncMarkerId = pContext->m_LastSyncMarkerId;
+
+    for (int i = 0; i < gs_NUM_ROUND_TRIPS; i++)
+    {
+        uint64_t startNs = TestNowNs();
+        RunFifoCommandLoopTillSync(pContext, 50);
+        latencies.Add(TestNowNs() - startNs);
+    }
+
+    latencies.Report("sync request to marker processed");
+    TEST_CHECK(pContext->m_LastSyncMarkerId == firstSyncMarkerId + gs_NUM_ROUND_TRIPS);
+    TEST_CHECK(latencies.GetPercentile(50) < 10 * 1000000);
+}
+
+/// A notification gdb does not answer, from the call to its read by gdb
+static void RunNotifications()
+{
+    TestLatencies latencies;
+
+    for (int i = 0; i < gs_NUM_NOTIFICATIONS; i++)
+    {
+        uint64_t startNs = TestNowNs();
+        TEST_CHECK(AgentNotifyPredispatchState(HSAIL_PREDISPATCH_ENTERED_PREDISPATCH) == HSAIL_AGENT_STATUS_SUCCESS);
+        uint64_t receiveNs = WaitForNotification(HSAIL_NOTIFY_PREDISPATCH_STATE);
+
+        if (receiveNs < startNs)
+        {
+            TEST_CHECK(false);
+            return;
+        }
+
+        latencies.Add(receiveNs - startNs);
+    }
+
+    latencies.Report("notification to gdb");
+}
+
+/// AgentWavePrinter::SendActiveWavesToGdb till gdb read HSAIL_NOTIFY_NEW_ACTIVE_WAVES
+static void RunWavePublications(AgentContext* pContext, const uint32_t numWaves)
+{
+    TestMakeWaves(numWaves, 0x1000, TestGetDebugEngine().m_waves);
+
+    AgentWavePrinter* pWavePrinter = pContext->GetWavePrinter();
+    TestLatencies latencies;
+
+    // The first publication grows the region to the waves
+    for (int i = -1; i < gs_NUM_WAVE_PUBLICATIONS; i++)
+    {
+        uint64_t startNs = TestNowNs();
+        TEST_CHECK(pWavePrinter->SendActiveWavesToGdb(HWDBG_EVENT_POST_BREAKPOINT, gs_DEBUG_CONTEXT) ==
+                   HSAIL_AGENT_STATUS_SUCCESS);
+        uint64_t receiveNs = WaitForNotification(HSAIL_NOTIFY_NEW_ACTIVE_WAVES);
+
+        if (receiveNs < startNs)
+        {
+            TEST_CHECK(false);
+            return;
+        }
+
+        if (i >= 0)
+        {
+            latencies.Add(receiveNs - startNs);
+        }
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "waves %5u", numWaves);
+    latencies.Report(name);
+}
+
+/// AgentBinary::PopulateBinaryFromDBE and NotifyGDB till gdb read HSAIL_NOTIFY_NEW_BINARY
+static void RunCodeObjectPublications(AgentContext* pContext, const size_t binarySize)
+{
+    TestGetDebugEngine().m_kernelBinary.assign(binarySize, 0x5a);
+
+    hsa_kernel_dispatch_packet_t packet;
+    TestMakeDispatchPacket(0, 64, packet);
+
+    AgentBinary binary(pContext->GetSharedMemRegistry(), nullptr);
+    TestLatencies latencies;
+
+    for (int i = -1; i < gs_NUM_CODE_OBJECT_PUBLICATIONS; i++)
+    {
+        uint64_t startNs = TestNowNs();
+        TEST_CHECK(binary.PopulateBinaryFromDBE(gs_DEBUG_CONTEXT, &packet, nullptr) == HSAIL_AGENT_STATUS_SUCCESS);
+        TEST_CHECK(binary.NotifyGDB(&packet, 0, i, false) == HSAIL_AGENT_STATUS_SUCCESS);
+        uint64_t receiveNs = WaitForNotification(HSAIL_NOTIFY_NEW_BINARY);
+
+        if (receiveNs < startNs)
+        {
+            TEST_CHECK(false);
+            return;
+        }
+
+        if (i >= 0)
+        {
+            latencies.Add(receiveNs - startNs);
+        }
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "code object %3zu MB", binarySize / (1024 * 1024));
+    latencies.Report(name);
+}
+
+int main()
+{
+    // The ISA is not part of the publication, the disassembler would dominate it
+    setenv("ROCM_GDB_DISABLE_ISA_DISASSEMBLE", "1", 1);
+
+    TestInitAgent();
+    TestResetDebugEngine();
+    TestGetDebugEngine().m_kernelName = "_Z10vectorCopyPKfPfj";
+
+    TestGdbScript script;
+    memset(&script, 0, sizeof(script));
+    script.m_protocolVersion = HSAIL_FRAME_PROTOCOL_VERSION;
+    script.m_isSyncAnswered = true;
+
+    if (!TestStartGdb(script))
+    {
+        TEST_CHECK(false);
+        return TestResult("IpcBench");
+    }
+
+    {
+        TestDispatcher dispatcher;
+        AgentContext* pContext = dispatcher.GetAgentContext();
+
+        if (dispatcher.IsReady())
+        {
+            // The first call takes the protocol of gdb, the second one gets its first marker
+            RunFifoCommandLoopTillSync(pContext, 1000);
+            RunFifoCommandLoopTillSync(pContext, 1000);
+            TEST_CHECK(AgentGetGdbProtocolVersion() == HSAIL_FRAME_PROTOCOL_VERSION);
+            TEST_CHECK(pContext->m_LastSyncMarkerId != 0);
+
+            printf("IpcBench: agent <--> gdb, gdb protocol %u, shared buffers with a header\n",
+                   AgentGetGdbProtocolVersion());
+
+            RunRoundTrips(pContext);
+            RunNotifications();
+
+            RunWavePublications(pContext, 1000);
+            RunWavePublications(pContext, 10000);
+            RunWavePublications(pContext, 40000);
+
+            RunCodeObjectPublications(pContext, 1024 * 1024);
+            RunCodeObjectPublications(pContext, 10 * 1024 * 1024);
+            RunCodeObjectPublications(pContext, 50 * 1024 * 1024);
+        }
+        else
+        {
+            TEST_CHECK(false);
+        }
+    }
+
+    TestStopGdb();
+
+    return TestResult("IpcBench");
+}
@@ -0,0 +1,134 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Time of a dispatch that does not stop, from the predispatch callback till the
+///        debug thread is done with it, with 0, 1 and 100 breakpoints set
+//==============================================================================
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "hsa.h"
+
+#include "CommunicationControl.h"
+
+#include "AgentTestDispatch.h"
+#include "AgentTestEngine.h"
+#include "AgentTestSupport.h"
+
+using namespace HwDbgAgentTest;
+
+/// The breakpoints are set after the code of the waves, no wave hits them
+static const uint64_t gs_WAVE_PC = 0x1000;
+static const uint64_t gs_FIRST_BREAKPOINT_PC = 0x8000;
+
+/// Dispatches without breakpoints take the fast path, they are many more
+static const int gs_NUM_FAST_DISPATCHES = 10000;
+static const int gs_NUM_DEBUGGED_DISPATCHES = 1000;
+
+static void RunDispatches(const char* pName, const uint32_t numBreakpoints, const int numDispatches,
+                          const uint64_t maxP50Us)
+{
+    TestGdbScript script;
+    memset(&script, 0, sizeof(script));
+    script.m_protocolVersion = HSAIL_FRAME_PROTOCOL_VERSION;
+    script.m_isSyncAnswered = true;
+
+    if (!TestStartGdb(script))
+    {
+        TEST_CHECK(false);
+        return;
+    }
+
+    TestLatencies latencies;
+
+    {
+        TestDispatcher dispatcher;
+        TEST_CHECK(dispatcher.IsReady());
+
+        for (uint32_t i = 0; i < numBreakpoints; i++)
+        {
+            dispatcher.CreatePCBreakpoint(gs_FIRST_BREAKPOINT_PC + 4 * i, 1 + i);
+        }
+
+        // The first dispatch sends the binary and gets the first sync marker
+        for (int dispatch = -1; dispatch < numDispatches && dispatcher.IsReady(); dispatch++)
+        {
+            uint64_t startNs = TestNowNs();
+            dispatcher.Dispatch(0x100000, 64);
+            dispatcher.WaitForDispatch();
+            uint64_t endNs = TestNowNs();
+
+            if (dispatch >= 0)
+            {
+                latencies.Add(endNs - startNs);
+            }
+
+            // gdb reads the notifications, the test does not look at them
+            TestGdbNotification notification;
+
+            while (TestWaitForGdbNotification(notification, 0))
+            {
+            }
+        }
+    }
+
+    TestStopGdb();
+
+    latencies.Report(pName);
+    TEST_CHECK(latencies.GetPercentile(50) < maxP50Us * 1000);
+}
+
+/// The dispatches of one agent, the fast path is read once per process
+static int RunAgent(const bool isFastPathDisabled)
+{
+    if (isFastPathDisabled)
+    {
+        setenv("ROCM_GDB_DISABLE_PREDISPATCH_FAST_PATH", "1", 1);
+    }
+
+    TestInitAgent();
+    TestResetDebugEngine();
+
+    TestDebugEngine& engine = TestGetDebugEngine();
+    engine.m_kernelBinary.assign(64 * 1024, 0x5a);
+    engine.m_kernelName = "_Z10vectorCopyPKfPfj";
+    TestMakeWaves(64, gs_WAVE_PC, engine.m_waves);
+
+    if (isFastPathDisabled)
+    {
+        RunDispatches("0 breakpoints, fast path disabled", 0, gs_NUM_DEBUGGED_DISPATCHES, 5000);
+        return TestResult("PredispatchBench without fast path");
+    }
+
+    RunDispatches("0 breakpoints", 0, gs_NUM_FAST_DISPATCHES, 20);
+    RunDispatches("1 breakpoint", 1, gs_NUM_DEBUGGED_DISPATCHES, 5000);
+    RunDispatches("100 breakpoints", 100, gs_NUM_DEBUGGED_DISPATCHES, 5000);
+
+    return TestResult("PredispatchBench");
+}
+
+int main()
+{
+    printf("PredispatchBench: dispatch of a kernel gdb has the binary of, no wave stops\n");
+    fflush(stdout);
+
+    pid_t childPid = fork();
+
+    if (childPid == 0)
+    {
+        int result = RunAgent(true);
+        fflush(stdout);
+        _exit(result);
+    }
+
+    int exitStatus = 0;
+    waitpid(childPid, &exitStatus, 0);
+    TEST_CHECK(WIFEXITED(exitStatus) && WEXITSTATUS(exitStatus) == 0);
+
+    return RunAgent(false);
+}
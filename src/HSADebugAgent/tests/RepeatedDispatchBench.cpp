@@ -0,0 +1,153 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief A loop of dispatches of a few kernels, gdb gets each code object once and
+///        then only its hash, against a loop where every dispatch has a new code object
+//==============================================================================
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "hsa.h"
+
+#include "CommunicationControl.h"
+
+#include "AgentTestDispatch.h"
+#include "AgentTestEngine.h"
+#include "AgentTestSupport.h"
+
+using namespace HwDbgAgentTest;
+
+/// The kernels of the loop, each one its own code object
+static const int gs_NUM_KERNELS = 4;
+static const size_t gs_CODE_OBJECT_SIZE = 1024 * 1024;
+
+static const int gs_NUM_REPEATED_DISPATCHES = 1000;
+static const int gs_NUM_NEW_CODE_OBJECT_DISPATCHES = 200;
+
+/// The binary notifications gdb got
+typedef struct
+{
+    uint64_t m_numNewBinaries;
+    uint64_t m_numReusedBinaries;
+} BinaryNotifications;
+
+static void ReadBinaryNotifications(BinaryNotifications& notificationsInOut)
+{
+    TestGdbNotification notification;
+
+    while (TestWaitForGdbNotification(notification, 0))
+    {
+        notificationsInOut.m_numNewBinaries += (notification.m_notification == HSAIL_NOTIFY_NEW_BINARY);
+        notificationsInOut.m_numReusedBinaries += (notification.m_notification == HSAIL_NOTIFY_REUSE_BINARY);
+    }
+}
+
+/// Dispatch the kernels in turn, or a kernel with a new code object every time
+static void RunDispatches(const char* pName, const int numDispatches, const bool isCodeObjectNew)
+{
+    TestGdbScript script;
+    memset(&script, 0, sizeof(script));
+    script.m_protocolVersion = HSAIL_FRAME_PROTOCOL_VERSION;
+    script.m_isSyncAnswered = true;
+
+    if (!TestStartGdb(script))
+    {
+        TEST_CHECK(false);
+        return;
+    }
+
+    std::vector<std::vector<char>> codeObjects(gs_NUM_KERNELS);
+
+    for (int i = 0; i < gs_NUM_KERNELS; i++)
+    {
+        codeObjects[i].assign(gs_CODE_OBJECT_SIZE, static_cast<char>(0x10 + i));
+    }
+
+    TestDebugEngine& engine = TestGetDebugEngine();
+    TestLatencies latencies;
+    BinaryNotifications notifications;
+    memset(&notifications, 0, sizeof(notifications));
+
+    {
+        TestDispatcher dispatcher;
+        TEST_CHECK(dispatcher.IsReady());
+
+        // The first round sends every code object
+        for (int dispatch = -gs_NUM_KERNELS; dispatch < numDispatches && dispatcher.IsReady(); dispatch++)
+        {
+            const int kernel = (dispatch + gs_NUM_KERNELS) % gs_NUM_KERNELS;
+            uint64_t kernelObject = 0x100000 + kernel * 0x10000;
+
+            if (isCodeObjectNew)
+            {
+                // Another executable loaded at another address
+                codeObjects[kernel][dispatch & 0xfff] ^= 1;
+                kernelObject += static_cast<uint64_t>(dispatch + gs_NUM_KERNELS) << 32;
+            }
+
+            engine.m_kernelBinary = codeObjects[kernel];
+
+            uint64_t startNs = TestNowNs();
+            dispatcher.Dispatch(kernelObject, 64);
+            dispatcher.WaitForDispatch();
+            uint64_t endNs = TestNowNs();
+
+            if (dispatch >= 0)
+            {
+                latencies.Add(endNs - startNs);
+                ReadBinaryNotifications(notifications);
+            }
+            else
+            {
+                BinaryNotifications firstRound;
+                memset(&firstRound, 0, sizeof(firstRound));
+                ReadBinaryNotifications(firstRound);
+                TEST_CHECK(firstRound.m_numNewBinaries == 1);
+            }
+        }
+    }
+
+    TestStopGdb();
+
+    latencies.Report(pName);
+    printf("    %llu new, %llu reused code objects, %.1f MB copied for gdb\n",
+           static_cast<unsigned long long>(notifications.m_numNewBinaries),
+           static_cast<unsigned long long>(notifications.m_numReusedBinaries),
+           notifications.m_numNewBinaries * gs_CODE_OBJECT_SIZE / (1024.0 * 1024.0));
+
+    if (isCodeObjectNew)
+    {
+        TEST_CHECK(notifications.m_numNewBinaries == static_cast<uint64_t>(numDispatches));
+    }
+    else
+    {
+        TEST_CHECK(notifications.m_numNewBinaries == 0);
+        TEST_CHECK(notifications.m_numReusedBinaries == static_cast<uint64_t>(numDispatches));
+    }
+}
+
+int main()
+{
+    // The predispatch of a dispatch without breakpoints would be skipped once gdb has its binary,
+    // the binary notification is what is measured here
+    setenv("ROCM_GDB_DISABLE_PREDISPATCH_FAST_PATH", "1", 1);
+
+    // The stand-in code objects can not be disassembled
+    setenv("ROCM_GDB_DISABLE_ISA_DISASSEMBLE", "1", 1);
+
+    TestInitAgent();
+    TestResetDebugEngine();
+    TestGetDebugEngine().m_kernelName = "_Z10vectorCopyPKfPfj";
+
+    printf("RepeatedDispatchBench: %d kernels of %zu KB, predispatch callback of a dispatch without breakpoints\n",
+           gs_NUM_KERNELS, gs_CODE_OBJECT_SIZE / 1024);
+
+    RunDispatches("4 kernels dispatched in turn", gs_NUM_REPEATED_DISPATCHES, false);
+    RunDispatches("a new code object every dispatch", gs_NUM_NEW_CODE_OBJECT_DISPATCHES, true);
+
+    return TestResult("RepeatedDispatchBench");
+}
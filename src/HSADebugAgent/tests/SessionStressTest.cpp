@@ -0,0 +1,241 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Many debug sessions at once, each one an agent and a stand-in gdb with its own
+///        session ID, their fifos and shared memory must not collide
+//==============================================================================
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <sstream>
+#include <string>
+#include <sys/shm.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "hsa.h"
+
+#include "AgentConfiguration.h"
+#include "CommunicationControl.h"
+#include "CommunicationParams.h"
+#include "HSADebugAgent.h"
+
+#include "AgentTestDispatch.h"
+#include "AgentTestEngine.h"
+#include "AgentTestSupport.h"
+
+using namespace HwDbgAgentTest;
+
+/// Sessions run at once, and the stops of each of them
+static const int gs_NUM_SESSIONS = 16;
+static const int gs_NUM_STOPS = 20;
+
+/// The code address of the breakpoint and of every wave
+static const uint64_t gs_BREAKPOINT_PC = 0x1000;
+
+/// The shared memory of a session, the command ring key is the one the agent found free
+static const HsailDebugConfigParam gs_SESSION_SHM_PARAMS[] =
+{
+    HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM,
+    HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM,
+    HSAIL_DEBUG_CONFIG_WAVE_INFO_SHM,
+    HSAIL_DEBUG_CONFIG_ISA_BUFFER_SHM,
+    HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM,
+};
+
+static const size_t gs_NUM_SESSION_SHM_PARAMS = sizeof(gs_SESSION_SHM_PARAMS) / sizeof(gs_SESSION_SHM_PARAMS[0]);
+
+/// What a session sends back to the test when it is done
+typedef struct
+{
+    int      m_shmKeys[gs_NUM_SESSION_SHM_PARAMS + 1];  // The last one is the command ring
+    int      m_numStops;
+    uint64_t m_stopNs[gs_NUM_STOPS];                    // Dispatch to HSAIL_NOTIFY_BREAKPOINT_HIT
+} SessionResult;
+
+/// One session, run in a child process with the session ID of its pid
+static void RunSession(const int resultFd)
+{
+    SessionResult result;
+    memset(&result, 0, sizeof(result));
+
+    TestInitAgent();
+    TestResetDebugEngine();
+
+    for (size_t i = 0; i < gs_NUM_SESSION_SHM_PARAMS; i++)
+    {
+        GetActiveAgentConfig()->GetConfigShmKey(gs_SESSION_SHM_PARAMS[i], result.m_shmKeys[i]);
+    }
+
+    // The agent creates the command ring when it is loaded
+    int ringShmKey = 0;
+    size_t ringShmSize = 0;
+    GetActiveAgentConfig()->GetConfigShmKey(HSAIL_DEBUG_CONFIG_COMMAND_RING_SHM, ringShmKey);
+    GetActiveAgentConfig()->GetConfigShmSize(HSAIL_DEBUG_CONFIG_COMMAND_RING_SHM, ringShmSize);
+
+    if (InitCommandRing(ringShmKey, ringShmSize) != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        _exit(1);
+    }
+
+    result.m_shmKeys[gs_NUM_SESSION_SHM_PARAMS] = GetCommandRingShmKey();
+
+    TestGdbScript script;
+    memset(&script, 0, sizeof(script));
+    script.m_protocolVersion = HSAIL_FRAME_PROTOCOL_VERSION;
+    script.m_isSyncAnswered = true;
+
+    if (!TestStartGdb(script))
+    {
+        _exit(1);
+    }
+
+    TestDebugEngine& engine = TestGetDebugEngine();
+    engine.m_kernelBinary.assign(64 * 1024, static_cast<char>(getpid()));
+    engine.m_kernelName = "_Z10vectorCopyPKfPfj";
+    TestMakeWaves(64, gs_BREAKPOINT_PC, engine.m_waves);
+
+    {
+        TestDispatcher dispatcher;
+
+        dispatcher.CreatePCBreakpoint(gs_BREAKPOINT_PC, 1);
+
+        HsailCommandPacket continuePacket;
+        memset(&continuePacket, 0, sizeof(continuePacket));
+        continuePacket.m_command = HSAIL_COMMAND_CONTINUE;
+
+        for (int stop = 0; stop < gs_NUM_STOPS && dispatcher.IsReady(); stop++)
+        {
+            engine.m_events.clear();
+            engine.m_events.push_back(HWDBG_EVENT_POST_BREAKPOINT);
+            engine.m_events.push_back(HWDBG_EVENT_END_DEBUGGING);
+
+            uint64_t startNs = TestNowNs();
+            dispatcher.Dispatch(0, 64);
+
+            TestGdbNotification notification;
+            bool isStopped = false;
+
+            while (!isStopped && TestWaitForGdbNotification(notification, 10000))
+            {
+                isStopped = (notification.m_notification == HSAIL_NOTIFY_BREAKPOINT_HIT);
+            }
+
+            if (!isStopped)
+            {
+                break;
+            }
+
+            result.m_stopNs[stop] = notification.m_receiveNs - startNs;
+
+            TestWriteGdbCommand(reinterpret_cast<const char*>(&continuePacket), sizeof(continuePacket));
+            dispatcher.WaitForDispatch();
+
+            result.m_numStops++;
+        }
+    }
+
+    TestStopGdb();
+    CloseCommandRing();
+
+    _exit((write(resultFd, &result, sizeof(result)) == sizeof(result)) ? 0 : 1);
+}
+
+/// Check that a session left none of its fifos or shared memory behind
+static void CheckSessionCleanedUp(const pid_t sessionPid, const SessionResult& result)
+{
+    std::stringstream sessionSuffix;
+    sessionSuffix << "-test" << sessionPid;
+
+    const char* fifoNames[] = { gs_GdbToAgentFifoName, gs_AgentToGdbFifoName };
+
+    for (size_t i = 0; i < sizeof(fifoNames) / sizeof(fifoNames[0]); i++)
+    {
+        std::string fifoName = std::string(fifoNames[i]) + sessionSuffix.str();
+        TEST_CHECK(access(fifoName.c_str(), F_OK) != 0);
+    }
+
+    for (size_t i = 0; i <= gs_NUM_SESSION_SHM_PARAMS; i++)
+    {
+        TEST_CHECK(shmget(result.m_shmKeys[i], 0, 0) < 0);
+    }
+}
+
+int main()
+{
+    pid_t sessionPids[gs_NUM_SESSIONS];
+    int resultFds[gs_NUM_SESSIONS];
+
+    uint64_t startNs = TestNowNs();
+
+    for (int i = 0; i < gs_NUM_SESSIONS; i++)
+    {
+        int fds[2];
+
+        if (pipe(fds) != 0)
+        {
+            TEST_CHECK(false);
+            return TestResult("SessionStressTest");
+        }
+
+        sessionPids[i] = fork();
+
+        if (sessionPids[i] == 0)
+        {
+            close(fds[0]);
+            RunSession(fds[1]);
+        }
+
+        close(fds[1]);
+        resultFds[i] = fds[0];
+    }
+
+    std::vector<SessionResult> results(gs_NUM_SESSIONS);
+    TestLatencies latencies;
+
+    for (int i = 0; i < gs_NUM_SESSIONS; i++)
+    {
+        memset(&results[i], 0, sizeof(SessionResult));
+        ssize_t readStatus = read(resultFds[i], &results[i], sizeof(SessionResult));
+        close(resultFds[i]);
+
+        int exitStatus = 0;
+        waitpid(sessionPids[i], &exitStatus, 0);
+
+        TEST_CHECK(WIFEXITED(exitStatus) && WEXITSTATUS(exitStatus) == 0);
+        TEST_CHECK(readStatus == sizeof(SessionResult));
+        TEST_CHECK(results[i].m_numStops == gs_NUM_STOPS);
+
+        for (int stop = 0; stop < results[i].m_numStops; stop++)
+        {
+            latencies.Add(results[i].m_stopNs[stop]);
+        }
+
+        CheckSessionCleanedUp(sessionPids[i], results[i]);
+    }
+
+    uint64_t durationNs = TestNowNs() - startNs;
+
+    // No two sessions may share a segment
+    for (size_t param = 0; param <= gs_NUM_SESSION_SHM_PARAMS; param++)
+    {
+        std::set<int> keys;
+
+        for (int i = 0; i < gs_NUM_SESSIONS; i++)
+        {
+            keys.insert(results[i].m_shmKeys[param]);
+        }
+
+        TEST_CHECK(keys.size() == static_cast<size_t>(gs_NUM_SESSIONS));
+    }
+
+    printf("SessionStressTest: %d sessions at once, %d stops each, %.2f s\n", gs_NUM_SESSIONS, gs_NUM_STOPS,
+           durationNs / 1e9);
+    latencies.Report("dispatch to breakpoint hit at gdb");
+
+    return TestResult("SessionStressTest");
+}
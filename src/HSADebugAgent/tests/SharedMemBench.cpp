@@ -0,0 +1,212 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Per-stop cost of the shared memory writes, with the regions attached on
+///        every stop and with the regions mapped once by AgentSharedMemRegistry
+//==============================================================================
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sys/resource.h>
+#include <vector>
+
+#include "hsa.h"
+
+#include "AgentConfiguration.h"
+#include "AgentFramedProtocol.h"
+#include "AgentSharedMemRegistry.h"
+#include "CommunicationControl.h"
+#include "CommunicationParams.h"
+#include "HSADebugAgent.h"
+
+#include "AgentTestSupport.h"
+
+using namespace HwDbgAgent;
+using namespace HwDbgAgentTest;
+
+/// The regions a stop touches: gdb writes the momentary breakpoints, the agent writes the rest
+static const HsailDebugConfigParam gs_STOP_REGIONS[] =
+{
+    HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM,
+    HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM,
+    HSAIL_DEBUG_CONFIG_WAVE_INFO_SHM,
+    HSAIL_DEBUG_CONFIG_ISA_BUFFER_SHM,
+    HSAIL_DEBUG_CONFIG_LOADMAP_BUFFER_SHM
+};
+
+static const size_t gs_NUM_STOP_REGIONS = sizeof(gs_STOP_REGIONS) / sizeof(gs_STOP_REGIONS[0]);
+
+static const int gs_NUM_STOPS = 300;
+
+/// The size of the SysV segment of a region before the registry
+static size_t GetLegacySegmentSize(const HsailDebugConfigParam region)
+{
+    switch (region)
+    {
+        case HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM:
+            return g_MOMENTARY_BP_BUFFER_MAXSIZE;
+
+        case HSAIL_DEBUG_CONFIG_WAVE_INFO_SHM:
+            return g_WAVE_BUFFER_MAXSIZE;
+
+        case HSAIL_DEBUG_CONFIG_CODE_OBJ_SHM:
+            return g_BINARY_BUFFER_MAXSIZE;
+
+        case HSAIL_DEBUG_CONFIG_ISA_BUFFER_SHM:
+            return g_ISASTREAM_MAXSIZE;
+
+        default:
+            return g_LOADMAP_MAXSIZE;
+    }
+}
+
+static long GetMinorFaults()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_minflt;
+}
+
+static void Report(const char* pPath, const size_t payloadSize, TestLatencies& latencies, const long numFaults)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%7zu B %s", payloadSize, pPath);
+    latencies.Report(name);
+    printf("  %-44s %.1f minor faults per stop\n", "", static_cast<double>(numFaults) / gs_NUM_STOPS);
+}
+
+/// Every stop attaches the segments with shmget+shmat, writes them and detaches them with shmdt
+static void RunAttachPerStop(const std::vector<char>& payload, const size_t payloadSize)
+{
+    key_t keys[gs_NUM_STOP_REGIONS];
+    size_t sizes[gs_NUM_STOP_REGIONS];
+
+    for (size_t i = 0; i < gs_NUM_STOP_REGIONS; i++)
+    {
+        int shmKey = 0;
+        GetActiveAgentConfig()->GetConfigShmKey(gs_STOP_REGIONS[i], shmKey);
+
+        // Not the keys of the registry of this process
+        keys[i] = shmKey + 0x100;
+        sizes[i] = GetLegacySegmentSize(gs_STOP_REGIONS[i]);
+        AgentAllocSharedMemBuffer(keys[i], sizes[i]);
+    }
+
+    std::vector<char> readBack(g_MOMENTARY_BP_BUFFER_INITIAL_SIZE);
+    TestLatencies latencies;
+    long startFaults = GetMinorFaults();
+
+    for (int stop = 0; stop < gs_NUM_STOPS; stop++)
+    {
+        uint64_t startNs = TestNowNs();
+
+        for (size_t i = 0; i < gs_NUM_STOP_REGIONS; i++)
+        {
+            char* pShm = static_cast<char*>(AgentMapSharedMemBuffer(keys[i], sizes[i]));
+
+            if (gs_STOP_REGIONS[i] == HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM)
+            {
+                memcpy(readBack.data(), pShm, std::min(payloadSize, readBack.size()));
+            }
+            else
+            {
+                memcpy(pShm + sizeof(size_t), payload.data(), payloadSize);
+                memcpy(pShm, &payloadSize, sizeof(size_t));
+            }
+
+            AgentUnMapSharedMemBuffer(pShm);
+        }
+
+        latencies.Add(TestNowNs() - startNs);
+    }
+
+    Report("shmget+shmat+shmdt per stop", payloadSize, latencies, GetMinorFaults() - startFaults);
+
+    for (size_t i = 0; i < gs_NUM_STOP_REGIONS; i++)
+    {
+        AgentFreeSharedMemBuffer(keys[i], sizes[i]);
+    }
+}
+
+/// The registry maps the regions once, a stop only writes them
+static void RunRegistry(const std::vector<char>& payload, const size_t payloadSize, const uint32_t gdbProtocolVersion)
+{
+    AgentSetGdbProtocolVersion(gdbProtocolVersion);
+
+    AgentSharedMemRegistry registry;
+
+    if (registry.MapAllRegions() != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        TEST_CHECK(false);
+        return;
+    }
+
+    TestLatencies latencies;
+    long startFaults = 0;
+
+    // The first stops grow the regions to the payload, they are not counted
+    for (int stop = -2; stop < gs_NUM_STOPS; stop++)
+    {
+        if (stop == 0)
+        {
+            startFaults = GetMinorFaults();
+        }
+
+        uint64_t startNs = TestNowNs();
+
+        for (size_t i = 0; i < gs_NUM_STOP_REGIONS; i++)
+        {
+            const HsailDebugConfigParam region = gs_STOP_REGIONS[i];
+
+            if (region == HSAIL_DEBUG_CONFIG_MOMENTARY_BP_SHM)
+            {
+                registry.RefreshRegion(region);
+
+                std::vector<char> readBack(std::min(payloadSize, registry.GetRegionSize(region)));
+                memcpy(readBack.data(), registry.GetRegion(region), readBack.size());
+                continue;
+            }
+
+            void* pPayload = registry.BeginRegionUpdate(region, payloadSize);
+            TEST_CHECK(pPayload != nullptr);
+
+            if (pPayload != nullptr)
+            {
+                memcpy(pPayload, payload.data(), payloadSize);
+                registry.EndRegionUpdate(region, payloadSize);
+            }
+        }
+
+        if (stop >= 0)
+        {
+            latencies.Add(TestNowNs() - startNs);
+        }
+    }
+
+    Report((gdbProtocolVersion == 0) ? "registry, SysV segments (old gdb)" : "registry, shared buffers",
+           payloadSize, latencies, GetMinorFaults() - startFaults);
+
+    registry.UnMapAllRegions();
+}
+
+int main()
+{
+    TestInitAgent();
+
+    printf("SharedMemBench: shared memory traffic of one stop, %d stops\n", gs_NUM_STOPS);
+
+    const size_t payloadSizes[] = { 4096, 64 * 1024, 1024 * 1024 };
+    std::vector<char> payload(1024 * 1024, 0x5a);
+
+    for (size_t i = 0; i < sizeof(payloadSizes) / sizeof(payloadSizes[0]); i++)
+    {
+        RunAttachPerStop(payload, payloadSizes[i]);
+        RunRegistry(payload, payloadSizes[i], 0);
+        RunRegistry(payload, payloadSizes[i], HSAIL_FRAME_PROTOCOL_VERSION);
+    }
+
+    return TestResult("SharedMemBench");
+}
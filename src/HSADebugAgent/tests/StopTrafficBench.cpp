@@ -0,0 +1,225 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Bytes and read / write system calls of the fifos for one breakpoint stop,
+///        with the fixed size structures of an old gdb and with the frames
+//==============================================================================
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "hsa.h"
+
+#include "AgentFramedProtocol.h"
+#include "CommunicationControl.h"
+
+#include "AgentTestDispatch.h"
+#include "AgentTestEngine.h"
+#include "AgentTestSupport.h"
+
+using namespace HwDbgAgent;
+using namespace HwDbgAgentTest;
+
+/// Stops measured, after the first one which sends the binary and creates the breakpoints
+static const int gs_NUM_STOPS = 50;
+
+/// Waves of every dispatch, spread over the breakpoints
+static const uint32_t gs_NUM_WAVES = 256;
+
+/// The code address of the first breakpoint, the next ones follow every instruction
+static const uint64_t gs_FIRST_BREAKPOINT_PC = 0x1000;
+
+/// The read and write system calls of the process, from /proc/self/io
+typedef struct
+{
+    uint64_t m_numReads;
+    uint64_t m_numWrites;
+} ProcessIO;
+
+static ProcessIO GetProcessIO()
+{
+    ProcessIO io;
+    memset(&io, 0, sizeof(io));
+
+    std::ifstream ioFile("/proc/self/io");
+    std::string name;
+    uint64_t value = 0;
+
+    while (ioFile >> name >> value)
+    {
+        if (name == "syscr:")
+        {
+            io.m_numReads = value;
+        }
+        else if (name == "syscw:")
+        {
+            io.m_numWrites = value;
+        }
+    }
+
+    return io;
+}
+
+/// The traffic of the stops of one gdb
+typedef struct
+{
+    uint64_t m_numNotificationBytes;
+    uint64_t m_numNotifications;
+    uint64_t m_numAgentReads;
+    uint64_t m_numAgentWrites;
+} StopTraffic;
+
+/// Read the reports of the stand-in gdb till the stop is reported
+/// \param[in,out] trafficInOut The notifications are added to it
+/// \param[out]    isStoppedOut  true if the stop was reported
+/// \return The reports read, each one is a read system call of the test
+static uint64_t ReadStopReports(StopTraffic& trafficInOut, bool& isStoppedOut)
+{
+    uint64_t numReports = 0;
+    TestGdbNotification notification;
+    isStoppedOut = false;
+
+    while (!isStoppedOut && TestWaitForGdbNotification(notification, 5000))
+    {
+        numReports++;
+        trafficInOut.m_numNotificationBytes += notification.m_size;
+        trafficInOut.m_numNotifications++;
+        isStoppedOut = (notification.m_notification == HSAIL_NOTIFY_BREAKPOINT_HIT);
+    }
+
+    return numReports;
+}
+
+/// Read the reports the agent sent after the continue, the end of the dispatch
+static uint64_t ReadRemainingReports(StopTraffic& trafficInOut)
+{
+    uint64_t numReports = 0;
+    TestGdbNotification notification;
+
+    while (TestWaitForGdbNotification(notification, 0))
+    {
+        numReports++;
+        trafficInOut.m_numNotificationBytes += notification.m_size;
+        trafficInOut.m_numNotifications++;
+    }
+
+    return numReports;
+}
+
+/// Stop every dispatch at numBreakpoints breakpoints, all of them hit by some wave
+static void RunStops(const char* pName, const uint32_t gdbProtocolVersion, const uint32_t numBreakpoints)
+{
+    AgentSetGdbProtocolVersion(0);
+
+    TestGdbScript script;
+    memset(&script, 0, sizeof(script));
+    script.m_protocolVersion = gdbProtocolVersion;
+    script.m_isSyncAnswered = true;
+
+    if (!TestStartGdb(script))
+    {
+        TEST_CHECK(false);
+        return;
+    }
+
+    TestDebugEngine& engine = TestGetDebugEngine();
+    TestMakeWaves(gs_NUM_WAVES, gs_FIRST_BREAKPOINT_PC, engine.m_waves);
+
+    for (uint32_t i = 0; i < gs_NUM_WAVES; i++)
+    {
+        engine.m_waves[i].codeAddress = gs_FIRST_BREAKPOINT_PC + 4 * (i % numBreakpoints);
+    }
+
+    StopTraffic traffic;
+    memset(&traffic, 0, sizeof(traffic));
+
+    {
+        TestDispatcher dispatcher;
+        TEST_CHECK(dispatcher.IsReady());
+
+        for (uint32_t i = 0; i < numBreakpoints; i++)
+        {
+            dispatcher.CreatePCBreakpoint(gs_FIRST_BREAKPOINT_PC + 4 * i, 1 + i);
+        }
+
+        HsailCommandPacket continuePacket;
+        memset(&continuePacket, 0, sizeof(continuePacket));
+        continuePacket.m_command = HSAIL_COMMAND_CONTINUE;
+
+        for (int stop = -1; stop < gs_NUM_STOPS && dispatcher.IsReady(); stop++)
+        {
+            engine.m_events.clear();
+            engine.m_events.push_back(HWDBG_EVENT_POST_BREAKPOINT);
+            engine.m_events.push_back(HWDBG_EVENT_END_DEBUGGING);
+
+            StopTraffic stopTraffic;
+            memset(&stopTraffic, 0, sizeof(stopTraffic));
+
+            ProcessIO startIO = GetProcessIO();
+
+            dispatcher.Dispatch(0, gs_NUM_WAVES);
+
+            bool isStopped = false;
+            uint64_t numTestReads = ReadStopReports(stopTraffic, isStopped);
+
+            if (!isStopped)
+            {
+                TEST_CHECK(false);
+                break;
+            }
+
+            TestWriteGdbCommand(reinterpret_cast<const char*>(&continuePacket), sizeof(continuePacket));
+            dispatcher.WaitForDispatch();
+
+            numTestReads += ReadRemainingReports(stopTraffic);
+
+            ProcessIO endIO = GetProcessIO();
+
+            // The test wrote the continue and read the reports, the rest is the agent's
+            if (stop >= 0)
+            {
+                traffic.m_numNotificationBytes += stopTraffic.m_numNotificationBytes;
+                traffic.m_numNotifications += stopTraffic.m_numNotifications;
+                traffic.m_numAgentReads += endIO.m_numReads - startIO.m_numReads - numTestReads;
+                traffic.m_numAgentWrites += endIO.m_numWrites - startIO.m_numWrites - 1;
+            }
+        }
+    }
+
+    TestStopGdb();
+
+    printf("  %-36s %9.1f bytes %6.1f notifications %6.1f writes %6.1f reads per stop\n", pName,
+           static_cast<double>(traffic.m_numNotificationBytes) / gs_NUM_STOPS,
+           static_cast<double>(traffic.m_numNotifications) / gs_NUM_STOPS,
+           static_cast<double>(traffic.m_numAgentWrites) / gs_NUM_STOPS,
+           static_cast<double>(traffic.m_numAgentReads) / gs_NUM_STOPS);
+
+    TEST_CHECK(traffic.m_numNotifications >= static_cast<uint64_t>(gs_NUM_STOPS));
+}
+
+int main()
+{
+    // An old gdb gets the ISA at every stop, the stand-in binary can not be disassembled
+    setenv("ROCM_GDB_DISABLE_ISA_DISASSEMBLE", "1", 1);
+
+    TestInitAgent();
+    TestResetDebugEngine();
+
+    TestDebugEngine& engine = TestGetDebugEngine();
+    engine.m_kernelBinary.assign(64 * 1024, 0x5a);
+    engine.m_kernelName = "_Z10vectorCopyPKfPfj";
+
+    printf("StopTrafficBench: fifo traffic of one stop and its continue, %u waves, %d stops\n",
+           gs_NUM_WAVES, gs_NUM_STOPS);
+
+    RunStops("old gdb, 1 breakpoint hit", 0, 1);
+    RunStops("old gdb, 100 breakpoints hit", 0, 100);
+    RunStops("frames, 1 breakpoint hit", HSAIL_FRAME_PROTOCOL_VERSION, 1);
+    RunStops("frames, 100 breakpoints hit", HSAIL_FRAME_PROTOCOL_VERSION, 100);
+
+    return TestResult("StopTrafficBench");
+}
@@ -0,0 +1,115 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Time of the predispatch callback of a dispatch that does not stop, with a gdb
+///        that answers the sync requests in several ways and with a gdb that does not
+//==============================================================================
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "hsa.h"
+
+#include "AgentFramedProtocol.h"
+#include "CommunicationControl.h"
+
+#include "AgentTestDispatch.h"
+#include "AgentTestEngine.h"
+#include "AgentTestSupport.h"
+
+using namespace HwDbgAgent;
+using namespace HwDbgAgentTest;
+
+/// Dispatches of a gdb that answers, and of one that leaves the agent to its fixed waits
+static const int gs_NUM_ANSWERED_DISPATCHES = 500;
+static const int gs_NUM_UNANSWERED_DISPATCHES = 20;
+
+/// How the stand-in gdb answers, one agent context and one gdb per mode.
+/// A dispatch without breakpoints syncs twice, before and after the binary is sent
+typedef struct
+{
+    const char* m_pName;
+    uint32_t    m_protocolVersion;
+    bool        m_isSyncAnswered;
+    uint32_t    m_numCommandsBeforeMarker;
+    uint32_t    m_markerDelayUs;
+    int         m_numDispatches;
+    uint64_t    m_maxP50Us;         // The p50 the mode must stay under
+} SyncMode;
+
+static const SyncMode gs_SYNC_MODES[] =
+{
+    { "old gdb, fixed waits",              0,                            false, 0,  0,    gs_NUM_UNANSWERED_DISPATCHES, 150000 },
+    { "framing gdb, no marker",            HSAIL_FRAME_PROTOCOL_VERSION, false, 0,  0,    gs_NUM_UNANSWERED_DISPATCHES, 150000 },
+    { "marker at once",                    HSAIL_FRAME_PROTOCOL_VERSION, true,  0,  0,    gs_NUM_ANSWERED_DISPATCHES,   10000  },
+    { "marker after 16 commands",          HSAIL_FRAME_PROTOCOL_VERSION, true,  16, 0,    gs_NUM_ANSWERED_DISPATCHES,   10000  },
+    { "marker after 2 ms",                 HSAIL_FRAME_PROTOCOL_VERSION, true,  0,  2000, gs_NUM_ANSWERED_DISPATCHES,   15000  },
+};
+
+static void RunSyncMode(const SyncMode& mode)
+{
+    AgentSetGdbProtocolVersion(0);
+
+    TestGdbScript script;
+    memset(&script, 0, sizeof(script));
+    script.m_protocolVersion = mode.m_protocolVersion;
+    script.m_isSyncAnswered = mode.m_isSyncAnswered;
+    script.m_numCommandsBeforeMarker = mode.m_numCommandsBeforeMarker;
+    script.m_markerDelayUs = mode.m_markerDelayUs;
+
+    if (!TestStartGdb(script))
+    {
+        TEST_CHECK(false);
+        return;
+    }
+
+    TestLatencies latencies;
+
+    {
+        TestDispatcher dispatcher;
+        TEST_CHECK(dispatcher.IsReady());
+
+        // The first dispatch sends the binary to gdb and gets the first answer of gdb
+        for (int dispatch = -1; dispatch < mode.m_numDispatches && dispatcher.IsReady(); dispatch++)
+        {
+            uint64_t startNs = TestNowNs();
+            dispatcher.Dispatch(0, 64);
+            dispatcher.WaitForDispatch();
+            uint64_t endNs = TestNowNs();
+
+            if (dispatch >= 0)
+            {
+                latencies.Add(endNs - startNs);
+            }
+        }
+    }
+
+    TestStopGdb();
+
+    latencies.Report(mode.m_pName);
+    TEST_CHECK(latencies.GetPercentile(50) < mode.m_maxP50Us * 1000);
+}
+
+int main()
+{
+    // Every dispatch syncs with gdb, a dispatch gdb has the binary of would skip the predispatch
+    setenv("ROCM_GDB_DISABLE_PREDISPATCH_FAST_PATH", "1", 1);
+
+    TestInitAgent();
+    TestResetDebugEngine();
+
+    TestDebugEngine& engine = TestGetDebugEngine();
+    engine.m_kernelBinary.assign(64 * 1024, 0x5a);
+    engine.m_kernelName = "_Z10vectorCopyPKfPfj";
+
+    printf("SyncHandshakeBench: predispatch callback of a dispatch without breakpoints\n");
+
+    for (size_t i = 0; i < sizeof(gs_SYNC_MODES) / sizeof(gs_SYNC_MODES[0]); i++)
+    {
+        RunSyncMode(gs_SYNC_MODES[i]);
+    }
+
+    return TestResult("SyncHandshakeBench");
+}
@@ -0,0 +1,221 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Cost of the wave, code object and load map writers of a stop, through the
+///        SysV segments of an old gdb and through the shared buffers with a header
+//==============================================================================
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "hsa.h"
+
+#include "AgentBinary.h"
+#include "AgentFramedProtocol.h"
+#include "AgentSegmentLoader.h"
+#include "AgentSharedMemRegistry.h"
+#include "AgentWavePrinter.h"
+#include "CommunicationControl.h"
+#include "CommunicationParams.h"
+
+#include "AgentTestEngine.h"
+#include "AgentTestSupport.h"
+
+using namespace HwDbgAgent;
+using namespace HwDbgAgentTest;
+
+static const int gs_NUM_STOPS = 200;
+
+/// Any non-null handle, the stand-in DBE has a single context
+static const HwDbgContextHandle gs_DEBUG_CONTEXT = reinterpret_cast<HwDbgContextHandle>(0x1);
+
+/// The writers before the buffer header cleared the whole SysV segment, then wrote the payload
+static void RunClearedRegion(const char* pName, const size_t regionSize, const size_t payloadSize)
+{
+    std::vector<char> region(regionSize);
+    std::vector<char> payload(payloadSize, 0x5a);
+
+    // The first clear faults the pages in, like the segment that stays attached
+    memset(region.data(), 0, regionSize);
+
+    TestLatencies latencies;
+
+    for (int stop = 0; stop < gs_NUM_STOPS; stop++)
+    {
+        uint64_t startNs = TestNowNs();
+        memset(region.data(), 0, regionSize);
+        memcpy(region.data(), payload.data(), payloadSize);
+        latencies.Add(TestNowNs() - startNs);
+    }
+
+    latencies.Report(pName);
+}
+
+static const char* GetPathName(const uint32_t gdbProtocolVersion)
+{
+    return (gdbProtocolVersion == 0) ? "SysV" : "header";
+}
+
+/// AgentWavePrinter::SendActiveWavesToGdb, the notification included
+static void RunWaveWriter(AgentSharedMemRegistry& registry, const uint32_t numWaves, const uint32_t gdbProtocolVersion)
+{
+    TestMakeWaves(numWaves, 0x1000, TestGetDebugEngine().m_waves);
+
+    AgentWavePrinter wavePrinter(&registry);
+    TestLatencies latencies;
+    TestGdbNotification notification;
+
+    for (int stop = -1; stop < gs_NUM_STOPS; stop++)
+    {
+        uint64_t startNs = TestNowNs();
+        TEST_CHECK(wavePrinter.SendActiveWavesToGdb(HWDBG_EVENT_POST_BREAKPOINT, gs_DEBUG_CONTEXT) ==
+                   HSAIL_AGENT_STATUS_SUCCESS);
+        uint64_t endNs = TestNowNs();
+
+        TEST_CHECK(TestWaitForGdbNotification(notification, 1000));
+
+        // The first stop grows the region to the waves
+        if (stop >= 0)
+        {
+            latencies.Add(endNs - startNs);
+        }
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "waves %5u, %s", numWaves, GetPathName(gdbProtocolVersion));
+    latencies.Report(name);
+}
+
+/// AgentBinary::PopulateBinaryFromDBE and NotifyGDB of a binary gdb has not seen
+static void RunCodeObjectWriter(AgentSharedMemRegistry& registry, const size_t binarySize,
+                                const uint32_t gdbProtocolVersion)
+{
+    TestGetDebugEngine().m_kernelBinary.assign(binarySize, 0x5a);
+    TestGetDebugEngine().m_kernelName = "_Z10vectorCopyPKfPfj";
+
+    hsa_kernel_dispatch_packet_t packet;
+    TestMakeDispatchPacket(0, 1000, packet);
+
+    AgentBinary binary(&registry, nullptr);
+    TestLatencies latencies;
+    TestGdbNotification notification;
+
+    for (int stop = -1; stop < gs_NUM_STOPS; stop++)
+    {
+        uint64_t startNs = TestNowNs();
+        TEST_CHECK(binary.PopulateBinaryFromDBE(gs_DEBUG_CONTEXT, &packet, nullptr) == HSAIL_AGENT_STATUS_SUCCESS);
+        TEST_CHECK(binary.NotifyGDB(&packet, 0, stop, false) == HSAIL_AGENT_STATUS_SUCCESS);
+        uint64_t endNs = TestNowNs();
+
+        TEST_CHECK(TestWaitForGdbNotification(notification, 1000));
+
+        if (stop >= 0)
+        {
+            latencies.Add(endNs - startNs);
+        }
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "code object %5zu KB, %s", binarySize / 1024, GetPathName(gdbProtocolVersion));
+    latencies.Report(name);
+}
+
+/// AgentSegmentLoader::UpdateLoadedSegments, the whole load map after a load
+/// and the two slots of the executed segment when another kernel runs
+static void RunLoadMapWriter(AgentSharedMemRegistry& registry, const size_t numSegments,
+                             const uint32_t gdbProtocolVersion)
+{
+    std::vector<HwDbgLoaderSegmentDescriptor>& segments = TestGetDebugEngine().m_segments;
+    segments.resize(numSegments);
+
+    for (size_t i = 0; i < numSegments; i++)
+    {
+        memset(&segments[i], 0, sizeof(segments[i]));
+        segments[i].device = 1;
+        segments[i].executable = 1 + i / 4;
+        segments[i].codeObjectStorageType = HWDBG_LOADER_CODE_OBJECT_STORAGE_TYPE_FILE;
+        segments[i].pCodeObjectStorageBase = "/opt/rocm/bench/vectorCopy.co";
+        segments[i].pSegmentBase = reinterpret_cast<const void*>(0x100000 + i * 0x10000);
+        segments[i].segmentSize = 0x1000;
+    }
+
+    AgentSegmentLoader segmentLoader(&registry);
+    TestLatencies loadLatencies;
+    TestLatencies switchLatencies;
+
+    for (int stop = -1; stop < gs_NUM_STOPS; stop++)
+    {
+        const uint64_t kernelObject = 0x100000 + (stop & 1) * 0x10000;
+
+        AgentInvalidateLoadMap();
+
+        uint64_t startNs = TestNowNs();
+        TEST_CHECK(segmentLoader.UpdateLoadedSegments(kernelObject) == HSAIL_AGENT_STATUS_SUCCESS);
+        uint64_t loadNs = TestNowNs();
+        TEST_CHECK(segmentLoader.UpdateLoadedSegments(kernelObject + 0x20000) == HSAIL_AGENT_STATUS_SUCCESS);
+        uint64_t switchNs = TestNowNs();
+
+        if (stop >= 0)
+        {
+            loadLatencies.Add(loadNs - startNs);
+            switchLatencies.Add(switchNs - loadNs);
+        }
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "load map %5zu segments, %s", numSegments, GetPathName(gdbProtocolVersion));
+    loadLatencies.Report(name);
+    snprintf(name, sizeof(name), "  executed segment of %5zu changed, %s", numSegments, GetPathName(gdbProtocolVersion));
+    switchLatencies.Report(name);
+}
+
+int main()
+{
+    // The ISA is not needed, the disassembler would dominate the code object writer
+    setenv("ROCM_GDB_DISABLE_ISA_DISASSEMBLE", "1", 1);
+
+    TestInitAgent();
+
+    TestGdbScript script;
+    memset(&script, 0, sizeof(script));
+
+    if (!TestStartGdb(script))
+    {
+        TEST_CHECK(false);
+        return TestResult("WriterBench");
+    }
+
+    printf("WriterBench: writers of one stop, %d stops\n", gs_NUM_STOPS);
+
+    RunClearedRegion("clear 20 MB wave region, 1000 waves", g_WAVE_BUFFER_MAXSIZE, 1000 * sizeof(HsailAgentWaveInfo));
+    RunClearedRegion("clear 10 MB code object region, 1 MB", g_BINARY_BUFFER_MAXSIZE, 1024 * 1024);
+    RunClearedRegion("clear 10 MB load map region, 100 segs", g_LOADMAP_MAXSIZE, 100 * sizeof(HsailSegmentDescriptor));
+
+    const uint32_t gdbProtocolVersions[] = { 0, HSAIL_FRAME_PROTOCOL_VERSION };
+
+    for (size_t i = 0; i < sizeof(gdbProtocolVersions) / sizeof(gdbProtocolVersions[0]); i++)
+    {
+        AgentSetGdbProtocolVersion(gdbProtocolVersions[i]);
+
+        AgentSharedMemRegistry registry;
+        TEST_CHECK(registry.MapAllRegions() == HSAIL_AGENT_STATUS_SUCCESS);
+
+        RunWaveWriter(registry, 10, gdbProtocolVersions[i]);
+        RunWaveWriter(registry, 1000, gdbProtocolVersions[i]);
+
+        RunCodeObjectWriter(registry, 64 * 1024, gdbProtocolVersions[i]);
+        RunCodeObjectWriter(registry, 1024 * 1024, gdbProtocolVersions[i]);
+
+        RunLoadMapWriter(registry, 10, gdbProtocolVersions[i]);
+        RunLoadMapWriter(registry, 100, gdbProtocolVersions[i]);
+
+        registry.UnMapAllRegions();
+    }
+
+    TestStopGdb();
+
+    return TestResult("WriterBench");
+}
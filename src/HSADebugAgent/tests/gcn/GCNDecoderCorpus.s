@@ -0,0 +1,126 @@
+; The instructions the GCN decoder is checked against, with their encodings, as llvm-mc
+; disassembles them for fiji (GFX8). GCNDecoderTest decodes the encoding of every line and
+; compares the text. Made with LLVM 14 by
+;   sed -n '/^\t/s/.*; encoding: //p' GCNDecoderCorpus.s | llvm-mc -triple=amdgcn -mcpu=fiji -disassemble -show-encoding
+	.text
+	s_add_u32 s0, s1, s2                    ; encoding: [0x01,0x02,0x00,0x80]
+	s_sub_i32 s4, s5, 17                    ; encoding: [0x05,0x91,0x84,0x81]
+	s_and_b64 s[0:1], s[2:3], vcc           ; encoding: [0x02,0x6a,0x80,0x86]
+	s_or_b32 s3, s4, 0x12345                ; encoding: [0x04,0xff,0x03,0x87,0x45,0x23,0x01,0x00]
+	s_lshl_b32 s1, s2, 3                    ; encoding: [0x02,0x83,0x01,0x8e]
+	s_mul_i32 s7, s8, s9                    ; encoding: [0x08,0x09,0x07,0x92]
+	s_cselect_b32 s1, s2, s3                ; encoding: [0x02,0x03,0x01,0x85]
+	s_movk_i32 s2, 0x1234                   ; encoding: [0x34,0x12,0x02,0xb0]
+	s_cmpk_eq_u32 s3, 0x10                  ; encoding: [0x10,0x00,0x03,0xb4]
+	s_addk_i32 s4, 0x20                     ; encoding: [0x20,0x00,0x04,0xb7]
+	s_mov_b32 s0, s1                        ; encoding: [0x01,0x00,0x80,0xbe]
+	s_mov_b64 s[0:1], exec                  ; encoding: [0x7e,0x01,0x80,0xbe]
+	s_not_b32 s1, s2                        ; encoding: [0x02,0x04,0x81,0xbe]
+	s_getpc_b64 s[4:5]                      ; encoding: [0x00,0x1c,0x84,0xbe]
+	s_setpc_b64 s[6:7]                      ; encoding: [0x06,0x1d,0x80,0xbe]
+	s_swappc_b64 s[0:1], s[2:3]             ; encoding: [0x02,0x1e,0x80,0xbe]
+	s_and_saveexec_b64 s[0:1], vcc          ; encoding: [0x6a,0x20,0x80,0xbe]
+	s_brev_b32 s1, s2                       ; encoding: [0x02,0x08,0x81,0xbe]
+	s_cmp_eq_u32 s0, s1                     ; encoding: [0x00,0x01,0x06,0xbf]
+	s_cmp_lt_i32 s2, 5                      ; encoding: [0x02,0x85,0x04,0xbf]
+	s_cmp_lg_u64 s[0:1], s[2:3]             ; encoding: [0x00,0x02,0x13,0xbf]
+	s_bitcmp0_b32 s0, 4                     ; encoding: [0x00,0x84,0x0c,0xbf]
+	s_nop 0                                 ; encoding: [0x00,0x00,0x80,0xbf]
+	s_endpgm                                ; encoding: [0x00,0x00,0x81,0xbf]
+	s_waitcnt vmcnt(0) lgkmcnt(0)           ; encoding: [0x70,0x00,0x8c,0xbf]
+	s_waitcnt lgkmcnt(0)                    ; encoding: [0x7f,0x00,0x8c,0xbf]
+	s_barrier                               ; encoding: [0x00,0x00,0x8a,0xbf]
+	s_branch 4                              ; encoding: [0x04,0x00,0x82,0xbf]
+	s_cbranch_scc0 2                        ; encoding: [0x02,0x00,0x84,0xbf]
+	s_cbranch_execz 16                      ; encoding: [0x10,0x00,0x88,0xbf]
+	s_cbranch_vccnz 1                       ; encoding: [0x01,0x00,0x87,0xbf]
+	s_trap 2                                ; encoding: [0x02,0x00,0x92,0xbf]
+	s_sethalt 1                             ; encoding: [0x01,0x00,0x8d,0xbf]
+	s_sleep 2                               ; encoding: [0x02,0x00,0x8e,0xbf]
+	s_load_dword s0, s[2:3], 0x10           ; encoding: [0x01,0x00,0x02,0xc0,0x10,0x00,0x00,0x00]
+	s_load_dwordx2 s[4:5], s[0:1], 0x0      ; encoding: [0x00,0x01,0x06,0xc0,0x00,0x00,0x00,0x00]
+	s_load_dwordx4 s[8:11], s[6:7], 0x20    ; encoding: [0x03,0x02,0x0a,0xc0,0x20,0x00,0x00,0x00]
+	s_buffer_load_dword s1, s[4:7], 0x4     ; encoding: [0x42,0x00,0x22,0xc0,0x04,0x00,0x00,0x00]
+	s_store_dword s1, s[2:3], 0x8           ; encoding: [0x41,0x00,0x42,0xc0,0x08,0x00,0x00,0x00]
+	s_dcache_inv                            ; encoding: [0x00,0x00,0x80,0xc0,0x00,0x00,0x00,0x00]
+	s_memtime s[0:1]                        ; encoding: [0x00,0x00,0x90,0xc0,0x00,0x00,0x00,0x00]
+	v_add_f32_e32 v0, v1, v2                ; encoding: [0x01,0x05,0x00,0x02]
+	v_add_f32_e32 v0, s1, v2                ; encoding: [0x01,0x04,0x00,0x02]
+	v_mul_f32_e32 v3, 1.0, v4               ; encoding: [0xf2,0x08,0x06,0x0a]
+	v_sub_f32_e32 v1, v2, v3                ; encoding: [0x02,0x07,0x02,0x04]
+	v_mac_f32_e32 v0, v1, v2                ; encoding: [0x01,0x05,0x00,0x2c]
+	v_and_b32_e32 v1, v2, v3                ; encoding: [0x02,0x07,0x02,0x26]
+	v_or_b32_e32 v1, 0x7f, v3               ; encoding: [0xff,0x06,0x02,0x28,0x7f,0x00,0x00,0x00]
+	v_lshlrev_b32_e32 v1, 2, v3             ; encoding: [0x82,0x06,0x02,0x24]
+	v_add_u32_e32 v1, vcc, v2, v3           ; encoding: [0x02,0x07,0x02,0x32]
+	v_addc_u32_e32 v1, vcc, v2, v3, vcc     ; encoding: [0x02,0x07,0x02,0x38]
+	v_cndmask_b32_e32 v0, v1, v2, vcc       ; encoding: [0x01,0x05,0x00,0x00]
+	v_max_i32_e32 v0, v1, v2                ; encoding: [0x01,0x05,0x00,0x1a]
+	v_mov_b32_e32 v0, v1                    ; encoding: [0x01,0x03,0x00,0x7e]
+	v_mov_b32_e32 v0, s1                    ; encoding: [0x01,0x02,0x00,0x7e]
+	v_mov_b32_e32 v0, 1.0                   ; encoding: [0xf2,0x02,0x00,0x7e]
+	v_mov_b32_e32 v0, -1                    ; encoding: [0xc1,0x02,0x00,0x7e]
+	v_cvt_f32_i32_e32 v1, v2                ; encoding: [0x02,0x0b,0x02,0x7e]
+	v_cvt_u32_f32_e32 v1, v2                ; encoding: [0x02,0x0f,0x02,0x7e]
+	v_rcp_f32_e32 v0, v1                    ; encoding: [0x01,0x45,0x00,0x7e]
+	v_sqrt_f32_e32 v0, v1                   ; encoding: [0x01,0x4f,0x00,0x7e]
+	v_readfirstlane_b32 s0, v1              ; encoding: [0x01,0x05,0x00,0x7e]
+	v_nop                                   ; encoding: [0x00,0x00,0x00,0x7e]
+	v_not_b32_e32 v2, v3                    ; encoding: [0x03,0x57,0x04,0x7e]
+	v_cmp_eq_u32_e32 vcc, v0, v1            ; encoding: [0x00,0x03,0x94,0x7d]
+	v_cmp_lt_f32_e32 vcc, 0, v1             ; encoding: [0x80,0x02,0x82,0x7c]
+	v_cmp_gt_i32_e32 vcc, s2, v1            ; encoding: [0x02,0x02,0x88,0x7d]
+	v_cmpx_ne_u32_e32 vcc, v0, v1           ; encoding: [0x00,0x03,0xba,0x7d]
+	v_cmp_eq_u32_e64 s[0:1], v0, v1         ; encoding: [0x00,0x00,0xca,0xd0,0x00,0x03,0x02,0x00]
+	v_add_f32_e64 v0, |v1|, -v2             ; encoding: [0x00,0x01,0x01,0xd1,0x01,0x05,0x02,0x40]
+	v_mad_f32 v0, v1, v2, v3                ; encoding: [0x00,0x00,0xc1,0xd1,0x01,0x05,0x0e,0x04]
+	v_mad_u32_u24 v0, v1, v2, v3            ; encoding: [0x00,0x00,0xc3,0xd1,0x01,0x05,0x0e,0x04]
+	v_fma_f32 v0, v1, v2, v3                ; encoding: [0x00,0x00,0xcb,0xd1,0x01,0x05,0x0e,0x04]
+	v_bfe_u32 v0, v1, 8, 8                  ; encoding: [0x00,0x00,0xc8,0xd1,0x01,0x11,0x21,0x02]
+	v_mul_lo_u32 v0, v1, v2                 ; encoding: [0x00,0x00,0x85,0xd2,0x01,0x05,0x02,0x00]
+	v_mul_hi_u32 v0, v1, v2                 ; encoding: [0x00,0x00,0x86,0xd2,0x01,0x05,0x02,0x00]
+	v_lshlrev_b64 v[0:1], 2, v[2:3]         ; encoding: [0x00,0x00,0x8f,0xd2,0x82,0x04,0x02,0x00]
+	v_add_f64 v[0:1], v[2:3], v[4:5]        ; encoding: [0x00,0x00,0x80,0xd2,0x02,0x09,0x02,0x00]
+	v_cndmask_b32_e64 v0, v1, v2, s[4:5]    ; encoding: [0x00,0x00,0x00,0xd1,0x01,0x05,0x12,0x00]
+	v_readlane_b32 s0, v1, 2                ; encoding: [0x00,0x00,0x89,0xd2,0x01,0x05,0x01,0x00]
+	v_writelane_b32 v0, s1, 3               ; encoding: [0x00,0x00,0x8a,0xd2,0x01,0x06,0x01,0x00]
+	ds_read_b32 v0, v1                      ; encoding: [0x00,0x00,0x6c,0xd8,0x01,0x00,0x00,0x00]
+	ds_read_b32 v0, v1 offset:16            ; encoding: [0x10,0x00,0x6c,0xd8,0x01,0x00,0x00,0x00]
+	ds_write_b32 v1, v2                     ; encoding: [0x00,0x00,0x1a,0xd8,0x01,0x02,0x00,0x00]
+	ds_write_b64 v1, v[2:3] offset:8        ; encoding: [0x08,0x00,0x9a,0xd8,0x01,0x02,0x00,0x00]
+	ds_add_u32 v1, v2                       ; encoding: [0x00,0x00,0x00,0xd8,0x01,0x02,0x00,0x00]
+	ds_read2_b32 v[0:1], v2 offset1:1       ; encoding: [0x00,0x01,0x6e,0xd8,0x02,0x00,0x00,0x00]
+	ds_swizzle_b32 v0, v1 offset:65535      ; encoding: [0xff,0xff,0x7a,0xd8,0x01,0x00,0x00,0x00]
+	buffer_load_dword v0, off, s[0:3], s4   ; encoding: [0x00,0x00,0x50,0xe0,0x00,0x00,0x00,0x04]
+	buffer_load_dword v0, v1, s[4:7], 0 offen ; encoding: [0x00,0x10,0x50,0xe0,0x01,0x00,0x01,0x80]
+	buffer_store_dword v0, off, s[8:11], 0 offset:16 ; encoding: [0x10,0x00,0x70,0xe0,0x00,0x00,0x02,0x80]
+	buffer_load_dwordx4 v[0:3], v4, s[0:3], 0 idxen ; encoding: [0x00,0x20,0x5c,0xe0,0x04,0x00,0x00,0x80]
+	buffer_wbinvl1                          ; encoding: [0x00,0x00,0xf8,0xe0,0x00,0x00,0x00,0x00]
+	flat_load_dword v0, v[1:2]              ; encoding: [0x00,0x00,0x50,0xdc,0x01,0x00,0x00,0x00]
+	flat_store_dword v[1:2], v0             ; encoding: [0x00,0x00,0x70,0xdc,0x01,0x00,0x00,0x00]
+	flat_load_dwordx2 v[0:1], v[2:3]        ; encoding: [0x00,0x00,0x54,0xdc,0x02,0x00,0x00,0x00]
+	flat_atomic_add v0, v[1:2], v3 glc      ; encoding: [0x00,0x00,0x09,0xdd,0x01,0x03,0x00,0x00]
+	flat_store_dwordx4 v[0:1], v[2:5]       ; encoding: [0x00,0x00,0x7c,0xdc,0x00,0x02,0x00,0x00]
+	tbuffer_load_format_x v0, off, s[0:3], 0 ; encoding: [0x00,0x00,0x08,0xe8,0x00,0x00,0x00,0x80]
+	image_load v[0:3], v4, s[8:15] dmask:0xf unorm ; encoding: [0x00,0x1f,0x00,0xf0,0x04,0x00,0x02,0x00]
+	image_sample v[0:3], v4, s[8:15], s[16:19] dmask:0xf ; encoding: [0x00,0x0f,0x80,0xf0,0x04,0x00,0x82,0x00]
+	v_interp_p1_f32_e32 v0, v1, attr0.x     ; encoding: [0x01,0x00,0x00,0xd4]
+	exp mrt0 v0, v1, v2, v3                 ; encoding: [0x0f,0x00,0x00,0xc4,0x00,0x01,0x02,0x03]
+	v_nop                                   ; encoding: [0x00,0x00,0x00,0x7e]
+	v_clrexcp                               ; encoding: [0x00,0x6a,0x00,0x7e]
+	v_readfirstlane_b32 s0, v1              ; encoding: [0x01,0x05,0x00,0x7e]
+	v_madmk_f32 v0, v1, 0x41000000, v2      ; encoding: [0x01,0x05,0x00,0x2e,0x00,0x00,0x00,0x41]
+	v_madak_f32 v0, v1, v2, 0x41000000      ; encoding: [0x01,0x05,0x00,0x30,0x00,0x00,0x00,0x41]
+	v_interp_p2_f32_e32 v0, v1, attr0.x     ; encoding: [0x01,0x00,0x01,0xd4]
+	v_interp_mov_f32_e32 v0, p10, attr0.x   ; encoding: [0x00,0x00,0x02,0xd4]
+	s_setprio 2                             ; encoding: [0x02,0x00,0x8f,0xbf]
+	s_incperflevel 3                        ; encoding: [0x03,0x00,0x94,0xbf]
+	s_ttracedata                            ; encoding: [0x00,0x00,0x96,0xbf]
+	s_cbranch_cdbgsys 3                     ; encoding: [0x03,0x00,0x97,0xbf]
+	tbuffer_load_format_x v0, off, s[0:3], 0 format:[BUF_DATA_FORMAT_32,BUF_NUM_FORMAT_FLOAT] ; encoding: [0x00,0x00,0xa0,0xeb,0x00,0x00,0x00,0x80]
+	ds_write2_b64 v1, v[2:3], v[4:5] offset1:1 ; encoding: [0x00,0x01,0x9c,0xd8,0x01,0x02,0x04,0x00]
+	ds_write2st64_b64 v1, v[2:3], v[4:5] offset1:1 ; encoding: [0x00,0x01,0x9e,0xd8,0x01,0x02,0x04,0x00]
+	ds_read2_b64 v[2:5], v1 offset1:1       ; encoding: [0x00,0x01,0xee,0xd8,0x01,0x00,0x00,0x02]
+	ds_write_b128 v1, v[2:5]                ; encoding: [0x00,0x00,0xbe,0xd9,0x01,0x02,0x00,0x00]
+	exp pos0 v0, off, v2, off done          ; encoding: [0xc5,0x08,0x00,0xc4,0x00,0x00,0x02,0x00]
+	exp param3 v0, v1, v2, v3               ; encoding: [0x3f,0x02,0x00,0xc4,0x00,0x01,0x02,0x03]
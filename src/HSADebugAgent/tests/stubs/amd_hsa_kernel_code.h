@@ -0,0 +1,18 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief The kernel code object header, only its size is used
+//==============================================================================
+#ifndef TEST_STUB_AMD_HSA_KERNEL_CODE_H_
+#define TEST_STUB_AMD_HSA_KERNEL_CODE_H_
+
+#include <stdint.h>
+
+typedef struct amd_kernel_code_s
+{
+    uint8_t bytes[256];
+} amd_kernel_code_t;
+
+#endif // TEST_STUB_AMD_HSA_KERNEL_CODE_H_
@@ -0,0 +1,33 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief The dispatch callbacks of the HSA tools interface
+//==============================================================================
+#ifndef TEST_STUB_AMD_HSA_TOOLS_INTERFACES_H_
+#define TEST_STUB_AMD_HSA_TOOLS_INTERFACES_H_
+
+#include "hsa.h"
+
+typedef struct hsa_dispatch_callback_s
+{
+    hsa_agent_t agent;
+    hsa_queue_t* queue;
+    uint64_t packet_id;
+    hsa_kernel_dispatch_packet_t* aql_packet;
+    bool pre_dispatch;
+} hsa_dispatch_callback_t;
+
+typedef void (*hsa_ext_tools_dispatch_callback_function)(const hsa_dispatch_callback_t* callback, void* user_data);
+
+hsa_status_t hsa_ext_tools_set_callback_functions(hsa_queue_t* queue,
+                                                  hsa_ext_tools_dispatch_callback_function pre_dispatch,
+                                                  hsa_ext_tools_dispatch_callback_function post_dispatch);
+hsa_status_t hsa_ext_tools_get_callback_functions(hsa_queue_t* queue,
+                                                  hsa_ext_tools_dispatch_callback_function* pre_dispatch,
+                                                  hsa_ext_tools_dispatch_callback_function* post_dispatch);
+hsa_status_t hsa_ext_tools_set_callback_arguments(hsa_queue_t* queue, void* pre_dispatch_args, void* post_dispatch_args);
+hsa_status_t hsa_ext_tools_get_callback_arguments(hsa_queue_t* queue, void** pre_dispatch_args, void** post_dispatch_args);
+
+#endif // TEST_STUB_AMD_HSA_TOOLS_INTERFACES_H_
@@ -0,0 +1,109 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief The part of hsa.h the agent sources use, so the tests build without the HSA runtime
+//==============================================================================
+#ifndef TEST_STUB_HSA_H_
+#define TEST_STUB_HSA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef enum
+{
+    HSA_STATUS_SUCCESS = 0,
+    HSA_STATUS_ERROR = 0x1000,
+    HSA_STATUS_ERROR_NOT_INITIALIZED = 0x100B
+} hsa_status_t;
+
+typedef struct hsa_agent_s { uint64_t handle; } hsa_agent_t;
+typedef struct hsa_signal_s { uint64_t handle; } hsa_signal_t;
+typedef struct hsa_isa_s { uint64_t handle; } hsa_isa_t;
+typedef struct hsa_code_object_s { uint64_t handle; } hsa_code_object_t;
+typedef struct hsa_executable_s { uint64_t handle; } hsa_executable_t;
+typedef struct hsa_executable_symbol_s { uint64_t handle; } hsa_executable_symbol_t;
+
+typedef uint32_t hsa_queue_type32_t;
+
+typedef enum
+{
+    HSA_DEVICE_TYPE_CPU = 0,
+    HSA_DEVICE_TYPE_GPU = 1
+} hsa_device_type_t;
+
+typedef enum
+{
+    HSA_AGENT_INFO_NAME = 0,
+    HSA_AGENT_INFO_VENDOR_NAME = 1,
+    HSA_AGENT_INFO_DEVICE = 17
+} hsa_agent_info_t;
+
+typedef enum
+{
+    HSA_CODE_OBJECT_TYPE_PROGRAM = 0
+} hsa_code_object_type_t;
+
+typedef enum
+{
+    HSA_EXECUTABLE_SYMBOL_INFO_TYPE = 0,
+    HSA_EXECUTABLE_SYMBOL_INFO_NAME_LENGTH = 1,
+    HSA_EXECUTABLE_SYMBOL_INFO_NAME = 2,
+    HSA_EXECUTABLE_SYMBOL_INFO_KERNEL_OBJECT = 22
+} hsa_executable_symbol_info_t;
+
+typedef enum
+{
+    HSA_PACKET_HEADER_TYPE = 0
+} hsa_packet_header_t;
+
+typedef enum
+{
+    HSA_KERNEL_DISPATCH_PACKET_SETUP_DIMENSIONS = 0
+} hsa_kernel_dispatch_packet_setup_t;
+
+typedef struct hsa_queue_s
+{
+    uint32_t type;
+    uint32_t features;
+    void* base_address;
+    hsa_signal_t doorbell_signal;
+    uint32_t size;
+    uint32_t reserved1;
+    uint64_t id;
+} hsa_queue_t;
+
+typedef struct hsa_kernel_dispatch_packet_s
+{
+    uint16_t header;
+    uint16_t setup;
+    uint16_t workgroup_size_x;
+    uint16_t workgroup_size_y;
+    uint16_t workgroup_size_z;
+    uint16_t reserved0;
+    uint32_t grid_size_x;
+    uint32_t grid_size_y;
+    uint32_t grid_size_z;
+    uint32_t private_segment_size;
+    uint32_t group_segment_size;
+    uint64_t kernel_object;
+    void* kernarg_address;
+    uint64_t reserved2;
+    hsa_signal_t completion_signal;
+} hsa_kernel_dispatch_packet_t;
+
+hsa_status_t hsa_status_string(hsa_status_t status, const char** status_string);
+hsa_status_t hsa_iterate_agents(hsa_status_t (*callback)(hsa_agent_t agent, void* data), void* data);
+hsa_status_t hsa_agent_get_info(hsa_agent_t agent, hsa_agent_info_t attribute, void* value);
+hsa_status_t hsa_shut_down();
+hsa_status_t hsa_queue_create(hsa_agent_t agent, uint32_t size, hsa_queue_type32_t type,
+                              void (*callback)(hsa_status_t status, hsa_queue_t* source, void* data), void* data,
+                              uint32_t private_segment_size, uint32_t group_segment_size, hsa_queue_t** queue);
+hsa_status_t hsa_executable_freeze(hsa_executable_t executable, const char* options);
+hsa_status_t hsa_executable_destroy(hsa_executable_t executable);
+hsa_status_t hsa_executable_symbol_get_info(hsa_executable_symbol_t executable_symbol,
+                                            hsa_executable_symbol_info_t attribute, void* value);
+
+#endif // TEST_STUB_HSA_H_
@@ -0,0 +1,36 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief The entries of the HSA API table the agent intercepts
+//==============================================================================
+#ifndef TEST_STUB_HSA_API_TRACE_H_
+#define TEST_STUB_HSA_API_TRACE_H_
+
+#include "hsa.h"
+#include "hsa_ext_finalize.h"
+
+struct CoreApiTable
+{
+    decltype(hsa_shut_down)* hsa_shut_down_fn;
+    decltype(hsa_queue_create)* hsa_queue_create_fn;
+    decltype(hsa_agent_get_info)* hsa_agent_get_info_fn;
+    decltype(hsa_iterate_agents)* hsa_iterate_agents_fn;
+    decltype(hsa_executable_freeze)* hsa_executable_freeze_fn;
+    decltype(hsa_executable_destroy)* hsa_executable_destroy_fn;
+    decltype(hsa_executable_symbol_get_info)* hsa_executable_symbol_get_info_fn;
+};
+
+struct FinalizerExtTable
+{
+    decltype(hsa_ext_program_finalize)* hsa_ext_program_finalize_fn;
+};
+
+struct HsaApiTable
+{
+    CoreApiTable* core_;
+    FinalizerExtTable* finalizer_ext_;
+};
+
+#endif // TEST_STUB_HSA_API_TRACE_H_
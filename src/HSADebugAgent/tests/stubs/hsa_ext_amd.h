@@ -0,0 +1,24 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief The AMD agent attributes the agent sources query
+//==============================================================================
+#ifndef TEST_STUB_HSA_EXT_AMD_H_
+#define TEST_STUB_HSA_EXT_AMD_H_
+
+#include "hsa.h"
+
+typedef enum
+{
+    HSA_AMD_AGENT_INFO_CHIP_ID = 0xA000,
+    HSA_AMD_AGENT_INFO_COMPUTE_UNIT_COUNT,
+    HSA_AMD_AGENT_INFO_MAX_CLOCK_FREQUENCY,
+    HSA_AMD_AGENT_INFO_MAX_WAVES_PER_CU,
+    HSA_AMD_AGENT_INFO_MEMORY_MAX_FREQUENCY,
+    HSA_AMD_AGENT_INFO_NUM_SHADER_ENGINES,
+    HSA_AMD_AGENT_INFO_NUM_SIMDS_PER_CU
+} hsa_amd_agent_info_t;
+
+#endif // TEST_STUB_HSA_EXT_AMD_H_
@@ -0,0 +1,24 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief The part of hsa_ext_finalize.h the agent sources use
+//==============================================================================
+#ifndef TEST_STUB_HSA_EXT_FINALIZE_H_
+#define TEST_STUB_HSA_EXT_FINALIZE_H_
+
+#include "hsa.h"
+
+typedef struct hsa_ext_program_s { uint64_t handle; } hsa_ext_program_t;
+
+typedef struct hsa_ext_control_directives_s
+{
+    uint64_t control_directives_mask;
+} hsa_ext_control_directives_t;
+
+hsa_status_t hsa_ext_program_finalize(hsa_ext_program_t program, hsa_isa_t isa, int32_t call_convention,
+                                      hsa_ext_control_directives_t control_directives, const char* options,
+                                      hsa_code_object_type_t code_object_type, hsa_code_object_t* code_object);
+
+#endif // TEST_STUB_HSA_EXT_FINALIZE_H_
@@ -0,0 +1,13 @@
+//==============================================================================
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Included by the agent sources, nothing of it is used
+//==============================================================================
+#ifndef TEST_STUB_HSA_EXT_PROFILER_H_
+#define TEST_STUB_HSA_EXT_PROFILER_H_
+
+#include "hsa.h"
+
+#endif // TEST_STUB_HSA_EXT_PROFILER_H_